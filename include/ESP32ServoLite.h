@@ -1,6 +1,44 @@
 #pragma once
 #include <Arduino.h>
 
+#define LEDC_CHANNELS   16
+
+/// @brief Hands out the LEDC channels, one per servo, from any task
+class LedcAllocator {
+public:
+    /// @return the channel or -1 when all are in use
+    static int allocate() {
+        int channel = -1;
+        portENTER_CRITICAL(&_mux);
+        for (int ch=0; ch<LEDC_CHANNELS; ++ch) {
+            if (!_used[ch]) {
+                _used[ch] = true;
+                channel = ch;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&_mux);
+        return channel;
+    }
+
+    static void release(int channel) {
+        if (channel < 0 or channel >= LEDC_CHANNELS) return;
+        portENTER_CRITICAL(&_mux);
+        _used[channel] = false;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    static int inUse() {
+        int n = 0;
+        for (bool used : _used) n += used;
+        return n;
+    }
+
+private:
+    static inline bool _used[LEDC_CHANNELS] = {};
+    static inline portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
 class ESP32ServoLite {
 public:
     ESP32ServoLite() : _attached(false), _channel(-1), _pin(-1), _minPulse(500), _maxPulse(2500) {}
@@ -13,14 +51,7 @@ public:
         _minPulse = minPulse;
         _maxPulse = maxPulse;
 
-        // Find a free LEDC channel (0..15)
-        for (int ch=0; ch<16; ++ch) {
-            if (!_usedChannels[ch]) {
-                _channel = ch;
-                _usedChannels[ch] = true;
-                break;
-            }
-        }
+        _channel = LedcAllocator::allocate();
         if (_channel < 0) return -1; // no free channel
 
         // 50 Hz, 16-bit resolution
@@ -31,10 +62,17 @@ public:
         return _channel;
     }
 
+    // Change the min/max pulse width while attached
+    void setRange(int minPulse, int maxPulse) {
+        _minPulse = minPulse;
+        _maxPulse = maxPulse;
+    }
+
     void detach() {
         if (_attached) {
             ledcDetachPin(_pin);
-            _usedChannels[_channel] = false;
+            LedcAllocator::release(_channel);
+            _channel = -1;
             _attached = false;
         }
     }
@@ -61,10 +99,4 @@ private:
     int _channel;
     int _pin;
     int _minPulse, _maxPulse;
-
-    // Track used LEDC channels globally
-    static bool _usedChannels[16];
 };
-
-// Initialize static member
-bool ESP32ServoLite::_usedChannels[16] = {false};
\ No newline at end of file
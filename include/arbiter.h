@@ -0,0 +1,145 @@
+#pragma once
+#include <Arduino.h>
+#include <doublebuffer.h>
+
+#define TARGET_TEXT_LENGTH  48
+
+// The producers, the priorities come from [sources] in config.ini
+enum TargetSourceId : uint8_t { TS_ONBOARD, TS_ROTCTLD, TS_WEB, TS_STELLARIUM, TS_COUNT };
+
+/// @brief A target position as a producer publishes it
+struct TargetSample {
+  float    altitude = 0.0, azimuth = 0.0;
+  bool     visible = false;
+  bool     valid = false;           // false: the source has nothing to offer (error says why)
+  bool     track = false;           // Start tracking with this sample (rotctld, web)
+  uint32_t time = 0;                // millis() the position is for
+  char     name[TARGET_TEXT_LENGTH] = "";
+  char     error[TARGET_TEXT_LENGTH] = "";
+};
+
+/// @brief One producer of targets, written by its own task
+class TargetSource {
+
+public:
+  /// @param priority higher wins, 0 turns the source off
+  /// @param timeout ms after the last sample it is no longer live, 0 for never
+  void configure(uint8_t priority, uint32_t timeout) {
+    _priority = priority;
+    _timeout = timeout;
+  }
+
+  /// @brief New position (producer side, one task only)
+  void publish(const TargetSample &sample) { _buffer.write(sample); }
+
+  /// @brief Nothing to offer any more, a lower source takes over at the next control tick (producer side)
+  void release(const char *error = "") {
+    TargetSample sample;
+    sample.time = millis();
+    strlcpy(sample.error, error, sizeof(sample.error));
+    _buffer.write(sample);
+  }
+
+  uint8_t priority() const { return _priority; }
+  uint32_t timeout() const { return _timeout; }
+
+private:
+  friend class TargetArbiter;
+  DoubleBuffer<TargetSample> _buffer;
+  uint8_t _priority = 0;
+  uint32_t _timeout = 0;
+};
+
+/// @brief How a source is doing, as seen by the control side
+struct TargetSourceStatus {
+  bool     live = false;
+  uint32_t received = 0;            // millis() the control side picked the last sample up
+  uint32_t latency = 0;             // ms from the sample time to the pick up
+};
+
+/*
+    Chooses which producer the control follows. Stellarium, rotctld clients, the web page and the
+    on-board trackers each publish into their own source, from their own task and without a lock.
+    Every control tick update() picks up what is new and follows the live source with the highest
+    priority: one that is on, has a valid sample and is not older than its timeout. A better source
+    takes over at the next tick, and when the one followed stops or goes stale the next one does.
+*/
+class TargetArbiter {
+
+public:
+  TargetSource &source(TargetSourceId id) { return _sources[id]; }
+  const TargetSource &source(TargetSourceId id) const { return _sources[id]; }
+
+  /// @brief Pick up new samples and choose the source to follow (control side, every tick)
+  /// @return true when the target changed: a new sample of the followed source or another source
+  bool update(uint32_t now) {
+    for (uint8_t i = 0; i < TS_COUNT; ++i) {
+      if (_sources[i]._buffer.read(_last[i], _version[i])) {
+        _status[i].received = now;
+        _status[i].latency = now - _last[i].time;
+        _fresh[i] = true;
+      }
+      const TargetSource &s = _sources[i];
+      _status[i].live = s._priority and _version[i] and _last[i].valid and
+                        (!s._timeout or (int32_t)(now - _last[i].time) <= (int32_t)s._timeout);
+    }
+
+    int8_t best = -1;
+    for (uint8_t i = 0; i < TS_COUNT; ++i)
+      if (_status[i].live and (best < 0 or _sources[i]._priority > _sources[best]._priority)) best = i;
+
+    bool changed = best != _active;
+    if (changed) {
+      log_i("Target source %s -> %s", _active < 0 ? "none" : name((TargetSourceId)_active),
+            best < 0 ? "none" : name((TargetSourceId)best));
+      _active = best;
+      _handover = true;
+    }
+    if (best >= 0 and _fresh[best]) changed = true;
+    for (uint8_t i = 0; i < TS_COUNT; ++i) _fresh[i] &= i != best;
+    return changed;
+  }
+
+  /// @brief The source followed, -1 when none is live
+  int8_t active() const { return _active; }
+  bool following(TargetSourceId id) const { return _active == id; }
+
+  /// @brief Another source was chosen since the last call
+  bool takeHandover() {
+    bool handover = _handover;
+    _handover = false;
+    return handover;
+  }
+
+  /// @brief Latest sample of the source followed
+  const TargetSample &current() const { return _last[_active < 0 ? 0 : _active]; }
+  /// @brief Latest sample of any source, e.g. for its error
+  const TargetSample &last(TargetSourceId id) const { return _last[id]; }
+  const TargetSourceStatus &status(TargetSourceId id) const { return _status[id]; }
+
+  /// @brief Why nothing is followed: the error of the best source that is on
+  const char *reason() const {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < TS_COUNT; ++i)
+      if (_sources[i]._priority and _last[i].error[0] and (best < 0 or _sources[i]._priority > _sources[best]._priority))
+        best = i;
+    return best < 0 ? "No target" : _last[best].error;
+  }
+
+  /// @brief Age of the last sample in ms, -1 when there never was one
+  int32_t age(TargetSourceId id, uint32_t now) const { return _version[id] ? (int32_t)(now - _last[id].time) : -1; }
+
+  static const char *name(TargetSourceId id) {
+    static const char *names[TS_COUNT] = {"onboard", "rotctld", "web", "stellarium"};
+    return id < TS_COUNT ? names[id] : "";
+  }
+
+private:
+  TargetSource _sources[TS_COUNT];
+  TargetSample _last[TS_COUNT];
+  TargetSourceStatus _status[TS_COUNT];
+  uint32_t _version[TS_COUNT] = {};
+  bool _fresh[TS_COUNT] = {};
+  int8_t _active = -1;
+  bool _handover = false;
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <WebServer.h>
+
+#define ASSET_MANIFEST      "/assets.txt"   // "<uri> <hash>" per line, written by scripts/compress_data.py
+#define ASSET_MAX           16
+#define ASSET_CACHE_PAGE    "no-cache"              // Pages are checked on every load, mostly a 304
+#define ASSET_CACHE_OTHER   "public, max-age=86400" // Style sheets, scripts and icons for a day
+
+/*
+    Serves the web page and everything else the browser asks for from SPIFFS. The file system
+    build stores the web assets gzipped, with a hash of their content in the manifest. That hash
+    is the ETag, so a browser that has the file gets a 304 without the file being opened. Only a
+    gzipped copy is in flash, every browser accepts gzip.
+    Without a manifest (an image built without the script, the native build) the plain files are
+    sent without an ETag.
+*/
+class StaticAssets {
+
+public:
+  /// @brief Read the manifest
+  void begin(fs::FS &fs) {
+    _fs = &fs;
+    _count = 0;
+    File file = fs.open(ASSET_MANIFEST, "r");
+    if (!file) {
+      log_w("No %s, web files are sent uncompressed", ASSET_MANIFEST);
+      return;
+    }
+    while (file.available() and _count < ASSET_MAX) {
+      String line = file.readStringUntil('\n');
+      line.trim();
+      int space = line.indexOf(' ');
+      if (space <= 0) continue;
+      _uri[_count] = line.substring(0, space);
+      _etag[_count] = "\"" + line.substring(space + 1) + "\"";
+      _count++;
+    }
+    file.close();
+    log_i("%d compressed web files", _count);
+  }
+
+  /// @brief Send a file, or 304 when the browser has it already
+  /// @return false when there is no such web file, nothing is sent then
+  bool serve(WebServer &server, String uri) {
+    if (!_fs or (server.method() != HTTP_GET and server.method() != HTTP_HEAD)) return false;
+    if (uri.endsWith("/")) uri += "index.html";
+    const char *type = _contentType(uri);
+    if (!type) return false;   // Not a web file, e.g. config.ini
+    const char *cache = strcmp(type, "text/html") == 0 ? ASSET_CACHE_PAGE : ASSET_CACHE_OTHER;
+
+    int8_t index = -1;
+    for (uint8_t i = 0; i < _count; ++i)
+      if (_uri[i] == uri) index = i;
+
+    if (index < 0) {
+      File file = _fs->open(uri, "r");
+      if (!file or file.isDirectory()) return false;
+      server.sendHeader("Cache-Control", "no-cache");
+      server.streamFile(file, type);
+      file.close();
+      return true;
+    }
+
+    server.sendHeader("ETag", _etag[index]);
+    server.sendHeader("Cache-Control", cache);
+    if (server.header("If-None-Match").indexOf(_etag[index]) >= 0) {
+      server.send(304);
+      _notModified++;
+      return true;
+    }
+
+    File file = _fs->open(uri + ".gz", "r");
+    if (!file) return false;
+    // streamFile adds Content-Encoding: gzip for a .gz file
+    server.sendHeader("Vary", "Accept-Encoding");
+    server.streamFile(file, type);
+    file.close();
+    _sent++;
+    log_d("Served %s.gz, %u sent, %u not modified", uri.c_str(), _sent, _notModified);
+    return true;
+  }
+
+private:
+
+  static const char *_contentType(const String &uri) {
+    if (uri.endsWith(".html") or uri.endsWith(".htm")) return "text/html";
+    if (uri.endsWith(".css")) return "text/css";
+    if (uri.endsWith(".js")) return "application/javascript";
+    if (uri.endsWith(".json")) return "application/json";
+    if (uri.endsWith(".svg")) return "image/svg+xml";
+    if (uri.endsWith(".ico")) return "image/x-icon";
+    if (uri.endsWith(".png")) return "image/png";
+    if (uri.endsWith(".jpg")) return "image/jpeg";
+    if (uri.endsWith(".webmanifest")) return "application/manifest+json";
+    return nullptr;
+  }
+
+  fs::FS *_fs = nullptr;
+  String _uri[ASSET_MAX], _etag[ASSET_MAX];
+  uint8_t _count = 0;
+  uint32_t _sent = 0, _notModified = 0;
+};
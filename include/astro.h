@@ -0,0 +1,134 @@
+#pragma once
+#include <Arduino.h>
+#include <sys/time.h>
+
+/*
+    Time and coordinate helpers for the on-board tracking: UTC clock, sidereal time and the
+    transformation to altitude/azimuth for the observer location from config.ini.
+*/
+
+#define JD_UNIX_EPOCH   2440587.5       // Julian date of 1970-01-01 00:00 UTC
+#define CLOCK_VALID     1577836800      // 2020-01-01, anything earlier means the clock was never set
+#define CLOCK_NOT_SET   "Clock not set, open the web page to set it"
+
+/// @brief Observer location, WGS-84
+struct Observer {
+    double latitude = 0.0;      // degrees, north positive
+    double longitude = 0.0;     // degrees, east positive
+    double altitude = 0.0;      // meters above the ellipsoid
+};
+
+/// @brief The ESP32 has no battery backed clock, it has to be set after every boot (see /time)
+bool clockSet() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec > CLOCK_VALID;
+}
+
+/// @brief Set the system clock
+/// @param unixMs milliseconds since 1970-01-01 UTC
+void setClock(uint64_t unixMs) {
+#ifndef NATIVE_BUILD
+    struct timeval tv;
+    tv.tv_sec = unixMs / 1000;
+    tv.tv_usec = (unixMs % 1000) * 1000;
+    settimeofday(&tv, nullptr);
+#endif  // The host clock is already right
+    log_i("Clock set to %llu", (unsigned long long)unixMs);
+}
+
+/// @brief Current Julian date (UTC)
+/// @param offsetMs added to the current time, e.g. to look ahead
+double julianDateNow(long offsetMs = 0) {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return JD_UNIX_EPOCH + (tv.tv_sec + (tv.tv_usec / 1000 + offsetMs) / 1000.0) / 86400.0;
+}
+
+/// @brief Greenwich mean sidereal time (IAU 1982), UT1 is taken equal to UTC
+/// @return radians
+double gmst(double jd) {
+    double t = (jd - 2451545.0) / 36525.0;
+    double seconds = -6.2e-6 * t * t * t + 0.093104 * t * t + (876600.0 * 3600.0 + 8640184.812866) * t + 67310.54841;
+    double g = fmod(seconds * (M_PI / 180.0) / 240.0, 2.0 * M_PI);
+    return g < 0.0 ? g + 2.0 * M_PI : g;
+}
+
+/// @brief Observer position in earth fixed coordinates
+/// @param r position in km
+void observerEcef(const Observer &observer, double r[3]) {
+    const double a = 6378.137, f = 1.0 / 298.257223563, e2 = f * (2.0 - f);
+    double lat = observer.latitude * (M_PI / 180.0), lon = observer.longitude * (M_PI / 180.0);
+    double h = observer.altitude / 1000.0;
+    double n = a / sqrt(1.0 - e2 * sin(lat) * sin(lat));
+    r[0] = (n + h) * cos(lat) * cos(lon);
+    r[1] = (n + h) * cos(lat) * sin(lon);
+    r[2] = (n * (1.0 - e2) + h) * sin(lat);
+}
+
+/// @brief Altitude/azimuth of a position in the TEME frame (SGP4 output), polar motion is ignored
+/// @param r position in km
+/// @param jd Julian date of the position
+/// @param alt, az receive degrees, azimuth from north through east
+/// @return range in km
+double temeToAltAz(const Observer &observer, double jd, const double r[3], double &alt, double &az) {
+    // TEME -> earth fixed, rotate over the sidereal angle
+    double g = gmst(jd);
+    double x = cos(g) * r[0] + sin(g) * r[1];
+    double y = -sin(g) * r[0] + cos(g) * r[1];
+    double z = r[2];
+
+    double o[3];
+    observerEcef(observer, o);
+    double dx = x - o[0], dy = y - o[1], dz = z - o[2];
+
+    // Topocentric south, east, zenith
+    double lat = observer.latitude * (M_PI / 180.0), lon = observer.longitude * (M_PI / 180.0);
+    double south = sin(lat) * cos(lon) * dx + sin(lat) * sin(lon) * dy - cos(lat) * dz;
+    double east = -sin(lon) * dx + cos(lon) * dy;
+    double zenith = cos(lat) * cos(lon) * dx + cos(lat) * sin(lon) * dy + sin(lat) * dz;
+    double range = sqrt(dx * dx + dy * dy + dz * dz);
+
+    alt = asin(zenith / range) * (180.0 / M_PI);
+    az = atan2(east, -south) * (180.0 / M_PI);
+    if (az < 0.0) az += 360.0;
+    return range;
+}
+
+/// @brief Precession of J2000 coordinates to the mean equinox of date (IAU 1976)
+/// @param ra0, dec0 J2000 coordinates in radians
+/// @param ra, dec receive the coordinates of date in radians
+void precessFromJ2000(double jd, double ra0, double dec0, double &ra, double &dec) {
+    const double arcsec = M_PI / (180.0 * 3600.0);
+    double t = (jd - 2451545.0) / 36525.0;
+    double zeta = (2306.2181 + (0.30188 + 0.017998 * t) * t) * t * arcsec;
+    double z = (2306.2181 + (1.09468 + 0.018203 * t) * t) * t * arcsec;
+    double theta = (2004.3109 - (0.42665 + 0.041833 * t) * t) * t * arcsec;
+
+    double a = cos(dec0) * sin(ra0 + zeta);
+    double b = cos(theta) * cos(dec0) * cos(ra0 + zeta) - sin(theta) * sin(dec0);
+    double c = sin(theta) * cos(dec0) * cos(ra0 + zeta) + cos(theta) * sin(dec0);
+    ra = fmod(atan2(a, b) + z + 2.0 * M_PI, 2.0 * M_PI);
+    dec = asin(c);
+}
+
+/// @brief Altitude/azimuth of equatorial coordinates of date, from the local sidereal time
+/// @param ra, dec radians
+/// @param alt, az receive degrees, azimuth from north through east
+void equatorialToAltAz(const Observer &observer, double jd, double ra, double dec, double &alt, double &az) {
+    double lat = observer.latitude * (M_PI / 180.0);
+    double h = gmst(jd) + observer.longitude * (M_PI / 180.0) - ra;     // Hour angle
+
+    alt = asin(sin(lat) * sin(dec) + cos(lat) * cos(dec) * cos(h)) * (180.0 / M_PI);
+    az = atan2(-cos(dec) * sin(h), sin(dec) * cos(lat) - cos(dec) * sin(lat) * cos(h)) * (180.0 / M_PI);
+    if (az < 0.0) az += 360.0;
+}
+
+/// @brief Atmospheric refraction (Saemundsson) for 10 C and 1010 hPa
+/// @param alt true altitude in degrees
+/// @return degrees to add to get the apparent altitude
+double refraction(double alt) {
+    if (alt < -1.0) return 0.0;
+    double r = 1.02 / tan((alt + 10.3 / (alt + 5.11)) * (M_PI / 180.0)) / 60.0;
+    return r > 0.0 ? r : 0.0;
+}
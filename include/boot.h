@@ -0,0 +1,94 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define BOOT_STAGES         12
+#define BOOT_NAMESPACE      "boot"
+
+/*
+    Times of the boot stages, to see where the time from a reset to a working rotor goes. Times
+    are micros() since the application started, the bootloader before it is not included. Stages
+    can be marked from any task, every one is logged when it is reached.
+*/
+class BootTimeline {
+
+public:
+  /// @brief A stage has been reached (any task)
+  /// @param stage text that lives as long as the program
+  void mark(const char *stage) {
+    uint32_t now = micros();
+    portENTER_CRITICAL(&_mux);
+    if (_count < BOOT_STAGES) {
+      _stage[_count] = stage;
+      _time[_count++] = now;
+    }
+    portEXIT_CRITICAL(&_mux);
+    log_i("Boot: %s at %lu.%03lu ms", stage, now / 1000, now % 1000);
+  }
+
+  /// @brief When a stage was reached in us, 0 when not (yet)
+  uint32_t at(const char *stage) const {
+    portENTER_CRITICAL(&_mux);
+    uint32_t time = 0;
+    for (uint8_t i = 0; i < _count and !time; ++i)
+      if (strcmp(_stage[i], stage) == 0) time = _time[i];
+    portEXIT_CRITICAL(&_mux);
+    return time;
+  }
+
+  /// @brief All stages on one line, "stage ms, ..."
+  String summary() const {
+    String line;
+    portENTER_CRITICAL(&_mux);
+    uint8_t count = _count;
+    portEXIT_CRITICAL(&_mux);
+    for (uint8_t i = 0; i < count; ++i) {
+      if (i) line += ", ";
+      line += String(_stage[i]) + " " + String(_time[i] / 1000.0, 1) + " ms";
+    }
+    return line;
+  }
+
+private:
+  const char *_stage[BOOT_STAGES] = {};
+  uint32_t _time[BOOT_STAGES] = {};
+  uint8_t _count = 0;
+  mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+/// @brief Access point name and password as last read from config.ini
+struct BootCredentials {
+  char ssid[33] = "";
+  char password[65] = "";
+};
+
+/*
+    Keeps the access point credentials in NVS, so the access point can be started at once after a
+    reset while the file system is still being mounted. When config.ini turns out to have others
+    the access point is started again with those.
+*/
+class CredentialCache {
+
+public:
+  /// @return false when there is nothing cached (first boot)
+  static bool read(BootCredentials &credentials) {
+    Preferences nvs;
+    if (!nvs.begin(BOOT_NAMESPACE, true)) return false;
+    bool ok = nvs.getBytes("ap", &credentials, sizeof(credentials)) == sizeof(credentials) and credentials.ssid[0];
+    nvs.end();
+    credentials.ssid[sizeof(credentials.ssid) - 1] = credentials.password[sizeof(credentials.password) - 1] = 0;
+    return ok;
+  }
+
+  /// @brief Save when they changed
+  static void write(const char *ssid, const char *password) {
+    BootCredentials credentials, cached;
+    strlcpy(credentials.ssid, ssid, sizeof(credentials.ssid));
+    strlcpy(credentials.password, password, sizeof(credentials.password));
+    if (read(cached) and memcmp(&credentials, &cached, sizeof(credentials)) == 0) return;
+    Preferences nvs;
+    if (!nvs.begin(BOOT_NAMESPACE, false)) return;
+    if (nvs.putBytes("ap", &credentials, sizeof(credentials)) != sizeof(credentials)) log_e("Could not cache the access point");
+    nvs.end();
+  }
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <Arduino.h>
+#include <rotorservo.h>
+#include <servolag.h>
+
+#define LOOP_RATE_FILTER    0.05f   // s, time constant of the filter on the derivative
+
+/*
+    A PID loop around a servo with a feedback input, every motion step. The setpoint is where the
+    lag model has the servo, so the loop leaves the lag alone (the lead takes care of that) and only
+    corrects what the model does not know: backlash, a load that drags the servo off, wind. The
+    correction is added to the pulse sent (RotorServo::correct()), limited to LOOP_LIMIT degrees and
+    the servo range. The integral only runs while that limit does not hold the output (anti-windup).
+    Measured that far off for STALL_TIME is a stall: the loop lets go until the axis is back near
+    the model, the caller stops the axis.
+*/
+class AxisLoop {
+
+public:
+  /// @param limit, stallError degrees
+  /// @param stallTime ms, 0 for no stall detection
+  void configure(float kp, float ki, float kd, float limit, float stallError, uint32_t stallTime) {
+    _kp = kp;
+    _ki = ki;
+    _kd = kd;
+    _limit = limit;
+    _stallError = stallError;
+    _stallTime = stallTime;
+  }
+
+  /// @brief Any gain set
+  bool enabled() const { return _kp > 0 or _ki > 0 or _kd > 0; }
+
+  /// @brief One step, after the feedback was sampled and the lag stepped
+  /// @param hold an identification moves the axis, the loop keeps out
+  /// @return true when the axis just stalled
+  bool run(RotorServo &servo, const AxisLag &lag, float dt, bool hold) {
+    float measured;
+    if (hold or dt <= 0.0 or !lag.measured(measured)) {
+      reset(servo);
+      _stalled = false;
+      return false;
+    }
+    float k = servo.pulsesPerDegree();
+    float error = lag.pulse() - measured;    // pulses
+    _error = error / k;
+
+    // Stall detection, also without gains
+    if (_stalled) {
+      if (fabsf(_error) < _stallError / 2) {
+        log_i("%s moves again", lag.axis());
+        _stalled = false;
+      }
+      reset(servo);
+      return false;
+    }
+    if (_stallTime and fabsf(_error) > _stallError) {
+      if (!_off) _offSince = millis();
+      _off = true;
+      if (millis() - _offSince >= _stallTime) {
+        _stalled = true;
+        ++_stalls;
+        reset(servo);
+        return true;
+      }
+    } else {
+      _off = false;
+    }
+
+    if (!enabled()) {
+      reset(servo);
+      return false;
+    }
+
+    // The setpoint comes out of the lag model so it has no steps, the derivative is that of the error
+    float rate = _primed ? (error - _lastError) / dt : 0.0f;
+    _lastError = error;
+    _primed = true;
+    _rate += (1 - expf(-dt / LOOP_RATE_FILTER)) * (rate - _rate);
+
+    // What the correction can be: the loop limit, and what is left of the servo range
+    float high = std::min(_limit * k, (float)(servo.getMax() - servo.getCurrent()));
+    float low = std::max(-_limit * k, (float)(servo.getMin() - servo.getCurrent()));
+    float output = _kp * error + _integral + _kd * _rate;
+    if (!(output >= high and error > 0) and !(output <= low and error < 0))
+      _integral = constrain(_integral + _ki * error * dt, low, high);
+    output = constrain(_kp * error + _integral + _kd * _rate, low, high);
+    servo.correct(lroundf(output));
+    return false;
+  }
+
+  /// @brief No correction, the loop starts over
+  void reset(RotorServo &servo) {
+    servo.correct(0);
+    _integral = 0.0;
+    _rate = 0.0;
+    _primed = false;
+    _off = false;
+  }
+
+  bool stalled() const { return _stalled; }
+  uint32_t stalls() const { return _stalls; }
+  /// @brief Model - measured (degrees) of the last step
+  float error() const { return _error; }
+
+private:
+  float _kp = 0.0, _ki = 0.0, _kd = 0.0;
+  float _limit = 0.0, _stallError = 0.0;
+  uint32_t _stallTime = 0;
+  float _integral = 0.0;        // pulses
+  float _lastError = 0.0, _rate = 0.0;
+  bool _primed = false;
+  float _error = 0.0;
+  bool _off = false, _stalled = false;
+  uint32_t _offSince = 0;
+  volatile uint32_t _stalls = 0;
+};
@@ -0,0 +1,480 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <history.h>
+#include <journal.h>
+#include <motiontask.h>
+#include <rotorservo.h>
+#include <satdump.h>
+#include <scheduler.h>
+#include <stellarium.h>
+#include <telemetry.h>
+
+#define CONFIG_PATH         "/config.ini"
+#define CONFIG_FILE_SIZE    4096    // bytes, largest config accepted by POST /config
+#define CONFIG_LINE_LENGTH  128     // bytes, longer lines are an error
+#define CONFIG_NAME_LENGTH  8       // Axis names
+#define CONFIG_MAX_ERRORS   16      // Reported, the rest is counted
+#define AXIS_SECTION        "axis "
+
+#define DEFAULT_SSID        "ESP32-Hotspot"
+#define DEFAULT_PASSWORD    "12345678"
+
+enum ConfigType : uint8_t { CT_INT, CT_FLOAT, CT_BOOL, CT_TEXT };
+
+// Flags of a key
+#define CF_LIVE         0x01    // Applied by POST /config, the others need a restart
+#define CF_REQUIRED     0x02    // No default, an axis must have it
+#define CF_NONZERO      0x04    // 0 is in the range but not allowed (DIRECTION)
+#define CF_OBSOLETE     0x08    // Still accepted, ignored with a warning
+
+/// @brief One servo axis, from [axis NAME] or the SERVO_ALT_.../SERVO_AZ_... keys of older files
+struct AxisConfig {
+  char     name[CONFIG_NAME_LENGTH] = "";
+  int32_t  pin = 0, slot = -1;          // slot -1: the next free one
+  int32_t  degrees = 0, min = 500, max = 2500, direction = 1;
+  int32_t  calibration = 0;             // Pulse at OFFSET degrees, only used when given
+  int32_t  feedback = -1;               // ADC1 pin of a potentiometer on the axis, -1 for none
+  int32_t  encoderCs = -1;              // Chip select of an AS5048A encoder on the axis instead, -1 for none
+  float    offset = 0.0, speed = DEFAULT_MAX_SPEED, accel = DEFAULT_MAX_ACCEL, jerk = DEFAULT_MAX_JERK;
+  bool     smooth = true;
+  // Closed loop on the feedback, off while the gains are 0
+  float    kp = 0.0, ki = 0.0, kd = 0.0;
+  float    loopLimit = 5.0;             // degrees the loop may correct
+  float    stallError = 5.0;            // degrees off for stallTime ms is a stall
+  int32_t  stallTime = 2000;            // 0 for no stall detection
+  bool     own = false;                 // Has an [axis NAME] section
+  uint32_t given = 0;                   // Bit per key in AXIS_KEYS that was in the file
+
+  /// @brief Was the key in the file
+  bool has(const char *key) const;
+};
+
+/// @brief Everything in config.ini
+struct RotorConfig {
+  char       ssid[33] = DEFAULT_SSID;
+  char       password[65] = DEFAULT_PASSWORD;
+  int32_t    telemetryRate = 10;
+  // Target sources: priority, higher wins and 0 is off, and ms without a sample before it is stale, 0 for never
+  int32_t    onboardPriority = 4, rotctldPriority = 3, webPriority = 2, stellariumPriority = 1;
+  int32_t    rotctldTimeout = ROTCTLD_TARGET_TIMEOUT, webTimeout = 0, stellariumTimeout = STELLARIUM_STALE;
+  bool       estimator = true;
+  int32_t    predictionHorizon = 0;
+  bool       leadCompensation = true;   // Command ahead by the identified servo lag
+  float      measurementNoise = 0.05, processNoise = 1.0;
+  bool       refraction = true;
+  float      latitude = 0.0, longitude = 0.0, altitude = 0.0;
+  int32_t    motionRate = 1000 / UPDATE_INTERVAL;
+  int32_t    historySize = HISTORY_SIZE;
+  int32_t    encoderSck = 18, encoderMiso = 19, encoderMosi = 23;   // SPI bus of the encoders
+  AxisConfig axis[MAX_AXES];            // ALT and AZ first
+  uint8_t    axes = 0;
+
+  /// @return nullptr when there is no such axis
+  const AxisConfig *find(const char *name) const {
+    for (uint8_t i = 0; i < axes; ++i)
+      if (strcmp(axis[i].name, name) == 0) return &axis[i];
+    return nullptr;
+  }
+};
+
+/// @brief A key of the schema, the default is what RotorConfig and AxisConfig start with
+struct ConfigKey {
+  const char *section;  // nullptr for the keys of an axis
+  const char *key;
+  ConfigType  type;
+  uint8_t     flags;
+  uint16_t    offset;   // In RotorConfig, or AxisConfig
+  uint8_t     size;     // Bytes of a text, with the 0
+  float       min, max;
+};
+
+#define CONFIG_KEY(section, key, type, member, flags, min, max) \
+  {section, key, type, flags, offsetof(RotorConfig, member), 0, min, max}
+#define CONFIG_TEXT(section, key, member, flags) \
+  {section, key, CT_TEXT, flags, offsetof(RotorConfig, member), sizeof(RotorConfig::member), 0, 0}
+#define AXIS_KEY(key, type, member, flags, min, max) \
+  {nullptr, key, type, flags, offsetof(AxisConfig, member), 0, min, max}
+
+inline const ConfigKey CONFIG_KEYS[] = {
+  CONFIG_TEXT("network", "WIFI_SSID", ssid, 0),
+  CONFIG_TEXT("network", "WIFI_PASSWORD", password, 0),
+  CONFIG_KEY("network", "TELEMETRY_RATE", CT_INT, telemetryRate, 0, 0, TELEMETRY_RATE_MAX),
+  CONFIG_KEY("sources", "ONBOARD", CT_INT, onboardPriority, CF_LIVE, 0, 9),
+  CONFIG_KEY("sources", "ROTCTLD", CT_INT, rotctldPriority, CF_LIVE, 0, 9),
+  CONFIG_KEY("sources", "WEB", CT_INT, webPriority, CF_LIVE, 0, 9),
+  CONFIG_KEY("sources", "STELLARIUM", CT_INT, stellariumPriority, CF_LIVE, 0, 9),
+  CONFIG_KEY("sources", "ROTCTLD_TIMEOUT", CT_INT, rotctldTimeout, CF_LIVE, 0, 600000),
+  CONFIG_KEY("sources", "WEB_TIMEOUT", CT_INT, webTimeout, CF_LIVE, 0, 600000),
+  CONFIG_KEY("sources", "STELLARIUM_TIMEOUT", CT_INT, stellariumTimeout, CF_LIVE, 0, 600000),
+  {"mode", "STELLARIUM_MODE", CT_BOOL, CF_OBSOLETE, 0, 0, 0, 1},    // All sources run at once now, see [sources]
+  CONFIG_KEY("tracking", "ESTIMATOR", CT_BOOL, estimator, CF_LIVE, 0, 1),
+  CONFIG_KEY("tracking", "PREDICTION_HORIZON", CT_INT, predictionHorizon, CF_LIVE, -5000, 5000),
+  CONFIG_KEY("tracking", "LEAD_COMPENSATION", CT_BOOL, leadCompensation, CF_LIVE, 0, 1),
+  CONFIG_KEY("tracking", "MEASUREMENT_NOISE", CT_FLOAT, measurementNoise, CF_LIVE, 0.001, 10),
+  CONFIG_KEY("tracking", "PROCESS_NOISE", CT_FLOAT, processNoise, CF_LIVE, 0.001, 1000),
+  CONFIG_KEY("tracking", "REFRACTION", CT_BOOL, refraction, CF_LIVE, 0, 1),
+  CONFIG_KEY("location", "LATITUDE", CT_FLOAT, latitude, CF_LIVE, -90, 90),
+  CONFIG_KEY("location", "LONGITUDE", CT_FLOAT, longitude, CF_LIVE, -180, 180),
+  CONFIG_KEY("location", "ALTITUDE", CT_FLOAT, altitude, CF_LIVE, -500, 9000),
+  CONFIG_KEY("servo", "MOTION_RATE", CT_INT, motionRate, 0, MOTION_RATE_MIN, MOTION_RATE_MAX),
+  CONFIG_KEY("servo", "HISTORY_SIZE", CT_INT, historySize, 0, 0, 256),
+  CONFIG_KEY("encoder", "SCK", CT_INT, encoderSck, 0, 0, 33),
+  CONFIG_KEY("encoder", "MISO", CT_INT, encoderMiso, 0, 0, 39),
+  CONFIG_KEY("encoder", "MOSI", CT_INT, encoderMosi, 0, 0, 33),
+};
+
+inline const ConfigKey AXIS_KEYS[] = {
+  AXIS_KEY("PIN", CT_INT, pin, CF_REQUIRED, 0, 39),
+  AXIS_KEY("SLOT", CT_INT, slot, 0, 0, JOURNAL_SLOTS - 1),
+  AXIS_KEY("DEGREES", CT_INT, degrees, CF_LIVE | CF_REQUIRED, 100, 360),
+  AXIS_KEY("MIN", CT_INT, min, CF_LIVE, 300, 1000),
+  AXIS_KEY("MAX", CT_INT, max, CF_LIVE, 1500, 3500),
+  AXIS_KEY("DIRECTION", CT_INT, direction, CF_LIVE | CF_NONZERO, -1, 1),
+  AXIS_KEY("OFFSET", CT_FLOAT, offset, CF_LIVE, -360, 360),
+  AXIS_KEY("CALIBRATION", CT_INT, calibration, CF_LIVE, 300, 3500),
+  AXIS_KEY("SMOOTH", CT_BOOL, smooth, CF_LIVE, 0, 1),
+  AXIS_KEY("MAX_SPEED", CT_FLOAT, speed, CF_LIVE, 0.1, 1000),
+  AXIS_KEY("MAX_ACCEL", CT_FLOAT, accel, CF_LIVE, 0.1, 10000),
+  AXIS_KEY("MAX_JERK", CT_FLOAT, jerk, CF_LIVE, 0, 100000),   // 0 for no jerk limit
+  AXIS_KEY("FEEDBACK", CT_INT, feedback, 0, 32, 39),          // ADC1, ADC2 does not work with the WiFi on
+  AXIS_KEY("ENCODER_CS", CT_INT, encoderCs, 0, 0, 33),
+  AXIS_KEY("LOOP_KP", CT_FLOAT, kp, CF_LIVE, 0, 10),
+  AXIS_KEY("LOOP_KI", CT_FLOAT, ki, CF_LIVE, 0, 100),          // 1/s
+  AXIS_KEY("LOOP_KD", CT_FLOAT, kd, CF_LIVE, 0, 1),            // s
+  AXIS_KEY("LOOP_LIMIT", CT_FLOAT, loopLimit, CF_LIVE, 0, 45),
+  AXIS_KEY("STALL_ERROR", CT_FLOAT, stallError, CF_LIVE, 0.1, 90),
+  AXIS_KEY("STALL_TIME", CT_INT, stallTime, CF_LIVE, 0, 60000),
+};
+static_assert(sizeof(AXIS_KEYS) / sizeof(ConfigKey) <= 32, "AxisConfig::given has a bit per axis key");
+
+inline bool AxisConfig::has(const char *key) const {
+  for (uint8_t k = 0; k < sizeof(AXIS_KEYS) / sizeof(ConfigKey); ++k)
+    if (strcmp(AXIS_KEYS[k].key, key) == 0) return given & (1ul << k);
+  return false;
+}
+
+/*
+    Reads config.ini in one pass, a line at a time through a fixed buffer, straight into a
+    RotorConfig. Every key is in the schema above with its type and range, so a typo in a name or
+    a value out of range is reported with its line instead of silently becoming a default. The
+    good lines are still used.
+    The same parser checks a new config for POST /config, compare() and copyLive() then tell what
+    can be applied right away.
+*/
+class ConfigParser {
+
+public:
+  /// @brief Start a config: the defaults with the ALT and AZ axes
+  static void defaults(RotorConfig &config) {
+    config = RotorConfig();
+    _axis(config, "ALT");
+    _axis(config, "AZ");
+  }
+
+  /// @brief Parse a file over the config
+  /// @return false when the file can't be read or had errors, see getError()
+  bool load(fs::FS &fs, const char *path, RotorConfig &config) {
+    _reset();
+    File file = fs.open(path, "r");
+    if (!file or file.isDirectory()) {
+      _error(0, String("Could not open ") + path);
+      return false;
+    }
+    char line[CONFIG_LINE_LENGTH];
+    size_t length = 0;
+    bool tooLong = false;
+    while (true) {
+      int c = file.read();
+      if (c < 0 or c == '\n') {
+        _line(line, length, tooLong, config);
+        length = 0;
+        tooLong = false;
+        if (c < 0) break;
+      } else if (length < sizeof(line) - 1) {
+        line[length++] = c;
+      } else {
+        tooLong = true;
+      }
+    }
+    file.close();
+    return _finish(config);
+  }
+
+  /// @brief Parse text (e.g. a request body) over the config
+  /// @return false when there were errors, see getError()
+  bool parse(const char *text, size_t size, RotorConfig &config) {
+    _reset();
+    char line[CONFIG_LINE_LENGTH];
+    size_t at = 0;
+    while (at < size) {
+      const char *end = (const char *)memchr(text + at, '\n', size - at);
+      size_t length = (end ? end - text : size) - at;
+      bool tooLong = length >= sizeof(line);
+      if (tooLong) length = sizeof(line) - 1;
+      memcpy(line, text + at, length);
+      _line(line, length, tooLong, config);
+      at = end ? end - text + 1 : size;
+    }
+    return _finish(config);
+  }
+
+  /// @brief One line per error, "line 12: ..."
+  const String &getError() const { return _errors; }
+  uint16_t errorCount() const { return _errorCount; }
+
+  /// @brief Keys that differ between two configs
+  /// @param live receives the ones that can be applied right away, comma separated
+  /// @param restart receives the ones that need a restart
+  static void compare(const RotorConfig &from, const RotorConfig &to, String &live, String &restart) {
+    live = restart = "";
+    for (const ConfigKey &key : CONFIG_KEYS) {
+      if (key.flags & CF_OBSOLETE or _same(key, &from, &to)) continue;
+      _list(key.flags & CF_LIVE ? live : restart, key.key);
+    }
+    if (!_sameAxes(from, to)) {
+      _list(restart, "axes");
+      return;
+    }
+    for (uint8_t i = 0; i < from.axes; ++i) {
+      for (const ConfigKey &key : AXIS_KEYS) {
+        if (_same(key, &from.axis[i], &to.axis[i])) continue;
+        _list(key.flags & CF_LIVE ? live : restart, String(from.axis[i].name) + "." + key.key);
+      }
+    }
+  }
+
+  /// @brief Take the keys that can be applied without a restart, the others keep their value
+  static void copyLive(RotorConfig &to, const RotorConfig &from) {
+    for (const ConfigKey &key : CONFIG_KEYS)
+      if (key.flags & CF_LIVE and !(key.flags & CF_OBSOLETE)) memcpy((uint8_t *)&to + key.offset, (const uint8_t *)&from + key.offset, _size(key));
+    if (!_sameAxes(to, from)) return;
+    for (uint8_t i = 0; i < to.axes; ++i) {
+      for (uint8_t k = 0; k < sizeof(AXIS_KEYS) / sizeof(ConfigKey); ++k) {
+        const ConfigKey &key = AXIS_KEYS[k];
+        if (!(key.flags & CF_LIVE)) continue;
+        memcpy((uint8_t *)&to.axis[i] + key.offset, (const uint8_t *)&from.axis[i] + key.offset, _size(key));
+        to.axis[i].given = (to.axis[i].given & ~(1ul << k)) | (from.axis[i].given & (1ul << k));
+      }
+    }
+  }
+
+private:
+
+  void _reset() {
+    _errors = "";
+    _errorCount = 0;
+    _number = 0;
+    _section = "";
+    _sectionAxis = -1;
+    _skip = false;
+  }
+
+  void _error(uint16_t line, const String &error) {
+    if (++_errorCount > CONFIG_MAX_ERRORS) return;
+    if (_errors != "") _errors += "\n";
+    _errors += line ? "line " + String(line) + ": " + error : error;
+  }
+
+  /// @brief Check what can only be checked at the end
+  bool _finish(RotorConfig &config) {
+    for (uint8_t i = 0; i < config.axes; ++i) {
+      const AxisConfig &axis = config.axis[i];
+      for (uint8_t k = 0; k < sizeof(AXIS_KEYS) / sizeof(ConfigKey); ++k)
+        if (AXIS_KEYS[k].flags & CF_REQUIRED and !(axis.given & (1ul << k)))
+          _error(0, String("[axis ") + axis.name + "] has no " + AXIS_KEYS[k].key);
+      if (axis.has("CALIBRATION") and (axis.calibration < axis.min or axis.calibration > axis.max))
+        _error(0, String("[axis ") + axis.name + "] CALIBRATION is not between MIN and MAX");
+      if (axis.has("FEEDBACK") and axis.has("ENCODER_CS"))
+        _error(0, String("[axis ") + axis.name + "] has both FEEDBACK and ENCODER_CS");
+    }
+    if (_errorCount > CONFIG_MAX_ERRORS) _errors += "\n" + String(_errorCount - CONFIG_MAX_ERRORS) + " more errors";
+    return _errorCount == 0;
+  }
+
+  void _line(char *line, size_t length, bool tooLong, RotorConfig &config) {
+    _number++;
+    line[length] = 0;
+    char *text = _trim(line);
+    if (!*text or *text == ';' or *text == '#') return;
+    if (tooLong) {
+      _error(_number, "Line longer than " + String(CONFIG_LINE_LENGTH - 1) + " characters");
+      return;
+    }
+
+    if (*text == '[') {
+      char *end = strchr(text, ']');
+      if (!end) {
+        _error(_number, "No ] after the section name");
+        _skip = true;
+        return;
+      }
+      *end = 0;
+      _section = _trim(text + 1);
+      _sectionAxis = -1;
+      _skip = false;
+      if (_section.startsWith(AXIS_SECTION)) {
+        String name = _section.substring(strlen(AXIS_SECTION));
+        name.trim();
+        _sectionAxis = _axis(config, name);
+        if (_sectionAxis < 0) {
+          _error(_number, "Can't add axis " + name + ", too many or a name longer than " + String(CONFIG_NAME_LENGTH - 1));
+          _skip = true;
+          return;
+        }
+        config.axis[_sectionAxis].own = true;
+        return;
+      }
+      bool known = _section == "pin";
+      for (const ConfigKey &key : CONFIG_KEYS) known |= _section == key.section;
+      if (!known) {
+        _error(_number, "Unknown section [" + _section + "]");
+        _skip = true;
+      }
+      return;
+    }
+    if (_skip) return;   // Reported at the section
+
+    char *equals = strchr(text, '=');
+    if (!equals) {
+      _error(_number, "No = in the line");
+      return;
+    }
+    *equals = 0;
+    String key = _trim(text);
+    char *value = _trim(equals + 1);
+
+    if (_sectionAxis >= 0) {
+      _axisValue(_sectionAxis, key, value, config);
+      return;
+    }
+
+    for (const ConfigKey &k : CONFIG_KEYS) {
+      if (_section != k.section or key != k.key) continue;
+      _value(k, (uint8_t *)&config, value);
+      return;
+    }
+
+    // SERVO_ALT_DEGREES in [servo] and PIN_SERVO_ALT in [pin] of the older files
+    for (const char *name : {"ALT", "AZ"}) {
+      String prefix = String("SERVO_") + name + "_";
+      if (_section == "servo" and key.startsWith(prefix) and _axisKey(key.c_str() + prefix.length()) >= 0) {
+        _axisValue(_axis(config, name), key.substring(prefix.length()), value, config);
+        return;
+      }
+      if (_section == "pin" and key == String("PIN_SERVO_") + name) {
+        _axisValue(_axis(config, name), "PIN", value, config);
+        return;
+      }
+    }
+    _error(_number, "Unknown key " + key + " in [" + _section + "]");
+  }
+
+  void _axisValue(int8_t axis, const String &key, const char *value, RotorConfig &config) {
+    int8_t k = _axisKey(key.c_str());
+    if (k < 0) {
+      _error(_number, "Unknown axis key " + key);
+      return;
+    }
+    if (_value(AXIS_KEYS[k], (uint8_t *)&config.axis[axis], value)) config.axis[axis].given |= 1ul << k;
+  }
+
+  /// @brief Check a value and store it
+  bool _value(const ConfigKey &key, uint8_t *base, const char *value) {
+    if (key.flags & CF_OBSOLETE) {
+      log_w("line %u: %s is no longer used, ignored", _number, key.key);
+      return true;
+    }
+    void *to = base + key.offset;
+    if (key.type == CT_TEXT) {
+      if (strlen(value) >= key.size) {
+        _error(_number, String(key.key) + " is longer than " + String(key.size - 1) + " characters");
+        return false;
+      }
+      strlcpy((char *)to, value, key.size);
+      return true;
+    }
+
+    char *end;
+    double number = key.type == CT_FLOAT ? strtod(value, &end) : strtol(value, &end, 10);
+    if (end == value or !_comment(end)) {
+      _error(_number, String(key.key) + " = " + value + " is not " + (key.type == CT_FLOAT ? "a number" : "a whole number"));
+      return false;
+    }
+    if (number < key.min or number > key.max or (key.flags & CF_NONZERO and number == 0)) {
+      _error(_number, String(key.key) + " = " + value + " is not " + (key.flags & CF_NONZERO ? "-1 or 1" :
+                      "between " + String(key.min, key.type == CT_FLOAT ? 3 : 0) + " and " + String(key.max, key.type == CT_FLOAT ? 3 : 0)));
+      return false;
+    }
+    switch (key.type) {
+      case CT_INT:   *(int32_t *)to = number; break;
+      case CT_FLOAT: *(float *)to = number; break;
+      case CT_BOOL:  *(bool *)to = number; break;
+      default:       break;
+    }
+    return true;
+  }
+
+  /// @brief Only spaces or a comment after a number
+  static bool _comment(const char *text) {
+    while (*text == ' ' or *text == '\t' or *text == '\r') text++;
+    return !*text or *text == ';' or *text == '#' or (text[0] == '/' and text[1] == '/');
+  }
+
+  static char *_trim(char *text) {
+    while (isspace((unsigned char)*text)) text++;
+    char *end = text + strlen(text);
+    while (end > text and isspace((unsigned char)end[-1])) *--end = 0;
+    return text;
+  }
+
+  /// @brief Find or add an axis
+  /// @return its index, -1 when there is no room
+  static int8_t _axis(RotorConfig &config, const String &name) {
+    for (uint8_t i = 0; i < config.axes; ++i)
+      if (name == config.axis[i].name) return i;
+    if (config.axes >= MAX_AXES or name.length() == 0 or name.length() >= CONFIG_NAME_LENGTH) return -1;
+    AxisConfig &axis = config.axis[config.axes];
+    axis = AxisConfig();
+    strlcpy(axis.name, name.c_str(), sizeof(axis.name));
+    return config.axes++;
+  }
+
+  static int8_t _axisKey(const char *key) {
+    for (uint8_t k = 0; k < sizeof(AXIS_KEYS) / sizeof(ConfigKey); ++k)
+      if (strcmp(AXIS_KEYS[k].key, key) == 0) return k;
+    return -1;
+  }
+
+  static size_t _size(const ConfigKey &key) {
+    switch (key.type) {
+      case CT_INT:   return sizeof(int32_t);
+      case CT_FLOAT: return sizeof(float);
+      case CT_BOOL:  return sizeof(bool);
+      default:       return key.size;
+    }
+  }
+
+  static bool _same(const ConfigKey &key, const void *a, const void *b) {
+    return memcmp((const uint8_t *)a + key.offset, (const uint8_t *)b + key.offset, _size(key)) == 0;
+  }
+
+  static bool _sameAxes(const RotorConfig &a, const RotorConfig &b) {
+    if (a.axes != b.axes) return false;
+    for (uint8_t i = 0; i < a.axes; ++i)
+      if (strcmp(a.axis[i].name, b.axis[i].name) or a.axis[i].own != b.axis[i].own) return false;
+    return true;
+  }
+
+  static void _list(String &list, const String &item) {
+    if (list != "") list += ", ";
+    list += item;
+  }
+
+  String   _errors;
+  uint16_t _errorCount = 0;
+  uint16_t _number = 0;         // Of the current line
+  String   _section;
+  int8_t   _sectionAxis = -1;   // Index of the axis of an [axis NAME] section
+  bool     _skip = false;       // Bad section, its keys are not reported
+};
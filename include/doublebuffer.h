@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+/*
+    Single writer double buffer for small POD structs shared between the cores.
+    The writer fills the back slot and then publishes it by bumping the version, a reader copies
+    the front slot and retries when a newer value was published during the copy. Every reader
+    keeps its own version, so there can be more than one.
+    Neither side takes a lock, the writer never waits and the reader only repeats a memcpy.
+*/
+template <typename T>
+class DoubleBuffer {
+
+public:
+    /// @brief Publish a new value (writer side)
+    void write(const T &value) {
+        uint32_t next = _version.load(std::memory_order_relaxed) + 1;
+        _slots[next & 1] = value;
+        _version.store(next, std::memory_order_release);
+    }
+
+    /// @brief Copy the latest value if it is newer than version (reader side)
+    /// @param value receives the copy
+    /// @param version version last seen by the reader, updated on success
+    /// @return true when there was a new value
+    bool read(T &value, uint32_t &version) const {
+        while (true) {
+            uint32_t v1 = _version.load(std::memory_order_acquire);
+            if (v1 == version) return false;
+            value = _slots[v1 & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t v2 = _version.load(std::memory_order_relaxed);
+            if (v2 == v1) {     // Slot v1&1 is only written again after publication v1+1
+                version = v1;
+                return true;
+            }
+        }
+    }
+
+    uint32_t version() const { return _version.load(std::memory_order_acquire); }
+
+private:
+    T _slots[2];
+    std::atomic<uint32_t> _version{0};
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <Arduino.h>
+
+#define ESTIMATOR_MAX_EXTRAPOLATION  3000   // ms, don't run ahead further than this when samples stop
+#define ESTIMATOR_JUMP               5.0    // degrees, a bigger innovation is a new target: restart
+
+/*
+    Constant acceleration Kalman filter for one axis.
+    Takes timestamped target samples (about 1 Hz from Stellarium or rotctld), filters the jitter
+    and estimates angle, rate and acceleration, so a setpoint can be handed to the servo for any
+    moment between and shortly after the samples.
+    For azimuth the angles wrap at 360 degrees, innovations are taken the short way round.
+*/
+class AxisEstimator {
+
+public:
+    /// @brief Set the filter parameters
+    /// @param measurementNoise standard deviation of the samples in degrees
+    /// @param processNoise spectral density of the jerk in (degrees/s^3)^2/Hz, higher follows changes faster
+    /// @param wrap true for an axis that wraps at 360 degrees (azimuth)
+    void configure(float measurementNoise, float processNoise, bool wrap) {
+        _r = measurementNoise * measurementNoise;
+        _q = processNoise;
+        _wrap = wrap;
+        reset();
+    }
+
+    void reset() { _valid = false; }
+
+    /// @brief Add a sample
+    /// @param timeMs millis() when the sample was taken
+    /// @param degrees sampled angle
+    void update(unsigned long timeMs, float degrees) {
+        if (!_valid) {
+            _start(timeMs, degrees);
+            return;
+        }
+
+        float dt = (long)(timeMs - _time) / 1000.0;
+        if (dt < 0) dt = 0;
+        _predict(dt);
+        _time = timeMs;
+
+        float innovation = degrees - _x[0];
+        if (_wrap) innovation = _wrap180(innovation);
+
+        if (fabs(innovation) > ESTIMATOR_JUMP) { // New object or a slew, start over
+            log_d("Estimator restart, innovation %0.2f", innovation);
+            _start(timeMs, degrees);
+            return;
+        }
+
+        // Kalman gain for a position measurement, H = [1 0 0]
+        float s = _P[0][0] + _r;
+        float k[3] = {_P[0][0] / s, _P[1][0] / s, _P[2][0] / s};
+
+        for (int i = 0; i < 3; ++i) _x[i] += k[i] * innovation;
+
+        // P = (I - K.H) P
+        float row0[3] = {_P[0][0], _P[0][1], _P[0][2]};
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                _P[i][j] -= k[i] * row0[j];
+
+        if (_wrap) _x[0] = _wrap360(_x[0]);
+        _samples++;
+    }
+
+    /// @brief Estimated angle at a moment, interpolated or extrapolated from the last sample
+    float predict(unsigned long timeMs) const {
+        if (!_valid) return 0.0;
+        long ms = (long)(timeMs - _time);
+        if (ms > ESTIMATOR_MAX_EXTRAPOLATION) ms = ESTIMATOR_MAX_EXTRAPOLATION;
+        float dt = ms / 1000.0;
+        // Until a second sample arrived the rate is unknown
+        float value = _samples > 1 ? _x[0] + _x[1] * dt + 0.5 * _x[2] * dt * dt : _x[0];
+        return _wrap ? _wrap360(value) : value;
+    }
+
+    float rate() const { return _valid ? _x[1] : 0.0; }            // degrees/s
+    float acceleration() const { return _valid ? _x[2] : 0.0; }    // degrees/s^2
+    bool valid() const { return _valid; }
+    unsigned long lastSample() const { return _time; }
+
+private:
+
+    void _start(unsigned long timeMs, float degrees) {
+        _x[0] = _wrap ? _wrap360(degrees) : degrees;
+        _x[1] = _x[2] = 0.0;
+        memset(_P, 0, sizeof(_P));
+        _P[0][0] = _r;
+        _P[1][1] = 1.0;     // (degrees/s)^2, anything up to a fast LEO pass
+        _P[2][2] = 0.1;     // (degrees/s^2)^2
+        _time = timeMs;
+        _samples = 1;
+        _valid = true;
+    }
+
+    // x = F x, P = F P F' + Q with the white jerk model
+    void _predict(float dt) {
+        float dt2 = dt * dt, dt3 = dt2 * dt;
+
+        _x[0] += _x[1] * dt + 0.5 * _x[2] * dt2;
+        _x[1] += _x[2] * dt;
+
+        float F[3][3] = {{1, dt, 0.5f * dt2}, {0, 1, dt}, {0, 0, 1}};
+        float FP[3][3];
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                FP[i][j] = F[i][0] * _P[0][j] + F[i][1] * _P[1][j] + F[i][2] * _P[2][j];
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                _P[i][j] = FP[i][0] * F[j][0] + FP[i][1] * F[j][1] + FP[i][2] * F[j][2];
+
+        float dt4 = dt3 * dt, dt5 = dt4 * dt;
+        float Q[3][3] = {{dt5 / 20, dt4 / 8, dt3 / 6}, {dt4 / 8, dt3 / 3, dt2 / 2}, {dt3 / 6, dt2 / 2, dt}};
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                _P[i][j] += _q * Q[i][j];
+    }
+
+    static float _wrap180(float d) {
+        while (d > 180.0) d -= 360.0;
+        while (d < -180.0) d += 360.0;
+        return d;
+    }
+
+    static float _wrap360(float d) {
+        while (d >= 360.0) d -= 360.0;
+        while (d < 0.0) d += 360.0;
+        return d;
+    }
+
+    float   _x[3] = {0, 0, 0};  // angle, rate, acceleration
+    float   _P[3][3];
+    float   _q = 1.0, _r = 0.0025;
+    bool    _wrap = false, _valid = false;
+    unsigned long _time = 0;
+    uint32_t _samples = 0;
+};
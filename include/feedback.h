@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+#include <SPI.h>
+
+#define FEEDBACK_ADC_READS    4         // Averaged per potentiometer reading
+#define ENCODER_MODULUS       16384     // Counts per turn of an AS5048A
+#define ENCODER_SPI_CLOCK     1000000
+#define ENCODER_READ_ANGLE    0xFFFF    // Read of register 0x3FFF with its parity bit
+#define ENCODER_NOP           0x0000
+#define ENCODER_CLEAR_ERROR   0x4001    // Read of the error register, which clears the flag
+
+/*
+    Where an axis really is: a potentiometer on an ADC1 pin, or an AS5048A magnetic encoder on the
+    SPI bus with its own chip select. The encoder counts a full turn and wraps, modulus() tells the
+    calibration where. An I2C encoder (AS5600) has a fixed address, so only one would fit on a bus.
+*/
+class FeedbackInput {
+
+public:
+  /// @brief Pins of the encoder bus, once before any encoder is used
+  static void beginBus(int8_t sck, int8_t miso, int8_t mosi) {
+    SPI.begin(sck, miso, mosi);
+  }
+
+  void beginAdc(int8_t pin) {
+    _pin = pin;
+    _encoder = false;
+  }
+
+  void beginEncoder(int8_t cs) {
+    _pin = cs;
+    _encoder = true;
+    pinMode(cs, OUTPUT);
+    digitalWrite(cs, HIGH);
+  }
+
+  bool present() const { return _pin >= 0; }
+  bool encoder() const { return _encoder; }
+  /// @brief Counts after which the reading wraps, 0 when it does not
+  uint16_t modulus() const { return _encoder ? ENCODER_MODULUS : 0; }
+
+  /// @brief Raw reading, false when the encoder flags an error or the frame is corrupt
+  bool read(uint16_t &raw) {
+    if (!present()) return false;
+    if (!_encoder) {
+      uint32_t sum = 0;
+      for (uint8_t i = 0; i < FEEDBACK_ADC_READS; ++i) sum += analogRead(_pin);
+      raw = sum / FEEDBACK_ADC_READS;
+      return true;
+    }
+    // The encoder answers a command in the next frame
+    _frame(ENCODER_READ_ANGLE);
+    uint16_t response = _frame(ENCODER_NOP);
+    if (__builtin_parity(response) or response & 0x4000) {
+      _frame(ENCODER_CLEAR_ERROR);
+      ++_errors;
+      return false;
+    }
+    raw = response & 0x3FFF;
+    return true;
+  }
+
+  /// @brief Failed encoder reads since the start
+  uint32_t errors() const { return _errors; }
+
+private:
+  uint16_t _frame(uint16_t command) {
+    SPI.beginTransaction(SPISettings(ENCODER_SPI_CLOCK, MSBFIRST, SPI_MODE1));
+    digitalWrite(_pin, LOW);
+    uint16_t response = SPI.transfer16(command);
+    digitalWrite(_pin, HIGH);
+    SPI.endTransaction();
+    return response;
+  }
+
+  int8_t _pin = -1;
+  bool _encoder = false;
+  uint32_t _errors = 0;
+};
@@ -0,0 +1,271 @@
+#pragma once
+#include <Arduino.h>
+
+#define HISTORY_BLOCK_SIZE  1024    // bytes, the ring drops the oldest block when it is full
+#define HISTORY_SIZE        96      // kB, default
+#define HISTORY_FIELDS      6       // See HistorySample
+#define HISTORY_RECORD_MAX  (1 + 5 * (HISTORY_FIELDS + 1))  // Flags and a varint for the time and every field
+#define HISTORY_MAGIC       "RTH1"
+#define HISTORY_NIBBLES     0x80    // Flag, the changes are packed in nibbles instead of varints
+#define HISTORY_MIN_SPAN    600000  // ms the ring holds at least, steps are thinned out to keep it
+
+/// @brief One step of the motion control
+struct HistorySample {
+  uint32_t time = 0;                    // millis()
+  int32_t  value[HISTORY_FIELDS] = {};  // Target alt and az in 0.01 degree, ALT commanded and
+                                        // current pulse, AZ commanded and current pulse (us)
+};
+
+/// @brief A key record followed by deltas, the unit the ring works with
+struct HistoryBlock {
+  uint32_t sequence = 0;                // 0 is an empty block
+  uint32_t time = 0;                    // Of the key record
+  int32_t  key[HISTORY_FIELDS] = {};
+  uint16_t count = 0;                   // Records, the key one included
+  uint16_t used = 0;                    // Bytes in data
+  uint8_t  data[HISTORY_BLOCK_SIZE - 36];
+};
+static_assert(sizeof(HistoryBlock) == HISTORY_BLOCK_SIZE, "HistoryBlock is not HISTORY_BLOCK_SIZE");
+
+/// @brief Start of the binary download, followed by the blocks (header and used data bytes)
+struct HistoryHeader {
+  char     magic[4];
+  uint16_t blockSize;
+  uint16_t period;                      // ms, records without a time delta are this far apart
+  uint8_t  fields;
+  uint8_t  reserved[3];
+  uint32_t now;                         // millis() when the download started
+};
+
+/*
+    Records every motion step in RAM, so a badly tracked pass can be looked at afterwards. A
+    record is only what changed since the one before it: a flags byte with a bit per changed field
+    and one for a time step other than the motion period, followed by the changes as zigzag
+    varints, or two to a byte when they are all small. A step that changes nothing is one byte,
+    tracking mostly two or three, but a step where every field jumps takes up to HISTORY_RECORD_MAX.
+    To hold at least HISTORY_MIN_SPAN whatever the motion, the bytes written in the last
+    HISTORY_MIN_SPAN are kept below what all blocks but one hold. A step that would go over is
+    skipped, the next record then has its own time step, so fast changing motion is thinned out
+    instead of pushing the older steps out. The ring is made of blocks that each start with a key
+    record, so the oldest one can be dropped and any block can be decoded on its own.
+    The motion task writes, the web server copies one block at a time under a short critical
+    section, so a download never holds up the tracking.
+*/
+class PointingHistory {
+
+public:
+  /// @brief Allocate the ring
+  /// @param kilobytes size of the ring, 0 for no history
+  /// @param period of the motion steps in ms
+  bool begin(uint16_t kilobytes, uint16_t period) {
+    _period = period;
+    _count = 0;
+    _windowStart = 1;
+    _windowBytes = 0;
+    if (!kilobytes) return true;
+    // Separate blocks, after the WiFi has started the heap has no large free areas left
+    _blocks = new HistoryBlock *[kilobytes]();
+    for (uint16_t i = 0; i < kilobytes; ++i) {
+      _blocks[i] = (HistoryBlock *)malloc(sizeof(HistoryBlock));
+      if (!_blocks[i]) break;
+      new (_blocks[i]) HistoryBlock();
+      _count++;
+    }
+    if (_count < kilobytes) {
+      log_e("History: only %u of %u kB free", _count, kilobytes);
+      if (_count < 2) return false;
+    }
+    // Once a block is dropped all the others are full and hold newer steps, these must not fit
+    // within HISTORY_MIN_SPAN
+    _limit = (_count - 1) * (sizeof(HistoryBlock::data) - HISTORY_RECORD_MAX);
+    log_i("History: %u kB, %u bytes per %u s", _count, _limit, HISTORY_MIN_SPAN / 1000);
+    return true;
+  }
+
+  /// @brief Add a step (one task only)
+  void record(const HistorySample &sample) {
+    if (_count < 2) return;
+
+    uint8_t record[HISTORY_RECORD_MAX];
+    uint8_t length = 0;
+    HistoryBlock *block = _blocks[_sequence % _count];
+    if (_sequence) {
+      uint8_t flags = 0;
+      length = 1;
+      uint32_t step = sample.time - _last.time;
+      if (step != _period) {
+        flags |= 1 << HISTORY_FIELDS;
+        length += _varint(step, record + length);
+      }
+      uint32_t zigzag[HISTORY_FIELDS];
+      uint8_t changed = 0;
+      bool small = true;
+      for (uint8_t i = 0; i < HISTORY_FIELDS; ++i) {
+        int32_t delta = sample.value[i] - _last.value[i];
+        if (!delta) continue;
+        flags |= 1 << i;
+        zigzag[changed] = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+        small &= zigzag[changed] < 16;
+        changed++;
+      }
+      if (small and changed) {
+        // Tracking moves a little every step, two changes in a byte
+        flags |= HISTORY_NIBBLES;
+        for (uint8_t i = 0; i < changed; i += 2)
+          record[length++] = zigzag[i] | (i + 1 < changed ? zigzag[i + 1] << 4 : 0);
+      } else {
+        for (uint8_t i = 0; i < changed; ++i) length += _varint(zigzag[i], record + length);
+      }
+      record[0] = flags;
+
+      // Blocks that ended before the last HISTORY_MIN_SPAN no longer count
+      while (_windowStart < _sequence) {
+        const HistoryBlock *next = _blocks[(_windowStart + 1) % _count];
+        if ((int32_t)(sample.time - next->time) < HISTORY_MIN_SPAN) break;
+        _windowBytes -= _blocks[_windowStart % _count]->used;
+        _windowStart++;
+      }
+      if (_windowBytes + length > _limit) {
+        _thinned++;
+        return;
+      }
+    }
+
+    portENTER_CRITICAL(&_mux);
+    if (!_sequence or block->used + length > sizeof(block->data)) {
+      // New key record, in the oldest block when all are in use
+      _sequence++;
+      block = _blocks[_sequence % _count];
+      if (_sequence > _count and _windowStart <= _sequence - _count) {
+        // Dropped while still counted, the limit should prevent this
+        _windowBytes -= block->used;
+        _windowStart = _sequence - _count + 1;
+      }
+      block->sequence = _sequence;
+      block->time = sample.time;
+      memcpy(block->key, sample.value, sizeof(block->key));
+      block->count = 1;
+      block->used = 0;
+    } else {
+      memcpy(block->data + block->used, record, length);
+      block->used += length;
+      block->count++;
+      _windowBytes += length;
+    }
+    portEXIT_CRITICAL(&_mux);
+    _last = sample;
+  }
+
+  /// @brief Copy the blocks, oldest first, the last one is still being filled (any task)
+  /// @param since millis(), blocks that end before this are skipped
+  /// @param f called as f(const HistoryBlock &), returns false to stop
+  template <typename F>
+  void forEach(uint32_t since, F f) const {
+    if (_count < 2) return;
+    static HistoryBlock copy;   // Too large for the stack of the web server, only that task reads
+    uint32_t newest = _newest();
+    uint32_t sequence = newest > _count ? newest - _count + 1 : 1;
+    for (; sequence <= _newest(); ++sequence) {
+      // The block after it tells when this one ended
+      const HistoryBlock *next = sequence < _newest() ? _blocks[(sequence + 1) % _count] : nullptr;
+      if (next and (int32_t)(next->time - since) < 0) continue;
+      portENTER_CRITICAL(&_mux);
+      copy = *_blocks[sequence % _count];
+      portEXIT_CRITICAL(&_mux);
+      if (copy.sequence != sequence) continue;    // Overwritten meanwhile
+      if (!f(copy)) return;
+    }
+  }
+
+  /// @brief Decode a block
+  /// @param f called as f(const HistorySample &) for every record
+  template <typename F>
+  static void decode(const HistoryBlock &block, uint16_t period, F f) {
+    HistorySample sample;
+    sample.time = block.time;
+    memcpy(sample.value, block.key, sizeof(sample.value));
+    f(sample);
+    size_t at = 0;
+    for (uint16_t n = 1; n < block.count and at < block.used; ++n) {
+      uint8_t flags = block.data[at++];
+      sample.time += flags & (1 << HISTORY_FIELDS) ? _read(block, at) : period;
+      uint8_t nibble = 0;
+      for (uint8_t i = 0; i < HISTORY_FIELDS; ++i) {
+        if (!(flags & (1 << i))) continue;
+        uint32_t zigzag;
+        if (flags & HISTORY_NIBBLES) {
+          zigzag = nibble++ & 1 ? block.data[at++] >> 4 : block.data[at] & 0x0F;
+        } else {
+          zigzag = _read(block, at);
+        }
+        sample.value[i] += (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+      }
+      if (nibble & 1) at++;   // Odd number of changes, the high nibble is not used
+      f(sample);
+    }
+  }
+
+  HistoryHeader header() const {
+    HistoryHeader header;
+    memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+    header.blockSize = HISTORY_BLOCK_SIZE;
+    header.period = _period;
+    header.fields = HISTORY_FIELDS;
+    memset(header.reserved, 0, sizeof(header.reserved));
+    header.now = millis();
+    return header;
+  }
+
+  uint16_t period() const { return _period; }
+
+  /// @brief Steps skipped to hold HISTORY_MIN_SPAN
+  uint32_t thinned() const { return _thinned; }
+
+  /// @brief Time covered in ms, at least HISTORY_MIN_SPAN once the oldest steps are dropped
+  uint32_t span() const {
+    if (_count < 2 or !_sequence) return 0;
+    uint32_t newest = _newest();
+    uint32_t oldest = newest > _count ? newest - _count + 1 : 1;
+    return _last.time - _blocks[oldest % _count]->time;
+  }
+
+private:
+
+  uint32_t _newest() const {
+    portENTER_CRITICAL(&_mux);
+    uint32_t sequence = _sequence;
+    portEXIT_CRITICAL(&_mux);
+    return sequence;
+  }
+
+  static uint8_t _varint(uint32_t value, uint8_t *out) {
+    uint8_t length = 0;
+    while (value >= 0x80) {
+      out[length++] = (value & 0x7F) | 0x80;
+      value >>= 7;
+    }
+    out[length++] = value;
+    return length;
+  }
+
+  static uint32_t _read(const HistoryBlock &block, size_t &at) {
+    uint32_t value = 0;
+    for (uint8_t shift = 0; at < block.used and shift < 35; shift += 7) {
+      uint8_t byte = block.data[at++];
+      value |= (uint32_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) break;
+    }
+    return value;
+  }
+
+  HistoryBlock **_blocks = nullptr;
+  uint16_t _count = 0;
+  uint16_t _period = 20;
+  uint32_t _sequence = 0;
+  uint32_t _windowStart = 1;            // Oldest block that ended within HISTORY_MIN_SPAN
+  uint32_t _windowBytes = 0;            // Written in it and the blocks after it
+  uint32_t _limit = 0;                  // bytes
+  uint32_t _thinned = 0;
+  HistorySample _last;
+  mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,223 @@
+#pragma once
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Preferences.h>
+#include <metrics.h>
+#ifndef NATIVE_BUILD
+#include <esp_system.h>
+#endif
+
+#define JOURNAL_SLOTS       16      // Positions in a record, one per axis
+#define JOURNAL_EEPROM_SIZE 32      // Before the journal slot n was saved at EEPROM address 4n
+#define JOURNAL_RECORDS     8       // Length of the ring
+#define JOURNAL_INTERVAL    5000    // ms, while moving the position is saved at most this often
+#define JOURNAL_MIN_GAP     1000    // ms, between saves when moves stop, slow tracking stops all the time
+#define JOURNAL_NAMESPACE   "journal"
+#define JOURNAL_OUTPUTS_KEY "out"
+
+inline Histogram journalCommit("rotor_journal_commit_seconds", "Time a journal record write blocked loop()");
+inline Counter journalFailures("rotor_journal_failures_total", "Journal records that could not be written");
+
+/// @brief One saved state of all positions
+struct JournalRecord {
+    uint32_t sequence = 0;
+    int16_t  position[JOURNAL_SLOTS] = {};
+    uint16_t crc = 0;
+};
+
+/// @brief Pin and pulse range of the servo in a slot, so it can be driven before config.ini is read
+struct JournalOutput {
+    int8_t   pin = -1;      // -1: no servo in this slot
+    int16_t  min = 0, max = 0;
+};
+
+struct JournalOutputs {
+    JournalOutput output[JOURNAL_SLOTS];
+    uint16_t crc = 0;
+};
+
+/// @brief Counters to see what saving costs
+struct JournalStats {
+    uint32_t commits = 0;       // Records written
+    uint32_t failures = 0;      // Writes that failed
+    uint32_t lastMicros = 0;    // Time the last write blocked the loop
+    uint32_t maxMicros = 0;     // Longest a write blocked the loop
+    uint64_t totalMicros = 0;
+};
+
+/*
+    Keeps the servo positions in RAM and only saves them when a move has stopped (at most once per
+    JOURNAL_MIN_GAP ms), every JOURNAL_INTERVAL ms while moving and on a restart. Before this
+    every 20 ms step was an EEPROM commit, blocking the loop and wearing the flash.
+    The records go round a ring of NVS keys, NVS itself spreads them over its flash pages. Every
+    record has a sequence number and a CRC, at boot the newest valid one is used, so a write torn
+    by a power cut falls back to the record before it. Without any record (first boot after an
+    update) the positions are taken from the old EEPROM layout.
+    A brown-out resets the chip from an interrupt without warning, what has moved since the last
+    record is then lost, at most JOURNAL_INTERVAL ms of a move.
+    Next to the positions the pin and pulse range of every slot are kept, so the servo's can be
+    driven at their position right after a reset, before config.ini has been read.
+*/
+class PositionJournal {
+
+public:
+    /// @brief Recover the last good record, only the first call does something
+    bool begin() {
+        if (_begun) return true;
+        _begun = true;
+
+        if (!_nvs.begin(JOURNAL_NAMESPACE, false)) {
+            log_e("Failed to open NVS, positions are not saved");
+            return false;
+        }
+
+        JournalRecord record;
+        bool found = false;
+        for (uint8_t i = 0; i < JOURNAL_RECORDS; ++i) {
+            char key[4];
+            _key(i, key);
+            if (_nvs.getBytes(key, &record, sizeof(record)) != sizeof(record) or
+                record.crc != _crc(&record, offsetof(JournalRecord, crc))) continue;
+            if (!found or (int32_t)(record.sequence - _record.sequence) > 0) _record = record;
+            found = true;
+        }
+
+        if (found) {
+            log_i("Journal record %u recovered", _record.sequence);
+        } else if (EEPROM.begin(JOURNAL_EEPROM_SIZE)) {
+            // Take over the positions from the EEPROM layout used before the journal
+            for (uint8_t slot = 0; slot < JOURNAL_EEPROM_SIZE / 4; ++slot)
+                _record.position[slot] = EEPROM.readInt(slot * 4);
+            log_i("No journal record, positions taken from EEPROM");
+        } else {
+            log_e("No journal record and no EEPROM, the servo's might jump");
+        }
+        _saved = _record;
+
+        if (_nvs.getBytes(JOURNAL_OUTPUTS_KEY, &_outputs, sizeof(_outputs)) != sizeof(_outputs) or
+            _outputs.crc != _crc(&_outputs, offsetof(JournalOutputs, crc)))
+            _outputs = JournalOutputs();
+
+#ifndef NATIVE_BUILD
+        esp_register_shutdown_handler(_shutdown);
+#endif
+        return true;
+    }
+
+    /// @brief Position in a slot
+    int16_t read(uint8_t slot) const { return slot < JOURNAL_SLOTS ? _record.position[slot] : 0; }
+
+    /// @brief Pin and range of the servo in a slot as it was before the reset
+    const JournalOutput &output(uint8_t slot) const { return _outputs.output[slot < JOURNAL_SLOTS ? slot : 0]; }
+
+    /// @brief Save the pin and range of a servo, only written when they changed (config.ini was changed)
+    void setOutput(uint8_t slot, int8_t pin, int16_t min, int16_t max) {
+        if (slot >= JOURNAL_SLOTS or !_begun) return;
+        JournalOutput &output = _outputs.output[slot];
+        if (output.pin == pin and output.min == min and output.max == max) return;
+        output.pin = pin;
+        output.min = min;
+        output.max = max;
+        _outputs.crc = _crc(&_outputs, offsetof(JournalOutputs, crc));
+        if (_nvs.putBytes(JOURNAL_OUTPUTS_KEY, &_outputs, sizeof(_outputs)) != sizeof(_outputs))
+            log_e("Could not save the output of slot %u", slot);
+    }
+
+    /// @brief Change a position in RAM only (any task)
+    void write(uint8_t slot, int16_t position) {
+        if (slot >= JOURNAL_SLOTS) return;
+        portENTER_CRITICAL(&_mux);
+        if (_record.position[slot] != position) {
+            if (!_dirty) _dirtySince = millis();
+            _record.position[slot] = position;
+            _dirty = true;
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    /// @brief A move has stopped, save it soon (any task)
+    void stopped() { _stopped = true; }
+
+    /// @brief Save when a move stopped or something changed longer than JOURNAL_INTERVAL ago
+    /// Call from loop(), the flash write blocks for a while
+    void loop() {
+        if (!_dirty) return;
+        unsigned long now = millis();
+        if (now - _dirtySince >= JOURNAL_INTERVAL or (_stopped and now - _flushed >= JOURNAL_MIN_GAP)) flush();
+    }
+
+    /// @brief Save now if something changed (one task only)
+    bool flush() {
+        if (!_dirty or !_begun) return true;
+        JournalRecord record;
+        portENTER_CRITICAL(&_mux);
+        record = _record;
+        _dirty = _stopped = false;
+        portEXIT_CRITICAL(&_mux);
+        _flushed = millis();
+        if (memcmp(record.position, _saved.position, sizeof(record.position)) == 0) return true;  // Back where it was
+
+        unsigned long start = micros();
+        record.sequence = _saved.sequence + 1;
+        record.crc = _crc(&record, offsetof(JournalRecord, crc));
+        char key[4];
+        _key(record.sequence % JOURNAL_RECORDS, key);
+        bool ok = _nvs.putBytes(key, &record, sizeof(record)) == sizeof(record);
+
+        uint32_t elapsed = micros() - start;
+        _stats.lastMicros = elapsed;
+        _stats.maxMicros = std::max(_stats.maxMicros, elapsed);
+        _stats.totalMicros += elapsed;
+        journalCommit.add(elapsed);
+        if (ok) {
+            _stats.commits++;
+            _saved = record;
+            log_d("Journal record %u written in %u us", record.sequence, elapsed);
+        } else {
+            _stats.failures++;
+            journalFailures.add();
+            portENTER_CRITICAL(&_mux);
+            _dirty = true;      // Try again after the interval
+            _dirtySince = millis();
+            portEXIT_CRITICAL(&_mux);
+            log_e("Journal record %u failed", record.sequence);
+        }
+        return ok;
+    }
+
+    const JournalStats &stats() const { return _stats; }
+
+private:
+
+    static void _key(uint8_t index, char *key) {
+        key[0] = 'p';
+        key[1] = '0' + index;
+        key[2] = 0;
+    }
+
+    // CRC-16/CCITT over everything before the crc itself
+    static uint16_t _crc(const void *data, size_t size) {
+        const uint8_t *p = (const uint8_t *)data;
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < size; ++i) {
+            crc ^= (uint16_t)p[i] << 8;
+            for (uint8_t b = 0; b < 8; ++b) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        return crc;
+    }
+
+    static void _shutdown();
+
+    Preferences _nvs;
+    JournalRecord _record, _saved;
+    JournalOutputs _outputs;
+    JournalStats _stats;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    volatile bool _dirty = false, _stopped = false;
+    bool _begun = false;
+    unsigned long _dirtySince = 0, _flushed = 0;
+};
+
+inline PositionJournal Journal;
+
+inline void PositionJournal::_shutdown() { Journal.flush(); }
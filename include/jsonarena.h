@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/*
+    ArduinoJson allocator on a fixed buffer, so a document can never grow beyond SIZE bytes and
+    never touches the heap. Freed blocks are only reclaimed by reset(), which is fine for a
+    document that is cleared and parsed again, like the Stellarium object info.
+*/
+template <size_t SIZE>
+class JsonArena : public ArduinoJson::Allocator {
+
+public:
+    void *allocate(size_t size) override {
+        size = _align(size);
+        if (_used + sizeof(Header) + size > SIZE) {
+            _failures++;
+            return nullptr;
+        }
+        Header *h = (Header *)(_buffer + _used);
+        h->size = size;
+        _last = _used;
+        _used += sizeof(Header) + size;
+        if (_used > _peak) _peak = _used;
+        return h + 1;
+    }
+
+    void deallocate(void *ptr) override {
+        // Give the space back only when it was the last block
+        if (ptr && _offset(ptr) == _last) {
+            _used = _last;
+        }
+    }
+
+    void *reallocate(void *ptr, size_t size) override {
+        if (!ptr) return allocate(size);
+        size = _align(size);
+        Header *h = (Header *)ptr - 1;
+        if (_offset(ptr) == _last) {    // Grow or shrink in place
+            if (_last + sizeof(Header) + size > SIZE) {
+                _failures++;
+                return nullptr;
+            }
+            h->size = size;
+            _used = _last + sizeof(Header) + size;
+            if (_used > _peak) _peak = _used;
+            return ptr;
+        }
+        if (size <= h->size) return ptr;
+        void *p = allocate(size);
+        if (p) memcpy(p, ptr, h->size);
+        return p;
+    }
+
+    /// @brief Forget all allocations, clear the document that uses the arena first
+    void reset() {
+        _used = 0;
+        _last = SIZE;
+    }
+
+    size_t used() const { return _used; }
+    size_t peak() const { return _peak; }
+    uint32_t failures() const { return _failures; }
+    static constexpr size_t capacity() { return SIZE; }
+
+private:
+    struct Header {
+        size_t size;
+        size_t reserved;    // Keeps the blocks 8 byte aligned
+    };
+
+    static size_t _align(size_t size) { return (size + 7) & ~(size_t)7; }
+    size_t _offset(void *ptr) const { return (uint8_t *)((Header *)ptr - 1) - _buffer; }
+
+    alignas(8) uint8_t _buffer[SIZE];
+    size_t _used = 0, _last = SIZE, _peak = 0;
+    uint32_t _failures = 0;
+};
@@ -0,0 +1,174 @@
+#pragma once
+#include <Arduino.h>
+
+#define METRIC_HISTOGRAM_BINS   24      // Bin k counts [2^(k-1), 2^k) us, the last one everything above (8 s)
+
+// Guards the 64 bit values, a torn read would show up as a huge jump in a rate
+inline portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+
+/// @brief Histogram of times in microseconds on a log2 scale
+struct TimingHistogram {
+    uint32_t bins[METRIC_HISTOGRAM_BINS] = {};
+    uint32_t count = 0;
+    uint32_t max = 0;
+    uint64_t sum = 0;
+
+    void add(uint32_t us) {
+        uint8_t bin = us ? 32 - __builtin_clz(us) : 0;
+        portENTER_CRITICAL(&metricsMux);
+        bins[std::min<uint8_t>(bin, METRIC_HISTOGRAM_BINS - 1)]++;
+        count++;
+        max = std::max(max, us);
+        sum += us;
+        portEXIT_CRITICAL(&metricsMux);
+    }
+
+    /// @brief Upper edge of a bin in microseconds
+    static uint32_t edge(uint8_t bin) { return 1UL << bin; }
+
+    /// @brief Sum of all times in seconds (any task)
+    double seconds() const {
+        portENTER_CRITICAL(&metricsMux);
+        uint64_t us = sum;
+        portEXIT_CRITICAL(&metricsMux);
+        return us / 1e6;
+    }
+};
+
+enum MetricType : uint8_t { MT_COUNTER, MT_GAUGE, MT_HISTOGRAM };
+
+/*
+    Metrics for /metrics in the Prometheus text format. Every metric is a global object that
+    links itself into a list when it is constructed, so nothing is allocated and updating one is a
+    few instructions from any task. Metrics with the same name and different labels form a family,
+    define them next to each other.
+*/
+class Metric {
+
+public:
+    /// @param name Prometheus name, rotor_...
+    /// @param labels e.g. "task=\"motion\"", nullptr for none
+    Metric(const char *name, const char *help, MetricType type, const char *labels = nullptr)
+        : _name(name), _help(help), _labels(labels), _type(type) {
+        Metric **last = &_first();
+        while (*last) last = &(*last)->_next;
+        *last = this;
+    }
+
+    /// @brief Write all metrics
+    static void writeAll(Print &out) {
+        for (Metric *m = _first(); m; m = m->_next) {
+            bool family = false;
+            for (Metric *p = _first(); p != m and !family; p = p->_next) family = strcmp(p->_name, m->_name) == 0;
+            if (!family) {
+                static const char *types[] = {"counter", "gauge", "histogram"};
+                out.printf("# HELP %s %s\n# TYPE %s %s\n", m->_name, m->_help, m->_name, types[m->_type]);
+            }
+            m->write(out);
+        }
+    }
+
+protected:
+    virtual void write(Print &out) = 0;
+
+    /// @brief One sample line, suffix and extra label (le="...") are optional
+    void _sample(Print &out, const char *suffix, const char *extra, double value) {
+        char number[24];
+        snprintf(number, sizeof(number), "%.9g", value);
+        bool labels = _labels or extra;
+        out.printf("%s%s%s%s%s%s%s %s\n", _name, suffix ? suffix : "", labels ? "{" : "", _labels ? _labels : "",
+                   _labels and extra ? "," : "", extra ? extra : "", labels ? "}" : "", number);
+    }
+
+private:
+    static Metric *&_first() {
+        static Metric *first = nullptr;
+        return first;
+    }
+
+    const char *_name, *_help, *_labels;
+    MetricType _type;
+    Metric *_next = nullptr;
+};
+
+/// @brief Only goes up
+class Counter : public Metric {
+
+public:
+    Counter(const char *name, const char *help, const char *labels = nullptr) : Metric(name, help, MT_COUNTER, labels) {}
+
+    void add(uint32_t n = 1) {
+        portENTER_CRITICAL(&metricsMux);
+        _value += n;
+        portEXIT_CRITICAL(&metricsMux);
+    }
+
+protected:
+    void write(Print &out) override {
+        portENTER_CRITICAL(&metricsMux);
+        uint64_t value = _value;
+        portEXIT_CRITICAL(&metricsMux);
+        _sample(out, nullptr, nullptr, value);
+    }
+
+private:
+    uint64_t _value = 0;
+};
+
+/// @brief A value read when scraped, from wherever it is kept already
+class Probe : public Metric {
+
+public:
+    Probe(const char *name, const char *help, MetricType type, double (*read)(), const char *labels = nullptr)
+        : Metric(name, help, type, labels), _read(read) {}
+
+protected:
+    void write(Print &out) override { _sample(out, nullptr, nullptr, _read()); }
+
+private:
+    double (*_read)();
+};
+
+/// @brief Times in microseconds, exported in seconds
+class Histogram : public Metric {
+
+public:
+    Histogram(const char *name, const char *help, const char *labels = nullptr)
+        : Metric(name, help, MT_HISTOGRAM, labels), _histogram(&_own) {}
+    /// @brief Export a histogram kept elsewhere
+    Histogram(const char *name, const char *help, const TimingHistogram *histogram, const char *labels = nullptr)
+        : Metric(name, help, MT_HISTOGRAM, labels), _histogram(histogram) {}
+
+    void add(uint32_t us) { _own.add(us); }
+    const TimingHistogram &histogram() const { return *_histogram; }
+
+protected:
+    void write(Print &out) override {
+        portENTER_CRITICAL(&metricsMux);
+        TimingHistogram h = *_histogram;
+        portEXIT_CRITICAL(&metricsMux);
+
+        uint32_t cumulative = 0;
+        char le[24];
+        for (uint8_t bin = 0; bin < METRIC_HISTOGRAM_BINS - 1; ++bin) {
+            cumulative += h.bins[bin];
+            snprintf(le, sizeof(le), "le=\"%g\"", TimingHistogram::edge(bin) / 1e6);
+            _sample(out, "_bucket", le, cumulative);
+        }
+        _sample(out, "_bucket", "le=\"+Inf\"", h.count);
+        _sample(out, "_sum", nullptr, h.sum / 1e6);
+        _sample(out, "_count", nullptr, h.count);
+    }
+
+private:
+    TimingHistogram _own;
+    const TimingHistogram *_histogram;
+};
+
+// Memory, read when scraped
+inline Probe heapFree("rotor_heap_free_bytes", "Free heap", MT_GAUGE, [] { return (double)ESP.getFreeHeap(); });
+inline Probe heapLargest("rotor_heap_largest_block_bytes", "Largest block that can be allocated", MT_GAUGE,
+                         [] { return (double)ESP.getMaxAllocHeap(); });
+inline Probe heapMinimum("rotor_heap_min_free_bytes", "Lowest free heap since boot", MT_GAUGE,
+                         [] { return (double)ESP.getMinFreeHeap(); });
+inline Probe uptime("rotor_uptime_seconds", "Time since boot", MT_COUNTER, [] { return millis() / 1e3; });
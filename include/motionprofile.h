@@ -0,0 +1,161 @@
+#pragma once
+#include <Arduino.h>
+
+#define MOTION_SLOTS        32      // Length of the smoothing window
+#define MOTION_MIN_STEP     0.001f  // s, bounds the work per update for very high jerk limits
+#define MOTION_MAX_STEP     1.0f    // s, a longer gap (e.g. after a stall) is not caught up
+
+/*
+    Jerk limited (S-curve) motion towards a target that may change at any time.
+    An acceleration limited (trapezoid) profile runs towards the target and brakes with the
+    square root law, so it never passes the target. Its position is then averaged over a window
+    of 2*maxAcceleration/maxJerk seconds: the averaged acceleration changes by the change of the
+    trapezoid's acceleration over the window, at most 2*maxAcceleration when a short move or a
+    reversal goes from full acceleration straight to full deceleration, so it ramps up and down
+    with at most maxJerk. The move still ends exactly on the target, without overshoot.
+    The price is a fixed delay of half the window, e.g. 0.25 s with the defaults, while tracking.
+    A new target replans from the current state. Time is in seconds and accumulates real elapsed
+    time, units are up to the caller (servo pulses here).
+*/
+class MotionProfile {
+
+public:
+    /// @brief Set the limits, a speed or acceleration <= 0 makes the motion jump to the target,
+    /// a jerk <= 0 gives a plain trapezoid
+    /// A move in progress goes on from where it is, with its speed and acceleration clamped to the new limits
+    void configure(float maxVelocity, float maxAcceleration, float maxJerk) {
+        _vlimit = maxVelocity;
+        _alimit = maxAcceleration;
+        _steplimit = maxJerk > 0.0f ? std::max(2.0f * maxAcceleration / maxJerk / MOTION_SLOTS, MOTION_MIN_STEP) : 0.0f;
+        setTimeScale(_scale);
+        if (!_limited()) return;    // update() jumps to the target
+        _qv = constrain(_qv, -_vmax, _vmax);
+        _v = constrain(_v, -_vmax, _vmax);
+        _a = constrain(_a, -_amax, _amax);
+    }
+
+    /// @brief Run slower than the limits, a move then takes 1/scale times as long (0 < scale <= 1)
+    /// Used to let another axis catch up, speed scales with scale, acceleration with scale^2 and so on
+    void setTimeScale(float scale) {
+        scale = constrain(scale, 0.01f, 1.0f);
+        _scale = scale;
+        _vmax = _vlimit * scale;
+        _amax = _alimit * scale * scale;
+        _step = _steplimit / scale;
+    }
+
+    /// @brief Time (s) a move over distance takes from standstill at the full limits
+    float duration(float distance) const {
+        if (!(_vlimit > 0.0f and _alimit > 0.0f)) return 0.0f;
+        distance = fabsf(distance);
+        float t = distance * _alimit >= _vlimit * _vlimit ? distance / _vlimit + _vlimit / _alimit
+                                                          : 2.0f * sqrtf(distance / _alimit);
+        return distance > 0.0f ? t + _steplimit * MOTION_SLOTS : 0.0f;
+    }
+
+    /// @brief Stand still at position
+    void reset(float position) {
+        _p = _q = _target = position;
+        _v = _a = _qv = 0.0f;
+        _elapsed = 0.0f;
+        for (auto &slot : _slots) slot = position;
+    }
+
+    void setTarget(float target) { _target = target; }
+
+    /// @brief Position where the axis comes to a stop when braking right now
+    float stoppingPoint() const {
+        if (!_limited()) return _p;
+        float d = _qv * _qv / (2.0f * _amax);
+        return _q + (_qv >= 0.0f ? d : -d);
+    }
+
+    /// @brief Advance the motion
+    /// @param dt elapsed time in seconds
+    /// @return the new position
+    float update(float dt) {
+        if (!_limited()) {
+            reset(_target);
+            return _p;
+        }
+
+        _elapsed += std::min(dt, MOTION_MAX_STEP);
+        if (_step <= 0.0f) {
+            // No jerk limit, plain trapezoid
+            float h = _elapsed;
+            _elapsed = 0.0f;
+            _trapezoid(h);
+            _output(_q, h);
+            return _p;
+        }
+
+        while (_elapsed >= _step) {
+            _elapsed -= _step;
+            _trapezoid(_step);
+            _slots[_next] = _q;
+            _next = (_next + 1) % MOTION_SLOTS;
+            float sum = 0.0f;
+            for (auto slot : _slots) sum += slot;
+            _output(_q == _target and _qv == 0.0f and _settled() ? _target : sum / MOTION_SLOTS, _step);
+        }
+        return _p;
+    }
+
+    float position() const { return _p; }
+    float velocity() const { return _v; }
+    float acceleration() const { return _a; }
+    float target() const { return _target; }
+    bool  done() const { return _p == _target and _v == 0.0f; }
+    /// @brief How far (s) the smoothing runs behind a steady move, half the window
+    float delay() const { return _step * (MOTION_SLOTS - 1) / 2.0f; }
+
+    /// @brief Highest |acceleration| since the last call
+    float takePeakAcceleration() {
+        float peak = _peak;
+        _peak = 0.0f;
+        return peak;
+    }
+
+private:
+
+    bool _limited() const { return _vmax > 0.0f and _amax > 0.0f; }
+
+    bool _settled() const {
+        for (auto slot : _slots)
+            if (slot != _target) return false;
+        return true;
+    }
+
+    // One step of the acceleration limited profile
+    void _trapezoid(float h) {
+        float e = _target - _q;
+        if (fabsf(e) <= fabsf(_qv) * h and fabsf(_qv) <= 2.0f * _amax * h) {
+            _q = _target;   // Arrives within this step
+            _qv = 0.0f;
+            return;
+        }
+        // Square root law, in the form that also brakes in time with discrete steps
+        float ah = _amax * h / 2.0f;
+        float vd = (e >= 0.0f ? 1.0f : -1.0f) * std::min(_vmax, sqrtf(ah * ah + 2.0f * _amax * fabsf(e)) - ah);
+        _qv += constrain(vd - _qv, -_amax * h, _amax * h);
+        _q += _qv * h;
+    }
+
+    // Smoothed position, keeps track of its speed and acceleration
+    void _output(float p, float h) {
+        float v = (p - _p) / h;
+        _a = (v - _v) / h;
+        _v = v;
+        _p = p;
+        _peak = std::max(_peak, fabsf(_a));
+    }
+
+    float _vlimit = 0.0f, _alimit = 0.0f, _steplimit = 0.0f;    // Configured
+    float _vmax = 0.0f, _amax = 0.0f, _step = 0.0f;             // Time scaled
+    float _scale = 1.0f;
+    float _q = 0.0f, _qv = 0.0f;                // Trapezoid
+    float _p = 0.0f, _v = 0.0f, _a = 0.0f;      // Smoothed output
+    float _target = 0.0f, _elapsed = 0.0f, _peak = 0.0f;
+    float _slots[MOTION_SLOTS] = {};
+    uint8_t _next = 0;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <Arduino.h>
+#include <metrics.h>
+
+#define MOTION_RATE_MIN         50      // Hz
+#define MOTION_RATE_MAX         500     // Hz
+#define MOTION_PRIORITY         5       // Above loop() and the web server (1)
+#define MOTION_HISTOGRAM_BINS   METRIC_HISTOGRAM_BINS
+
+struct MotionStats {
+    TimingHistogram jitter;     // |actual - nominal period|
+    TimingHistogram execution;  // Time the step took
+    uint32_t overruns = 0;      // Steps that took longer than the period
+};
+
+/*
+    Runs the motion control (target, setpoints, servo steps) at a fixed rate from its own task on
+    core 1, above loop() so logging and network I/O in loop() can no longer stretch the period.
+    The task is woken by vTaskDelayUntil, so the period is a whole number of ticks (1 ms). Every
+    step records how far the period was off and how long the step took.
+    On the host with the virtual clock no task is started, the simulation calls tick() itself after
+    advancing the clock, which makes the timing deterministic.
+*/
+class MotionTask {
+
+public:
+    /// @brief Start the task
+    /// @param step called every period
+    /// @param rate in Hz, MOTION_RATE_MIN to MOTION_RATE_MAX
+    bool begin(void (*step)(), uint16_t rate) {
+        _step = step;
+        rate = constrain(rate, MOTION_RATE_MIN, MOTION_RATE_MAX);
+        _ticks = std::max<TickType_t>(pdMS_TO_TICKS(1000 / rate), 1);
+        _period = _ticks * portTICK_PERIOD_MS * 1000UL;
+        log_i("Motion task at %lu Hz", 1000000UL / _period);
+
+#ifdef NATIVE_BUILD
+        if (native::virtualClock()) {   // Driven by the simulation
+            native::simulation().motionStep = [this] { tick(); };
+            native::simulation().motionPeriod = _period;
+            return true;
+        }
+#endif
+        return xTaskCreatePinnedToCore(
+            _task,              // Task function
+            "Motion",           // Task name
+            8192,               // Stack size (bytes)
+            this,               // Task parameters
+            MOTION_PRIORITY,    // Priority
+            NULL,               // Task handle
+            1) == pdPASS;       // Pin to Core 1
+    }
+
+    /// @brief One step with its timing
+    void tick() {
+        unsigned long start = micros();
+        if (_last) {
+            long error = (long)(start - _last) - (long)_period;
+            _stats.jitter.add(labs(error));
+        }
+        _last = start;
+
+        _step();
+
+        uint32_t elapsed = micros() - start;
+        _stats.execution.add(elapsed);
+        if (elapsed > _period) _stats.overruns++;
+    }
+
+    /// @brief Period in microseconds
+    uint32_t period() const { return _period; }
+    const MotionStats &stats() const { return _stats; }
+    void resetStats() { _stats = MotionStats(); }
+
+private:
+
+    static void _task(void *parameter) {
+        MotionTask *self = (MotionTask *)parameter;
+        TickType_t wake = xTaskGetTickCount();
+        while (true) {
+            vTaskDelayUntil(&wake, self->_ticks);
+            self->tick();
+        }
+    }
+
+    void (*_step)() = nullptr;
+    TickType_t _ticks = 1;
+    uint32_t _period = 1000;
+    unsigned long _last = 0;
+    MotionStats _stats;
+};
@@ -6,18 +6,55 @@
 #include <ArduinoJson.h>
 #include <objectData.h>
 #include <stellarium.h>
+#include <satellite.h>
+#include <scheduler.h>
+#include <assets.h>
+#include <pagedata.h>
+#include <history.h>
+#include <metrics.h>
+#include <configschema.h>
+#include <servolag.h>
 
 // WebServer object on port 80
 WebServer server(80);
 
-// Pointer to object data to be shown
-ObjectData *currentObjectData = nullptr;
+// Time of every request, the stations on the access point
+Histogram httpRequest("rotor_http_request_seconds", "Time the web server spent on a request");
+Probe wifiStations("rotor_wifi_stations", "Stations connected to the access point", MT_GAUGE,
+                   [] { return (double)WiFi.softAPgetStationNum(); });
+
+// index.html and the other web files, gzipped with ETags
+StaticAssets assets;
+
+// Object data to be shown, as published by the control side
+const PagePublisher *currentPageData = nullptr;
 
 CalibrationData cData;
 
 
-void linkData (ObjectData *data) {
-  currentObjectData = data;
+void linkData (const PagePublisher *data) {
+  currentPageData = data;
+}
+
+// Satellites from the TLE files
+SatelliteTracker *satelliteTracker = nullptr;
+
+void linkSatellites(SatelliteTracker *tracker) {
+  satelliteTracker = tracker;
+}
+
+// Recorded motion steps
+const PointingHistory *pointingHistory = nullptr;
+
+void linkHistory(const PointingHistory *history) {
+  pointingHistory = history;
+}
+
+// Servo lag identification
+const LagIdentifier *lagIdentifier = nullptr;
+
+void linkIdentifier(const LagIdentifier *identifier) {
+  lagIdentifier = identifier;
 }
 
 // Callback function to set tracking
@@ -37,65 +74,89 @@ void setCalibrationCallBack(void(*func_ptr)(CalibrationData &)) {
   calibration_callback = func_ptr;
 }
 
-// Mutex for thread-safe access to the data structure
-portMUX_TYPE dataMutex = portMUX_INITIALIZER_UNLOCKED;
+// To store sidereal command callback function
+bool(*sidereal_callback)(SiderealData &) = nullptr;
+
+/// @brief Set callback function to lock/release the RA/Dec tracking
+void setSiderealCallBack(bool(*func_ptr)(SiderealData &)) {
+  sidereal_callback = func_ptr;
+}
+
+// To store target callback function
+bool(*target_callback)(TargetData &) = nullptr;
+
+/// @brief Set callback function for a target from the web page
+void setTargetCallBack(bool(*func_ptr)(TargetData &)) {
+  target_callback = func_ptr;
+}
+
+// To store axis move callback function
+bool(*axis_callback)(AxisData &) = nullptr;
+
+/// @brief Set callback function to move a single axis
+void setAxisCallBack(bool(*func_ptr)(AxisData &)) {
+  axis_callback = func_ptr;
+}
+
+// To store axes list callback function
+uint8_t(*axes_callback)(AxisData *, uint8_t) = nullptr;
+
+/// @brief Set callback function to list the axes, it fills in up to size and returns how many
+void setAxesCallBack(uint8_t(*func_ptr)(AxisData *, uint8_t)) {
+  axes_callback = func_ptr;
+}
+
+// To store identify callback function
+bool(*identify_callback)(IdentifyData &) = nullptr;
+
+/// @brief Set callback function to start or stop a servo lag identification
+void setIdentifyCallBack(bool(*func_ptr)(IdentifyData &)) {
+  identify_callback = func_ptr;
+}
+
+// To store config callback function
+bool(*config_callback)(const RotorConfig &, bool, String &) = nullptr;
+
+/// @brief Set callback function to check and apply a new config
+/// The callback gets the parsed config, whether to apply it and fills in what changed
+void setConfigCallBack(bool(*func_ptr)(const RotorConfig &, bool, String &)) {
+  config_callback = func_ptr;
+}
 
 // --- Web Server Request Handlers ---
 
 // Handles the root path ("/")
 void handleRoot() {
-  File file = SPIFFS.open("/index.html", "r");
-  if (!file) {
+  if (!assets.serve(server, "/index.html")) {
     Serial.println("Failed to open index.html for reading");
     server.send(500, "text/plain", "500: Internal Server Error");
-    return;
   }
-  // streamFile is highly efficient, it sends the file in chunks
-  // without loading the whole thing into memory.
-  // The second argument is the content-type.
-  server.streamFile(file, "text/html");
-  file.close();
-  Serial.println("Served index.html");
 }
 
 // API endpoint to get the current data as JSON
+// The body is only serialized again when new data was published, otherwise the last one is sent
 void handleData() {
-  // Create a JSON document
-  JsonDocument doc;
+  static PageData page;
+  static uint32_t version = 0;
+  static char body[PAGE_JSON_SIZE] = "{}";
+  static size_t length = 2;
 
-  // Use the mutex to safely read the shared data
-  if (currentObjectData) {
-    portENTER_CRITICAL(&dataMutex);
-    doc["altitude"] = currentObjectData->altitude;
-    doc["azimuth"] = currentObjectData->azimuth;
-    doc["name"] = currentObjectData->name;
-    doc["visible"] = currentObjectData->visible;
-    doc["valid"] = currentObjectData->valid;
-    doc["tracking"] = currentObjectData->tracking;
-    doc["error"] = currentObjectData->error.c_str();
-    doc["servo_alt"] = currentObjectData->currAlt;
-    doc["servo_az"] = currentObjectData->currAz;
-    portEXIT_CRITICAL(&dataMutex);
-  }
-  // Serialize JSON to a string
-  String jsonString;
-  serializeJson(doc, jsonString);
+  if (currentPageData and currentPageData->read(page, version))
+    length = serializePage(page, body, sizeof(body));
 
-  // Send the JSON response
-  server.send(200, "application/json", jsonString);
+  server.send_P(200, "application/json", body, length);
 }
 
 // Handler to toggle tracking status
 void handleTracking() {
-  // Use the mutex to safely write to the shared data
-  if (currentObjectData) {
-    portENTER_CRITICAL(&dataMutex);
-    currentObjectData->tracking = !currentObjectData->tracking;
-    portEXIT_CRITICAL(&dataMutex);
+  if (currentPageData) {
+    PageData page;
+    uint32_t version = 0;
+    currentPageData->read(page, version);
     if (tracking_callback)
-      tracking_callback(currentObjectData->tracking);
-    
-    Serial.printf("Tracking is now %s\n", currentObjectData->tracking ? "ON" : "OFF");
+      tracking_callback(!page.tracking);
+
+    Serial.printf("Tracking is now %s\n", !page.tracking ? "ON" : "OFF");
   }
   server.send(200, "text/plain", "OK");
 }
@@ -144,25 +205,356 @@ void handleCalibrate() {
   server.send(200, "text/plain", "OK");
 }
 
+// List the satellites in the TLE files
+void handleSatellites() {
+  JsonDocument doc;
+  doc["clock"] = clockSet();
+  if (satelliteTracker) satelliteTracker->list(doc["satellites"].to<JsonArray>());
+
+  String jsonString;
+  serializeJson(doc, jsonString);
+  server.send(200, "application/json", jsonString);
+}
+
+// Select the satellite to track, no name stops the satellite tracking
+void handleSatellite() {
+  if (!satelliteTracker) {
+    server.send(404, "text/plain", "404: Not Found");
+    return;
+  }
+  if (!satelliteTracker->select(server.arg("name"))) {
+    server.send(400, "text/plain", satelliteTracker->getError());
+    return;
+  }
+  server.send(200, "text/plain", "OK");
+}
+
+// Set the clock from the browser, epoch in ms
+void handleTime() {
+  if (!server.hasArg("epoch")) {
+    server.send(400, "text/plain", "Missing epoch");
+    return;
+  }
+  setClock(strtoull(server.arg("epoch").c_str(), nullptr, 10));
+  server.send(200, "text/plain", "OK");
+}
+
+// Lock the RA/Dec of the current Stellarium object, or the given ra/dec (J2000 degrees), and track it on the ESP32
+void handleSidereal() {
+  SiderealData sData;
+  sData.command = SC_LOCK;
+  if (server.hasArg("ra") and server.hasArg("dec")) {
+    sData.coordinates = true;
+    sData.ra = server.arg("ra").toDouble();
+    sData.dec = server.arg("dec").toDouble();
+    sData.name = server.hasArg("name") ? server.arg("name") : "RA/Dec";
+  }
+
+  if (sidereal_callback and !sidereal_callback(sData)) {
+    server.send(400, "text/plain", sData.error);
+    return;
+  }
+  server.send(200, "text/plain", "OK");
+}
+
+// Stop the RA/Dec tracking
+void handleSiderealRelease() {
+  SiderealData sData;
+  sData.command = SC_RELEASE;
+  if (sidereal_callback) sidereal_callback(sData);
+  server.send(200, "text/plain", "OK");
+}
+
+// Point at alt/az (degrees) and track it, it is followed while no source with a higher priority has a target
+void handleTarget() {
+  if (!server.hasArg("alt") or !server.hasArg("az")) {
+    server.send(400, "text/plain", "Missing alt or az");
+    return;
+  }
+  TargetData tData;
+  tData.command = TC_SET;
+  tData.altitude = server.arg("alt").toFloat();
+  tData.azimuth = server.arg("az").toFloat();
+  tData.name = server.hasArg("name") ? server.arg("name") : "Web";
+  if (target_callback and !target_callback(tData)) {
+    server.send(400, "text/plain", tData.error);
+    return;
+  }
+  server.send(200, "text/plain", "OK");
+}
+
+// Drop the web target, the next source takes over
+void handleTargetRelease() {
+  TargetData tData;
+  tData.command = TC_RELEASE;
+  if (target_callback) target_callback(tData);
+  server.send(200, "text/plain", "OK");
+}
 
-// Handles requests to unknown paths
+// List the axes with their position and range in degrees
+void handleAxes() {
+  AxisData axes[MAX_AXES];
+  uint8_t count = axes_callback ? axes_callback(axes, MAX_AXES) : 0;
+  JsonDocument doc;
+  JsonArray list = doc.to<JsonArray>();
+  for (uint8_t i = 0; i < count; ++i) {
+    JsonObject axis = list.add<JsonObject>();
+    axis["name"] = axes[i].name;
+    axis["degrees"] = axes[i].degrees;
+    axis["min"] = axes[i].min;
+    axis["max"] = axes[i].max;
+  }
+
+  String jsonString;
+  serializeJson(doc, jsonString);
+  server.send(200, "application/json", jsonString);
+}
+
+// Move one axis to degrees, e.g. a polarisation rotator
+void handleAxis() {
+  if (!server.hasArg("name") or !server.hasArg("degrees")) {
+    server.send(400, "text/plain", "Missing name or degrees");
+    return;
+  }
+  AxisData aData;
+  aData.name = server.arg("name");
+  aData.degrees = server.arg("degrees").toFloat();
+  if (axis_callback and !axis_callback(aData)) {
+    server.send(400, "text/plain", aData.error);
+    return;
+  }
+  server.send(200, "text/plain", "OK");
+}
+
+// Identify the lag of an axis with its feedback input, ?axis=NAME, ?stop=1 stops it
+void handleIdentify() {
+  IdentifyData iData;
+  iData.command = server.arg("stop") == "1" ? IC_STOP : IC_START;
+  iData.axis = server.arg("axis");
+  if (iData.command == IC_START and iData.axis == "") {
+    server.send(400, "text/plain", "Missing axis");
+    return;
+  }
+  if (identify_callback and !identify_callback(iData)) {
+    server.send(400, "text/plain", iData.error);
+    return;
+  }
+  server.send(200, "text/plain", "OK");
+}
+
+// How the identification is going, the model once it is done
+void handleIdentifyStatus() {
+  if (!lagIdentifier) {
+    server.send(404, "text/plain", "No identification");
+    return;
+  }
+  static const char *stages[] = {"idle", "calibrating", "calibrating", "moving", "fitting", "done", "failed"};
+  LagReport report = lagIdentifier->report();
+  JsonDocument doc;
+  doc["axis"] = report.axis;
+  doc["stage"] = stages[report.stage];
+  doc["samples"] = report.samples;
+  doc["error"] = report.error;
+  if (report.stage == LS_DONE) {
+    doc["delay_ms"] = report.model.delay * 1e3;
+    doc["tau_ms"] = report.model.tau * 1e3;
+    doc["lead_ms"] = report.model.lead() * 1e3;
+    doc["rms_us"] = report.model.rms;
+  }
+
+  String jsonString;
+  serializeJson(doc, jsonString);
+  server.send(200, "application/json", jsonString);
+}
+
+// Download the recorded motion steps, ?format=csv (default) or bin, ?seconds= for only the last part
+// Sent in chunks while the tracking goes on, scripts/history_decode.py turns bin into csv
+// X-History-Seconds is the time the ring holds right now, at least HISTORY_MIN_SPAN once it is full
+void handleHistory() {
+  if (!pointingHistory) {
+    server.send(404, "text/plain", "No history");
+    return;
+  }
+  bool binary = server.arg("format") == "bin";
+  uint32_t since = 0;
+  if (server.hasArg("seconds")) since = millis() - server.arg("seconds").toInt() * 1000UL;
+
+  server.sendHeader("Content-Disposition", binary ? "attachment; filename=history.bin" : "attachment; filename=history.csv");
+  server.sendHeader("X-History-Seconds", String(pointingHistory->span() / 1000.0, 1));
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, binary ? "application/octet-stream" : "text/csv", "");
+
+  if (binary) {
+    HistoryHeader header = pointingHistory->header();
+    server.sendContent((const char *)&header, sizeof(header));
+    pointingHistory->forEach(since, [](const HistoryBlock &block) {
+      server.sendContent((const char *)&block, offsetof(HistoryBlock, data) + block.used);
+      return true;
+    });
+  } else {
+    static char chunk[1460];
+    size_t length = snprintf(chunk, sizeof(chunk), "time,alt,az,alt_command,alt_current,az_command,az_current\n");
+    uint16_t period = pointingHistory->period();
+    pointingHistory->forEach(since, [&](const HistoryBlock &block) {
+      PointingHistory::decode(block, period, [&](const HistorySample &sample) {
+        if ((int32_t)(sample.time - since) < 0) return;
+        if (length > sizeof(chunk) - 80) {
+          server.sendContent(chunk, length);
+          length = 0;
+        }
+        length += snprintf(chunk + length, sizeof(chunk) - length, "%u,%.2f,%.2f,%d,%d,%d,%d\n", (unsigned)sample.time,
+                           sample.value[0] / 100.0, sample.value[1] / 100.0, (int)sample.value[2],
+                           (int)sample.value[3], (int)sample.value[4], (int)sample.value[5]);
+      });
+      return server.client().connected();
+    });
+    server.sendContent(chunk, length);
+  }
+  server.sendContent("");   // Last chunk
+}
+
+// The config file as it is
+void handleConfig() {
+  File file = SPIFFS.open(CONFIG_PATH, "r");
+  if (!file) {
+    server.send(404, "text/plain", "No config file");
+    return;
+  }
+  server.sendHeader("Cache-Control", "no-cache");
+  server.streamFile(file, "text/plain");
+  file.close();
+}
+
+// Check a new config.ini (the request body) and apply what can change while running, ?apply=0 only checks it
+// An applied config is saved, the keys that need a restart are used from the next boot
+void handleConfigUpdate() {
+  const String &body = server.arg("plain");
+  if (body.length() == 0) {
+    server.send(400, "text/plain", "No config in the request body");
+    return;
+  }
+  if (body.length() > CONFIG_FILE_SIZE) {
+    server.send(413, "text/plain", "Config larger than " + String(CONFIG_FILE_SIZE) + " bytes");
+    return;
+  }
+  if (!config_callback) {
+    server.send(503, "text/plain", "Not ready");
+    return;
+  }
+
+  static RotorConfig config;  // Too large for the stack of the web server
+  ConfigParser parser;
+  ConfigParser::defaults(config);
+  if (!parser.parse(body.c_str(), body.length(), config)) {
+    server.send(400, "text/plain", parser.getError());
+    return;
+  }
+
+  bool apply = server.arg("apply") != "0";
+  String message;
+  if (!config_callback(config, apply, message)) {
+    server.send(400, "text/plain", message);
+    return;
+  }
+  if (apply) {
+    File file = SPIFFS.open(CONFIG_PATH, "w");
+    bool saved = file and file.print(body) == body.length();
+    file.close();
+    if (!saved) {
+      server.send(500, "text/plain", message + "\nCould not save " + CONFIG_PATH);
+      return;
+    }
+    log_i("Saved %s", CONFIG_PATH);
+  }
+  server.send(200, "text/plain", message);
+}
+
+/// @brief Collects output and sends it as chunks of a response
+class ChunkedPrint : public Print {
+
+public:
+  ~ChunkedPrint() { flush(); }
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    for (size_t i = 0; i < size; ++i) {
+      if (_length == sizeof(_chunk)) flush();
+      _chunk[_length++] = buffer[i];
+    }
+    return size;
+  }
+  void flush() override {
+    if (_length) server.sendContent(_chunk, _length);
+    _length = 0;
+  }
+
+private:
+  char _chunk[1024];
+  size_t _length = 0;
+};
+
+// Prometheus scrape
+void handleMetrics() {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+  {
+    ChunkedPrint out;
+    Metric::writeAll(out);
+  }
+  server.sendContent("");   // Last chunk
+}
+
+// Handles requests to unknown paths, these can still be web files (style sheets, icons)
 void handleNotFound() {
+  if (assets.serve(server, server.uri())) return;
   server.send(404, "text/plain", "404: Not Found");
 }
 
 
 // --- The Task for Core 0 ---
 
+/// @brief Register a handler, timed for /metrics
+void route(const char *uri, HTTPMethod method, void (*handler)()) {
+  server.on(uri, method, [handler]() {
+    unsigned long start = micros();
+    handler();
+    httpRequest.add(micros() - start);
+  });
+}
+
 // This task will handle all web server functions
 void WebServerTask(void *pvParameters) {
   Serial.println("Web Server Task started on Core 0");
 
+  assets.begin(SPIFFS);
+  const char *headers[] = {"If-None-Match"};
+  server.collectHeaders(headers, 1);
+
   // --- Define Server Routes ---
-  server.on("/", HTTP_GET, handleRoot);
-  server.on("/data", HTTP_GET, handleData);
-  server.on("/tracking", HTTP_POST, handleTracking); // Use POST for state changes
-  server.on("/calibrate", HTTP_GET, handleCalibrate);
-  server.onNotFound(handleNotFound);
+  route("/", HTTP_GET, handleRoot);
+  route("/data", HTTP_GET, handleData);
+  route("/tracking", HTTP_POST, handleTracking); // Use POST for state changes
+  route("/calibrate", HTTP_GET, handleCalibrate);
+  route("/satellites", HTTP_GET, handleSatellites);
+  route("/satellite", HTTP_POST, handleSatellite);
+  route("/time", HTTP_POST, handleTime);
+  route("/sidereal", HTTP_POST, handleSidereal);
+  route("/sidereal/release", HTTP_POST, handleSiderealRelease);
+  route("/target", HTTP_POST, handleTarget);
+  route("/target/release", HTTP_POST, handleTargetRelease);
+  route("/axes", HTTP_GET, handleAxes);
+  route("/axis", HTTP_POST, handleAxis);
+  route("/history", HTTP_GET, handleHistory);
+  route("/identify", HTTP_GET, handleIdentifyStatus);
+  route("/identify", HTTP_POST, handleIdentify);
+  route("/metrics", HTTP_GET, handleMetrics);
+  route("/config", HTTP_GET, handleConfig);
+  route("/config", HTTP_POST, handleConfigUpdate);
+  server.onNotFound([]() {
+    unsigned long start = micros();
+    handleNotFound();
+    httpRequest.add(micros() - start);
+  });
 
   // Start the server
   server.begin();
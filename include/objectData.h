@@ -9,3 +9,37 @@ struct CalibrationData {
   uint16_t              speed;
   CalibrationDirection  direction;
 };
+
+enum SiderealCommand { SC_NONE, SC_LOCK, SC_RELEASE };
+
+struct SiderealData {
+  SiderealCommand       command = SC_NONE;
+  bool                  coordinates = false;  // ra/dec given, otherwise take them from Stellarium
+  double                ra = 0.0, dec = 0.0;  // J2000 degrees
+  String                name = "";
+  String                error = "";           // Set by the callback when it fails
+};
+
+struct AxisData {
+  String                name = "";
+  float                 degrees = 0.0;
+  float                 min = 0.0, max = 0.0; // Range in degrees, filled in for the list of axes
+  String                error = "";           // Set by the callback when it fails
+};
+
+enum TargetCommand { TC_NONE, TC_SET, TC_RELEASE };
+
+struct TargetData {
+  TargetCommand         command = TC_NONE;
+  float                 altitude = 0.0, azimuth = 0.0;
+  String                name = "";
+  String                error = "";           // Set by the callback when it fails
+};
+
+enum IdentifyCommand { IC_NONE, IC_START, IC_STOP };
+
+struct IdentifyData {
+  IdentifyCommand       command = IC_NONE;
+  String                axis = "";
+  String                error = "";           // Set by the callback when it fails
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <doublebuffer.h>
+#include <stellarium.h>
+#include <arbiter.h>
+
+#define PAGE_TEXT_LENGTH    48
+#define PAGE_JSON_SIZE      768     // bytes, /data with both texts at full length and every source
+
+/// @brief Fixed size copy of the fields on the web page
+struct PageData {
+  float altitude = 0.0, azimuth = 0.0;
+  float currAlt = 0.0, currAz = 0.0;
+  bool visible = false, valid = false, tracking = false, sidereal = false;
+  char name[PAGE_TEXT_LENGTH] = "";
+  char error[PAGE_TEXT_LENGTH] = "";
+  char source[12] = "";                 // Followed, empty for none
+  int16_t age[TS_COUNT] = {};           // 0.1 s since the last sample of each source, -1 for never
+  uint16_t latency[TS_COUNT] = {};      // ms from a sample to the control picking it up
+};
+
+/*
+    The page data as published by the control side. Only the motion step writes it, after
+    everything of that step has been done, the web server and the telemetry stream read it from
+    core 0 without a lock. Nothing is allocated on either side and a new version only appears when
+    a field changed, so the readers can keep what they made of the previous one.
+*/
+class PagePublisher {
+
+public:
+  /// @brief Publish the data if it changed (control side, one task only)
+  void publish(const ObjectData &data, const TargetArbiter &targets) {
+    PageData page;
+    page.altitude = data.altitude;
+    page.azimuth = data.azimuth;
+    page.currAlt = data.currAlt;
+    page.currAz = data.currAz;
+    page.visible = data.visible;
+    page.valid = data.valid;
+    page.tracking = data.tracking;
+    page.sidereal = data.sidereal;
+    strlcpy(page.name, data.name.c_str(), sizeof(page.name));
+    strlcpy(page.error, data.error.c_str(), sizeof(page.error));
+    if (data.source >= 0) strlcpy(page.source, TargetArbiter::name((TargetSourceId)data.source), sizeof(page.source));
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < TS_COUNT; ++i) {
+      int32_t age = targets.age((TargetSourceId)i, now);
+      page.age[i] = age < 0 ? -1 : std::min<int32_t>(age / 100, INT16_MAX);
+      page.latency[i] = std::min<uint32_t>(targets.status((TargetSourceId)i).latency, UINT16_MAX);
+    }
+    if (_published and memcmp(&page, &_last, sizeof(page)) == 0) return;
+    _buffer.write(page);
+    _last = page;
+    _published = true;
+  }
+
+  /// @brief Copy the latest data if it is newer than version (any task)
+  bool read(PageData &page, uint32_t &version) const { return _buffer.read(page, version); }
+
+private:
+  DoubleBuffer<PageData> _buffer;
+  PageData _last;
+  bool _published = false;
+};
+
+/// @brief The /data JSON of a page
+/// @return length, without the terminating 0
+inline size_t serializePage(const PageData &page, char *buffer, size_t size) {
+  JsonDocument doc;
+  doc["altitude"] = page.altitude;
+  doc["azimuth"] = page.azimuth;
+  doc["name"] = page.name;
+  doc["visible"] = page.visible;
+  doc["valid"] = page.valid;
+  doc["tracking"] = page.tracking;
+  doc["error"] = page.error;
+  doc["servo_alt"] = page.currAlt;
+  doc["servo_az"] = page.currAz;
+  doc["sidereal"] = page.sidereal;
+  doc["source"] = page.source;
+  // Per source "stellarium_age" in s (-1 before the first sample) and "stellarium_latency" in ms
+  char key[24];
+  for (uint8_t i = 0; i < TS_COUNT; ++i) {
+    const char *name = TargetArbiter::name((TargetSourceId)i);
+    snprintf(key, sizeof(key), "%s_age", name);
+    doc[key] = page.age[i] < 0 ? -1.0 : page.age[i] / 10.0;
+    snprintf(key, sizeof(key), "%s_latency", name);
+    doc[key] = page.latency[i];
+  }
+  return serializeJson(doc, buffer, size);
+}
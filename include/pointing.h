@@ -0,0 +1,212 @@
+#pragma once
+#include <Arduino.h>
+
+#define POINTING_STEP           15000       // ms between the samples of a pass
+#define POINTING_MAX_PASS       1800000     // ms, a pass is looked ahead at most this far
+#define POINTING_MAX_SAMPLES    (POINTING_MAX_PASS / POINTING_STEP + 1)
+
+/// @brief Predicts the target position offsetMs from now, false when unknown
+typedef bool (*TargetPredictor)(long offsetMs, float &alt, float &az);
+
+/// @brief The pose chosen for a pass, from the PassPlanner to the PointingPlanner
+struct PassPlan {
+    uint32_t generation = 0;    // PointingPlanner::generation() it was planned for
+    int   samples = 0;          // Visible samples, 0 when nothing is in sight yet
+    bool  flipped = false;
+    float turn = 0.0f;          // Added to the azimuth, degrees
+    float reference = 0.0f;     // Azimuth where the pass starts, later ones are unwrapped from it
+    float startAlt = 0.0f, startAz = 0.0f;  // Servo angles where the pass starts
+    long  covered = 0;          // ms the pose keeps the target in range, see PassPlanner::plan()
+};
+
+/*
+    Chooses the pose for a pass.
+    Every sky position can be reached in two poses: the normal one (az, alt) and the flipped one
+    over the top (az+180, 180-alt), the latter needs an altitude servo that reaches past the zenith.
+    On top of that the azimuth servo angle can be az plus or minus a multiple of 360 degrees.
+    The track is predicted up to POINTING_MAX_PASS ahead and the pose and the azimuth turn are
+    chosen so the whole pass fits in the servo ranges, with the shortest slew to the start.
+    That takes up to POINTING_MAX_SAMPLES predictions, so it runs in loop() and not in the motion
+    step, which gets the result through PointingPlanner::apply().
+*/
+class PassPlanner {
+
+public:
+    /// @brief Angles the servo's can reach, in servo degrees
+    void setRange(float altMin, float altMax, float azMin, float azMax) {
+        _altMin = std::min(altMin, altMax);
+        _altMax = std::max(altMin, altMax);
+        _azMin = std::min(azMin, azMax);
+        _azMax = std::max(azMin, azMax);
+    }
+
+    /// @brief Choose the pose and azimuth turn for the pass that starts now
+    /// @param predict target positions ahead, only the part above the horizon counts
+    /// @param servoAlt, servoAz current servo angles
+    /// @return the plan, its covered is how long (ms) the chosen pose keeps the target in range, 0 when
+    /// not even the start fits, POINTING_MAX_PASS when all of it fits (or nothing is visible yet)
+    PassPlan plan(TargetPredictor predict, float servoAlt, float servoAz) {
+        // Sample the visible part of the pass, the azimuth unwrapped to a continuous track
+        int n = 0;
+        float previous = 0.0f;
+        for (long t = 0; t <= POINTING_MAX_PASS and n < POINTING_MAX_SAMPLES; t += POINTING_STEP) {
+            float alt, az;
+            if (!predict(t, alt, az)) break;
+            if (alt < 0.0f) {
+                if (n > 0) break;   // Set
+                continue;           // Not risen yet, the pass starts later
+            }
+            if (n > 0) az = previous + _wrap180(az - previous);
+            _alt[n] = alt;
+            _az[n] = previous = az;
+            _time[n] = t;
+            n++;
+        }
+
+        PassPlan plan;
+        plan.samples = n;
+        plan.covered = POINTING_MAX_PASS;
+        if (n == 0) return plan;    // Nothing visible to plan for, use the normal pose
+
+        // Try both poses and every azimuth turn, keep the one covering the longest part of the pass
+        long bestCover = -1;
+        float bestSlew = 0.0f;
+        for (int flip = 0; flip < 2; ++flip) {
+            for (int k = -2; k <= 2; ++k) {
+                float turn = 360.0f * k + (flip ? 180.0f : 0.0f);
+                int covered = 0;
+                while (covered < n and _fits(_alt[covered], _az[covered], flip, turn)) covered++;
+                if (covered == 0) continue;
+
+                long cover = covered == n ? POINTING_MAX_PASS + 1 : _time[covered - 1];
+                float startAlt = flip ? 180.0f - _alt[0] : _alt[0];
+                float slew = std::max(fabsf(startAlt - servoAlt), fabsf(_az[0] + turn - servoAz));
+                if (cover > bestCover or (cover == bestCover and slew < bestSlew)) {
+                    bestCover = cover;
+                    bestSlew = slew;
+                    plan.flipped = flip;
+                    plan.turn = turn;
+                }
+            }
+        }
+
+        // Later samples are unwrapped relative to the first one
+        plan.reference = _az[0];
+        plan.startAlt = plan.flipped ? 180.0f - _alt[0] : _alt[0];
+        plan.startAz = _az[0] + plan.turn;
+        plan.covered = bestCover < 0 ? 0 : std::min(bestCover, (long)POINTING_MAX_PASS);
+        log_i("Pass planned: %d samples, %s pose, azimuth turn %0.0f, slew %0.1f degrees",
+              n, plan.flipped ? "flipped" : "normal", plan.turn, bestSlew);
+        return plan;
+    }
+
+private:
+
+    static float _wrap180(float a) {
+        a = fmodf(a + 180.0f, 360.0f);
+        return a < 0.0f ? a + 180.0f : a - 180.0f;
+    }
+
+    bool _fits(float alt, float az, bool flip, float turn) const {
+        float a = flip ? 180.0f - alt : alt;
+        float z = az + turn;
+        return a >= _altMin and a <= _altMax and z >= _azMin and z <= _azMax;
+    }
+
+    float _altMin = 0.0f, _altMax = 90.0f, _azMin = 0.0f, _azMax = 360.0f;
+    float _alt[POINTING_MAX_SAMPLES], _az[POINTING_MAX_SAMPLES];
+    long  _time[POINTING_MAX_SAMPLES];
+};
+
+/*
+    Maps sky positions onto the servo's in the pose planned for the pass, in the motion step.
+    The choice is kept for the rest of the pass, so there is no unwind halfway. Every reset() (a new
+    target, tracking stopped) starts a new generation, a plan made for an older one is not taken.
+*/
+class PointingPlanner {
+
+public:
+    /// @brief Angles the servo's can reach, in servo degrees
+    void setRange(float altMin, float altMax, float azMin, float azMax) {
+        _altMin = std::min(altMin, altMax);
+        _altMax = std::max(altMin, altMax);
+        _azMin = std::min(azMin, azMax);
+        _azMax = std::max(azMin, azMax);
+    }
+
+    /// @brief Start over with the next target
+    void reset() {
+        _planned = _replan = false;
+        _generation++;
+    }
+
+    /// @brief The target left the planned range, plan again from here. A second time it is out of range
+    void replan() {
+        reset();
+        _replan = true;
+    }
+
+    /// @brief The current plan was made after the target left the range of the one before
+    bool replanned() const { return _replan; }
+
+    uint32_t generation() const { return _generation; }
+    bool planned() const { return _planned; }
+    bool flipped() const { return _flipped; }
+
+    /// @brief A (new) plan is needed, while waiting for a pass to rise it is retried every POINTING_STEP
+    bool due() const { return !_planned or (_samples == 0 and millis() - _plannedAt >= POINTING_STEP); }
+
+    /// @brief Take a plan from the PassPlanner
+    /// @return false when it was made for an earlier generation, the target changed meanwhile
+    bool apply(const PassPlan &plan) {
+        if (plan.generation != _generation) return false;
+        _planned = true;
+        _plannedAt = millis();
+        _samples = plan.samples;
+        _flipped = plan.flipped;
+        _turn = plan.turn;
+        _reference = plan.reference;
+        _startAlt = plan.startAlt;
+        _startAz = plan.startAz;
+        return true;
+    }
+
+    /// @brief Servo angles where the planned pass starts, to wait there for it to rise
+    /// @return false when there is no pass in sight
+    bool start(float &servoAlt, float &servoAz) const {
+        if (!_planned or _samples == 0) return false;
+        servoAlt = _startAlt;
+        servoAz = _startAz;
+        return true;
+    }
+
+    /// @brief Servo angles for a sky position in the planned pose
+    /// @return false when out of range
+    bool toServo(float alt, float az, float &servoAlt, float &servoAz) {
+        az = _reference + _wrap180(az - _reference);   // Continue on the planned track
+        _reference = az;
+        servoAlt = _flipped ? 180.0f - alt : alt;
+        servoAz = az + _turn;
+        return servoAlt >= _altMin and servoAlt <= _altMax and servoAz >= _azMin and servoAz <= _azMax;
+    }
+
+    /// @brief Sky position of the servo angles in the planned pose
+    void toSky(float servoAlt, float servoAz, float &alt, float &az) const {
+        alt = _flipped ? 180.0f - servoAlt : servoAlt;
+        az = fmodf(servoAz - _turn + 720.0f, 360.0f);
+    }
+
+private:
+
+    static float _wrap180(float a) {
+        a = fmodf(a + 180.0f, 360.0f);
+        return a < 0.0f ? a + 180.0f : a - 180.0f;
+    }
+
+    float _altMin = 0.0f, _altMax = 90.0f, _azMin = 0.0f, _azMax = 360.0f;
+    bool  _planned = false, _replan = false, _flipped = false;
+    uint32_t _generation = 0;
+    int   _samples = 0;
+    unsigned long _plannedAt = 0;
+    float _turn = 0.0f, _reference = 0.0f, _startAlt = 0.0f, _startAz = 0.0f;
+};
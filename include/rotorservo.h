@@ -1,11 +1,70 @@
 #pragma once
 #include <ESP32ServoLite.h>
-#include <EEPROM.h>
 #include <esp_log.h>
+#include <motionprofile.h>
+#include <journal.h>
+#include <metrics.h>
 
-#define EEPROM_SIZE         32  // Need to have a value here
-#define UPDATE_INTERVAL     20  // ms, ~50Hz update rate
-#define MAX_US_PER_SECOND   300 // limit speed in microseconds/sec
+#define UPDATE_INTERVAL     20  // ms, default period of the motion task (50Hz)
+
+// Default motion limits when smooth, overruled by config.ini
+#define DEFAULT_MAX_SPEED   60.0    // degrees/s
+#define DEFAULT_MAX_ACCEL   60.0    // degrees/s^2
+#define DEFAULT_MAX_JERK    240.0   // degrees/s^3
+
+inline Counter servoPulses("rotor_servo_pulses_total", "Pulse width changes written to the servo's");
+inline Counter servoErrors("rotor_servo_errors_total", "Servo steps that failed");
+
+/*
+    Drives the servo's at their saved position within milliseconds of a reset, from the pins and
+    ranges in the journal, long before the file system is mounted and config.ini is read. Without
+    pulses a servo goes limp and the dish sags or turns in the wind meanwhile.
+    RotorServo::init takes the output of its slot over without a gap in the pulses, outputs that no
+    axis took over (the config changed) are released once all axes are initialized.
+*/
+class ServoHold {
+
+public:
+    /// @brief Start the outputs of all slots the journal knows
+    /// @return the number of servo's held
+    static uint8_t begin() {
+        uint8_t count = 0;
+        for (uint8_t slot = 0; slot < JOURNAL_SLOTS; ++slot) {
+            const JournalOutput &output = Journal.output(slot);
+            if (output.pin < 0 or output.min >= output.max) continue;
+            if (_servo[slot].attach(output.pin, output.min, output.max) < 0) break;
+            _servo[slot].writeMicroseconds(constrain(Journal.read(slot), output.min, output.max));
+            count++;
+        }
+        return count;
+    }
+
+    /// @brief Take the output of a slot over if it is on the same pin, otherwise it is stopped
+    /// @return false when there was no output to take over, attach it yourself
+    static bool take(uint8_t slot, int8_t pin, int16_t min, int16_t max, ESP32ServoLite &servo) {
+        if (slot >= JOURNAL_SLOTS or !_servo[slot].attached()) return false;
+        if (Journal.output(slot).pin != pin) {
+            _servo[slot].detach();
+            return false;
+        }
+        servo = _servo[slot];
+        servo.setRange(min, max);
+        _servo[slot] = ESP32ServoLite();    // The output now belongs to servo
+        return true;
+    }
+
+    /// @brief Stop the outputs that were not taken over
+    static void release() {
+        for (uint8_t slot = 0; slot < JOURNAL_SLOTS; ++slot) {
+            if (!_servo[slot].attached()) continue;
+            log_w("Journal slot %u is not used any more, output released", slot);
+            _servo[slot].detach();
+        }
+    }
+
+private:
+    static inline ESP32ServoLite _servo[JOURNAL_SLOTS];
+};
 
 class RotorServo {
 
@@ -16,14 +75,10 @@ public:
         if (_init) _servo.detach();
     }
 
-    bool init(int8_t pin, int8_t eepromAddress, int16_t min, int16_t max, int16_t degrees, int8_t direction, float offset) {
-
+    /// @param slot journal slot of the saved position, unique per servo
+    bool init(int8_t pin, int8_t slot, int16_t min, int16_t max, int16_t degrees, int8_t direction, float offset) {
 
-        if (!EEPROM.begin(EEPROM_SIZE)) {
-            log_e("Failed to initialise EEPROM, the servo might jump");
-        } else {
-            log_d("Succesful to initialise EEPROM");
-        }
+        Journal.begin();
 
         _errorString = "";
         if (_init) {
@@ -33,16 +88,16 @@ public:
         }
 
         _pin = pin;
-        _eepromAddress = eepromAddress;
+        _slot = slot;
 
-        if (_eepromAddress < 0 or _eepromAddress > EEPROM_SIZE-4) {
-           _errorString = "EEPROM address out of range";
+        if (_slot < 0 or _slot >= JOURNAL_SLOTS) {
+           _errorString = "Journal slot out of range";
             log_e("%s", _errorString.c_str());
             return false;             
         }
 
-        _targetPulse = _currentPulse = EEPROM.readInt(_eepromAddress);
-        log_i("Target read from EEPROM: %d",_targetPulse);
+        _targetPulse = _currentPulse = Journal.read(_slot);
+        log_i("Target read from journal: %d",_targetPulse);
         _min = min;
         _max = max;
         _degrees = degrees;
@@ -56,49 +111,68 @@ public:
             return false;   
         }
 
+        int16_t saved = _targetPulse;
         if (_targetPulse < _min) { // Don't return error, but set to _min
             _targetPulse = _currentPulse = _min;
-            _errorString = "Target read from EEPROM smaller than minimum value";
+            _errorString = "Saved target smaller than minimum value";
             log_w("%s", _errorString.c_str());
         }
 
         if (_targetPulse > _max) { // Don't return error, but set to _max
-            _errorString = "Target read from EEPROM greater than minimum value";
+            _errorString = "Saved target greater than maximum value";
             _targetPulse = _currentPulse = _max;
             log_w("%s", _errorString.c_str());
         }
 
-        if (_min<300 or _min>1000 or _max>3500 or _max<1500) {
-            _errorString = "Min/max out of range";
-            log_e("%s", _errorString.c_str());
-            return false; 
-        }
+        if (!_checkSettings(_min, _max, _degrees, _direction, _offset)) return false;
 
-        if (_direction != 1 and _direction != -1) {
-            _errorString = "Direction can only be 1 or -1";
-            log_e("%s", _errorString.c_str());
-            return false;             
-        }
+        // Start where the servo is, it has been held there since the reset, so nothing moves
+        _profile.reset(_currentPulse);
+        setLimits(DEFAULT_MAX_SPEED, DEFAULT_MAX_ACCEL, DEFAULT_MAX_JERK);
+        _lastUpdate = micros();
 
-        if (_degrees < 100 or _degrees > 360) {
-           _errorString = "Degree setting out of range";
+        bool held = ServoHold::take(_slot, pin, _min, _max, _servo);
+        int s = held ? 0 : _servo.attach((int)pin, (int)RotorServo::_min, (int)RotorServo::_max);
+        if (s < 0) {
+            _errorString = "No free LEDC channel";
             log_e("%s", _errorString.c_str());
-            return false;   
+            return false;
         }
+        _write();
+        Journal.setOutput(_slot, _pin, _min, _max);
+        if (_currentPulse != saved) _savePosition();   // Moved inside the range
+        _init = true;
+        log_i("Pin=%d, Min=%d, Max=%d, Current Pulse=%d, %s",(int)pin,(int)RotorServo::_min,(int)RotorServo::_max, _currentPulse,
+              held ? "held since the reset" : ("channel " + String(s)).c_str());
+        log_i("Servo on pin %d succesfully initialized.",(int)pin);
+        return true;
+    }
 
-        if (_offset<-360 or _offset>360) {
-           _errorString = "Offset out of range";
+    /// @brief Change the range and angles of a running servo, the calibration pulse and position stay
+    /// Targets outside the new range are moved inside it, set the limits again afterwards (degrees/s on the new scale)
+    bool configure(int16_t min, int16_t max, int16_t degrees, int8_t direction, float offset) {
+        _errorString = "";
+
+        if (!_init) {
+            _errorString = "Call init first!";
             log_e("%s", _errorString.c_str());
-            return false;   
+            return false;
         }
 
-        _currentPulse--;    // Force a small movement on the first run(), it will move to the target again and store in EEPROM
+        if (!_checkSettings(min, max, degrees, direction, offset)) return false;
 
-        int s = _servo.attach((int)pin, (int)RotorServo::_min, (int)RotorServo::_max);
-        _servo.writeMicroseconds(_currentPulse);
-        _init = true;
-        log_i("Pin=%d, Min=%d, Max=%d, Current Pulse=%d Return value=%d",(int)pin,(int)RotorServo::_min,(int)RotorServo::_max, _currentPulse, s);
-        log_i("Servo on pin %d succesfully initialized.",(int)pin);
+        _min = min;
+        _max = max;
+        _degrees = degrees;
+        _direction = direction;
+        _offset = offset;
+        _servo.setRange(_min, _max);
+        Journal.setOutput(_slot, _pin, _min, _max);
+        _calibration = constrain(_calibration, _min, _max);
+        _targetPulse = constrain(_targetPulse, _min, _max);
+        if (!_smooth) _moveQuick();
+        log_i("Servo on pin %d: Min=%d, Max=%d, Degrees=%d, Direction=%d, Offset=%0.1f", (int)_pin, _min, _max, _degrees,
+              _direction, _offset);
         return true;
     }
 
@@ -108,6 +182,7 @@ public:
         if (!_init) {
             _errorString = "Call init first!";
             log_e("%s", _errorString.c_str());
+            servoErrors.add();
             return false;
         }
 
@@ -179,9 +254,9 @@ public:
             b = calibration - a.offset 
         */
 
-        float a = (_max-_min)/_degrees*_direction;
+        float a = _pulsesPerDegree()*_direction;
         float b = _calibration - a*_offset;
-        int16_t y = a*degrees + b;
+        int16_t y = lroundf(a*degrees + b);
 
         if (y<_min) {
             y = _min;
@@ -228,6 +303,19 @@ public:
     }
 
 
+    /// @brief Calibrate without moving there: at pulse the servo is at the offset angle
+    bool setCalibration(int16_t pulse) {
+        _errorString = "";
+        if (pulse < _min or pulse > _max) {
+            _errorString = "Calibration out of range";
+            log_e("%s", _errorString.c_str());
+            return false;
+        }
+        _calibration = pulse;
+        _calibrated = true;
+        return true;
+    }
+
     bool recalibrate(int16_t adjust) {
         _errorString = "";
 
@@ -254,9 +342,51 @@ public:
     
     }
 
-    bool run() {
-        static unsigned long lastUpdate = 0;
+    /// @brief Motion limits when smooth
+    /// @param speed degrees/s, acceleration degrees/s^2, jerk degrees/s^3 (0 for no jerk limit)
+    void setLimits(float speed, float acceleration, float jerk) {
+        float k = _pulsesPerDegree();
+        _profile.configure(speed * k, acceleration * k, jerk * k);
+    }
+
+    /// @brief How far (s) the pulse runs behind the target while tracking, see MotionProfile::delay()
+    float smoothingDelay() { return _smooth ? _profile.delay() : 0.0f; }
+
+    /// @brief Offset on the pulse sent to the servo, from a closed loop around it
+    /// The position, the journal and the profile stay at the uncorrected pulse
+    void correct(int16_t pulses) {
+        if (!_init or pulses == _correction) return;
+        _correction = pulses;
+        _write();
+    }
+
+    /// @brief Slow down so a slew takes longer, see MotionProfile::setTimeScale()
+    void setTimeScale(float scale) { _profile.setTimeScale(scale); }
 
+    /// @brief Estimated time (s) to move from the current position to degrees, 0 when not smooth
+    float slewTime(float degrees) {
+        if (!_init or !_smooth) return 0.0f;
+        float a = _pulsesPerDegree()*_direction;
+        float b = _calibration - a*_offset;
+        return _profile.duration(a*degrees + b - _profile.position());
+    }
+
+    /// @brief Range the servo can reach in degrees, with the current calibration
+    void getRange(float &low, float &high) {
+        float a = _pulsesPerDegree() * _direction;
+        float b = _calibration - a * _offset;
+        low = (_min - b) / a;
+        high = (_max - b) / a;
+        if (low > high) std::swap(low, high);
+    }
+
+    /// @brief Brake to a stop, as quick as the limits allow
+    void stop() {
+        if (!_init) return;
+        _targetPulse = constrain(lroundf(_smooth ? _profile.stoppingPoint() : _currentPulse), _min, _max);
+    }
+
+    bool run() {
         _errorString = "";
 
         if (!_init) {
@@ -269,73 +399,123 @@ public:
         if (_targetPulse < _min or _targetPulse > _max) {
             _errorString = "Target pulse out of range";
             log_e("%s", _errorString.c_str());
-            return false;            
+            servoErrors.add();
+            return false;
         }
 
-        unsigned long now = millis();
-        if (now - lastUpdate >= UPDATE_INTERVAL) {
-            lastUpdate = now;
-            int stepSize = (MAX_US_PER_SECOND * UPDATE_INTERVAL) / 1000; // µs per update
-
-            if (_currentPulse < _targetPulse) {
-                _currentPulse += stepSize;
-                if (_currentPulse > _targetPulse) {
-                _currentPulse = _targetPulse;
-                }
-                log_d("Servo on pin %d: %d",(int)_pin,_currentPulse);
-                _servo.writeMicroseconds(_currentPulse);
-                _writeToEEPROM();
-            }
-            else if (_currentPulse > _targetPulse) {
-                _currentPulse -= stepSize;
-                if (_currentPulse < _targetPulse) {
-                _currentPulse = _targetPulse;
-                }
-                log_d("Servo on pin %d: %d",(int)_pin,_currentPulse);
-                _servo.writeMicroseconds(_currentPulse);
-                _writeToEEPROM();
+        // Follow the S-curve profile, integrated over the real elapsed time since the last call
+        unsigned long now = micros();
+        if (now != _lastUpdate) {
+            float dt = (now - _lastUpdate) / 1e6f;
+            _lastUpdate = now;
+            if (!_smooth) return true;
+
+            bool moving = !_profile.done();
+            _profile.setTarget(_targetPulse);
+            if (_profile.done()) return true;
+            if (!moving) _moveStart = millis();
+
+            long pulse = lroundf(_profile.update(dt));
+            pulse = constrain(pulse, _min, _max);
+            if (pulse != _currentPulse) {
+                _currentPulse = pulse;
+                log_v("Servo on pin %d: %d",(int)_pin,_currentPulse);
+                _write();
+                servoPulses.add();
+                _savePosition();
             }
 
+            if (_profile.done()) {
+                Journal.stopped();  // Save where the move stopped
+                log_d("Servo on pin %d at %d after %lu ms, peak acceleration %0.1f degrees/s2", (int)_pin, _currentPulse,
+                      millis() - _moveStart, _profile.takePeakAcceleration() / _pulsesPerDegree());
+            }
         }
 
         return true;
     }
 
-    float getDegrees() {
-        float a = (_max - _min) / _degrees * _direction;
+    float getDegrees() { return toDegrees(_currentPulse); }
+
+    /// @brief Angle of a pulse, e.g. where the servo really is
+    float toDegrees(float pulse) {
+        float a = _pulsesPerDegree() * _direction;
         float b = _calibration - a * _offset;
-        float degrees = ((float)_currentPulse - b) / a;
+        float degrees = (pulse - b) / a;
         return degrees;
     }
 
+    float pulsesPerDegree() const { return _pulsesPerDegree(); }
+    bool calibrated() const { return _calibrated; }
     int16_t getCurrent() { return _currentPulse; }
+    int16_t getCorrection() { return _correction; }
     int16_t getTarget() { return _targetPulse; }
+    int16_t getMin() { return _min; }
+    int16_t getMax() { return _max; }
+    int8_t  getDirection() { return _direction; }
     String getError() { return _errorString; }
 
 private:
 
-    void _writeToEEPROM() {
-        size_t s = EEPROM.writeInt(_eepromAddress, (int)_currentPulse);
-        if (EEPROM.commit()) {
-            log_d("Writing %d to EEPROM address %d succes", _currentPulse, _eepromAddress);
-        } else {
-            log_d("Writing %d to EEPROM address %d failed", _currentPulse, _eepromAddress);
+    // Not rounded down, before it was the integer (_max - _min) / _degrees: 11 instead of 11.11 for
+    // 500..2500 over 180 degrees, so angles away from _offset moved up to ~1% (calibrate again)
+    float _pulsesPerDegree() const { return (float)(_max - _min) / _degrees; }
+
+    bool _checkSettings(int16_t min, int16_t max, int16_t degrees, int8_t direction, float offset) {
+        if (min<300 or min>1000 or max>3500 or max<1500) {
+            _errorString = "Min/max out of range";
+            log_e("%s", _errorString.c_str());
+            return false; 
         }
+
+        if (direction != 1 and direction != -1) {
+            _errorString = "Direction can only be 1 or -1";
+            log_e("%s", _errorString.c_str());
+            return false;             
+        }
+
+        if (degrees < 100 or degrees > 360) {
+           _errorString = "Degree setting out of range";
+            log_e("%s", _errorString.c_str());
+            return false;   
+        }
+
+        if (offset<-360 or offset>360) {
+           _errorString = "Offset out of range";
+            log_e("%s", _errorString.c_str());
+            return false;   
+        }
+        return true;
+    }
+
+    // Only in RAM, the journal writes it to flash when the move stops or after a while
+    void _savePosition() {
+        Journal.write(_slot, _currentPulse);
+    }
+
+    void _write() {
+        _servo.writeMicroseconds(constrain(_currentPulse + _correction, _min, _max));
     }
 
     void _moveQuick() {
+        if (_currentPulse == _targetPulse) return; // Already there, save a flash write
         _currentPulse = _targetPulse;
-        _servo.writeMicroseconds(_currentPulse);
-        _writeToEEPROM();
+        _profile.reset(_currentPulse);
+        _write();
+        _savePosition();
+        Journal.stopped();
     }
 
     ESP32ServoLite _servo;
     bool    _init = false, _calibrated = false;
     int16_t _min, _max, _degrees;
     float   _offset;
-    int8_t  _pin, _direction = 1, _eepromAddress;
+    int8_t  _pin, _direction = 1, _slot;
     int16_t _currentPulse, _targetPulse, _calibration=0;
+    int16_t _correction = 0;
     String  _errorString = "" ;
     bool    _smooth = false;
+    MotionProfile _profile;
+    unsigned long _lastUpdate = 0, _moveStart = 0;
 
 };
\ No newline at end of file
@@ -1,127 +1,427 @@
 #pragma once
 #include <WiFi.h>
-#include <WebServer.h>
-#include <tuple>
-
-std::tuple<float,float> handleSatDump(float currentAlt, float currentAz) {
-    static float targetAz=0.0, targetAlt=0.0;
-    static WiFiServer rotctldServer(4533);
-    static bool started = false;
-    static WiFiClient client;
-
-    if (!started) {
-        rotctldServer.begin();
-        started = true;
-    }
-
-    if (!client) client = rotctldServer.available();
-
-    if (!client) return {0.0,0.0} ;
-
-    if (!client.connected()) return {0.0,0.0} ;
-  
-
-    if (client.available()) {
-        String cmd = client.readStringUntil('\n');  // rotctld uses \n line endings
-        cmd.trim();
-        log_i("CMD: %s", cmd);
-
-        if (cmd.startsWith("P ")) {
-            // Format: "P az alt"
-            float az, alt;
-            if (sscanf(cmd.c_str(), "P %f %f", &az, &alt) == 2) {
-                targetAz = az;
-                targetAlt = alt;
-                client.print("RPRT 0\n");
-                return {targetAlt,targetAz};
-            } else {
-                client.print("RPRT -1\n");
+#include <metrics.h>
+
+#define ROTCTLD_PORT            4533
+#define ROTCTLD_MAX_CLIENTS     4       // SatDump, gpredict, a logger, ...
+#define ROTCTLD_NAME_LENGTH     16      // Longest long-form command name (\dump_state)
+#define ROTCTLD_OUT_SIZE        256     // Replies are collected and sent with one write
+#define ROTCTLD_TARGET_TIMEOUT  5000    // ms, stop tracking when no new target arrives
+
+#define ROTCTLD_MODEL           2       // Hamlib model number of a NET rotctl rotator
+#define ROTCTLD_INFO            "ESP32 Rotor"
+
+// Hamlib return codes
+#define RPRT_OK         0
+#define RPRT_EINVAL     -1
+#define RPRT_ENIMPL     -4
+
+// Hamlib directions for the M (move) command
+#define ROT_MOVE_UP     2
+#define ROT_MOVE_DOWN   4
+#define ROT_MOVE_LEFT   8
+#define ROT_MOVE_RIGHT  16
+
+inline Counter rotctldCommands("rotor_rotctld_commands_total", "rotctld commands handled");
+inline Counter rotctldInvalid("rotor_rotctld_invalid_total", "rotctld commands that could not be parsed");
+
+enum RotctldCommand : uint8_t { RC_NONE, RC_SET_POS, RC_GET_POS, RC_STOP, RC_MOVE, RC_GET_INFO, RC_DUMP_STATE, RC_QUIT, RC_UNKNOWN };
+
+struct RotctldRequest {
+    RotctldCommand  command = RC_NONE;
+    uint8_t         argc = 0;       // Number of arguments parsed
+    float           args[2] = {0.0, 0.0};
+    char            separator = 0;  // Extended response separator, 0 for the normal response
+    bool            valid = false;  // False when the command or its arguments could not be parsed
+};
+
+/*
+    Streaming rotctld command parser.
+    Bytes are fed one at a time, a request is complete as soon as its last argument has been read.
+    Numbers are accumulated digit by digit, there are no line buffers, Strings or heap allocations.
+    Supports the short and long (\set_pos) command forms and the +;|, extended response prefixes.
+*/
+class RotctldParser {
+
+public:
+    /// @brief Feed one byte
+    /// @return true when a complete request is available in request()
+    bool feed(char c) {
+        bool space = (c == ' ' or c == '\t' or c == '\r' or c == '\n');
+
+        switch (_state) {
+            case PS_IDLE:
+                if (space) return false;
+                _reset();
+                if (c == '+') { _request.separator = '\n'; _state = PS_PREFIX; return false; }
+                if (c == ';' or c == '|' or c == ',') { _request.separator = c; _state = PS_PREFIX; return false; }
+                // fall through
+            case PS_PREFIX:
+                if (space) return false;
+                if (c == '\\') { _nameLength = 0; _state = PS_LONG_NAME; return false; }
+                return _start(_shortCommand(c), false);
+
+            case PS_LONG_NAME:
+                if (!space) {
+                    if (_nameLength < ROTCTLD_NAME_LENGTH) _name[_nameLength++] = c;
+                    else _nameLength = ROTCTLD_NAME_LENGTH + 1; // Too long, will not match anything
+                    return false;
+                }
+                _name[_nameLength <= ROTCTLD_NAME_LENGTH ? _nameLength : 0] = 0;
+                return _start(_longCommand(_name), c == '\n');
+
+            case PS_ARGS:
+                if (space) {
+                    if (_inNumber && !_endNumber()) return _fail(c == '\n');
+                    if (_request.argc == _argsNeeded) return _complete();
+                    if (c == '\n') return _fail(true);  // Line ended before all arguments were read
+                    return false;
+                }
+                if (!_number(c)) return _fail(false);
+                return false;
+
+            case PS_SKIP:
+                if (c == '\n') return _complete();
+                return false;
+        }
+        return false;
+    }
+
+    const RotctldRequest &request() const { return _request; }
+
+private:
+
+    enum State : uint8_t { PS_IDLE, PS_PREFIX, PS_LONG_NAME, PS_ARGS, PS_SKIP };
+    enum NumberPhase : uint8_t { NP_SIGN, NP_INT, NP_FRAC, NP_EXP_SIGN, NP_EXP };
+
+    static RotctldCommand _shortCommand(char c) {
+        switch (c) {
+            case 'P': return RC_SET_POS;
+            case 'p': return RC_GET_POS;
+            case 'S': return RC_STOP;
+            case 'M': return RC_MOVE;
+            case '_': return RC_GET_INFO;
+            case 'q': case 'Q': return RC_QUIT;
+            default:  return RC_UNKNOWN;
+        }
+    }
+
+    static RotctldCommand _longCommand(const char *name) {
+        if (strcmp(name, "set_pos") == 0)       return RC_SET_POS;
+        if (strcmp(name, "get_pos") == 0)       return RC_GET_POS;
+        if (strcmp(name, "stop") == 0)          return RC_STOP;
+        if (strcmp(name, "move") == 0)          return RC_MOVE;
+        if (strcmp(name, "get_info") == 0)      return RC_GET_INFO;
+        if (strcmp(name, "dump_state") == 0)    return RC_DUMP_STATE;
+        if (strcmp(name, "quit") == 0)          return RC_QUIT;
+        return RC_UNKNOWN;
+    }
+
+    static uint8_t _argumentCount(RotctldCommand command) {
+        return (command == RC_SET_POS or command == RC_MOVE) ? 2 : 0;
+    }
+
+    void _reset() {
+        _request = RotctldRequest();
+        _inNumber = false;
+    }
+
+    bool _start(RotctldCommand command, bool endOfLine) {
+        _request.command = command;
+        _argsNeeded = _argumentCount(command);
+        if (command == RC_UNKNOWN) return _fail(endOfLine);
+        if (_argsNeeded == 0) return _complete();
+        if (endOfLine) return _fail(true);
+        _state = PS_ARGS;
+        return false;
+    }
+
+    bool _complete() {
+        _request.valid = _request.command != RC_UNKNOWN && _request.argc == _argsNeeded;
+        _state = PS_IDLE;
+        return true;
+    }
+
+    // Discard the rest of the line, the request is answered with an error
+    bool _fail(bool endOfLine) {
+        _request.argc = 0xFF;
+        if (endOfLine) return _complete();
+        _state = PS_SKIP;
+        return false;
+    }
+
+    // Incremental number parser: [+-]digits[.digits][(e|E)[+-]digits]
+    bool _number(char c) {
+        if (!_inNumber) {
+            if (_request.argc >= _argsNeeded) return false;  // Too many arguments
+            _inNumber = true;
+            _negative = _expNegative = false;
+            _mantissa = 0;
+            _scale = _exponent = 0;
+            _digits = 0;
+            _phase = NP_SIGN;
+        }
+
+        if (c == '-' or c == '+') {
+            if (_phase == NP_SIGN) { _negative = c == '-'; _phase = NP_INT; return true; }
+            if (_phase == NP_EXP_SIGN) { _expNegative = c == '-'; _phase = NP_EXP; return true; }
+            return false;
+        }
+
+        if (c >= '0' && c <= '9') {
+            if (_phase == NP_SIGN) _phase = NP_INT;
+            if (_phase == NP_EXP_SIGN) _phase = NP_EXP;
+            if (_phase == NP_EXP) {
+                if (_exponent < 100) _exponent = _exponent * 10 + (c - '0');
+                return true;
             }
-        } 
-        else if (cmd == "p") {
-            // Report current position
-            char buf[32];
-            snprintf(buf, sizeof(buf), "%.2f %.2f\n", currentAz, currentAlt);
-            client.print(buf);
-            return {targetAlt,targetAz};
-        } 
-        else if (cmd == "q") {
-            client.print("RPRT 0\n");
-            client.stop();
-
-        } 
-        else {
-            client.print("RPRT -1\n");
+            if (_digits < 255) _digits++;
+            if (_mantissa < 100000000) {     // Keep 9 significant digits, more than a float holds
+                _mantissa = _mantissa * 10 + (c - '0');
+                if (_phase == NP_FRAC) _scale--;
+            } else if (_phase == NP_INT) {
+                _scale++;
+            }
+            return true;
         }
+
+        if (c == '.' && (_phase == NP_SIGN || _phase == NP_INT)) { _phase = NP_FRAC; return true; }
+        if ((c == 'e' || c == 'E') && _digits && _phase != NP_EXP_SIGN && _phase != NP_EXP) { _phase = NP_EXP_SIGN; return true; }
+        return false;
     }
 
-    return {0.0,0.0};
-}
-
-
-void satDumpTest() {
-    float alt=0.0, az=0.0;
-    while (true) {
-        log_i("Running");
-        auto res = handleSatDump(alt,az);
-        alt = std::get<0>(res); 
-        az = std::get<1>(res); 
-        if (az!=0.0 and alt!=0.0) log_i("Stadumptest Alt: %0.2f, Az: %0.2f", alt,az);
-        delay(1000);
-    }
-}
-
-std::tuple<float,float> SAVEhandleSatDump(float currentAlt, float currentAz) {
-    static float targetAz=0.0, targetAlt=0.0;
-    static WiFiServer rotctldServer(4533);
-    static bool started = false;
-    static WiFiClient client;
-
-  if (!started) {
-    rotctldServer.begin();
-    started = true;
-  }
-
-  if (!client) client = rotctldServer.available();
-
-  if (client) {
-
-    if (client.connected()) {
-      if (client.available()) {
-        String cmd = client.readStringUntil('\n');  // rotctld uses \n line endings
-        cmd.trim();
-        Serial.println("CMD: " + cmd);
-
-        if (cmd.startsWith("P ")) {
-          // Format: "P az alt"
-          float az, alt;
-          if (sscanf(cmd.c_str(), "P %f %f", &az, &alt) == 2) {
-            targetAz = az;
-            targetAlt = alt;
-            client.print("RPRT 0\n");
-          } else {
-            client.print("RPRT -1\n");
-          }
-        } 
-        else if (cmd == "p") {
-          // Report current position
-          char buf[32];
-          snprintf(buf, sizeof(buf), "%.2f %.2f\n", currentAz, currentAlt);
-          client.print(buf);
-        } 
-        else if (cmd == "q") {
-          client.print("RPRT 0\n");
-          client.stop();
-
-        } 
-        else {
-          client.print("RPRT -1\n");
+    bool _endNumber() {
+        static const float pow10[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+        _inNumber = false;
+        if (_digits == 0 || _phase == NP_EXP_SIGN) return false;
+        int exponent = _scale + (_expNegative ? -_exponent : _exponent);
+        float value = (float)_mantissa;
+        while (exponent > 0) { int e = exponent > 10 ? 10 : exponent; value *= pow10[e]; exponent -= e; }
+        while (exponent < 0) { int e = -exponent > 10 ? 10 : -exponent; value /= pow10[e]; exponent += e; }
+        _request.args[_request.argc++] = _negative ? -value : value;
+        return true;
+    }
+
+    State           _state = PS_IDLE;
+    RotctldRequest  _request;
+    uint8_t         _argsNeeded = 0;
+    char            _name[ROTCTLD_NAME_LENGTH + 1];
+    uint8_t         _nameLength = 0;
+
+    bool            _inNumber = false, _negative = false, _expNegative = false;
+    NumberPhase     _phase = NP_SIGN;
+    uint32_t        _mantissa = 0;
+    int16_t         _scale = 0, _exponent = 0;
+    uint8_t         _digits = 0;
+};
+
+/*
+    Non-blocking rotctld (Hamlib rotator daemon) server.
+    poll() is called on every pass of loop(), it accepts new clients and handles every command
+    that has been received, but never waits for data that is not there yet.
+    All replies to the commands drained in one poll() go out with a single write per client.
+*/
+class RotctldServer {
+
+public:
+    RotctldServer(uint16_t port = ROTCTLD_PORT) : _server(port) {}
+
+    void begin() {
+        _server.begin();
+        _server.setNoDelay(true);
+        _started = true;
+        log_i("rotctld server listening on port %d", ROTCTLD_PORT);
+    }
+
+    /// @brief Set callback function for the S (stop) and M (move) commands
+    /// @param func_ptr gets the request, returns a Hamlib status code (RPRT_OK when succesful)
+    void setCallBack(int(*func_ptr)(const RotctldRequest &)) {
+        _callback = func_ptr;
+    }
+
+    /// @brief Limits reported by \dump_state
+    void setLimits(float minAz, float maxAz, float minEl, float maxEl) {
+        _minAz = minAz; _maxAz = maxAz; _minEl = minEl; _maxEl = maxEl;
+    }
+
+    /// @brief Accept clients and handle all received commands
+    /// @param currentAlt current altitude, reported on 'p'
+    /// @param currentAz current azimuth, reported on 'p'
+    /// @return true when a new target position was received
+    bool poll(float currentAlt, float currentAz) {
+        if (!_started) begin();
+
+        _accept();
+
+        bool newTarget = false;
+        for (auto &c : _connections) {
+            if (!c.active) continue;
+
+            if (!c.client.connected()) {
+                log_i("rotctld client disconnected");
+                c.client.stop();
+                c.active = false;
+                continue;
+            }
+
+            uint8_t buf[64];
+            int n;
+            while (c.active && c.client.available() > 0 && (n = c.client.read(buf, sizeof(buf))) > 0) {
+                for (int i = 0; i < n && c.active; ++i) {
+                    if (c.parser.feed((char)buf[i]))
+                        newTarget |= _handle(c, c.parser.request(), currentAlt, currentAz);
+                }
+            }
+            _flush(c);
         }
-      }
+        return newTarget;
+    }
+
+    float getTargetAlt() { return _targetAlt; }
+    float getTargetAz() { return _targetAz; }
+    unsigned long getTargetTime() { return _targetTime; }
+    bool hasTarget() { return _hasTarget; }
+    uint32_t commands() const { return _commands; }   // Handled since the start
+
+    uint8_t clients() {
+        uint8_t n = 0;
+        for (auto &c : _connections)
+            if (c.active) n++;
+        return n;
     }
 
-  }
+private:
+
+    struct Connection {
+        WiFiClient      client;
+        RotctldParser   parser;
+        char            out[ROTCTLD_OUT_SIZE];
+        uint16_t        outLength = 0;
+        bool            active = false;
+    };
+
+    void _accept() {
+        while (true) {
+            WiFiClient client = _server.available();
+            if (!client) return;
+
+            Connection *slot = nullptr;
+            for (auto &c : _connections)
+                if (!c.active) { slot = &c; break; }
+
+            if (!slot) {
+                log_w("rotctld: too many clients, refusing connection");
+                client.stop();
+                continue;
+            }
+
+            client.setNoDelay(true);
+            slot->client = client;
+            slot->parser = RotctldParser();
+            slot->outLength = 0;
+            slot->active = true;
+            log_i("rotctld client connected (%d active)", clients());
+        }
+    }
+
+    // Append a formatted reply to the output buffer of the connection
+    void _reply(Connection &c, const char *format, ...) __attribute__((format(printf, 3, 4))) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            va_list args;
+            va_start(args, format);
+            int n = vsnprintf(c.out + c.outLength, ROTCTLD_OUT_SIZE - c.outLength, format, args);
+            va_end(args);
+            if (n < 0) return;
+            if (c.outLength + n < ROTCTLD_OUT_SIZE) { c.outLength += n; return; }
+            _flush(c);  // Did not fit, send what we have and try again
+        }
+    }
+
+    void _flush(Connection &c) {
+        if (c.outLength == 0) return;
+        c.client.write((const uint8_t *)c.out, c.outLength);
+        c.outLength = 0;
+    }
+
+    // Hamlib ends every set command, and every extended response, with a status line
+    void _status(Connection &c, int status) {
+        _reply(c, "RPRT %d\n", status);
+    }
+
+    bool _handle(Connection &c, const RotctldRequest &r, float currentAlt, float currentAz) {
+        char sep = r.separator;
+
+        log_d("rotctld command %d valid=%d", (int)r.command, (int)r.valid);
+        rotctldCommands.add();
+        _commands++;
+
+        if (!r.valid) {
+            rotctldInvalid.add();
+            _status(c, RPRT_EINVAL);
+            return false;
+        }
+
+        switch (r.command) {
+            case RC_SET_POS:
+                // Format: "P az alt"
+                _targetAz = r.args[0];
+                _targetAlt = r.args[1];
+                _targetTime = millis();
+                _hasTarget = true;
+                if (sep) _reply(c, "set_pos: %.2f %.2f%c", r.args[0], r.args[1], sep);
+                _status(c, RPRT_OK);
+                return true;
+
+            case RC_GET_POS:
+                if (sep) _reply(c, "get_pos:%cAzimuth: %.2f%cElevation: %.2f%c", sep, currentAz, sep, currentAlt, sep);
+                else     _reply(c, "%.2f\n%.2f\n", currentAz, currentAlt);
+                if (sep) _status(c, RPRT_OK);
+                break;
+
+            case RC_STOP:
+            case RC_MOVE: {
+                int status = _callback ? _callback(r) : RPRT_ENIMPL;
+                if (sep && r.command == RC_STOP) _reply(c, "stop:%c", sep);
+                if (sep && r.command == RC_MOVE) _reply(c, "move: %d %d%c", (int)r.args[0], (int)r.args[1], sep);
+                _status(c, status);
+                break;
+            }
+
+            case RC_GET_INFO:
+                if (sep) _reply(c, "get_info:%cInfo: %s%c", sep, ROTCTLD_INFO, sep);
+                else     _reply(c, "%s\n", ROTCTLD_INFO);
+                if (sep) _status(c, RPRT_OK);
+                break;
+
+            case RC_DUMP_STATE:
+                if (sep) _reply(c, "dump_state:%crotctld Protocol Ver: 1%cRotor Model: %d%cMinimum Azimuth: %.6f%cMaximum Azimuth: %.6f%cMinimum Elevation: %.6f%cMaximum Elevation: %.6f%c",
+                                sep, sep, ROTCTLD_MODEL, sep, _minAz, sep, _maxAz, sep, _minEl, sep, _maxEl, sep);
+                else     _reply(c, "1\n%d\n%.6f\n%.6f\n%.6f\n%.6f\n", ROTCTLD_MODEL, _minAz, _maxAz, _minEl, _maxEl);
+                if (sep) _status(c, RPRT_OK);
+                break;
+
+            case RC_QUIT:
+                _status(c, RPRT_OK);
+                _flush(c);
+                c.client.stop();
+                c.active = false;
+                break;
+
+            default:
+                _status(c, RPRT_EINVAL);
+                break;
+        }
+        return false;
+    }
 
-  
-  return {targetAlt,targetAz};
-}
\ No newline at end of file
+    WiFiServer  _server;
+    Connection  _connections[ROTCTLD_MAX_CLIENTS];
+    int         (*_callback)(const RotctldRequest &) = nullptr;
+    bool        _started = false;
+    bool        _hasTarget = false;
+    float       _targetAlt = 0.0, _targetAz = 0.0;
+    unsigned long _targetTime = 0;
+    uint32_t    _commands = 0;
+    float       _minAz = 0.0, _maxAz = 360.0, _minEl = 0.0, _maxEl = 90.0;
+};
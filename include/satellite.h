@@ -0,0 +1,127 @@
+#pragma once
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <ArduinoJson.h>
+#include <sgp4.h>
+#include <astro.h>
+#include <doublebuffer.h>
+
+#define SATELLITE_LIST_MAX  100     // Names returned to the web page
+
+/*
+    Satellite tracking on the ESP32 itself from the TLE files (*.tle) in SPIFFS.
+    The files are only read from the web server task when a satellite is selected. The elements
+    are handed to the control loop through a double buffer and the loop propagates its own copy,
+    so no file or network access is needed while tracking.
+*/
+class SatelliteTracker {
+
+public:
+    void setObserver(const Observer &observer) { _observer = observer; }
+
+    /// @brief Add the names of all satellites in the TLE files (web server task)
+    void list(JsonArray names) {
+        _forEachTle([&](const char *name, const char *, const char *) {
+            names.add(name);
+            return names.size() >= SATELLITE_LIST_MAX;
+        });
+    }
+
+    /// @brief Select the satellite to track, an empty name stops the satellite tracking (web server task)
+    /// @return false if not found or not supported, see getError()
+    bool select(const String &name) {
+        _error = "";
+        Sgp4 sgp4;
+
+        if (name != "") {
+            Tle tle;
+            bool found = false;
+            _forEachTle([&](const char *n, const char *line1, const char *line2) {
+                if (name == n) found = parseTle(n, line1, line2, tle);
+                return found;
+            });
+            if (!found) {
+                _error = "Satellite " + name + " not found";
+                return false;
+            }
+            if (!sgp4.init(tle)) {
+                _error = "Invalid elements for " + name;
+                return false;
+            }
+            log_i("Selected %s, epoch JD %0.5f%s", tle.name, tle.epoch, sgp4.deepSpace() ? ", deep space" : "");
+        }
+
+        _buffer.write(sgp4);
+        return true;
+    }
+
+    /// @brief Pick up a new selection (control loop)
+    void update() {
+        _buffer.read(_sgp4, _version);
+    }
+
+    /// @brief A satellite is selected (control loop)
+    bool active() const { return _sgp4.initialized(); }
+
+    const char *name() const { return _sgp4.tle().name; }
+
+    /// @brief Position of the selected satellite (control loop)
+    /// @param offsetMs look ahead from the current time
+    /// @param alt, az receive the position in degrees
+    /// @return nullptr or an error message
+    const char *position(long offsetMs, float &alt, float &az) {
+        if (!clockSet()) return CLOCK_NOT_SET;
+
+        double jd = julianDateNow(offsetMs);
+        double r[3], v[3];
+        if (!_sgp4.propagateTo(jd, r, v)) return _sgp4.error() == 6 ? "Satellite decayed" : "Propagation failed";
+
+        double a, z;
+        temeToAltAz(_observer, jd, r, a, z);
+        alt = a;
+        az = z;
+        return nullptr;
+    }
+
+    /// @brief Error of the last select()
+    String getError() const { return _error; }
+
+private:
+
+    /// @brief Call f(name, line1, line2) for every TLE in the *.tle files, until it returns true
+    template <typename F>
+    void _forEachTle(F f) {
+        File dir = SPIFFS.open("/");
+        if (!dir) return;
+
+        bool done = false;
+        for (File file = dir.openNextFile(); file and !done; file = dir.openNextFile()) {
+            String path = file.path();
+            if (!path.endsWith(".tle")) continue;
+
+            // Both the three line (with name) and the two line format, the name then is the catalog number
+            String name, line1;
+            while (file.available() and !done) {
+                String line = file.readStringUntil('\n');
+                line.trim();
+                if (line.startsWith("1 ") and line.length() >= 69) {
+                    line1 = line;
+                } else if (line.startsWith("2 ") and line.length() >= 69 and line1 != "") {
+                    if (name == "") name = line1.substring(2, 7);
+                    done = f(name.c_str(), line1.c_str(), line.c_str());
+                    name = line1 = "";
+                } else {
+                    name = line.startsWith("0 ") ? line.substring(2) : line;
+                    line1 = "";
+                }
+            }
+            file.close();
+        }
+    }
+
+    Observer _observer;
+    DoubleBuffer<Sgp4> _buffer;
+    uint32_t _version = 0;
+    Sgp4 _sgp4;
+    String _error;
+};
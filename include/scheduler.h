@@ -0,0 +1,63 @@
+#pragma once
+#include <Arduino.h>
+#include <rotorservo.h>
+
+#define MAX_AXES    LEDC_CHANNELS   // One LEDC channel each
+
+/*
+    Owns the axes of the board: AZ and ALT, a polarisation rotator, a second rotor pair, up to one
+    per LEDC channel. Every axis keeps its own timing and motion state, run() steps them all in one
+    pass per tick of the motion task.
+    Axes added with a servo of their own (AZ and ALT in main.cpp) stay owned by the caller, the
+    ones created here live as long as the program.
+*/
+class MotionScheduler {
+
+public:
+    /// @brief Add an existing servo
+    /// @return false when the name is taken or there is no room
+    bool add(const String &name, RotorServo *servo) {
+        if (_count >= MAX_AXES or get(name)) return false;
+        _names[_count] = name;
+        _axes[_count++] = servo;
+        return true;
+    }
+
+    /// @brief Add a new servo, init it yourself
+    /// @return nullptr when the name is taken or there is no room
+    RotorServo *create(const String &name) {
+        if (_count >= MAX_AXES or get(name)) return nullptr;
+        RotorServo *servo = new RotorServo();
+        add(name, servo);
+        return servo;
+    }
+
+    RotorServo *get(const String &name) const {
+        for (uint8_t i = 0; i < _count; ++i)
+            if (_names[i] == name) return _axes[i];
+        return nullptr;
+    }
+
+    uint8_t count() const { return _count; }
+    RotorServo *axis(uint8_t i) const { return i < _count ? _axes[i] : nullptr; }
+    const String &name(uint8_t i) const { return _names[i]; }
+
+    /// @brief Step all axes
+    /// @return false if one of them failed, see getError()
+    bool run() {
+        _errorString = "";
+        for (uint8_t i = 0; i < _count; ++i) {
+            if (!_axes[i]->run() and _errorString == "")
+                _errorString = "Failed to move " + _names[i] + ": " + _axes[i]->getError();
+        }
+        return _errorString == "";
+    }
+
+    String getError() const { return _errorString; }
+
+private:
+    RotorServo *_axes[MAX_AXES] = {};
+    String _names[MAX_AXES];
+    uint8_t _count = 0;
+    String _errorString;
+};
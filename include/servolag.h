@@ -0,0 +1,477 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include <rotorservo.h>
+#include <feedback.h>
+
+#define LAG_NAMESPACE       "lag"
+#define LAG_SAMPLES         1536    // Recorded by an identification, 30 s at the sample period
+#define LAG_SAMPLE_PERIOD   20      // ms, at faster motion rates only every so many steps are recorded
+#define LAG_MAX_DELAY       0.3     // s, dead time range of the fit
+#define LAG_MAX_TAU         1.0     // s, time constant range of the fit
+#define LAG_HISTORY         32      // Commanded pulses kept by the follower for the dead time
+#define LAG_SETTLE          500     // ms the feedback has to stay within LAG_SETTLE_COUNTS
+#define LAG_SETTLE_COUNTS   12      // ADC counts, twice that of an encoder
+#define LAG_SETTLE_TIMEOUT  4000    // ms after the pulse arrived
+#define LAG_MIN_SPAN        200     // ADC counts between the two calibration points, twice that of an encoder
+#define LAG_ERROR_WINDOW    10.0f   // s, averaging time of the tracking error
+
+/*
+    Where the servo really is, behind its pulse: a dead time followed by a first order lag with
+    time constant tau. On a ramp the servo then runs delay + tau behind the pulse, so a moving
+    target is reached when the pulse is that far ahead of it.
+    Identified with a feedback input (see FeedbackInput) and kept in NVS, together with the two
+    points that map the raw feedback on pulses.
+*/
+struct LagModel {
+  float    delay = 0.0, tau = 0.0;      // s
+  float    rms = 0.0;                   // us, of the fit
+  int16_t  pulseLow = 0, pulseHigh = 0; // Feedback calibration: at these pulses
+  float    rawLow = 0, rawHigh = 0;     // the feedback read these counts, rawHigh unwrapped from rawLow
+  uint16_t modulus = 0;                 // of the feedback, 0 when it does not wrap
+
+  /// @brief Only an identification fills in the calibration
+  bool identified() const { return rawLow != rawHigh; }
+  /// @brief How far (s) the servo runs behind its pulse on a ramp
+  float lead() const { return delay + tau; }
+  /// @brief Raw feedback to pulse, a wrapping reading is taken nearest to the calibrated range
+  float pulse(float raw) const {
+    if (modulus) raw = unwrap(raw, (rawLow + rawHigh) / 2);
+    return pulseLow + (raw - rawLow) * (pulseHigh - pulseLow) / (rawHigh - rawLow);
+  }
+  /// @brief The reading modulo modulus that is nearest to near
+  float unwrap(float raw, float near) const {
+    return modulus ? near + difference(raw, near) : raw;
+  }
+  /// @brief a - b, the short way round
+  float difference(float a, float b) const {
+    float d = a - b;
+    if (modulus) d -= modulus * roundf(d / modulus);
+    return d;
+  }
+};
+
+/// @brief The identified models in NVS, a record per axis name
+/// A record of another size (of an older version) reads as not identified
+class LagStore {
+
+public:
+  /// @return false when the axis was never identified
+  static bool read(const char *axis, LagModel &model) {
+    Preferences nvs;
+    if (!nvs.begin(LAG_NAMESPACE, true)) return false;
+    LagModel stored;
+    bool ok = nvs.getBytes(axis, &stored, sizeof(stored)) == sizeof(stored);
+    nvs.end();
+    if (ok) model = stored;
+    return ok;
+  }
+
+  static bool write(const char *axis, const LagModel &model) {
+    Preferences nvs;
+    if (!nvs.begin(LAG_NAMESPACE, false)) return false;
+    bool ok = nvs.putBytes(axis, &model, sizeof(model)) == sizeof(model);
+    nvs.end();
+    if (!ok) log_e("Could not save the lag of %s", axis);
+    return ok;
+  }
+};
+
+/*
+    The lag of one axis while running. Every motion step the commanded pulse is run through the
+    model, which gives where the servo is expected to be. With a feedback input that is measured
+    as well, and while tracking the difference with the intended trajectory is kept as an RMS.
+*/
+class AxisLag {
+
+public:
+  void begin(const char *axis, const FeedbackInput &feedback) {
+    strlcpy(_axis, axis, sizeof(_axis));
+    _feedback = feedback;
+    if (!LagStore::read(axis, _model)) return;
+    if (_model.modulus != feedback.modulus()) {
+      log_w("Lag of %s was identified with another FEEDBACK, identify it again", axis);
+      _model = LagModel();
+      return;
+    }
+    log_i("Lag of %s: delay %0.0f ms, tau %0.0f ms", axis, _model.delay * 1e3, _model.tau * 1e3);
+  }
+
+  const char *axis() const { return _axis; }
+  bool hasFeedback() const { return _feedback.present(); }
+  const FeedbackInput &feedback() const { return _feedback; }
+
+  /// @brief Read the feedback, once every motion step after the axes ran
+  void sample() {
+    _valid = _feedback.read(_raw);
+  }
+
+  /// @brief Raw feedback of the last sample(), false when there is none
+  bool raw(uint16_t &raw) const {
+    raw = _raw;
+    return _valid;
+  }
+
+  /// @brief Measured pulse of the last sample(), false without a (calibrated) feedback
+  bool measured(float &pulse) const {
+    if (!_valid or !_model.identified()) return false;
+    pulse = _model.pulse(_raw);
+    return true;
+  }
+
+  /// @brief Where the servo is: measured when possible, else where the model has it
+  float position() const {
+    float pulse;
+    return measured(pulse) ? pulse : _pulse;
+  }
+
+  const LagModel &model() const { return _model; }
+  void setModel(const LagModel &model) {
+    _model = model;
+    _primed = false;
+  }
+
+  /// @brief How far (s) the servo runs behind its pulse, 0 when not identified
+  float lead() const { return _model.identified() ? _model.lead() : 0.0; }
+
+  /// @brief Run the commanded pulse through the model, every motion step
+  /// @param dt s since the last step
+  void step(int16_t pulse, float dt) {
+    if (!_primed) {
+      for (float &p : _history) p = pulse;
+      _pulse = pulse;
+      _primed = true;
+    }
+    _head = (_head + 1) % LAG_HISTORY;
+    _history[_head] = pulse;
+    if (!_model.identified() or dt <= 0.0) {
+      _pulse = pulse;
+      return;
+    }
+
+    // Pulse of delay ago, between the two steps around it
+    float back = std::min(_model.delay / dt, (float)LAG_HISTORY - 2);
+    uint8_t steps = back;
+    float f = back - steps;
+    float u = _history[(_head + LAG_HISTORY - steps) % LAG_HISTORY] * (1 - f) +
+              _history[(_head + LAG_HISTORY - steps - 1) % LAG_HISTORY] * f;
+    _pulse += (_model.tau > 0.0 ? 1 - expf(-dt / _model.tau) : 1.0f) * (u - _pulse);
+  }
+
+  /// @brief Where the model has the servo, the commanded pulse when not identified
+  float pulse() const { return _pulse; }
+
+  /// @brief Add a tracking error (degrees, measured - intended)
+  void error(float degrees, float dt) {
+    _errorSquare += std::min(dt / LAG_ERROR_WINDOW, 1.0f) * (degrees * degrees - _errorSquare);
+  }
+  float trackingError() const { return sqrtf(_errorSquare); }
+
+private:
+  char _axis[16] = "";
+  FeedbackInput _feedback;
+  uint16_t _raw = 0;
+  bool _valid = false;
+  LagModel _model;
+  float _history[LAG_HISTORY] = {};
+  uint8_t _head = 0;
+  float _pulse = 0.0;
+  bool _primed = false;
+  float _errorSquare = 0.0;
+};
+
+enum LagStage : uint8_t { LS_IDLE, LS_LOW, LS_HIGH, LS_MOVES, LS_FIT, LS_DONE, LS_FAILED };
+
+/// @brief One recorded motion step of an identification
+struct LagSample {
+  uint16_t time;                        // ms since the first sample
+  int16_t  pulse;                       // Commanded
+  int16_t  feedback;                    // Raw, in pulses after the calibration
+};
+
+/// @brief How an identification is doing, for GET /identify
+struct LagReport {
+  LagStage stage = LS_IDLE;
+  char     axis[16] = "";
+  char     error[48] = "";
+  uint16_t samples = 0;
+  LagModel model;                       // Once done
+};
+
+/*
+    Identifies the lag of one axis with its feedback input. The servo is moved to 25% and 75% of
+    its range to map the feedback on the pulses, then makes a step and two ramps (at half and 0.3
+    of the speed limit) while the commanded and the measured pulse are recorded. The motion task runs the
+    moves, the fit is left to loop() as it takes a while: delay and tau that make the model follow
+    the measured pulse best, over a grid of delays and a golden section search of tau each.
+*/
+class LagIdentifier {
+
+public:
+  /// @brief Start, under the control lock
+  bool start(RotorServo &servo, AxisLag &lag, String &error) {
+    if (active()) {
+      error = String("Identifying ") + _report.axis;
+      return false;
+    }
+    if (!lag.hasFeedback()) {
+      error = String(lag.axis()) + " has no FEEDBACK or ENCODER_CS";
+      return false;
+    }
+    delete[] _samples;
+    _samples = new (std::nothrow) LagSample[LAG_SAMPLES];
+    if (!_samples) {
+      error = "Out of memory";
+      return false;
+    }
+    _servo = &servo;
+    _lag = &lag;
+    _start = servo.getCurrent();
+    int16_t span = servo.getMax() - servo.getMin();
+    _low = servo.getMin() + span / 4;
+    _high = servo.getMax() - span / 4;
+    _count = 0;
+    _steps = 0;
+    _lastRaw = millis();
+    _model = LagModel();
+    _model.modulus = lag.feedback().modulus();
+    _counts = _model.modulus ? 2 : 1;    // Per degree, against a potentiometer over 180 degrees
+    LagReport report;
+    strlcpy(report.axis, lag.axis(), sizeof(report.axis));
+    _setReport(report);
+    _moveTo(LS_LOW, _low, 1.0);
+    log_i("Identifying the lag of %s", lag.axis());
+    return true;
+  }
+
+  /// @brief Stop the moves, under the control lock
+  void stop(const char *why) {
+    if (_stage < LS_LOW or _stage > LS_MOVES) return;
+    _fail(why);
+  }
+
+  /// @brief Moving the axis or fitting
+  bool active() const { return _stage >= LS_LOW and _stage <= LS_FIT; }
+  bool moving(const RotorServo *servo) const { return _stage >= LS_LOW and _stage <= LS_MOVES and servo == _servo; }
+
+  /// @brief Next part of the moves, every motion step after the axes ran, under the control lock
+  /// @param dt motion period in seconds
+  void step(float dt) {
+    if (_stage < LS_LOW or _stage > LS_MOVES) return;
+    uint32_t now = millis();
+    uint16_t raw;
+    if (!_lag->raw(raw)) {          // Next step, unless the feedback stays away
+      if (now - _lastRaw > LAG_SETTLE_TIMEOUT) _fail("The feedback does not answer");
+      return;
+    }
+    _lastRaw = now;
+
+    // Every step at the default rate, counted in steps so a late one is not skipped. Its time goes with it
+    uint16_t stride = std::max(1L, lroundf(LAG_SAMPLE_PERIOD / 1000.0f / dt));
+    if (_stage == LS_MOVES and _count < LAG_SAMPLES and _steps++ % stride == 0) {
+      if (!_count) _firstSample = now;
+      _samples[_count].time = now - _firstSample;
+      _samples[_count].pulse = _servo->getCurrent();
+      _samples[_count++].feedback = raw;
+    }
+
+    // Wait for the pulse to arrive and the feedback to stay put
+    if (_servo->getCurrent() != _servo->getTarget()) {
+      _arrived = 0;
+      return;
+    }
+    if (!_arrived or fabsf(_model.difference(raw, _steady)) > LAG_SETTLE_COUNTS * _counts) {
+      if (!_arrived) _arrived = now;
+      _steady = raw;
+      _steadySince = now;
+    }
+    if (now - _steadySince < LAG_SETTLE) {
+      if (now - _arrived > LAG_SETTLE_TIMEOUT) _fail("The feedback does not settle");
+      return;
+    }
+
+    switch (_stage) {
+      case LS_LOW:
+        _model.pulseLow = _low;
+        _model.rawLow = raw;
+        _moveTo(LS_HIGH, _high, 1.0);
+        break;
+      case LS_HIGH:
+        _model.pulseHigh = _high;
+        _model.rawHigh = _model.unwrap(raw, _model.rawLow);
+        if (fabsf(_model.rawHigh - _model.rawLow) < LAG_MIN_SPAN * _counts) {
+          _fail("The feedback does not follow the servo");
+          break;
+        }
+        _move = 0;
+        _moveTo(LS_MOVES, _low, 1.0);
+        break;
+      default:
+        if (++_move == 1) {
+          _moveTo(LS_MOVES, _high, 0.5);
+        } else if (_move == 2) {
+          _moveTo(LS_MOVES, _low, 0.3);
+        } else {
+          _servo->setTimeScale(1.0);
+          _servo->moveTo(_start);
+          _stage = LS_FIT;
+        }
+    }
+  }
+
+  /// @brief The moves are done, fit() is due
+  bool fitDue() const { return _stage == LS_FIT; }
+
+  /// @brief Fit the model and save it, from loop() outside the control lock
+  /// @return false when it failed, see report()
+  bool fit() {
+    LagReport report = this->report();
+    report.samples = _count;
+    if (_count < LAG_SETTLE * 4 / LAG_SAMPLE_PERIOD) {
+      _fail("Too few samples");
+      return false;
+    }
+    // The recorded counts become pulses
+    for (uint16_t i = 0; i < _count; ++i) _samples[i].feedback = lroundf(_model.pulse(_samples[i].feedback));
+    float period = _samples[_count - 1].time / 1000.0f / (_count - 1);   // Average, the model uses the real spacing
+
+    // Dead times a whole average period apart first, then around the best one in eighths
+    float bestDelay = 0, bestTau = 0, best = INFINITY;
+    uint8_t steps = LAG_MAX_DELAY / period;
+    for (uint8_t d = 0; d <= steps; ++d) _fitTau(d * period, bestDelay, bestTau, best);
+    float coarse = bestDelay;
+    for (int8_t i = -7; i <= 7; ++i)
+      if (i and coarse + i * period / 8.0f >= 0) _fitTau(coarse + i * period / 8.0f, bestDelay, bestTau, best);
+
+    _model.delay = bestDelay;
+    _model.tau = bestTau;
+    _model.rms = sqrtf(best / _count);
+    delete[] _samples;
+    _samples = nullptr;
+
+    LagStore::write(_lag->axis(), _model);
+    report.stage = LS_DONE;
+    report.model = _model;
+    _setReport(report);
+    _stage = LS_DONE;
+    log_i("Lag of %s: delay %0.0f ms, tau %0.0f ms, rms %0.1f us over %u samples", report.axis,
+          _model.delay * 1e3, _model.tau * 1e3, _model.rms, _count);
+    return true;
+  }
+
+  /// @brief Use the fitted model, under the control lock
+  void apply() {
+    if (_stage == LS_DONE and _lag) _lag->setModel(_model);
+  }
+
+  /// @brief Copy of the state (any task)
+  LagReport report() const {
+    LagReport report;
+    portENTER_CRITICAL(&_mux);
+    report = _report;
+    portEXIT_CRITICAL(&_mux);
+    return report;
+  }
+
+private:
+  void _moveTo(LagStage stage, int16_t pulse, float scale) {
+    _stage = stage;
+    _arrived = 0;
+    _servo->setTimeScale(scale);
+    _servo->moveTo(pulse);
+    LagReport report = this->report();
+    report.stage = stage;
+    report.samples = _count;
+    _setReport(report);
+  }
+
+  void _fail(const char *why) {
+    log_w("Identifying %s: %s", _lag->axis(), why);
+    if (_stage != LS_FIT) {
+      _servo->setTimeScale(1.0);
+      _servo->moveTo(_start);
+    }
+    _stage = LS_FAILED;
+    delete[] _samples;
+    _samples = nullptr;
+    LagReport report = this->report();
+    report.stage = LS_FAILED;
+    strlcpy(report.error, why, sizeof(report.error));
+    _setReport(report);
+  }
+
+  void _setReport(const LagReport &report) {
+    portENTER_CRITICAL(&_mux);
+    _report = report;
+    portEXIT_CRITICAL(&_mux);
+  }
+
+  /// @brief Best tau for a dead time (s) by golden section, keeps the best so far
+  void _fitTau(float delay, float &bestDelay, float &bestTau, float &best) {
+    const float g = 0.618034f;
+    float a = 0.0, b = LAG_MAX_TAU;
+    float c = b - g * (b - a), d = a + g * (b - a);
+    float fc = _error(delay, c), fd = _error(delay, d);
+    for (uint8_t i = 0; i < 24; ++i) {
+      if (fc < fd) {
+        b = d; d = c; fd = fc;
+        c = b - g * (b - a);
+        fc = _error(delay, c);
+      } else {
+        a = c; c = d; fc = fd;
+        d = a + g * (b - a);
+        fd = _error(delay, d);
+      }
+    }
+    // Without a lag at all the search never gets there
+    float tau = fc < fd ? c : d, error = std::min(fc, fd), none = _error(delay, 0.0);
+    if (none <= error) {
+      tau = 0.0;
+      error = none;
+    }
+    if (error < best) {
+      best = error;
+      bestDelay = delay;
+      bestTau = tau;
+    }
+  }
+
+  /// @brief Sum of the squared differences between the model and the measured pulses
+  /// The same steps as AxisLag::step(), each over the time between its samples
+  float _error(float delay, float tau) const {
+    float y = _samples[0].feedback, sum = 0.0;
+    int k = 0;    // Last sample at or before the delayed time, it only moves forward
+    for (int i = 1; i < _count; ++i) {
+      float dt = (_samples[i].time - _samples[i - 1].time) / 1000.0f;
+      float a = tau > 0.0 ? 1 - expf(-dt / tau) : 1.0f;
+      float t = _samples[i].time - delay * 1000.0f;
+      while (k + 1 < i and _samples[k + 1].time <= t) k++;
+      float u = _samples[0].pulse;
+      if (t > _samples[0].time) {
+        const LagSample &from = _samples[k], &to = _samples[k + 1];
+        float f = std::min((t - from.time) / std::max(to.time - from.time, 1), 1.0f);
+        u = from.pulse + f * (to.pulse - from.pulse);
+      }
+      y += a * (u - y);
+      float e = _samples[i].feedback - y;
+      sum += e * e;
+    }
+    return sum;
+  }
+
+  RotorServo *_servo = nullptr;
+  AxisLag *_lag = nullptr;
+  volatile LagStage _stage = LS_IDLE;
+  int16_t _start = 0, _low = 0, _high = 0;
+  uint8_t _move = 0;
+  uint32_t _arrived = 0, _steadySince = 0;
+  uint16_t _steady = 0;
+  uint8_t _counts = 1;                  // Settle and span counts per ADC count
+  LagSample *_samples = nullptr;
+  uint16_t _count = 0;
+  uint32_t _steps = 0;                  // Motion steps while recording
+  uint32_t _firstSample = 0, _lastRaw = 0;
+  LagModel _model;
+  LagReport _report;
+  mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
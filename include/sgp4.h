@@ -0,0 +1,725 @@
+#pragma once
+#include <Arduino.h>
+#include <astro.h>
+
+/*
+    SGP4/SDP4 satellite propagator for two line element sets (TLE).
+    Follows Vallado's reference implementation ("Revisiting Spacetrack Report #3", 2006) with the
+    WGS-72 constants the elements are fitted with, in the improved mode (opsmode 'i').
+    Deep space objects (orbital period of 225 minutes or more, e.g. GPS, Molniya or geostationary)
+    get the SDP4 lunar/solar terms and the resonances of 12 and 24 hour orbits. The resonance
+    integrator restarts at the epoch on every call, so propagate() keeps no state between calls
+    and costs a step per 720 minutes from the epoch.
+    Positions are in km, velocities in km/s, in the TEME frame.
+*/
+
+#define TLE_NAME_LENGTH     25
+
+struct Tle {
+    char    name[TLE_NAME_LENGTH] = "";
+    double  epoch = 0.0;        // Julian date (UTC)
+    double  bstar = 0.0;        // 1/earth radii
+    double  inclination = 0.0;  // radians
+    double  raan = 0.0;         // radians
+    double  eccentricity = 0.0;
+    double  argPerigee = 0.0;   // radians
+    double  meanAnomaly = 0.0;  // radians
+    double  meanMotion = 0.0;   // radians/minute (Kozai)
+};
+
+/// @brief Julian date of a calendar date (UTC)
+double julianDate(int year, int month, int day, int hour = 0, int minute = 0, double second = 0.0) {
+    return 367.0 * year - floor((7 * (year + floor((month + 9) / 12.0))) * 0.25) + floor(275 * month / 9.0)
+           + day + 1721013.5 + ((second / 60.0 + minute) / 60.0 + hour) / 24.0;
+}
+
+namespace tle_detail {
+
+// Parse a fixed column field, columns are 1 based as in the TLE documentation
+inline double field(const char *line, int from, int to) {
+    char buf[16];
+    int n = 0;
+    for (int i = from - 1; i < to && line[i] && n < (int)sizeof(buf) - 1; ++i) buf[n++] = line[i];
+    buf[n] = 0;
+    return atof(buf);
+}
+
+// Exponential fields like " 28098-4" mean 0.28098e-4, the decimal point is assumed
+inline double assumedDecimal(const char *line, int from, int to) {
+    char buf[16];
+    int n = 0;
+    const char *p = line + from - 1;
+    while (p < line + to && *p == ' ') p++;
+    if (*p == '-' || *p == '+') buf[n++] = *p++;
+    buf[n++] = '.';
+    while (p < line + to && isdigit((unsigned char)*p) && n < 12) buf[n++] = *p++;
+    buf[n++] = 'e';
+    while (p < line + to && (*p == '-' || *p == '+' || isdigit((unsigned char)*p)) && n < 15) buf[n++] = *p++;
+    buf[n] = 0;
+    return atof(buf);
+}
+
+inline bool checksum(const char *line) {
+    if (strlen(line) < 69) return false;
+    int sum = 0;
+    for (int i = 0; i < 68; ++i) {
+        if (isdigit((unsigned char)line[i])) sum += line[i] - '0';
+        else if (line[i] == '-') sum += 1;
+    }
+    return sum % 10 == line[68] - '0';
+}
+
+} // namespace tle_detail
+
+/// @brief Parse a TLE
+/// @param name name line (may be empty), line1 and line2 the element lines
+/// @param tle receives the elements
+/// @return false when the lines are not a valid TLE
+bool parseTle(const char *name, const char *line1, const char *line2, Tle &tle) {
+    using namespace tle_detail;
+
+    if (line1[0] != '1' || line2[0] != '2' || !checksum(line1) || !checksum(line2)) return false;
+
+    // Name, without the optional "0 " prefix and trailing white space
+    if (name[0] == '0' && name[1] == ' ') name += 2;
+    strlcpy(tle.name, name, sizeof(tle.name));
+    for (int i = strlen(tle.name) - 1; i >= 0 && isspace((unsigned char)tle.name[i]); --i) tle.name[i] = 0;
+
+    int year = (int)field(line1, 19, 20);
+    year += year < 57 ? 2000 : 1900;
+    double days = field(line1, 21, 32);
+    tle.epoch = julianDate(year, 1, 1) + days - 1.0;
+    tle.bstar = assumedDecimal(line1, 54, 61);
+
+    const double deg2rad = M_PI / 180.0;
+    tle.inclination = field(line2, 9, 16) * deg2rad;
+    tle.raan = field(line2, 18, 25) * deg2rad;
+    char ecc[10] = "0.";
+    strncat(ecc, line2 + 26, 7);
+    tle.eccentricity = atof(ecc);
+    tle.argPerigee = field(line2, 35, 42) * deg2rad;
+    tle.meanAnomaly = field(line2, 44, 51) * deg2rad;
+    tle.meanMotion = field(line2, 53, 63) * 2.0 * M_PI / 1440.0;
+    return tle.meanMotion > 0.0;
+}
+
+class Sgp4 {
+
+public:
+    // WGS-72
+    static constexpr double RE = 6378.135;             // km
+    static constexpr double MU = 398600.8;             // km^3/s^2
+    static constexpr double J2 = 0.001082616;
+    static constexpr double J3 = -0.00000253881;
+    static constexpr double J4 = -0.00000165597;
+
+    bool init(const Tle &tle) {
+        _tle = tle;
+        _init = false;
+        _error = 0;
+
+        const double x2o3 = 2.0 / 3.0;
+        _xke = 60.0 / sqrt(RE * RE * RE / MU);
+        _j3oj2 = J3 / J2;
+
+        double ss = 78.0 / RE + 1.0;
+        double qzms2t = pow((120.0 - 78.0) / RE, 4);
+
+        double ecco = tle.eccentricity, inclo = tle.inclination;
+        double eccsq = ecco * ecco;
+        double omeosq = 1.0 - eccsq;
+        double rteosq = sqrt(omeosq);
+        double cosio = cos(inclo);
+        double cosio2 = cosio * cosio;
+
+        // Un-Kozai the mean motion
+        double ak = pow(_xke / tle.meanMotion, x2o3);
+        double d1 = 0.75 * J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+        double del = d1 / (ak * ak);
+        double adel = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+        del = d1 / (adel * adel);
+        _no = tle.meanMotion / (1.0 + del);
+
+        double ao = pow(_xke / _no, x2o3);
+        _sinio = sin(inclo);
+        _cosio = cosio;
+        double po = ao * omeosq;
+        double con42 = 1.0 - 5.0 * cosio2;
+        _con41 = -con42 - cosio2 - cosio2;
+        double posq = po * po;
+        double rp = ao * (1.0 - ecco);
+
+        if (omeosq < 0.0 || _no < 0.0) {
+            _error = 1;
+            return false;
+        }
+
+        _deep = 2.0 * M_PI / _no >= 225.0;
+        _isimp = _deep || rp < (220.0 / RE + 1.0);
+
+        double sfour = ss, qzms24 = qzms2t;
+        double perige = (rp - 1.0) * RE;
+        if (perige < 156.0) {
+            sfour = perige - 78.0;
+            if (perige < 98.0) sfour = 20.0;
+            qzms24 = pow((120.0 - sfour) / RE, 4);
+            sfour = sfour / RE + 1.0;
+        }
+
+        double pinvsq = 1.0 / posq;
+        double tsi = 1.0 / (ao - sfour);
+        _eta = ao * ecco * tsi;
+        double etasq = _eta * _eta;
+        double eeta = ecco * _eta;
+        double psisq = fabs(1.0 - etasq);
+        double coef = qzms24 * pow(tsi, 4);
+        double coef1 = coef / pow(psisq, 3.5);
+        double cc2 = coef1 * _no * (ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq)) +
+                     0.375 * J2 * tsi / psisq * _con41 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+        _cc1 = tle.bstar * cc2;
+        double cc3 = 0.0;
+        if (ecco > 1.0e-4) cc3 = -2.0 * coef * tsi * _j3oj2 * _no * _sinio / ecco;
+        _x1mth2 = 1.0 - cosio2;
+        _cc4 = 2.0 * _no * coef1 * ao * omeosq *
+               (_eta * (2.0 + 0.5 * etasq) + ecco * (0.5 + 2.0 * etasq) -
+                J2 * tsi / (ao * psisq) * (-3.0 * _con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta)) +
+                0.75 * _x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * cos(2.0 * tle.argPerigee)));
+        _cc5 = 2.0 * coef1 * ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+
+        double cosio4 = cosio2 * cosio2;
+        double temp1 = 1.5 * J2 * pinvsq * _no;
+        double temp2 = 0.5 * temp1 * J2 * pinvsq;
+        double temp3 = -0.46875 * J4 * pinvsq * pinvsq * _no;
+        _mdot = _no + 0.5 * temp1 * rteosq * _con41 + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+        _argpdot = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4) +
+                   temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+        double xhdot1 = -temp1 * cosio;
+        _nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * cosio;
+        _omgcof = tle.bstar * cc3 * cos(tle.argPerigee);
+        _xmcof = ecco > 1.0e-4 ? -x2o3 * coef * tle.bstar / eeta : 0.0;
+        _nodecf = 3.5 * omeosq * xhdot1 * _cc1;
+        _t2cof = 1.5 * _cc1;
+        double den = fabs(cosio + 1.0) > 1.5e-12 ? 1.0 + cosio : 1.5e-12;
+        _xlcof = -0.25 * _j3oj2 * _sinio * (3.0 + 5.0 * cosio) / den;
+        _aycof = -0.5 * _j3oj2 * _sinio;
+        _delmo = pow(1.0 + _eta * cos(tle.meanAnomaly), 3);
+        _sinmao = sin(tle.meanAnomaly);
+        _x7thm1 = 7.0 * cosio2 - 1.0;
+
+        if (_deep) _deepSpaceInit(_argpdot + _nodedot, eccsq);
+
+        if (!_isimp) {
+            double cc1sq = _cc1 * _cc1;
+            _d2 = 4.0 * ao * tsi * cc1sq;
+            double temp = _d2 * tsi * _cc1 / 3.0;
+            _d3 = (17.0 * ao + sfour) * temp;
+            _d4 = 0.5 * temp * ao * tsi * (221.0 * ao + 31.0 * sfour) * _cc1;
+            _t3cof = _d2 + 2.0 * cc1sq;
+            _t4cof = 0.25 * (3.0 * _d3 + _cc1 * (12.0 * _d2 + 10.0 * cc1sq));
+            _t5cof = 0.2 * (3.0 * _d4 + 12.0 * _cc1 * _d3 + 6.0 * _d2 * _d2 + 15.0 * cc1sq * (2.0 * _d2 + cc1sq));
+        }
+
+        _init = true;
+        return true;
+    }
+
+    /// @brief Propagate
+    /// @param tsince minutes since the epoch of the elements
+    /// @param r position in km (TEME)
+    /// @param v velocity in km/s (TEME)
+    /// @return false on an error, see error()
+    bool propagate(double tsince, double r[3], double v[3]) {
+        if (!_init) return false;
+        const double x2o3 = 2.0 / 3.0, twopi = 2.0 * M_PI;
+        const Tle &e = _tle;
+        double t = tsince;
+
+        // Secular gravity and atmospheric drag
+        double xmdf = e.meanAnomaly + _mdot * t;
+        double argpdf = e.argPerigee + _argpdot * t;
+        double nodedf = e.raan + _nodedot * t;
+        double argpm = argpdf, mm = xmdf;
+        double t2 = t * t;
+        double nodem = nodedf + _nodecf * t2;
+        double tempa = 1.0 - _cc1 * t;
+        double tempe = e.bstar * _cc4 * t;
+        double templ = _t2cof * t2;
+
+        if (!_isimp) {
+            double delomg = _omgcof * t;
+            double delmtemp = 1.0 + _eta * cos(xmdf);
+            double delm = _xmcof * (delmtemp * delmtemp * delmtemp - _delmo);
+            double temp = delomg + delm;
+            mm = xmdf + temp;
+            argpm = argpdf - temp;
+            double t3 = t2 * t, t4 = t3 * t;
+            tempa = tempa - _d2 * t2 - _d3 * t3 - _d4 * t4;
+            tempe = tempe + e.bstar * _cc5 * (sin(mm) - _sinmao);
+            templ = templ + _t3cof * t3 + t4 * (_t4cof + t * _t5cof);
+        }
+
+        double nm = _no, em = e.eccentricity, inclm = e.inclination;
+        if (_deep) _deepSpaceSecular(t, em, argpm, inclm, mm, nodem, nm);
+        if (nm <= 0.0) return _fail(2);
+
+        double am = pow(_xke / nm, x2o3) * tempa * tempa;
+        nm = _xke / pow(am, 1.5);
+        em = em - tempe;
+        if (em >= 1.0 || em < -0.001 || am < 0.95) return _fail(1);
+        if (em < 1.0e-6) em = 1.0e-6;
+        mm = mm + _no * templ;
+        double xlm = mm + argpm + nodem;
+
+        nodem = fmod(nodem, twopi);
+        argpm = fmod(argpm, twopi);
+        xlm = fmod(xlm, twopi);
+        mm = fmod(xlm - argpm - nodem, twopi);
+
+        // Lunar/solar periodics, they change the inclination and so the terms that depend on it
+        double ep = em, xincp = inclm, argpp = argpm, nodep = nodem, mp = mm;
+        double sinip = _sinio, cosip = _cosio;
+        double aycof = _aycof, xlcof = _xlcof, con41 = _con41, x1mth2 = _x1mth2, x7thm1 = _x7thm1;
+        if (_deep) {
+            _deepSpacePeriodics(t, ep, xincp, nodep, argpp, mp);
+            if (xincp < 0.0) {
+                xincp = -xincp;
+                nodep = nodep + M_PI;
+                argpp = argpp - M_PI;
+            }
+            if (ep < 0.0 || ep > 1.0) return _fail(3);
+
+            sinip = sin(xincp);
+            cosip = cos(xincp);
+            aycof = -0.5 * _j3oj2 * sinip;
+            double den = fabs(cosip + 1.0) > 1.5e-12 ? 1.0 + cosip : 1.5e-12;
+            xlcof = -0.25 * _j3oj2 * sinip * (3.0 + 5.0 * cosip) / den;
+            double cosisq = cosip * cosip;
+            con41 = 3.0 * cosisq - 1.0;
+            x1mth2 = 1.0 - cosisq;
+            x7thm1 = 7.0 * cosisq - 1.0;
+        }
+
+        // Long period periodics
+        double axnl = ep * cos(argpp);
+        double temp = 1.0 / (am * (1.0 - ep * ep));
+        double aynl = ep * sin(argpp) + temp * aycof;
+        double xl = mp + argpp + nodep + temp * xlcof * axnl;
+
+        // Kepler's equation
+        double u = fmod(xl - nodep, twopi);
+        double eo1 = u, tem5 = 9999.9, sineo1 = 0.0, coseo1 = 1.0;
+        for (int ktr = 1; fabs(tem5) >= 1.0e-12 && ktr <= 10; ++ktr) {
+            sineo1 = sin(eo1);
+            coseo1 = cos(eo1);
+            tem5 = 1.0 - coseo1 * axnl - sineo1 * aynl;
+            tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / tem5;
+            if (fabs(tem5) >= 0.95) tem5 = tem5 > 0.0 ? 0.95 : -0.95;
+            eo1 = eo1 + tem5;
+        }
+
+        // Short period preliminary quantities
+        double ecose = axnl * coseo1 + aynl * sineo1;
+        double esine = axnl * sineo1 - aynl * coseo1;
+        double el2 = axnl * axnl + aynl * aynl;
+        double pl = am * (1.0 - el2);
+        if (pl < 0.0) return _fail(4);
+
+        double rl = am * (1.0 - ecose);
+        double rdotl = sqrt(am) * esine / rl;
+        double rvdotl = sqrt(pl) / rl;
+        double betal = sqrt(1.0 - el2);
+        temp = esine / (1.0 + betal);
+        double sinu = am / rl * (sineo1 - aynl - axnl * temp);
+        double cosu = am / rl * (coseo1 - axnl + aynl * temp);
+        double su = atan2(sinu, cosu);
+        double sin2u = (cosu + cosu) * sinu;
+        double cos2u = 1.0 - 2.0 * sinu * sinu;
+        temp = 1.0 / pl;
+        double temp1 = 0.5 * J2 * temp;
+        double temp2 = temp1 * temp;
+
+        // Short period periodics
+        double mrt = rl * (1.0 - 1.5 * temp2 * betal * con41) + 0.5 * temp1 * x1mth2 * cos2u;
+        su = su - 0.25 * temp2 * x7thm1 * sin2u;
+        double xnode = nodep + 1.5 * temp2 * cosip * sin2u;
+        double xinc = xincp + 1.5 * temp2 * cosip * sinip * cos2u;
+        double mvt = rdotl - nm * temp1 * x1mth2 * sin2u / _xke;
+        double rvdot = rvdotl + nm * temp1 * (x1mth2 * cos2u + 1.5 * con41) / _xke;
+
+        // Orientation vectors
+        double sinsu = sin(su), cossu = cos(su);
+        double snod = sin(xnode), cnod = cos(xnode);
+        double sini = sin(xinc), cosi = cos(xinc);
+        double xmx = -snod * cosi, xmy = cnod * cosi;
+        double ux = xmx * sinsu + cnod * cossu;
+        double uy = xmy * sinsu + snod * cossu;
+        double uz = sini * sinsu;
+        double vx = xmx * cossu - cnod * sinsu;
+        double vy = xmy * cossu - snod * sinsu;
+        double vz = sini * cossu;
+
+        double vkmpersec = RE * _xke / 60.0;
+        r[0] = mrt * ux * RE;
+        r[1] = mrt * uy * RE;
+        r[2] = mrt * uz * RE;
+        v[0] = (mvt * ux + rvdot * vx) * vkmpersec;
+        v[1] = (mvt * uy + rvdot * vy) * vkmpersec;
+        v[2] = (mvt * uz + rvdot * vz) * vkmpersec;
+
+        if (mrt < 1.0) return _fail(6);     // Decayed
+        _error = 0;
+        return true;
+    }
+
+    /// @brief Propagate to a Julian date (UTC)
+    bool propagateTo(double jd, double r[3], double v[3]) {
+        return propagate((jd - _tle.epoch) * 1440.0, r, v);
+    }
+
+    const Tle &tle() const { return _tle; }
+    bool initialized() const { return _init; }
+    /// @brief 0 ok, 1 bad eccentricity/mean motion, 2 mean motion < 0, 3 perturbed eccentricity out of range,
+    /// 4 semi-latus rectum < 0, 6 decayed
+    int error() const { return _error; }
+    /// @brief The elements are propagated with the SDP4 deep space terms
+    bool deepSpace() const { return _deep; }
+
+private:
+
+    // Periodic terms of the sun or the moon (Vallado's se2..sh3 and ee2..xh3)
+    struct LunarSolar {
+        double e2, e3, i2, i3, l2, l3, l4, gh2, gh3, gh4, h2, h3;
+        double zm, zn, ze;      // mean anomaly at the epoch, its rate and the eccentricity of the orbit
+    };
+
+    // SDP4 coefficients, set once by init()
+    struct DeepSpace {
+        LunarSolar body[2];     // sun, moon
+        double dedt, didt, dmdt, dnodt, domdt;  // secular rates
+        int irez;               // 0 none, 1 synchronous (24 hour), 2 half day (12 hour) resonance
+        double d2201, d2211, d3210, d3222, d4410, d4422, d5220, d5232, d5421, d5433;
+        double del1, del2, del3, xfact, xlamo, gsto;
+    };
+
+    bool _fail(int error) {
+        _error = error;
+        return false;
+    }
+
+    // Lunar/solar terms and resonances (Vallado's dscom and dsinit), tc = 0
+    void _deepSpaceInit(double xpidot, double eccsq) {
+        const Tle &e = _tle;
+        DeepSpace &d = _ds;
+        const double twopi = 2.0 * M_PI, x2o3 = 2.0 / 3.0;
+        const double rptim = 4.37526908801129966e-3;   // earth rotation, radians/minute
+
+        double snodm = sin(e.raan), cnodm = cos(e.raan);
+        double sinomm = sin(e.argPerigee), cosomm = cos(e.argPerigee);
+        double sinim = _sinio, cosim = _cosio;
+        double em = e.eccentricity, emsq = eccsq;
+        double betasq = 1.0 - emsq, rtemsq = sqrt(betasq);
+
+        // Orbit of the moon, days since 1950 Jan 0
+        double day = e.epoch - 2433281.5 + 18261.5;
+        double xnodce = fmod(4.5236020 - 9.2422029e-4 * day, twopi);
+        double stem = sin(xnodce), ctem = cos(xnodce);
+        double zcosil = 0.91375164 - 0.03568096 * ctem;
+        double zsinil = sqrt(1.0 - zcosil * zcosil);
+        double zsinhl = 0.089683511 * stem / zsinil;
+        double zcoshl = sqrt(1.0 - zsinhl * zsinhl);
+        double gam = 5.8351514 + 0.0019443680 * day;
+        double zx = atan2(0.39785416 * stem / zsinil, zcoshl * ctem + 0.91744867 * zsinhl * stem);
+        zx = gam + zx - xnodce;
+
+        // Sun then moon: their orbit against the orbit of the satellite
+        double zcosg = 0.1945905, zsing = -0.98088458, zcosi = 0.91744867, zsini = 0.39785416;
+        double zcosh = cnodm, zsinh = snodm, cc = 2.9864797e-6;
+        d.body[0].zm = fmod(6.2565837 + 0.017201977 * day, twopi);
+        d.body[0].zn = 1.19459e-5;
+        d.body[0].ze = 0.01675;
+        d.body[1].zm = fmod(4.7199672 + 0.22997150 * day - gam, twopi);
+        d.body[1].zn = 1.5835218e-4;
+        d.body[1].ze = 0.05490;
+        d.dedt = d.didt = d.dmdt = d.dnodt = d.domdt = 0.0;
+
+        for (int i = 0; i < 2; ++i) {
+            LunarSolar &b = d.body[i];
+            if (i == 1) {
+                zcosg = cos(zx);
+                zsing = sin(zx);
+                zcosi = zcosil;
+                zsini = zsinil;
+                zcosh = zcoshl * cnodm + zsinhl * snodm;
+                zsinh = snodm * zcoshl - cnodm * zsinhl;
+                cc = 4.7968065e-7;
+            }
+
+            double a1 = zcosg * zcosh + zsing * zcosi * zsinh;
+            double a3 = -zsing * zcosh + zcosg * zcosi * zsinh;
+            double a7 = -zcosg * zsinh + zsing * zcosi * zcosh;
+            double a8 = zsing * zsini;
+            double a9 = zsing * zsinh + zcosg * zcosi * zcosh;
+            double a10 = zcosg * zsini;
+            double a2 = cosim * a7 + sinim * a8;
+            double a4 = cosim * a9 + sinim * a10;
+            double a5 = -sinim * a7 + cosim * a8;
+            double a6 = -sinim * a9 + cosim * a10;
+
+            double x1 = a1 * cosomm + a2 * sinomm;
+            double x2 = a3 * cosomm + a4 * sinomm;
+            double x3 = -a1 * sinomm + a2 * cosomm;
+            double x4 = -a3 * sinomm + a4 * cosomm;
+            double x5 = a5 * sinomm;
+            double x6 = a6 * sinomm;
+            double x7 = a5 * cosomm;
+            double x8 = a6 * cosomm;
+
+            double z31 = 12.0 * x1 * x1 - 3.0 * x3 * x3;
+            double z32 = 24.0 * x1 * x2 - 6.0 * x3 * x4;
+            double z33 = 12.0 * x2 * x2 - 3.0 * x4 * x4;
+            double z1 = 3.0 * (a1 * a1 + a2 * a2) + z31 * emsq;
+            double z2 = 6.0 * (a1 * a3 + a2 * a4) + z32 * emsq;
+            double z3 = 3.0 * (a3 * a3 + a4 * a4) + z33 * emsq;
+            double z11 = -6.0 * a1 * a5 + emsq * (-24.0 * x1 * x7 - 6.0 * x3 * x5);
+            double z12 = -6.0 * (a1 * a6 + a3 * a5) + emsq * (-24.0 * (x2 * x7 + x1 * x8) - 6.0 * (x3 * x6 + x4 * x5));
+            double z13 = -6.0 * a3 * a6 + emsq * (-24.0 * x2 * x8 - 6.0 * x4 * x6);
+            double z21 = 6.0 * a2 * a5 + emsq * (24.0 * x1 * x5 - 6.0 * x3 * x7);
+            double z22 = 6.0 * (a4 * a5 + a2 * a6) + emsq * (24.0 * (x2 * x5 + x1 * x6) - 6.0 * (x4 * x7 + x3 * x8));
+            double z23 = 6.0 * a4 * a6 + emsq * (24.0 * x2 * x6 - 6.0 * x4 * x8);
+            z1 = z1 + z1 + betasq * z31;
+            z2 = z2 + z2 + betasq * z32;
+            z3 = z3 + z3 + betasq * z33;
+            double s3 = cc / _no;
+            double s2 = -0.5 * s3 / rtemsq;
+            double s4 = s3 * rtemsq;
+            double s1 = -15.0 * em * s4;
+            double s5 = x1 * x3 + x2 * x4;
+            double s6 = x2 * x3 + x1 * x4;
+            double s7 = x2 * x4 - x1 * x3;
+
+            // Periodics
+            b.e2 = 2.0 * s1 * s6;
+            b.e3 = 2.0 * s1 * s7;
+            b.i2 = 2.0 * s2 * z12;
+            b.i3 = 2.0 * s2 * (z13 - z11);
+            b.l2 = -2.0 * s3 * z2;
+            b.l3 = -2.0 * s3 * (z3 - z1);
+            b.l4 = -2.0 * s3 * (-21.0 - 9.0 * emsq) * b.ze;
+            b.gh2 = 2.0 * s4 * z32;
+            b.gh3 = 2.0 * s4 * (z33 - z31);
+            b.gh4 = -18.0 * s4 * b.ze;
+            b.h2 = -2.0 * s2 * z22;
+            b.h3 = -2.0 * s2 * (z23 - z21);
+
+            // Secular rates, the node is undefined for an equatorial orbit
+            double zn = b.zn;
+            d.dedt += s1 * zn * s5;
+            d.didt += s2 * zn * (z11 + z13);
+            d.dmdt -= zn * s3 * (z1 + z3 - 14.0 - 6.0 * emsq);
+            double sgh = s4 * zn * (z31 + z33 - 6.0);
+            double sh = -zn * s2 * (z21 + z23);
+            if (e.inclination < 5.2359877e-2 || e.inclination > M_PI - 5.2359877e-2) sh = 0.0;
+            if (sinim != 0.0) sh = sh / sinim;
+            d.domdt += sgh - cosim * sh;
+            d.dnodt += sh;
+        }
+
+        // Resonances of the geopotential with 24 hour and 12 hour (eccentric) orbits
+        d.gsto = gmst(e.epoch);
+        d.irez = 0;
+        if (_no < 0.0052359877 && _no > 0.0034906585) d.irez = 1;
+        if (_no >= 8.26e-3 && _no <= 9.24e-3 && em >= 0.5) d.irez = 2;
+        if (d.irez == 0) return;
+
+        double aonv = pow(_no / _xke, x2o3);
+        double xno2 = _no * _no, ainv2 = aonv * aonv;
+        if (d.irez == 2) {
+            double cosisq = cosim * cosim, eoc = em * emsq;
+            double g201 = -0.306 - (em - 0.64) * 0.440;
+            double g211, g310, g322, g410, g422, g520, g521, g532, g533;
+            if (em <= 0.65) {
+                g211 = 3.616 - 13.2470 * em + 16.2900 * emsq;
+                g310 = -19.302 + 117.3900 * em - 228.4190 * emsq + 156.5910 * eoc;
+                g322 = -18.9068 + 109.7927 * em - 214.6334 * emsq + 146.5816 * eoc;
+                g410 = -41.122 + 242.6940 * em - 471.0940 * emsq + 313.9530 * eoc;
+                g422 = -146.407 + 841.8800 * em - 1629.014 * emsq + 1083.4350 * eoc;
+                g520 = -532.114 + 3017.977 * em - 5740.032 * emsq + 3708.2760 * eoc;
+            } else {
+                g211 = -72.099 + 331.819 * em - 508.738 * emsq + 266.724 * eoc;
+                g310 = -346.844 + 1582.851 * em - 2415.925 * emsq + 1246.113 * eoc;
+                g322 = -342.585 + 1554.908 * em - 2366.899 * emsq + 1215.972 * eoc;
+                g410 = -1052.797 + 4758.686 * em - 7193.992 * emsq + 3651.957 * eoc;
+                g422 = -3581.690 + 16178.110 * em - 24462.770 * emsq + 12422.520 * eoc;
+                if (em > 0.715) g520 = -5149.66 + 29936.92 * em - 54087.36 * emsq + 31324.56 * eoc;
+                else g520 = 1464.74 - 4664.75 * em + 3763.64 * emsq;
+            }
+            if (em < 0.7) {
+                g533 = -919.22770 + 4988.6100 * em - 9064.7700 * emsq + 5542.21 * eoc;
+                g521 = -822.71072 + 4568.6173 * em - 8491.4146 * emsq + 5337.524 * eoc;
+                g532 = -853.66600 + 4690.2500 * em - 8624.7700 * emsq + 5341.4 * eoc;
+            } else {
+                g533 = -37995.780 + 161616.52 * em - 229838.20 * emsq + 109377.94 * eoc;
+                g521 = -51752.104 + 218913.95 * em - 309468.16 * emsq + 146349.42 * eoc;
+                g532 = -40023.880 + 170470.89 * em - 242699.48 * emsq + 115605.82 * eoc;
+            }
+
+            double sini2 = sinim * sinim;
+            double f220 = 0.75 * (1.0 + 2.0 * cosim + cosisq);
+            double f221 = 1.5 * sini2;
+            double f321 = 1.875 * sinim * (1.0 - 2.0 * cosim - 3.0 * cosisq);
+            double f322 = -1.875 * sinim * (1.0 + 2.0 * cosim - 3.0 * cosisq);
+            double f441 = 35.0 * sini2 * f220;
+            double f442 = 39.3750 * sini2 * sini2;
+            double f522 = 9.84375 * sinim * (sini2 * (1.0 - 2.0 * cosim - 5.0 * cosisq) +
+                          0.33333333 * (-2.0 + 4.0 * cosim + 6.0 * cosisq));
+            double f523 = sinim * (4.92187512 * sini2 * (-2.0 - 4.0 * cosim + 10.0 * cosisq) +
+                          6.56250012 * (1.0 + 2.0 * cosim - 3.0 * cosisq));
+            double f542 = 29.53125 * sinim * (2.0 - 8.0 * cosim + cosisq * (-12.0 + 8.0 * cosim + 10.0 * cosisq));
+            double f543 = 29.53125 * sinim * (-2.0 - 8.0 * cosim + cosisq * (12.0 + 8.0 * cosim - 10.0 * cosisq));
+
+            double temp1 = 3.0 * xno2 * ainv2;
+            double temp = temp1 * 1.7891679e-6;
+            d.d2201 = temp * f220 * g201;
+            d.d2211 = temp * f221 * g211;
+            temp1 = temp1 * aonv;
+            temp = temp1 * 3.7393792e-7;
+            d.d3210 = temp * f321 * g310;
+            d.d3222 = temp * f322 * g322;
+            temp1 = temp1 * aonv;
+            temp = 2.0 * temp1 * 7.3636953e-9;
+            d.d4410 = temp * f441 * g410;
+            d.d4422 = temp * f442 * g422;
+            temp1 = temp1 * aonv;
+            temp = temp1 * 1.1428639e-7;
+            d.d5220 = temp * f522 * g520;
+            d.d5232 = temp * f523 * g532;
+            temp = 2.0 * temp1 * 2.1765803e-9;
+            d.d5421 = temp * f542 * g521;
+            d.d5433 = temp * f543 * g533;
+            d.xlamo = fmod(e.meanAnomaly + e.raan + e.raan - d.gsto - d.gsto, twopi);
+            d.xfact = _mdot + d.dmdt + 2.0 * (_nodedot + d.dnodt - rptim) - _no;
+        } else {
+            double g200 = 1.0 + emsq * (-2.5 + 0.8125 * emsq);
+            double g310 = 1.0 + 2.0 * emsq;
+            double g300 = 1.0 + emsq * (-6.0 + 6.60937 * emsq);
+            double f220 = 0.75 * (1.0 + cosim) * (1.0 + cosim);
+            double f311 = 0.9375 * sinim * sinim * (1.0 + 3.0 * cosim) - 0.75 * (1.0 + cosim);
+            double f330 = 1.0 + cosim;
+            f330 = 1.875 * f330 * f330 * f330;
+            d.del1 = 3.0 * xno2 * ainv2;
+            d.del2 = 2.0 * d.del1 * f220 * g200 * 1.7891679e-6;
+            d.del3 = 3.0 * d.del1 * f330 * g300 * 2.2123015e-7 * aonv;
+            d.del1 = d.del1 * f311 * g310 * 2.1460748e-6 * aonv;
+            d.xlamo = fmod(e.meanAnomaly + e.raan + e.argPerigee - d.gsto, twopi);
+            d.xfact = _mdot + xpidot - rptim + d.dmdt + d.domdt + d.dnodt - _no;
+        }
+    }
+
+    // Secular lunar/solar drift and the resonance integration (Vallado's dspace). The integrator
+    // runs from the epoch in steps of 720 minutes every call, so propagate() keeps no state
+    void _deepSpaceSecular(double t, double &em, double &argpm, double &inclm, double &mm, double &nodem, double &nm) const {
+        const DeepSpace &d = _ds;
+        const double twopi = 2.0 * M_PI;
+        const double fasx2 = 0.13130908, fasx4 = 2.8843198, fasx6 = 0.37448087;
+        const double g22 = 5.7686396, g32 = 0.95240898, g44 = 1.8014998, g52 = 1.0508330, g54 = 4.4108898;
+        const double rptim = 4.37526908801129966e-3, stepp = 720.0, step2 = 259200.0;
+
+        double theta = fmod(d.gsto + t * rptim, twopi);
+        em = em + d.dedt * t;
+        inclm = inclm + d.didt * t;
+        argpm = argpm + d.domdt * t;
+        nodem = nodem + d.dnodt * t;
+        mm = mm + d.dmdt * t;
+        if (d.irez == 0) return;
+
+        double atime = 0.0, xli = d.xlamo, xni = _no, delt = t > 0.0 ? stepp : -stepp;
+        double xndt, xldot, xnddt, ft;
+        while (true) {
+            if (d.irez != 2) {
+                xndt = d.del1 * sin(xli - fasx2) + d.del2 * sin(2.0 * (xli - fasx4)) + d.del3 * sin(3.0 * (xli - fasx6));
+                xldot = xni + d.xfact;
+                xnddt = d.del1 * cos(xli - fasx2) + 2.0 * d.del2 * cos(2.0 * (xli - fasx4)) +
+                        3.0 * d.del3 * cos(3.0 * (xli - fasx6));
+                xnddt = xnddt * xldot;
+            } else {
+                double xomi = _tle.argPerigee + _argpdot * atime;
+                double x2omi = xomi + xomi, x2li = xli + xli;
+                xndt = d.d2201 * sin(x2omi + xli - g22) + d.d2211 * sin(xli - g22) +
+                       d.d3210 * sin(xomi + xli - g32) + d.d3222 * sin(-xomi + xli - g32) +
+                       d.d4410 * sin(x2omi + x2li - g44) + d.d4422 * sin(x2li - g44) +
+                       d.d5220 * sin(xomi + xli - g52) + d.d5232 * sin(-xomi + xli - g52) +
+                       d.d5421 * sin(xomi + x2li - g54) + d.d5433 * sin(-xomi + x2li - g54);
+                xldot = xni + d.xfact;
+                xnddt = d.d2201 * cos(x2omi + xli - g22) + d.d2211 * cos(xli - g22) +
+                        d.d3210 * cos(xomi + xli - g32) + d.d3222 * cos(-xomi + xli - g32) +
+                        d.d5220 * cos(xomi + xli - g52) + d.d5232 * cos(-xomi + xli - g52) +
+                        2.0 * (d.d4410 * cos(x2omi + x2li - g44) + d.d4422 * cos(x2li - g44) +
+                        d.d5421 * cos(xomi + x2li - g54) + d.d5433 * cos(-xomi + x2li - g54));
+                xnddt = xnddt * xldot;
+            }
+            if (fabs(t - atime) < stepp) {
+                ft = t - atime;
+                break;
+            }
+            xli = xli + xldot * delt + xndt * step2;
+            xni = xni + xndt * delt + xnddt * step2;
+            atime = atime + delt;
+        }
+
+        nm = xni + xndt * ft + xnddt * ft * ft * 0.5;
+        double xl = xli + xldot * ft + xndt * ft * ft * 0.5;
+        mm = d.irez != 1 ? xl - 2.0 * nodem + 2.0 * theta : xl - nodem - argpm + theta;
+    }
+
+    // Lunar/solar periodics (Vallado's dpper), with the Lyddane modification below 0.2 rad inclination
+    void _deepSpacePeriodics(double t, double &ep, double &inclp, double &nodep, double &argpp, double &mp) const {
+        double pe = 0.0, pinc = 0.0, pl = 0.0, pgh = 0.0, ph = 0.0;
+        for (const LunarSolar &b : _ds.body) {
+            double zm = b.zm + b.zn * t;
+            double zf = zm + 2.0 * b.ze * sin(zm);
+            double sinzf = sin(zf);
+            double f2 = 0.5 * sinzf * sinzf - 0.25;
+            double f3 = -0.5 * sinzf * cos(zf);
+            pe += b.e2 * f2 + b.e3 * f3;
+            pinc += b.i2 * f2 + b.i3 * f3;
+            pl += b.l2 * f2 + b.l3 * f3 + b.l4 * sinzf;
+            pgh += b.gh2 * f2 + b.gh3 * f3 + b.gh4 * sinzf;
+            ph += b.h2 * f2 + b.h3 * f3;
+        }
+
+        inclp = inclp + pinc;
+        ep = ep + pe;
+        double sinip = sin(inclp), cosip = cos(inclp);
+        if (inclp >= 0.2) {
+            ph = ph / sinip;
+            pgh = pgh - cosip * ph;
+            argpp = argpp + pgh;
+            nodep = nodep + ph;
+            mp = mp + pl;
+            return;
+        }
+
+        double sinop = sin(nodep), cosop = cos(nodep);
+        double alfdp = sinip * sinop + ph * cosop + pinc * cosip * sinop;
+        double betdp = sinip * cosop - ph * sinop + pinc * cosip * cosop;
+        nodep = fmod(nodep, 2.0 * M_PI);
+        double xls = mp + argpp + cosip * nodep + pl + pgh - pinc * nodep * sinop;
+        double xnoh = nodep;
+        nodep = atan2(alfdp, betdp);
+        if (fabs(xnoh - nodep) > M_PI) nodep = nodep < xnoh ? nodep + 2.0 * M_PI : nodep - 2.0 * M_PI;
+        mp = mp + pl;
+        argpp = xls - mp - cosip * nodep;
+    }
+
+    Tle     _tle;
+    bool    _init = false, _isimp = false, _deep = false;
+    int     _error = 0;
+    double  _xke = 0.0, _j3oj2 = 0.0, _no = 0.0;
+    double  _sinio = 0.0, _cosio = 0.0, _con41 = 0.0, _x1mth2 = 0.0, _x7thm1 = 0.0;
+    double  _eta = 0.0, _cc1 = 0.0, _cc4 = 0.0, _cc5 = 0.0;
+    double  _mdot = 0.0, _argpdot = 0.0, _nodedot = 0.0, _nodecf = 0.0;
+    double  _omgcof = 0.0, _xmcof = 0.0, _t2cof = 0.0, _xlcof = 0.0, _aycof = 0.0;
+    double  _delmo = 0.0, _sinmao = 0.0;
+    double  _d2 = 0.0, _d3 = 0.0, _d4 = 0.0, _t3cof = 0.0, _t4cof = 0.0, _t5cof = 0.0;
+    DeepSpace _ds = {};
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <Arduino.h>
+#include <astro.h>
+#include <doublebuffer.h>
+
+#define SIDEREAL_NAME_LENGTH  48
+
+/// @brief Fixed sky object, J2000 coordinates
+struct SkyObject {
+    char    name[SIDEREAL_NAME_LENGTH] = "";
+    double  ra = 0.0;       // radians
+    double  dec = 0.0;      // radians
+    bool    active = false;
+};
+
+/*
+    Tracks a fixed object (star, nebula, radio source) from its J2000 RA/Dec.
+    The coordinates are set once from the web server task, the control loop then computes the
+    alt/az from the sidereal time, so there is no network traffic while tracking.
+    Precession is applied, nutation and aberration (< 1 arcminute) are not. Refraction is optional.
+    Planets, the moon and comets move against the stars and drift away after a while.
+*/
+class SiderealTracker {
+
+public:
+    void setObserver(const Observer &observer) { _observer = observer; }
+    void setRefraction(bool refraction) { _refraction = refraction; }
+
+    /// @brief Start tracking (web server task)
+    /// @param ra, dec J2000 coordinates in degrees
+    void set(const char *name, double ra, double dec) {
+        SkyObject object;
+        strlcpy(object.name, name, sizeof(object.name));
+        object.ra = ra * (M_PI / 180.0);
+        object.dec = dec * (M_PI / 180.0);
+        object.active = true;
+        _buffer.write(object);
+        log_i("Sidereal tracking %s RA %0.4f Dec %0.4f", name, ra, dec);
+    }
+
+    /// @brief Stop tracking (web server task)
+    void clear() {
+        _buffer.write(SkyObject());
+    }
+
+    /// @brief Pick up new coordinates (control loop)
+    void update() {
+        if (_buffer.read(_object, _version)) _precessed = 0.0;
+    }
+
+    bool active() const { return _object.active; }
+    const char *name() const { return _object.name; }
+
+    /// @brief Position of the object (control loop)
+    /// @param offsetMs look ahead from the current time
+    /// @param alt, az receive the position in degrees
+    /// @return nullptr or an error message
+    const char *position(long offsetMs, float &alt, float &az) {
+        if (!clockSet()) return CLOCK_NOT_SET;
+
+        double jd = julianDateNow(offsetMs);
+        // Precession only adds up over days, there is no need to redo it on every update
+        if (fabs(jd - _precessed) > 1.0) {
+            precessFromJ2000(jd, _object.ra, _object.dec, _ra, _dec);
+            _precessed = jd;
+        }
+
+        double a, z;
+        equatorialToAltAz(_observer, jd, _ra, _dec, a, z);
+        if (_refraction) a += refraction(a);
+        alt = a;
+        az = z;
+        return nullptr;
+    }
+
+private:
+    Observer _observer;
+    bool _refraction = true;
+    DoubleBuffer<SkyObject> _buffer;
+    uint32_t _version = 0;
+    SkyObject _object;
+    double _precessed = 0.0;    // Julian date of _ra, _dec
+    double _ra = 0.0, _dec = 0.0;
+};
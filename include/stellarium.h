@@ -2,6 +2,10 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include <doublebuffer.h>
+#include <arbiter.h>
+#include <jsonarena.h>
+#include <metrics.h>
 
 extern "C" {
   #include "esp_wifi.h"
@@ -19,8 +23,41 @@ struct ObjectData {
   String error = "";
   // Current Servo direction
   float currAlt = 0.0, currAz = 0.0;
-  // What mode are we in
-  bool stellariumMode = false;
+  // The target source followed, -1 for none
+  int8_t source = -1;
+  bool sidereal = false;  // Tracking fixed RA/Dec on the ESP32
+};
+
+#define STELLARIUM_PORT           8090
+#define STELLARIUM_POLL_INTERVAL  1000  // ms, status polls, a new selection shows up within this
+#define STELLARIUM_INFO_MIN       250   // ms, object info for the fastest objects (satellites)
+#define STELLARIUM_INFO_MAX       10000 // ms, object info for the slowest (stars)
+#define STELLARIUM_TOLERANCE      0.1   // degrees an extrapolated position may drift before the object info is asked again
+#define STELLARIUM_TIME_JUMP      5.0   // s, a Stellarium clock further off than this was set by hand
+#define STELLARIUM_TIMEOUT        2000  // ms, only the Stellarium task waits for this
+#define STELLARIUM_STALE          5000  // ms, older samples are no longer valid
+#define STELLARIUM_TEXT_LENGTH    48
+#define STELLARIUM_ARENA_SIZE     2048  // bytes, bound for the filtered object info document
+#define STELLARIUM_SELECTION_HEAD 96    // chars of the selection info that identify the object
+
+inline Histogram stellariumRequest("rotor_stellarium_request_seconds", "Stellarium round trip, parsing included");
+inline Counter stellariumErrors("rotor_stellarium_errors_total", "Stellarium polls without an answer");
+inline Counter stellariumStatusPolls("rotor_stellarium_requests_total", "Requests to Stellarium", "api=\"main/status\"");
+inline Counter stellariumInfoPolls("rotor_stellarium_requests_total", "", "api=\"objects/info\"");
+inline Counter stellariumBytes("rotor_stellarium_bytes_total", "Response bytes read from Stellarium");
+
+/// @brief Fixed size copy of the object data, published by the Stellarium task to the control loop
+struct StellariumSample {
+  float altitude = 0.0;
+  float azimuth = 0.0;
+  bool visible = false;
+  bool valid = false;
+  bool hasRaDec = false;
+  double ra = 0.0;        // J2000 degrees
+  double dec = 0.0;
+  char name[STELLARIUM_TEXT_LENGTH] = "";
+  char error[STELLARIUM_TEXT_LENGTH] = "";
+  unsigned long time = 0; // millis() when received
 };
 
 /// @brief Helper function, assumption is that only one device is connected to the AP
@@ -53,85 +90,495 @@ IPAddress checkConnectedClients() {
   return clientIP;
 }
 
-/// @brief Helper function, sends a request for the currently tracking object to stellarium
-/// @param clientIP 
-/// @return Json response from stellarium
-String sendHTTPRequestToClient(IPAddress clientIP) {
-  if (!clientIP) return "";
+/// @brief Keys used from /api/objects/info, everything else is skipped while parsing
+const JsonDocument &stellariumFilter() {
+  static JsonDocument filter;
+  if (filter.isNull()) {
+    filter["altitude"] = true;
+    filter["azimuth"] = true;
+    filter["localized-name"] = true;
+    filter["above-horizon"] = true;
+    filter["raJ2000"] = true;
+    filter["decJ2000"] = true;
+  }
+  return filter;
+}
+
+/// @brief Helper function - parse data returned from stellarium
+/// @param input JSON text, or the stream it arrives on
+/// @param doc document to parse into, only the filtered keys are stored
+/// @param sample receives the object data, if valid this property is true
+/// @return result of the deserialization
+template <typename TInput>
+DeserializationError parseStellariumJson(TInput &input, JsonDocument &doc, StellariumSample &sample) {
+
+  DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(stellariumFilter()));
 
-  String url = "http://" + clientIP.toString() + ":8090/api/objects/info?format=json";
+  sample.valid = false;
 
-  HTTPClient http;
-  http.begin(url);
-  int httpCode = http.GET();
+  if (error) {
+    log_w("JSON parse failed: %s", error.c_str());
+    strlcpy(sample.error, error == DeserializationError::NoMemory ? "Object info too large" : "No object selected", sizeof(sample.error));
+    return error;
+  }
 
-  if (httpCode > 0) {
-    String payload = http.getString();
-    http.end();
-    return payload;
+  if (doc["altitude"].is<float>() && doc["azimuth"].is<float>() && doc["localized-name"].is<const char *>()) {
+    sample.altitude = doc["altitude"].as<float>();
+    sample.azimuth = doc["azimuth"].as<float>();
+    strlcpy(sample.name, doc["localized-name"].as<const char *>(), sizeof(sample.name));
+    sample.visible = doc["above-horizon"].as<bool>();
+    sample.hasRaDec = doc["raJ2000"].is<double>() && doc["decJ2000"].is<double>();
+    sample.ra = doc["raJ2000"].as<double>();
+    sample.dec = doc["decJ2000"].as<double>();
+    sample.valid = true;
+    sample.error[0] = 0;
   } else {
-    Serial.printf("HTTP request failed: %s\n", http.errorToString(httpCode).c_str());
-    http.end();
-    return "";
+    strlcpy(sample.error, "Missing expected keys in JSON.", sizeof(sample.error));
+    log_w("Missing expected keys in JSON.");
   }
+  return error;
 }
 
+/*
+    Reads at most length bytes from a stream, and can skip what was not read.
+    Used to parse a response body straight from a keep-alive connection without losing sync with
+    the next response.
+*/
+class LimitedStream : public Stream {
 
-/// @brief Helper function - parse data returned from stellarium
-/// @param jsonString input data
-/// @return ObjectData object, if valid this property is true
-ObjectData parseStellariumJson(const String& jsonString) {
+public:
+  LimitedStream(Stream &stream, int length) : _stream(stream), _remaining(length) {}
 
-  ObjectData data;
-  JsonDocument doc;
-  DeserializationError error = deserializeJson(doc, jsonString);
+  int available() override { return _remaining > 0 ? std::min(_stream.available(), _remaining) : 0; }
+  int peek() override { return _remaining > 0 ? _stream.peek() : -1; }
 
-  data.valid = false;
+  int read() override {
+    if (_remaining <= 0) return -1;
+    int c = _stream.read();
+    if (c >= 0) { _remaining--; _count++; }
+    return c;
+  }
 
-  if (error) {
-    Serial.print("JSON parse failed: ");
-    Serial.println(error.f_str());
-    data.error = "No object selected";
-    return data;
-  }
-
-  try {
-    if (doc["altitude"] && doc["azimuth"] && doc["localized-name"] /*&& doc["above-horizon"]*/) {
-      data.altitude = doc["altitude"].as<float>();
-      data.azimuth = doc["azimuth"].as<float>();
-      data.name = doc["localized-name"].as<String>();
-      data.visible = doc["above-horizon"].as<bool>();
-      data.valid = true;
-    } else {
-      data.error = "Missing expected keys in JSON.";
-      Serial.println("Missing expected keys in JSON.");
-    }
-  } catch (...) {
-    Serial.println("Failed misserably....");
+  size_t readBytes(char *buffer, size_t length) override {
+    if (_remaining <= 0) return 0;
+    size_t n = _stream.readBytes(buffer, std::min((int)length, _remaining));
+    _remaining -= n;
+    _count += n;
+    return n;
+  }
+
+  size_t write(uint8_t) override { return 0; }
+
+  /// @brief Skip the rest of the body
+  void drain() {
+    char buf[64];
+    while (_remaining > 0 && readBytes(buf, sizeof(buf)) > 0) {}
+  }
+
+  int remaining() const { return _remaining; }
+  size_t count() const { return _count; }   // Bytes read so far
+
+private:
+  Stream &_stream;
+  int _remaining;
+  size_t _count = 0;
+};
+
+/// @brief Keys used from /api/main/status, the selection info is scanned while it streams by
+const JsonDocument &stellariumStatusFilter() {
+  static JsonDocument filter;
+  if (filter.isNull()) {
+    filter["time"]["jday"] = true;
+    filter["time"]["timerate"] = true;
+    filter["actionChanges"]["id"] = true;
+    filter["propertyChanges"]["id"] = true;
   }
-  return data;
+  return filter;
 }
 
-ObjectData getStellariumData() {
+/*
+    Hash of the head of the "selectioninfo" text in /api/main/status, to see that another object
+    was selected without keeping the (HTML, a few KB) text. Only the head, the heading with the
+    name, as the rest has the position and changes all the time. Fed every byte of the body.
+*/
+class SelectionScanner {
+
+public:
+  void feed(char c) {
+    static const char key[] = "\"selectioninfo\"", end[] = "</h2>";
+    switch (_state) {
+      case S_KEY:
+        _matched = c == key[_matched] ? _matched + 1 : (c == key[0] ? 1 : 0);
+        if (_matched == sizeof(key) - 1) _state = S_COLON;
+        break;
+      case S_COLON:   // : and the opening quote
+        if (c == '"') _state = S_TEXT;
+        break;
+      case S_TEXT:
+        if (c == '"' and !_escape) {
+          _state = S_DONE;
+          break;
+        }
+        _escape = c == '\\' and !_escape;
+        if (_length < STELLARIUM_SELECTION_HEAD) {
+          _hash = (_hash ^ (uint8_t)c) * 16777619u;   // FNV-1a
+          _length++;
+          _ended = c == end[_ended] ? _ended + 1 : (c == end[0] ? 1 : 0);
+          if (_ended == sizeof(end) - 1) _length = STELLARIUM_SELECTION_HEAD;   // Heading complete
+        }
+        break;
+      case S_DONE:
+        break;
+    }
+  }
+
+  void feed(const String &text) {
+    for (size_t i = 0; i < text.length(); ++i) feed(text[i]);
+  }
+
+  bool found() const { return _state == S_DONE; }
+  /// @brief 0 when nothing is selected
+  uint32_t hash() const { return _length ? _hash : 0; }
+
+private:
+  enum State : uint8_t { S_KEY, S_COLON, S_TEXT, S_DONE };
+  State _state = S_KEY;
+  uint8_t _matched = 0, _ended = 0;
+  bool _escape = false;
+  uint16_t _length = 0;
+  uint32_t _hash = 2166136261u;
+};
+
+/// @brief Passes a stream through a SelectionScanner while it is parsed
+class ScannedStream : public Stream {
+
+public:
+  ScannedStream(Stream &stream, SelectionScanner &scanner) : _stream(stream), _scanner(scanner) {}
+
+  int available() override { return _stream.available(); }
+  int peek() override { return _stream.peek(); }
+
+  int read() override {
+    int c = _stream.read();
+    if (c >= 0) _scanner.feed(c);
+    return c;
+  }
+
+  size_t readBytes(char *buffer, size_t length) override {
+    size_t n = _stream.readBytes(buffer, length);
+    for (size_t i = 0; i < n; ++i) _scanner.feed(buffer[i]);
+    return n;
+  }
+
+  size_t write(uint8_t) override { return 0; }
+
+private:
+  Stream &_stream;
+  SelectionScanner &_scanner;
+};
+
+/*
+    Polls Stellarium from its own task on core 0, so a slow or absent laptop never holds up the
+    servo's on core 1. The address of the laptop comes from the WiFi station events and the HTTP
+    connection is kept open between polls. Results go into a double buffer, and into the Stellarium
+    target source when one is given.
+*/
+class StellariumClient {
+
+public:
+  /// @brief Start polling, again does nothing
+  /// @param source gets every object as a target
+  void begin(TargetSource *source = nullptr) {
+    if (_started) return;
+    _source = source;
+    _started = true;
+    WiFi.onEvent([this](WiFiEvent_t event, WiFiEventInfo_t info) {
+      if (event == ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED) {
+        _clientIP = info.wifi_ap_staipassigned.ip.addr;
+        log_i("Station got IP %s", IPAddress(_clientIP.load()).toString().c_str());
+      }
+      if (event == ARDUINO_EVENT_WIFI_AP_STADISCONNECTED and WiFi.softAPgetStationNum() == 0) {
+        _clientIP = 0;
+        log_i("Last station left the access point");
+      }
+    });
+
+    xTaskCreatePinnedToCore(
+        _task,          // Task function
+        "Stellarium",   // Task name
+        8192,           // Stack size (bytes)
+        this,           // Task parameters
+        1,              // Priority
+        NULL,           // Task handle
+        0);             // Pin to Core 0
+  }
+
+  /// @brief Stop polling, e.g. while the RA/Dec is tracked on the ESP32 itself
+  void pause(bool pause) {
+    if (_paused.exchange(pause) == pause) return;
+    log_i("Stellarium polling %s", pause ? "paused" : "resumed");
+  }
+
+  /// @brief ms between two object infos, as set by the rate of the object
+  uint32_t interval() const { return _interval; }
+
+  /// @brief Get the latest sample if there is a new one
+  /// @param sample receives the sample
+  /// @param version last version read by the caller, updated when there is a new sample
+  /// @return true when there was a new sample
+  bool read(StellariumSample &sample, uint32_t &version) const {
+    return _buffer.read(sample, version);
+  }
+
+private:
+
+  static void _task(void *pvParameters) {
+    StellariumClient *self = (StellariumClient *)pvParameters;
+    log_i("Stellarium task started on core %d", xPortGetCoreID());
+
+    self->_http.setReuse(true);   // HTTP/1.1 keep-alive
+    self->_http.setTimeout(STELLARIUM_TIMEOUT);
+    self->_http.setConnectTimeout(STELLARIUM_TIMEOUT);
+
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true) {
+      if (!self->_paused) {
+        self->_poll();
+      } else if (self->_wifiClient.connected()) {
+        self->_wifiClient.stop();   // No need to keep it open for hours
+        self->_refresh = true;      // Whatever was selected meanwhile
+      }
+      vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(self->_period()));
+    }
+  }
+
+  /// @brief Time to the next poll: the object info interval, with status polls at least every STELLARIUM_POLL_INTERVAL
+  /// A slow laptop gets at least twice its round trip between the requests
+  uint32_t _period() const {
+    return std::max<uint32_t>(std::min<uint32_t>(_interval, STELLARIUM_POLL_INTERVAL), 2 * _rtt);
+  }
+
+  /*
+      A poll asks the cheap /api/main/status unless the object info is due. The status tells
+      whether another object was selected, the Stellarium clock was set or its rate changed, or a
+      property changed (e.g. the location); only then, or when the position would have drifted
+      more than STELLARIUM_TOLERANCE, the object info is asked. In between the last position is
+      extrapolated at its rate, so the target keeps moving and stays fresh.
+  */
+  void _poll() {
+    StellariumSample sample;
+    _asked = millis();
+
+    IPAddress clientIP(_clientIP.load());
+    if (!clientIP and WiFi.softAPgetStationNum() > 0) {
+      // Station connected before we registered for the events, look it up once
+      clientIP = checkConnectedClients();
+      _clientIP = (uint32_t)clientIP;
+    }
+
+    if (!clientIP) {
+      _publish(sample, "No connected client");
+      return;
+    }
+
+    if (clientIP != _connectedIP) {
+      _base = "http://" + clientIP.toString() + ":" + String(STELLARIUM_PORT);
+      _connectedIP = clientIP;
+      _actionId = _propId = -2;     // Only the current ids, not every change since the start
+      _statusKnown = false;
+      _refresh = true;
+    }
+
+    if (!_refresh and _asked - _lastInfo + _period() / 2 < _interval) {
+      int changed = _status();
+      if (changed < 0) return;
+      if (!changed) {
+        _extrapolate();
+        return;
+      }
+    }
+    _info();
+  }
+
+  /// @return -1 no answer (published), 0 nothing changed, 1 the object info is needed
+  int _status() {
+    char url[48];
+    snprintf(url, sizeof(url), "/api/main/status?actionId=%d&propId=%d", _actionId, _propId);
+    SelectionScanner scanner;
+    DeserializationError error;
+    bool answered = _get(_base + url, [&](auto &body) { error = _parseStatus(body, scanner); });
+    stellariumStatusPolls.add();
+    if (!answered) return -1;
+    if (error or !scanner.found()) {
+      log_w("Stellarium status not understood: %s", error.c_str());
+      _refresh = true;
+      return 1;
+    }
+
+    double jday = _doc["time"]["jday"].as<double>();
+    double rate = _doc["time"]["timerate"].as<double>();   // Days per second
+    _actionId = _doc["actionChanges"]["id"] | _actionId;
+    int propId = _doc["propertyChanges"]["id"] | _propId;
+
+    const char *change = nullptr;
+    if (_statusKnown) {
+      double expected = _jday + _timeRate * (int32_t)(_asked - _statusAt) / 1000.0;
+      if (scanner.hash() != _selection) change = "selection";
+      else if (propId != _propId) change = "property";
+      else if (fabs(rate - _timeRate) > 0.01 * fabs(_timeRate) + 1e-12) change = "time rate";
+      else if (fabs(jday - expected) * 86400.0 > STELLARIUM_TIME_JUMP) change = "time";
+    }
+    if (change) {
+      log_d("Stellarium %s changed", change);
+      _refresh = true;
+    }
+    _selection = scanner.hash();
+    _propId = propId;
+    _jday = jday;
+    _timeRate = rate;
+    _statusAt = _asked;
+    _statusKnown = true;
+    return change != nullptr;
+  }
+
+  DeserializationError _parseStatus(Stream &body, SelectionScanner &scanner) {
+    ScannedStream scanned(body, scanner);
+    return deserializeJson(_doc, scanned, DeserializationOption::Filter(stellariumStatusFilter()));
+  }
+
+  DeserializationError _parseStatus(String &body, SelectionScanner &scanner) {
+    scanner.feed(body);
+    return deserializeJson(_doc, body, DeserializationOption::Filter(stellariumStatusFilter()));
+  }
+
+  void _info() {
+    StellariumSample sample;
+    bool answered = _get(_base + "/api/objects/info?format=json", [&](auto &body) { parseStellariumJson(body, _doc, sample); });
+    stellariumInfoPolls.add();
+    if (!answered) return;
+
+    // The rate from the previous position of the same object sets when to ask again
+    float dt = (int32_t)(_asked - _lastInfo) / 1000.0;
+    bool same = sample.valid and _last.valid and strcmp(sample.name, _last.name) == 0 and !_refresh and dt > 0;
+    if (same) {
+      _rateAlt = (sample.altitude - _last.altitude) / dt;
+      float az = sample.azimuth - _last.azimuth;
+      _rateAz = (az > 180 ? az - 360 : az < -180 ? az + 360 : az) / dt;
+      float rate = hypotf(_rateAlt, _rateAz * cosf(sample.altitude * (M_PI / 180.0)));
+      _interval = rate > 0 ? constrain(STELLARIUM_TOLERANCE / rate * 1000, STELLARIUM_INFO_MIN, STELLARIUM_INFO_MAX)
+                           : STELLARIUM_INFO_MAX;
+    } else {
+      // New object, ask again after a poll interval to measure its rate. Without an object the status tells when there is one
+      _rateAlt = _rateAz = 0;
+      _interval = sample.valid ? STELLARIUM_POLL_INTERVAL : STELLARIUM_INFO_MAX;
+    }
+    _last = sample;
+    _lastInfo = _asked;
+    _refresh = false;
+    _publish(sample);
+  }
 
-    ObjectData data;
-    data.valid = false;
-    // Get the IP address of the client connected to this AP
-    auto clientIP = checkConnectedClients();
-    if (!clientIP) {// No connected client
-      data.error = "No connected client";
-        return data;
+  /// @brief Nothing changed, the last position moved on at its rate
+  void _extrapolate() {
+    StellariumSample sample = _last;
+    if (sample.valid) {
+      float dt = (int32_t)(_asked - _lastInfo) / 1000.0;
+      sample.altitude += _rateAlt * dt;
+      sample.azimuth = fmodf(sample.azimuth + _rateAz * dt + 360, 360);
     }
+    _publish(sample);
+  }
 
-    // Send request to stellarium to get the current object if any.
-    auto response = sendHTTPRequestToClient(clientIP);
+  /// @brief GET from Stellarium and parse the body straight from the connection
+  /// @param parse gets the body, a Stream or when there is no Content-Length a String
+  /// @return false when there was no answer, that is published
+  template <typename Parse>
+  bool _get(const String &url, Parse parse) {
+    unsigned long request = micros();
+    _http.begin(_wifiClient, url);
+    int httpCode = _http.GET();
+    if (httpCode <= 0) {
+      log_w("HTTP request failed: %s", _http.errorToString(httpCode).c_str());
+      stellariumErrors.add();
+      _http.end();
+      _wifiClient.stop();   // Start with a fresh connection next time
+      _refresh = true;
+      StellariumSample sample;
+      _publish(sample, "No response from Stellarium");
+      return false;
+    }
 
-    if (response=="") { // No valid server response.
-      data.error = "No response from Stellarium";
-        return data;
+    // Parse straight from the connection into a document on a fixed arena, the (several KB)
+    // response is never copied and the keys we don't use are skipped
+    _doc.clear();
+    _arena.reset();
+    unsigned long start = micros();
+    size_t bytes;
+    int size = _http.getSize();
+    if (size > 0) {
+      LimitedStream body(_http.getStream(), size);
+      body.setTimeout(STELLARIUM_TIMEOUT);
+      parse((Stream &)body);
+      bytes = body.count();
+      body.drain();         // Keeps the connection in sync with the next response
+    } else {
+      // No Content-Length, read until the connection closes and start a new one next time
+      String payload = _http.getString();
+      parse(payload);
+      bytes = payload.length();
+      _wifiClient.stop();
     }
+    _http.end();
+    uint32_t took = micros() - request;
+    stellariumRequest.add(took);
+    stellariumBytes.add(size > 0 ? size : bytes);
+    _rtt = (3 * _rtt + took / 1000) / 4;
 
-    // Try to parse the stellarium data
-    data = parseStellariumJson(response);
-    return data;
-}
\ No newline at end of file
+    log_d("Stellarium %s: %d bytes, %u parsed in %lu us, arena peak %u of %u bytes", url.c_str() + _base.length(),
+          size, (unsigned)bytes, micros() - start, (unsigned)_arena.peak(), (unsigned)_arena.capacity());
+    return true;
+  }
+
+  void _publish(StellariumSample &sample, const char *error = nullptr) {
+    if (error) strlcpy(sample.error, error, sizeof(sample.error));
+    sample.time = millis();
+    _buffer.write(sample);
+    if (!_source) return;
+
+    // The position is for when it was asked, the round trip counts as latency
+    TargetSample target;
+    target.altitude = sample.altitude;
+    target.azimuth = sample.azimuth;
+    target.visible = sample.visible;
+    target.valid = sample.valid;
+    target.time = _asked;
+    strlcpy(target.name, sample.name, sizeof(target.name));
+    strlcpy(target.error, sample.error, sizeof(target.error));
+    _source->publish(target);
+  }
+
+  DoubleBuffer<StellariumSample> _buffer;
+  std::atomic<uint32_t> _clientIP{0};
+  std::atomic<bool> _paused{false};
+  bool _started = false;
+  TargetSource *_source = nullptr;
+  uint32_t _asked = 0;      // millis() of the request of the current sample
+  IPAddress _connectedIP;
+  String _base;                     // http://<laptop>:8090
+  bool _refresh = true;             // Ask the object info at the next poll, the last one can't be extrapolated
+  uint32_t _interval = STELLARIUM_POLL_INTERVAL;   // ms between object infos
+  uint32_t _rtt = 0;                // ms, average round trip
+  // Last object info, and its rate in degrees/s
+  StellariumSample _last;
+  uint32_t _lastInfo = 0;
+  float _rateAlt = 0.0, _rateAz = 0.0;
+  // Last status
+  bool _statusKnown = false;
+  uint32_t _selection = 0, _statusAt = 0;
+  int _actionId = -2, _propId = -2;
+  double _jday = 0.0, _timeRate = 0.0;
+  WiFiClient _wifiClient;
+  HTTPClient _http;
+  JsonArena<STELLARIUM_ARENA_SIZE> _arena;
+  JsonDocument _doc{&_arena};
+};
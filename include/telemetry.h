@@ -0,0 +1,212 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <ArduinoJson.h>
+#include <pagedata.h>
+#include <metrics.h>
+
+#define TELEMETRY_PORT          81      // Own port, the synchronous web server can't keep a connection open
+#define TELEMETRY_RATE_MIN      5       // Hz
+#define TELEMETRY_RATE_MAX      20      // Hz
+#define TELEMETRY_CLIENTS       4       // Browsers streaming at the same time
+#define TELEMETRY_HEARTBEAT     5000    // ms, comment line when nothing changed, so dead clients are noticed
+#define TELEMETRY_REQUEST_TIMEOUT 500   // ms, for the request headers of a new client
+
+inline Histogram telemetrySend("rotor_telemetry_send_seconds", "Time to send a telemetry frame to all streams");
+
+/*
+    Streams the same fields as GET /data as Server-Sent Events on their own port, from a task on
+    core 0. Every frame only holds the fields that changed since the previous one (angles at 0.01
+    degree), a client that just connected gets all of them first. Nothing is sent while nothing
+    changes, apart from a heartbeat. The page merges the frames into what it has and goes back to
+    polling /data when the stream is not there.
+*/
+class TelemetryStream {
+
+public:
+  /// @brief Start streaming
+  /// @param data fields to send
+  /// @param rate in Hz, TELEMETRY_RATE_MIN to TELEMETRY_RATE_MAX, 0 to not stream at all
+  void begin(const PagePublisher *data, uint16_t rate) {
+    if (rate == 0) {
+      log_i("Telemetry stream off");
+      return;
+    }
+    _data = data;
+    _interval = 1000 / constrain(rate, TELEMETRY_RATE_MIN, TELEMETRY_RATE_MAX);
+    log_i("Telemetry stream on port %d every %u ms", TELEMETRY_PORT, _interval);
+
+    xTaskCreatePinnedToCore(
+        _task,          // Task function
+        "Telemetry",    // Task name
+        6144,           // Stack size (bytes)
+        this,           // Task parameters
+        1,              // Priority
+        NULL,           // Task handle
+        0);             // Pin to Core 0
+  }
+
+  /// @brief Number of connected streams
+  uint8_t clients() const { return _count; }
+
+private:
+
+  static void _task(void *pvParameters) {
+    TelemetryStream *self = (TelemetryStream *)pvParameters;
+    log_i("Telemetry task started on core %d", xPortGetCoreID());
+
+    self->_server.begin();
+    self->_server.setNoDelay(true);
+
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true) {
+      unsigned long start = micros();
+      self->_accept();
+      self->_send();
+      telemetrySend.add(micros() - start);
+      vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(self->_interval));
+    }
+  }
+
+  /// @brief Take on a new client if there is one
+  void _accept() {
+    if (!_server.hasClient()) return;
+    WiFiClient client = _server.accept();
+    if (!client) return;
+
+    // Only the request line matters, the rest of the headers is read and dropped
+    client.setTimeout(TELEMETRY_REQUEST_TIMEOUT);
+    String request = client.readStringUntil('\n');
+    unsigned long start = millis();
+    while (client.connected() and millis() - start < TELEMETRY_REQUEST_TIMEOUT) {
+      String line = client.readStringUntil('\n');
+      if (line.length() <= 1) break;    // "\r" ends the headers
+    }
+
+    int8_t slot = -1;
+    for (uint8_t i = 0; i < TELEMETRY_CLIENTS; ++i)
+      if (!_clients[i].connected()) slot = i;
+
+    if (!request.startsWith("GET /events")) {
+      client.print("HTTP/1.1 404 Not Found\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+      client.stop();
+      return;
+    }
+    if (slot < 0) {
+      client.print("HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+      client.stop();
+      log_w("Telemetry stream refused, already %d clients", TELEMETRY_CLIENTS);
+      return;
+    }
+
+    // The page comes from port 80, so the stream needs CORS. retry: is the reconnect delay in ms
+    client.print("HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/event-stream\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Connection: keep-alive\r\n"
+                 "Access-Control-Allow-Origin: *\r\n\r\n"
+                 "retry: 2000\n\n");
+    _clients[slot] = client;
+    _fresh[slot] = true;
+    log_i("Telemetry stream to %s", client.remoteIP().toString().c_str());
+  }
+
+  /// @brief Send what changed to every client, everything to new ones
+  void _send() {
+    _count = 0;
+    bool anyone = false;
+    for (uint8_t i = 0; i < TELEMETRY_CLIENTS; ++i) anyone |= _clients[i].connected();
+    if (!anyone) return;
+
+    // Nothing to compare when nothing new was published
+    size_t deltaLength = 0;
+    if (_data->read(_frame, _version)) deltaLength = _encode(_frame, &_sent, _delta, sizeof(_delta));
+    size_t fullLength = 0;
+
+    unsigned long now = millis();
+    bool heartbeat = now - _lastFrame >= TELEMETRY_HEARTBEAT;
+    if (deltaLength or heartbeat) _lastFrame = now;
+
+    for (uint8_t i = 0; i < TELEMETRY_CLIENTS; ++i) {
+      WiFiClient &client = _clients[i];
+      if (!client.connected()) continue;
+      const char *text = nullptr;
+      size_t length = 0;
+      if (_fresh[i]) {
+        if (!fullLength) fullLength = _encode(_frame, nullptr, _full, sizeof(_full));
+        text = _full;
+        length = fullLength;
+        _fresh[i] = false;
+      } else if (deltaLength) {
+        text = _delta;
+        length = deltaLength;
+      } else if (heartbeat) {
+        text = ":\n\n";
+        length = 3;
+      }
+      // A client that can't keep up is dropped, the browser reconnects and starts with a full frame
+      if (length and client.write((const uint8_t *)text, length) != length) {
+        log_w("Telemetry client dropped");
+        client.stop();
+        continue;
+      }
+      _count++;
+    }
+  }
+
+  /// @brief Make an event of the fields that differ from what was sent before
+  /// @param sent what the clients have, the fields that go out are updated. nullptr for all fields
+  /// @return length of the event, 0 when nothing changed
+  static size_t _encode(const PageData &frame, PageData *sent, char *buffer, size_t size) {
+    JsonDocument doc;
+    // Against what was sent, not the previous frame, so a slow drift still shows up
+    auto angle = [&](const char *key, float value, float &before) {
+      if (sent and lroundf(value * 100) == lroundf(before * 100)) return;
+      doc[key] = value;
+      before = value;
+    };
+    auto flag = [&](const char *key, bool value, bool &before) {
+      if (sent and value == before) return;
+      doc[key] = value;
+      before = value;
+    };
+    auto text = [&](const char *key, const char *value, char *before, size_t size) {
+      if (sent and strcmp(value, before) == 0) return;
+      doc[key] = value;
+      strlcpy(before, value, size);
+    };
+    PageData all;
+    PageData &p = sent ? *sent : all;
+    angle("altitude", frame.altitude, p.altitude);
+    angle("azimuth", frame.azimuth, p.azimuth);
+    angle("servo_alt", frame.currAlt, p.currAlt);
+    angle("servo_az", frame.currAz, p.currAz);
+    flag("visible", frame.visible, p.visible);
+    flag("valid", frame.valid, p.valid);
+    flag("tracking", frame.tracking, p.tracking);
+    flag("sidereal", frame.sidereal, p.sidereal);
+    text("name", frame.name, p.name, sizeof(p.name));
+    text("error", frame.error, p.error, sizeof(p.error));
+    text("source", frame.source, p.source, sizeof(p.source));
+    if (doc.isNull()) return 0;
+
+    // SSE framing, "data: <json>\n\n"
+    size_t length = strlcpy(buffer, "data: ", size);
+    length += serializeJson(doc, buffer + length, size - length - 2);
+    buffer[length++] = '\n';
+    buffer[length++] = '\n';
+    buffer[length] = 0;
+    return length;
+  }
+
+  WiFiServer _server{TELEMETRY_PORT, TELEMETRY_CLIENTS};
+  WiFiClient _clients[TELEMETRY_CLIENTS];
+  bool _fresh[TELEMETRY_CLIENTS] = {};
+  const PagePublisher *_data = nullptr;
+  PageData _frame, _sent;
+  uint32_t _version = 0;
+  char _delta[384], _full[384];
+  uint16_t _interval = 100;
+  unsigned long _lastFrame = 0;
+  volatile uint8_t _count = 0;
+};
@@ -0,0 +1,508 @@
+#pragma once
+// Host stand-in for the parts of the ESP32 Arduino core used by this project.
+// Only compiled in the [env:native] PlatformIO environment (see platformio.ini).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define NATIVE_BUILD 1
+
+#ifndef LED_BUILTIN
+#define LED_BUILTIN 2
+#endif
+#define LOW     0
+#define HIGH    1
+#define INPUT   0x01
+#define OUTPUT  0x03
+
+// --- Clock ---
+// By default millis()/micros() follow the host clock. A simulation can switch to a virtual
+// clock and advance it explicitly, delay() in the thread that switched then advances virtual time
+// instead of sleeping. The other threads (web server, telemetry) sleep in host time, so they do not
+// move the clock.
+namespace native {
+
+inline std::atomic<bool> &virtualClock() { static std::atomic<bool> v{false}; return v; }
+inline std::atomic<uint64_t> &virtualMicros() { static std::atomic<uint64_t> t{0}; return t; }
+inline std::atomic<std::thread::id> &clockOwner() { static std::atomic<std::thread::id> id; return id; }
+inline bool ownsClock() { return virtualClock() and std::this_thread::get_id() == clockOwner().load(); }
+
+inline uint64_t hostMicros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline uint64_t nowMicros() { return virtualClock() ? virtualMicros().load() : hostMicros(); }
+
+inline void useVirtualClock(uint64_t startMicros = 0) {
+    virtualMicros() = startMicros;
+    clockOwner() = std::this_thread::get_id();
+    virtualClock() = true;
+}
+
+inline void advance(uint64_t us) { virtualMicros() += us; }
+
+} // namespace native
+
+inline unsigned long millis() { return (unsigned long)(native::nowMicros() / 1000); }
+inline unsigned long micros() { return (unsigned long)native::nowMicros(); }
+inline int64_t esp_timer_get_time() { return (int64_t)native::nowMicros(); }
+
+inline void delay(uint32_t ms) {
+    if (native::ownsClock())
+        native::advance((uint64_t)ms * 1000);
+    else
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(uint32_t us) {
+    if (native::ownsClock())
+        native::advance(us);
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void yield() { std::this_thread::yield(); }
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char *dst, const char *src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = 0;
+    }
+    return len;
+}
+#endif
+
+// --- Math helpers ---
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// --- String ---
+class String {
+public:
+    String() {}
+    String(const char *s) : _s(s ? s : "") {}
+    String(const char *s, unsigned int length) : _s(s ? s : "", s ? length : 0) {}
+    String(const std::string &s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int v) : _s(std::to_string(v)) {}
+    String(unsigned int v) : _s(std::to_string(v)) {}
+    String(long v) : _s(std::to_string(v)) {}
+    String(unsigned long v) : _s(std::to_string(v)) {}
+    String(float v, unsigned int decimals = 2) { _fromDouble(v, decimals); }
+    String(double v, unsigned int decimals = 2) { _fromDouble(v, decimals); }
+
+    const char *c_str() const { return _s.c_str(); }
+    unsigned int length() const { return (unsigned int)_s.size(); }
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    bool isEmpty() const { return _s.empty(); }
+
+    bool concat(const String &s) { _s += s._s; return true; }
+    bool concat(const char *s) { if (s) _s += s; return true; }
+    bool concat(const char *s, unsigned int length) { if (s) _s.append(s, length); return true; }
+    bool concat(char c) { _s += c; return true; }
+
+    String &operator+=(const String &s) { concat(s); return *this; }
+    String &operator+=(const char *s) { concat(s); return *this; }
+    String &operator+=(char c) { concat(c); return *this; }
+
+    friend String operator+(const String &a, const String &b) { String r(a); r += b; return r; }
+    friend String operator+(const String &a, const char *b) { String r(a); r += b; return r; }
+    friend String operator+(const char *a, const String &b) { String r(a); r += b; return r; }
+
+    bool operator==(const String &s) const { return _s == s._s; }
+    bool operator==(const char *s) const { return _s == (s ? s : ""); }
+    bool operator!=(const String &s) const { return !(*this == s); }
+    bool operator!=(const char *s) const { return !(*this == s); }
+    bool operator<(const String &s) const { return _s < s._s; }
+    char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+    char charAt(unsigned int i) const { return (*this)[i]; }
+
+    bool equals(const String &s) const { return *this == s; }
+    bool equalsIgnoreCase(const String &s) const { return strcasecmp(c_str(), s.c_str()) == 0; }
+    bool startsWith(const String &s) const { return _s.compare(0, s._s.size(), s._s) == 0; }
+    bool endsWith(const String &s) const {
+        return _s.size() >= s._s.size() && _s.compare(_s.size() - s._s.size(), s._s.size(), s._s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { auto p = _s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+    int indexOf(const String &s, unsigned int from = 0) const { auto p = _s.find(s._s, from); return p == std::string::npos ? -1 : (int)p; }
+    int lastIndexOf(char c) const { auto p = _s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+
+    String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= _s.size()) return String();
+        return String(_s.substr(from, to - from));
+    }
+
+    void trim() {
+        auto b = _s.find_first_not_of(" \t\r\n");
+        if (b == std::string::npos) { _s.clear(); return; }
+        auto e = _s.find_last_not_of(" \t\r\n");
+        _s = _s.substr(b, e - b + 1);
+    }
+    void toLowerCase() { for (auto &c : _s) c = (char)tolower((unsigned char)c); }
+    void toUpperCase() { for (auto &c : _s) c = (char)toupper((unsigned char)c); }
+    void replace(const String &find, const String &repl) {
+        if (find._s.empty()) return;
+        size_t p = 0;
+        while ((p = _s.find(find._s, p)) != std::string::npos) { _s.replace(p, find._s.size(), repl._s); p += repl._s.size(); }
+    }
+
+    long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_s.c_str(), nullptr); }
+    double toDouble() const { return strtod(_s.c_str(), nullptr); }
+
+private:
+    void _fromDouble(double v, unsigned int decimals) {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        _s = buf;
+    }
+    std::string _s;
+};
+
+// --- Print / Stream ---
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buf++);
+        return n;
+    }
+    size_t write(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+    size_t write(const char *buf, size_t size) { return write((const uint8_t *)buf, size); }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write((const uint8_t *)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T &v) { size_t n = print(v); return n + println(); }
+
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, fmt);
+        int len = vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        if (len < 0) return 0;
+        if ((size_t)len < sizeof(buf)) return write((const uint8_t *)buf, len);
+        std::string big(len + 1, '\0');
+        va_start(args, fmt);
+        vsnprintf(&big[0], big.size(), fmt, args);
+        va_end(args);
+        return write((const uint8_t *)big.data(), len);
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    unsigned long getTimeout() const { return _timeout; }
+
+    virtual size_t readBytes(char *buffer, size_t length) {
+        size_t count = 0;
+        while (count < length) {
+            int c = _timedRead();
+            if (c < 0) break;
+            *buffer++ = (char)c;
+            count++;
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+
+    String readStringUntil(char terminator) {
+        String ret;
+        int c = _timedRead();
+        while (c >= 0 && c != terminator) {
+            ret += (char)c;
+            c = _timedRead();
+        }
+        return ret;
+    }
+
+    String readString() {
+        String ret;
+        int c = _timedRead();
+        while (c >= 0) {
+            ret += (char)c;
+            c = _timedRead();
+        }
+        return ret;
+    }
+
+protected:
+    int _timedRead() {
+        unsigned long start = millis();
+        do {
+            int c = read();
+            if (c >= 0) return c;
+            if (native::virtualClock()) return -1; // Nothing arrives while virtual time stands still
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        } while (millis() - start < _timeout);
+        return -1;
+    }
+    unsigned long _timeout = 1000;
+};
+
+// --- Serial ---
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fwrite(&c, 1, 1, stdout); }
+    size_t write(const uint8_t *buf, size_t size) override { return fwrite(buf, 1, size, stdout); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override { fflush(stdout); }
+    operator bool() const { return true; }
+};
+
+inline HardwareSerial Serial;
+
+// --- IPAddress ---
+class IPAddress {
+public:
+    IPAddress() : _addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    IPAddress(uint32_t addr) : _addr(addr) {}
+
+    operator uint32_t() const { return _addr; }
+    uint8_t operator[](int i) const { return (_addr >> (8 * i)) & 0xFF; }
+    bool operator==(const IPAddress &o) const { return _addr == o._addr; }
+    bool operator!=(const IPAddress &o) const { return _addr != o._addr; }
+
+    String toString() const {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+        return String(buf);
+    }
+
+private:
+    uint32_t _addr; // Network order, like lwIP
+};
+
+// --- GPIO / LEDC ---
+namespace native {
+
+struct LedcChannel {
+    uint32_t freq = 0;
+    uint8_t resolution = 0;
+    int pin = -1;
+    uint32_t duty = 0;
+    uint32_t writes = 0;
+};
+
+inline LedcChannel *ledc() { static LedcChannel channels[16]; return channels; }
+inline uint8_t *gpio() { static uint8_t levels[40] = {0}; return levels; }
+
+} // namespace native
+
+#include "plant.h"
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t val) { if (pin < 40) native::gpio()[pin] = val; }
+inline int digitalRead(uint8_t pin) { return pin < 40 ? native::gpio()[pin] : LOW; }
+
+inline uint32_t ledcSetup(uint8_t chan, uint32_t freq, uint8_t bits) {
+    if (chan >= 16) return 0;
+    native::ledc()[chan].freq = freq;
+    native::ledc()[chan].resolution = bits;
+    return freq;
+}
+inline void ledcAttachPin(uint8_t pin, uint8_t chan) {
+    for (int ch = 0; ch < 16; ++ch)
+        if (native::ledc()[ch].pin == pin) native::ledc()[ch].pin = -1;
+    if (chan < 16) native::ledc()[chan].pin = pin;
+}
+inline void ledcDetachPin(uint8_t pin) {
+    for (int ch = 0; ch < 16; ++ch)
+        if (native::ledc()[ch].pin == pin) native::ledc()[ch].pin = -1;
+}
+inline void ledcWrite(uint8_t chan, uint32_t duty) {
+    if (chan >= 16) return;
+    native::LedcChannel &channel = native::ledc()[chan];
+    channel.duty = duty;
+    channel.writes++;
+    if (channel.pin >= 0 and channel.freq)
+        native::plants().write(channel.pin, duty * 1e6 / channel.freq / (1u << channel.resolution));
+}
+inline uint16_t analogRead(uint8_t pin) { return native::plants().read(pin); }
+
+// --- Logging ---
+// Same macro names as esp32-hal-log.h. Arguments go through a template so an Arduino String
+// passed to %s prints its contents instead of invoking undefined behaviour.
+#ifndef CORE_DEBUG_LEVEL
+#define CORE_DEBUG_LEVEL 3
+#endif
+
+namespace native {
+
+template <typename T> inline T logArg(T v) { return v; }
+inline const char *logArg(const String &s) { return s.c_str(); }
+inline const char *logArg(const IPAddress &ip) {
+    static thread_local char buf[16];
+    snprintf(buf, sizeof(buf), "%s", ip.toString().c_str());
+    return buf;
+}
+
+template <typename... A> inline void log(char level, const char *func, const char *fmt, A... args) {
+    char buf[512];
+    snprintf(buf, sizeof(buf), fmt, logArg(args)...);
+    size_t len = strlen(buf);
+    while (len && buf[len - 1] == '\n') buf[--len] = 0;
+    printf("[%6lu][%c][%s] %s\n", millis(), level, func, buf);
+}
+
+} // namespace native
+
+#pragma GCC diagnostic ignored "-Wformat-security"
+#define log_e(format, ...) do { if (CORE_DEBUG_LEVEL >= 1) native::log('E', __func__, format, ##__VA_ARGS__); } while (0)
+#define log_w(format, ...) do { if (CORE_DEBUG_LEVEL >= 2) native::log('W', __func__, format, ##__VA_ARGS__); } while (0)
+#define log_i(format, ...) do { if (CORE_DEBUG_LEVEL >= 3) native::log('I', __func__, format, ##__VA_ARGS__); } while (0)
+#define log_d(format, ...) do { if (CORE_DEBUG_LEVEL >= 4) native::log('D', __func__, format, ##__VA_ARGS__); } while (0)
+#define log_v(format, ...) do { if (CORE_DEBUG_LEVEL >= 5) native::log('V', __func__, format, ##__VA_ARGS__); } while (0)
+
+// --- FreeRTOS ---
+typedef void (*TaskFunction_t)(void *);
+typedef void *TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+#define pdPASS          1
+#define pdTRUE          1
+#define pdFALSE         0
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY  0x7FFFFFFF
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *, uint32_t, void *params, UBaseType_t, TaskHandle_t *handle, BaseType_t) {
+    std::thread t(task, params);
+    if (handle) *handle = (TaskHandle_t)(uintptr_t)std::hash<std::thread::id>{}(t.get_id());
+    t.detach();
+    return pdPASS;
+}
+
+inline TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline void vTaskDelayUntil(TickType_t *previousWake, TickType_t increment) {
+    *previousWake += increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(*previousWake - now) > 0) delay(*previousWake - now);
+}
+inline void vTaskDelete(TaskHandle_t) {}
+inline BaseType_t xPortGetCoreID() { return 1; }
+
+struct portMUX_TYPE {
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+inline void portENTER_CRITICAL(portMUX_TYPE *mux) { while (mux->flag.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux) { mux->flag.clear(std::memory_order_release); }
+
+// Mutexes only, waiting is either forever or not at all
+typedef std::mutex *SemaphoreHandle_t;
+#define portMAX_DELAY   0xFFFFFFFF
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::mutex; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t wait) {
+    if (wait == portMAX_DELAY) { mutex->lock(); return pdTRUE; }
+    return mutex->try_lock() ? pdTRUE : pdFALSE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) { mutex->unlock(); return pdTRUE; }
+
+// Event groups, waiting is either forever or not at all
+typedef uint32_t EventBits_t;
+struct EventGroup {
+    std::mutex mutex;
+    std::condition_variable changed;
+    EventBits_t bits = 0;
+};
+typedef EventGroup *EventGroupHandle_t;
+#ifndef BIT0
+#define BIT0    0x01
+#define BIT1    0x02
+#define BIT2    0x04
+#define BIT3    0x08
+#endif
+inline EventGroupHandle_t xEventGroupCreate() { return new EventGroup; }
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    group->bits |= bits;
+    group->changed.notify_all();
+    return group->bits;
+}
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    return group->bits;
+}
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all, TickType_t wait) {
+    std::unique_lock<std::mutex> lock(group->mutex);
+    auto done = [&] { return all ? (group->bits & bits) == bits : (group->bits & bits) != 0; };
+    if (wait == portMAX_DELAY) group->changed.wait(lock, done);
+    EventBits_t result = group->bits;
+    if (clear and done()) group->bits &= ~bits;
+    return result;
+}
+
+// --- System ---
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    void restart() { fflush(stdout); std::exit(0); }
+};
+inline EspClass ESP;
+
+// Arduino sketch entry points, called from native_main.cpp
+void setup();
+void loop();
+
+// --- Simulation ---
+// With the virtual clock the motion task is not started, the pass simulator (simulator.cpp) steps
+// it itself. The sketch tells it where the antenna really points.
+namespace native {
+
+struct Simulation {
+    std::function<void()> motionStep;                       // MotionTask::tick()
+    uint32_t motionPeriod = 0;                              // us
+    std::function<bool(float &alt, float &az)> pointing;    // Of the plants, false while not tracking
+};
+
+inline Simulation &simulation() { static Simulation s; return s; }
+
+/// @brief `program simulate ...`, see simulator.cpp
+int simulate(int argc, char **argv);
+
+} // namespace native
@@ -0,0 +1,74 @@
+#pragma once
+// Host stand-in for the ESP32 EEPROM emulation. Contents live in RAM, and are loaded from and
+// committed to the file named by the ROTOR_EEPROM environment variable when it is set.
+#include <Arduino.h>
+#include <vector>
+
+class EEPROMClass {
+public:
+    bool begin(size_t size) {
+        if (size == 0) return false;
+        if (_data.size() >= size) return true;
+        _data.resize(size, 0xFF);
+        const char *path = getenv("ROTOR_EEPROM");
+        if (path) {
+            if (FILE *f = fopen(path, "rb")) {
+                size_t n = fread(_data.data(), 1, _data.size(), f);
+                (void)n;
+                fclose(f);
+            }
+        }
+        return true;
+    }
+
+    void end() { commit(); }
+
+    bool commit() {
+        commits++;
+        const char *path = getenv("ROTOR_EEPROM");
+        if (!path) return true;
+        FILE *f = fopen(path, "wb");
+        if (!f) return false;
+        bool ok = fwrite(_data.data(), 1, _data.size(), f) == _data.size();
+        fclose(f);
+        return ok;
+    }
+
+    uint8_t read(int address) { return _valid(address, 1) ? _data[address] : 0; }
+    void write(int address, uint8_t val) { if (_valid(address, 1)) _data[address] = val; }
+    uint16_t length() { return (uint16_t)_data.size(); }
+    uint8_t *getDataPtr() { return _data.data(); }
+
+    template <typename T> T &get(int address, T &t) {
+        if (_valid(address, sizeof(T))) memcpy(&t, &_data[address], sizeof(T));
+        return t;
+    }
+
+    template <typename T> const T &put(int address, const T &t) {
+        if (_valid(address, sizeof(T))) memcpy(&_data[address], &t, sizeof(T));
+        return t;
+    }
+
+    int32_t readInt(int address) { int32_t v = 0; return get(address, v); }
+    size_t writeInt(int address, int32_t value) { put(address, value); return _valid(address, sizeof(value)) ? sizeof(value) : 0; }
+    int16_t readShort(int address) { int16_t v = 0; return get(address, v); }
+    size_t writeShort(int address, int16_t value) { put(address, value); return _valid(address, sizeof(value)) ? sizeof(value) : 0; }
+    size_t readBytes(int address, void *value, size_t len) {
+        if (!_valid(address, len)) return 0;
+        memcpy(value, &_data[address], len);
+        return len;
+    }
+    size_t writeBytes(int address, const void *value, size_t len) {
+        if (!_valid(address, len)) return 0;
+        memcpy(&_data[address], value, len);
+        return len;
+    }
+
+    uint32_t commits = 0;
+
+private:
+    bool _valid(int address, size_t len) const { return address >= 0 && (size_t)address + len <= _data.size(); }
+    std::vector<uint8_t> _data;
+};
+
+inline EEPROMClass EEPROM;
@@ -0,0 +1,112 @@
+#pragma once
+// Host stand-in for the Arduino FS API. Paths map onto a host directory, see SPIFFS.h.
+#include <Arduino.h>
+#include <dirent.h>
+#include <memory>
+#include <sys/stat.h>
+#include <vector>
+
+namespace fs {
+
+class File : public Stream {
+public:
+    File() {}
+    File(FILE *f, const String &name, bool directory = false)
+        : _f(f ? std::shared_ptr<FILE>(f, fclose) : nullptr), _name(name), _directory(directory) {}
+    // Directory, entries are the paths of the files in it
+    File(const String &name, const String &root, std::vector<String> entries)
+        : _name(name), _directory(true), _root(root), _entries(std::move(entries)) {}
+
+    operator bool() const { return _f != nullptr || _directory; }
+    bool isDirectory() const { return _directory; }
+    const char *name() const { return _name.c_str(); }
+    const char *path() const { return _name.c_str(); }
+
+    size_t size() const {
+        if (!_f) return 0;
+        long pos = ftell(_f.get());
+        fseek(_f.get(), 0, SEEK_END);
+        long size = ftell(_f.get());
+        fseek(_f.get(), pos, SEEK_SET);
+        return size < 0 ? 0 : (size_t)size;
+    }
+    size_t position() const { return _f ? (size_t)ftell(_f.get()) : 0; }
+    bool seek(uint32_t pos) { return _f && fseek(_f.get(), pos, SEEK_SET) == 0; }
+
+    int available() override { return _f ? (int)(size() - position()) : 0; }
+    int read() override { return _f ? fgetc(_f.get()) : -1; }
+    int peek() override {
+        if (!_f) return -1;
+        int c = fgetc(_f.get());
+        if (c >= 0) ungetc(c, _f.get());
+        return c;
+    }
+    size_t read(uint8_t *buf, size_t size) { return _f ? fread(buf, 1, size, _f.get()) : 0; }
+    size_t readBytes(char *buffer, size_t length) override { return read((uint8_t *)buffer, length); }
+    size_t write(uint8_t c) override { return _f ? fwrite(&c, 1, 1, _f.get()) : 0; }
+    size_t write(const uint8_t *buf, size_t size) override { return _f ? fwrite(buf, 1, size, _f.get()) : 0; }
+    void flush() override { if (_f) fflush(_f.get()); }
+    void close() { _f.reset(); _directory = false; }
+
+    File openNextFile(const char *mode = "r") {
+        if (!_directory || _next >= _entries.size()) return File();
+        String path = _entries[_next++];
+        return File(fopen((_root + path).c_str(), mode[0] == 'w' ? "wb" : "rb"), path);
+    }
+
+private:
+    std::shared_ptr<FILE> _f;
+    String _name;
+    bool _directory = false;
+    String _root;
+    std::vector<String> _entries;
+    size_t _next = 0;
+};
+
+class FS {
+public:
+    // Host directory that plays the role of the SPIFFS image, defaults to the project data/ dir
+    String root() const {
+        const char *r = getenv("ROTOR_FS_ROOT");
+        return r ? String(r) : String("data");
+    }
+
+    File open(const char *path, const char *mode = "r") {
+        String full = root() + path;
+        struct stat st;
+        if (stat(full.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            std::vector<String> entries;
+            String dir = path;
+            if (!dir.endsWith("/")) dir += "/";
+            if (DIR *d = opendir(full.c_str())) {
+                while (struct dirent *e = readdir(d))
+                    if (e->d_type == DT_REG) entries.push_back(dir + e->d_name);
+                closedir(d);
+            }
+            std::sort(entries.begin(), entries.end(), [](const String &a, const String &b) { return strcmp(a.c_str(), b.c_str()) < 0; });
+            return File(String(path), root(), entries);
+        }
+        std::string m = mode;
+        if (m.find('b') == std::string::npos) m += 'b';
+        FILE *f = fopen(full.c_str(), m.c_str());
+        return File(f, String(path));
+    }
+    File open(const String &path, const char *mode = "r") { return open(path.c_str(), mode); }
+
+    bool exists(const char *path) {
+        FILE *f = fopen((root() + path).c_str(), "rb");
+        if (!f) return false;
+        fclose(f);
+        return true;
+    }
+    bool exists(const String &path) { return exists(path.c_str()); }
+    bool remove(const char *path) { return ::remove((root() + path).c_str()) == 0; }
+    bool remove(const String &path) { return remove(path.c_str()); }
+    bool rename(const char *from, const char *to) { return ::rename((root() + from).c_str(), (root() + to).c_str()) == 0; }
+    bool rename(const String &from, const String &to) { return rename(from.c_str(), to.c_str()); }
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
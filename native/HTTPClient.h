@@ -0,0 +1,115 @@
+#pragma once
+// Host stand-in for the ESP32 HTTPClient: plain HTTP/1.1 GET over the WiFiClient stand-in.
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+#define HTTP_CODE_OK 200
+
+class HTTPClient {
+public:
+    bool begin(WiFiClient &client, const String &url) {
+        _client = &client;
+        return begin(url);
+    }
+
+    bool begin(const String &url) {
+        String u = url;
+        if (u.startsWith("http://")) u = u.substring(7);
+        int slash = u.indexOf('/');
+        String hostPort = slash < 0 ? u : u.substring(0, slash);
+        String path = slash < 0 ? String("/") : u.substring(slash);
+        int colon = hostPort.indexOf(':');
+        String host = colon < 0 ? hostPort : hostPort.substring(0, colon);
+        uint16_t port = colon < 0 ? 80 : (uint16_t)hostPort.substring(colon + 1).toInt();
+        if (_client->connected() && (host != _host || port != _port)) _client->stop();
+        _host = host;
+        _port = port;
+        _path = path;
+        return true;
+    }
+
+    void setReuse(bool reuse) { _reuse = reuse; }
+    void setTimeout(uint16_t timeout) { _timeout = timeout; }
+    void setConnectTimeout(int32_t timeout) { _connectTimeout = timeout; }
+    void useHTTP10(bool http10) { _http10 = http10; }
+
+    int GET() {
+        _size = -1;
+        if (!_client->connected() && !_client->connect(_host.c_str(), _port, _connectTimeout))
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        _client->setTimeout(_timeout);
+        String request = String("GET ") + _path + (_http10 ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n") +
+                         "Host: " + _host + "\r\nConnection: " + (_reuse ? "keep-alive" : "close") + "\r\n\r\n";
+        if (_client->print(request) != request.length()) return HTTPC_ERROR_SEND_HEADER_FAILED;
+
+        String status = _client->readStringUntil('\n');
+        if (!status.startsWith("HTTP/")) { _client->stop(); return HTTPC_ERROR_READ_TIMEOUT; }
+        int code = status.substring(status.indexOf(' ') + 1).toInt();
+        while (true) {
+            String line = _client->readStringUntil('\n');
+            line.trim();
+            if (line.length() == 0) break;
+            int colon = line.indexOf(':');
+            if (colon < 0) continue;
+            String name = line.substring(0, colon);
+            String value = line.substring(colon + 1);
+            value.trim();
+            if (name.equalsIgnoreCase("Content-Length")) _size = value.toInt();
+            if (name.equalsIgnoreCase("Connection") && value.equalsIgnoreCase("close")) _canReuse = false;
+        }
+        return code;
+    }
+
+    int getSize() { return _size; }
+    WiFiClient &getStream() { return *_client; }
+    WiFiClient *getStreamPtr() { return _client; }
+
+    String getString() {
+        if (_size < 0) return _client->readString();
+        String body;
+        body.reserve(_size);
+        char buf[256];
+        int remaining = _size;
+        while (remaining > 0) {
+            size_t n = _client->readBytes(buf, std::min<int>(remaining, sizeof(buf)));
+            if (n == 0) break;
+            body.concat(buf, n);
+            remaining -= n;
+        }
+        return body;
+    }
+
+    void end() {
+        if (!_reuse || !_canReuse) _client->stop();
+        _canReuse = true;
+    }
+
+    bool connected() { return _client->connected(); }
+
+    static String errorToString(int error) {
+        switch (error) {
+            case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+            case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+            case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+            case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+            case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+            default: return String();
+        }
+    }
+
+private:
+    WiFiClient _ownClient;
+    WiFiClient *_client = &_ownClient;
+    String _host, _path;
+    uint16_t _port = 80;
+    int _size = -1;
+    uint16_t _timeout = 5000;
+    int32_t _connectTimeout = 5000;
+    bool _reuse = true, _canReuse = true, _http10 = false;
+};
@@ -0,0 +1,89 @@
+#pragma once
+// Host stand-in for the ESP32 Preferences (NVS) library, only the byte blob calls.
+// Contents live in RAM, and are loaded from and saved to the file named by the ROTOR_NVS
+// environment variable when it is set (one file for all namespaces).
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace native {
+
+// NVS is used from more than one task
+inline std::recursive_mutex &nvsMutex() { static std::recursive_mutex m; return m; }
+
+inline std::map<std::string, std::vector<uint8_t>> &nvs() {
+    static std::map<std::string, std::vector<uint8_t>> store;
+    static bool loaded = false;
+    if (!loaded) {
+        loaded = true;
+        const char *path = getenv("ROTOR_NVS");
+        if (FILE *f = path ? fopen(path, "rb") : nullptr) {
+            uint32_t keyLength, length;
+            while (fread(&keyLength, 4, 1, f) == 1) {
+                std::string key(keyLength, 0);
+                if (fread(&key[0], 1, keyLength, f) != keyLength or fread(&length, 4, 1, f) != 1) break;
+                std::vector<uint8_t> value(length);
+                if (fread(value.data(), 1, length, f) != length) break;
+                store[key] = value;
+            }
+            fclose(f);
+        }
+    }
+    return store;
+}
+
+inline void saveNvs() {
+    const char *path = getenv("ROTOR_NVS");
+    FILE *f = path ? fopen(path, "wb") : nullptr;
+    if (!f) return;
+    for (auto &entry : nvs()) {
+        uint32_t keyLength = entry.first.size(), length = entry.second.size();
+        fwrite(&keyLength, 4, 1, f);
+        fwrite(entry.first.data(), 1, keyLength, f);
+        fwrite(&length, 4, 1, f);
+        fwrite(entry.second.data(), 1, length, f);
+    }
+    fclose(f);
+}
+
+} // namespace native
+
+class Preferences {
+public:
+    bool begin(const char *name, bool readOnly = false) {
+        _prefix = std::string(name) + "/";
+        _readOnly = readOnly;
+        _open = true;
+        return true;
+    }
+
+    void end() { _open = false; }
+
+    size_t putBytes(const char *key, const void *value, size_t len) {
+        if (!_open or _readOnly) return 0;
+        std::lock_guard<std::recursive_mutex> lock(native::nvsMutex());
+        auto bytes = (const uint8_t *)value;
+        native::nvs()[_prefix + key] = std::vector<uint8_t>(bytes, bytes + len);
+        native::saveNvs();
+        return len;
+    }
+
+    size_t getBytesLength(const char *key) {
+        std::lock_guard<std::recursive_mutex> lock(native::nvsMutex());
+        auto it = native::nvs().find(_prefix + key);
+        return _open and it != native::nvs().end() ? it->second.size() : 0;
+    }
+
+    size_t getBytes(const char *key, void *buf, size_t maxLen) {
+        std::lock_guard<std::recursive_mutex> lock(native::nvsMutex());
+        size_t len = getBytesLength(key);
+        if (len == 0 or len > maxLen) return 0;
+        memcpy(buf, native::nvs()[_prefix + key].data(), len);
+        return len;
+    }
+
+private:
+    std::string _prefix;
+    bool _readOnly = false, _open = false;
+};
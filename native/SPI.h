@@ -0,0 +1,24 @@
+#pragma once
+// Host stand-in for the ESP32 SPI library, 16 bit frames go to the simulated encoders of plant.h.
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+#define MSBFIRST  1
+
+struct SPISettings {
+    SPISettings(uint32_t = 1000000, uint8_t = MSBFIRST, uint8_t = SPI_MODE0) {}
+};
+
+class SPIClass {
+public:
+    void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    uint16_t transfer16(uint16_t data) { return native::plants().spi(data); }
+};
+
+inline SPIClass SPI;
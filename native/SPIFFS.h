@@ -0,0 +1,15 @@
+#pragma once
+#include <FS.h>
+
+class SPIFFSFS : public fs::FS {
+public:
+    bool begin(bool formatOnFail = false, const char * = "/spiffs", uint8_t = 10, const char * = nullptr) {
+        (void)formatOnFail;
+        return true;
+    }
+    void end() {}
+    size_t totalBytes() { return 1024 * 1024; }
+    size_t usedBytes() { return 0; }
+};
+
+inline SPIFFSFS SPIFFS;
@@ -0,0 +1,230 @@
+#pragma once
+// Host stand-in for the synchronous ESP32 WebServer: one request per connection, enough to
+// serve index.html and the JSON endpoints to a browser on the host.
+#include <Arduino.h>
+#include <FS.h>
+#include <WiFi.h>
+#include <functional>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    WebServer(int port = 80) : _server(port) {}
+
+    void begin() { _server.begin(); }
+    void stop() { _server.end(); }
+
+    void on(const String &uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String &uri, HTTPMethod method, THandlerFunction fn) { _routes.push_back({uri, method, fn}); }
+    void onNotFound(THandlerFunction fn) { _notFound = fn; }
+
+    void collectHeaders(const char *headerKeys[], const size_t headerKeysCount) {
+        _collect.clear();
+        for (size_t i = 0; i < headerKeysCount; ++i) _collect.push_back(headerKeys[i]);
+    }
+
+    void handleClient() {
+        _client = _server.accept();
+        if (!_client) return;
+        if (_readRequest()) {
+            _responseHeaders = "";
+            _contentLength = CONTENT_LENGTH_NOT_SET;
+            _chunked = false;
+            bool handled = false;
+            for (auto &r : _routes) {
+                if (r.uri == _uri && (r.method == HTTP_ANY || r.method == _method)) {
+                    r.fn();
+                    handled = true;
+                    break;
+                }
+            }
+            if (!handled) {
+                if (_notFound) _notFound();
+                else send(404, "text/plain", "Not found");
+            }
+            if (_chunked) _client.print("0\r\n\r\n");
+        }
+        _client.stop();
+    }
+
+    // --- Request ---
+    String uri() const { return _uri; }
+    HTTPMethod method() const { return _method; }
+    WiFiClient &client() { return _client; }
+    int args() const { return (int)_args.size(); }
+    String arg(int i) const { return i < (int)_args.size() ? _args[i].second : String(); }
+    String argName(int i) const { return i < (int)_args.size() ? _args[i].first : String(); }
+    String arg(const String &name) const {
+        for (auto &a : _args)
+            if (a.first == name) return a.second;
+        return String();
+    }
+    bool hasArg(const String &name) const {
+        for (auto &a : _args)
+            if (a.first == name) return true;
+        return false;
+    }
+    String header(const String &name) const {
+        for (auto &h : _headers)
+            if (h.first.equalsIgnoreCase(name)) return h.second;
+        return String();
+    }
+    bool hasHeader(const String &name) const {
+        for (auto &h : _headers)
+            if (h.first.equalsIgnoreCase(name)) return true;
+        return false;
+    }
+
+    // --- Response ---
+    void sendHeader(const String &name, const String &value, bool first = false) {
+        String line = name + ": " + value + "\r\n";
+        _responseHeaders = first ? line + _responseHeaders : _responseHeaders + line;
+    }
+    void setContentLength(const size_t contentLength) { _contentLength = contentLength; }
+
+    void send(int code, const char *contentType = nullptr, const String &content = String()) {
+        if (_contentLength == CONTENT_LENGTH_NOT_SET) _contentLength = content.length();
+        _sendHead(code, contentType);
+        if (content.length()) sendContent(content);
+    }
+    void send(int code, const String &contentType, const String &content) { send(code, contentType.c_str(), content); }
+    void send_P(int code, const char *contentType, const char *content, size_t len) {
+        _contentLength = len;
+        _sendHead(code, contentType);
+        _client.write((const uint8_t *)content, len);
+    }
+
+    void sendContent(const String &content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char *content, size_t size) {
+        if (_chunked) {
+            if (!size) return;
+            char head[20];
+            snprintf(head, sizeof(head), "%zx\r\n", size);
+            _client.print(head);
+            _client.write((const uint8_t *)content, size);
+            _client.print("\r\n");
+        } else {
+            _client.write((const uint8_t *)content, size);
+        }
+    }
+
+    template <typename T> size_t streamFile(T &file, const String &contentType, int code = 200) {
+        _contentLength = file.size();
+        // Like the ESP32 version, a .gz file is sent as the compressed form of contentType
+        if (String(file.name()).endsWith(".gz") && contentType != "application/x-gzip" && contentType != "application/octet-stream")
+            sendHeader("Content-Encoding", "gzip");
+        _sendHead(code, contentType.c_str());
+        uint8_t buf[1024];
+        size_t total = 0, n;
+        while ((n = file.read(buf, sizeof(buf))) > 0) total += _client.write(buf, n);
+        return total;
+    }
+
+private:
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction fn;
+    };
+
+    static String _decode(const String &s) {
+        String out;
+        for (unsigned int i = 0; i < s.length(); ++i) {
+            char c = s[i];
+            if (c == '+') out += ' ';
+            else if (c == '%' && i + 2 < s.length()) {
+                char hex[3] = {s[i + 1], s[i + 2], 0};
+                out += (char)strtol(hex, nullptr, 16);
+                i += 2;
+            } else out += c;
+        }
+        return out;
+    }
+
+    void _parseArgs(const String &query) {
+        int start = 0;
+        while (start < (int)query.length()) {
+            int amp = query.indexOf('&', start);
+            if (amp < 0) amp = query.length();
+            String pair = query.substring(start, amp);
+            int eq = pair.indexOf('=');
+            if (pair.length()) {
+                if (eq < 0) _args.push_back({_decode(pair), String()});
+                else _args.push_back({_decode(pair.substring(0, eq)), _decode(pair.substring(eq + 1))});
+            }
+            start = amp + 1;
+        }
+    }
+
+    bool _readRequest() {
+        _client.setTimeout(1000);
+        _args.clear();
+        _headers.clear();
+        String line = _client.readStringUntil('\n');
+        line.trim();
+        int sp1 = line.indexOf(' '), sp2 = line.indexOf(' ', sp1 + 1);
+        if (sp1 < 0 || sp2 < 0) return false;
+        String method = line.substring(0, sp1);
+        String url = line.substring(sp1 + 1, sp2);
+        _method = method == "POST" ? HTTP_POST : method == "PUT" ? HTTP_PUT : method == "DELETE" ? HTTP_DELETE
+                : method == "HEAD" ? HTTP_HEAD : method == "OPTIONS" ? HTTP_OPTIONS : HTTP_GET;
+        int q = url.indexOf('?');
+        _uri = q < 0 ? url : url.substring(0, q);
+        if (q >= 0) _parseArgs(url.substring(q + 1));
+
+        int contentLength = 0;
+        while (true) {
+            String h = _client.readStringUntil('\n');
+            h.trim();
+            if (h.length() == 0) break;
+            int colon = h.indexOf(':');
+            if (colon < 0) continue;
+            String name = h.substring(0, colon), value = h.substring(colon + 1);
+            value.trim();
+            if (name.equalsIgnoreCase("Content-Length")) contentLength = value.toInt();
+            _headers.push_back({name, value});
+        }
+        if (contentLength > 0) {
+            std::string body(contentLength, '\0');
+            size_t n = _client.readBytes(&body[0], contentLength);
+            body.resize(n);
+            String plain(body);
+            String type = header("Content-Type");
+            if (type.startsWith("application/x-www-form-urlencoded")) _parseArgs(plain);
+            _args.push_back({"plain", plain});
+        }
+        return true;
+    }
+
+    void _sendHead(int code, const char *contentType) {
+        String head = String("HTTP/1.1 ") + String(code) + (code == 200 ? " OK" : code == 304 ? " Not Modified" : "") + "\r\n";
+        if (contentType && *contentType) head += String("Content-Type: ") + contentType + "\r\n";
+        if (_contentLength == CONTENT_LENGTH_UNKNOWN) {
+            _chunked = true;
+            head += "Transfer-Encoding: chunked\r\n";
+        } else if (_contentLength != CONTENT_LENGTH_NOT_SET) {
+            head += String("Content-Length: ") + String((unsigned long)_contentLength) + "\r\n";
+        }
+        head += _responseHeaders + "Connection: close\r\n\r\n";
+        _client.print(head);
+    }
+
+    WiFiServer _server;
+    WiFiClient _client;
+    std::vector<Route> _routes;
+    THandlerFunction _notFound;
+    std::vector<String> _collect;
+    String _uri;
+    HTTPMethod _method = HTTP_GET;
+    std::vector<std::pair<String, String>> _args, _headers;
+    String _responseHeaders;
+    size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+    bool _chunked = false;
+};
@@ -0,0 +1,265 @@
+#pragma once
+// Host stand-in for the ESP32 WiFi library. WiFiServer/WiFiClient are real non-blocking TCP
+// sockets, so SatDump, gpredict or a browser on the host can talk to a native build.
+// Ports below 1024 are shifted up by 8000 (the web server on port 80 listens on 8080), all ports by
+// ROTOR_PORT_OFFSET so more than one can run at once.
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace native {
+
+inline uint16_t hostPort(uint16_t port) {
+    static const int offset = getenv("ROTOR_PORT_OFFSET") ? atoi(getenv("ROTOR_PORT_OFFSET")) : 0;
+    return (port < 1024 ? port + 8000 : port) + offset;
+}
+
+struct Socket {
+    explicit Socket(int fd) : fd(fd) {}
+    ~Socket() { if (fd >= 0) ::close(fd); }
+    int fd;
+};
+
+} // namespace native
+
+class WiFiClient : public Stream {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd) : _sock(std::make_shared<native::Socket>(fd)) {}
+
+    int connect(IPAddress ip, uint16_t port, int32_t timeout_ms = 3000) {
+        return connect(ip.toString().c_str(), port, timeout_ms);
+    }
+
+    int connect(const char *host, uint16_t port, int32_t timeout_ms = 3000) {
+        stop();
+        addrinfo hints{}, *res = nullptr;
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host, std::to_string(port).c_str(), &hints, &res) != 0 || !res) return 0;
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) { freeaddrinfo(res); return 0; }
+        timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int ok = ::connect(fd, res->ai_addr, res->ai_addrlen);
+        freeaddrinfo(res);
+        if (ok != 0) { ::close(fd); return 0; }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        _sock = std::make_shared<native::Socket>(fd);
+        return 1;
+    }
+
+    uint8_t connected() {
+        if (!_sock) return 0;
+        char c;
+        ssize_t n = recv(_sock->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0) { stop(); return 0; }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) { stop(); return 0; }
+        return 1;
+    }
+
+    operator bool() { return connected(); }
+    bool operator==(const WiFiClient &o) const { return _sock == o._sock; }
+    bool operator!=(const WiFiClient &o) const { return _sock != o._sock; }
+
+    int available() override {
+        if (!_sock) return 0;
+        int n = 0;
+        if (ioctl(_sock->fd, FIONREAD, &n) < 0) return 0;
+        return n;
+    }
+
+    int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    int read(uint8_t *buf, size_t size) {
+        if (!_sock) return -1;
+        ssize_t n = recv(_sock->fd, buf, size, MSG_DONTWAIT);
+        return n > 0 ? (int)n : -1;
+    }
+
+    size_t readBytes(char *buffer, size_t length) override { return Stream::readBytes(buffer, length); }
+
+    int peek() override {
+        if (!_sock) return -1;
+        uint8_t c;
+        return recv(_sock->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override {
+        if (!_sock) return 0;
+        size_t sent = 0;
+        unsigned long start = millis();
+        while (sent < size) {
+            ssize_t n = send(_sock->fd, buf + sent, size - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) { sent += n; continue; }
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) break;
+            if (millis() - start > 3000) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return sent;
+    }
+    using Print::write;
+
+    void stop() { _sock.reset(); }
+    void flush() override {}
+    int setNoDelay(bool nodelay) {
+        if (!_sock) return -1;
+        int v = nodelay;
+        return setsockopt(_sock->fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+    }
+    int fd() const { return _sock ? _sock->fd : -1; }
+
+    IPAddress remoteIP() const {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        if (!_sock || getpeername(_sock->fd, (sockaddr *)&addr, &len) != 0) return IPAddress();
+        return IPAddress((uint32_t)addr.sin_addr.s_addr);
+    }
+    uint16_t remotePort() const {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        if (!_sock || getpeername(_sock->fd, (sockaddr *)&addr, &len) != 0) return 0;
+        return ntohs(addr.sin_port);
+    }
+
+private:
+    std::shared_ptr<native::Socket> _sock;
+};
+
+class WiFiServer {
+public:
+    WiFiServer(uint16_t port = 80, uint8_t max_clients = 4) : _port(port), _maxClients(max_clients) {}
+    ~WiFiServer() { end(); }
+
+    void begin(uint16_t port = 0) {
+        if (port) _port = port;
+        if (_fd >= 0) return;
+        _fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (_fd < 0) return;
+        int one = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(native::hostPort(_port));
+        if (::bind(_fd, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(_fd, _maxClients) != 0) {
+            log_e("Could not listen on port %d", (int)native::hostPort(_port));
+            ::close(_fd);
+            _fd = -1;
+            return;
+        }
+        fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+        log_i("Listening on host port %d", (int)native::hostPort(_port));
+    }
+
+    void end() {
+        if (_fd >= 0) ::close(_fd);
+        _fd = -1;
+    }
+    void stop() { end(); }
+    void close() { end(); }
+
+    WiFiClient accept() {
+        if (_fd < 0) return WiFiClient();
+        int fd = ::accept(_fd, nullptr, nullptr);
+        if (fd < 0) return WiFiClient();
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        WiFiClient client(fd);
+        if (_noDelay) client.setNoDelay(true);
+        return client;
+    }
+    WiFiClient available() { return accept(); }
+
+    bool hasClient() {
+        if (_fd < 0) return false;
+        fd_set set;
+        FD_ZERO(&set);
+        FD_SET(_fd, &set);
+        timeval tv{0, 0};
+        return select(_fd + 1, &set, nullptr, nullptr, &tv) > 0;
+    }
+
+    void setNoDelay(bool nodelay) { _noDelay = nodelay; }
+    operator bool() { return _fd >= 0; }
+
+private:
+    uint16_t _port;
+    uint8_t _maxClients;
+    int _fd = -1;
+    bool _noDelay = false;
+};
+
+#include <esp_wifi.h>
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_AP_START,
+    ARDUINO_EVENT_WIFI_AP_STOP,
+    ARDUINO_EVENT_WIFI_AP_STACONNECTED,
+    ARDUINO_EVENT_WIFI_AP_STADISCONNECTED,
+    ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED,
+    ARDUINO_EVENT_MAX
+} arduino_event_id_t;
+
+typedef union {
+    struct { uint8_t mac[6]; uint8_t aid; } wifi_ap_staconnected;
+    struct { uint8_t mac[6]; uint8_t aid; } wifi_ap_stadisconnected;
+    struct { esp_ip4_addr_t ip; } wifi_ap_staipassigned;
+} arduino_event_info_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef arduino_event_info_t WiFiEventInfo_t;
+typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> WiFiEventFuncCb;
+typedef size_t wifi_event_id_t;
+
+// The host is the one station on the simulated access point, it gets 127.0.0.1 as soon as the
+// AP is up, or immediately when a handler registers after that.
+class WiFiClass {
+public:
+    bool softAP(const char *ssid, const char *passphrase = nullptr, int = 1, int = 0, int = 4) {
+        log_i("Simulated access point '%s' (password '%s')", ssid, passphrase ? passphrase : "");
+        _apStarted = true;
+        for (auto &h : _handlers) _stationJoined(h);
+        return true;
+    }
+    IPAddress softAPIP() { return IPAddress(127, 0, 0, 1); }
+    uint8_t softAPgetStationNum() { return _apStarted ? 1 : 0; }
+
+    wifi_event_id_t onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX) {
+        _handlers.push_back({cb, event});
+        if (_apStarted) _stationJoined(_handlers.back());
+        return _handlers.size();
+    }
+
+private:
+    struct Handler {
+        WiFiEventFuncCb cb;
+        arduino_event_id_t event;
+    };
+
+    static void _stationJoined(Handler &h) {
+        arduino_event_info_t info{};
+        if (h.event == ARDUINO_EVENT_MAX || h.event == ARDUINO_EVENT_WIFI_AP_STACONNECTED)
+            h.cb(ARDUINO_EVENT_WIFI_AP_STACONNECTED, info);
+        info.wifi_ap_staipassigned.ip.addr = 0x0100007F; // 127.0.0.1
+        if (h.event == ARDUINO_EVENT_MAX || h.event == ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED)
+            h.cb(ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED, info);
+    }
+
+    std::vector<Handler> _handlers;
+    bool _apStarted = false;
+};
+
+inline WiFiClass WiFi;
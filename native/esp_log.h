@@ -0,0 +1,3 @@
+#pragma once
+// Logging macros are provided by the Arduino.h stand-in
+#include <Arduino.h>
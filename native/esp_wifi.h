@@ -0,0 +1,47 @@
+#pragma once
+// Host stand-in for the soft-AP station list: the host itself is the one connected station,
+// so a Stellarium instance on the same machine is found at 127.0.0.1.
+#include <cstdint>
+#include <cstring>
+
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+
+typedef struct { uint32_t addr; } esp_ip4_addr_t;
+
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;
+} wifi_sta_info_t;
+
+#define ESP_WIFI_MAX_CONN_NUM 10
+
+typedef struct {
+    wifi_sta_info_t sta[ESP_WIFI_MAX_CONN_NUM];
+    int num;
+} wifi_sta_list_t;
+
+typedef struct {
+    uint8_t mac[6];
+    esp_ip4_addr_t ip;
+} tcpip_adapter_sta_info_t;
+
+typedef struct {
+    tcpip_adapter_sta_info_t sta[ESP_WIFI_MAX_CONN_NUM];
+    int num;
+} tcpip_adapter_sta_list_t;
+
+inline esp_err_t esp_wifi_ap_get_sta_list(wifi_sta_list_t *sta) {
+    memset(sta, 0, sizeof(*sta));
+    sta->num = 1;
+    return ESP_OK;
+}
+
+inline esp_err_t tcpip_adapter_get_sta_list(const wifi_sta_list_t *wifi_sta_list, tcpip_adapter_sta_list_t *tcpip_sta_list) {
+    memset(tcpip_sta_list, 0, sizeof(*tcpip_sta_list));
+    tcpip_sta_list->num = wifi_sta_list->num;
+    for (int i = 0; i < wifi_sta_list->num; ++i)
+        tcpip_sta_list->sta[i].ip.addr = 0x0100007F; // 127.0.0.1, little-endian like lwIP
+    return ESP_OK;
+}
@@ -0,0 +1,13 @@
+// Entry point for the native build: runs the sketch like the Arduino core does on the ESP32,
+// or with "simulate" as first argument the pass simulator of simulator.cpp.
+#include <Arduino.h>
+
+int main(int argc, char **argv) {
+    if (argc > 1 and strcmp(argv[1], "simulate") == 0) return native::simulate(argc - 1, argv + 1);
+    setup();
+    while (true) {
+        loop();
+        // The ESP32 loop task never sleeps, on the host give the CPU back between iterations
+        if (!native::virtualClock()) delayMicroseconds(500);
+    }
+}
@@ -0,0 +1,217 @@
+#pragma once
+// Host stand-in for the mechanics behind the servo's, included by Arduino.h.
+// ROTOR_PLANT="16:34,17:35" puts a servo driven from pin 16 behind a potentiometer on ADC pin 34
+// and so on, "16:cs5" behind an AS5048A encoder selected by pin 5 (see SPI.h). A third field gives
+// the degrees that 500..2500 us turn the axis (default 180), for the encoder and the backlash.
+// The shaft follows the pulse after a dead time (ROTOR_PLANT_DELAY ms, default 60) with a first
+// order lag (ROTOR_PLANT_TAU ms, default 150). Optional, all 0 by default: the speed is limited to
+// ROTOR_PLANT_SLEW degrees/s and reached with a time constant of ROTOR_PLANT_INERTIA ms, the servo
+// does not move within ROTOR_PLANT_DEADBAND us of its pulse, and a pulse puts the shaft up to
+// ROTOR_PLANT_NONLINEARITY degrees (halfway the range) off the straight line from 500 to 2500 us.
+// Between the shaft and what the sensor reads is ROTOR_PLANT_BACKLASH degrees of play. The potentiometer maps 500..2500 us on 0..4095
+// counts, the encoder reads 0 at 200 degrees into the range (so it wraps on a wide axis), both
+// with ROTOR_PLANT_NOISE counts of noise (default 3). ROTOR_PLANT_STALL="16:20000" jams the servo
+// on pin 16 20 s after the start.
+
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace native {
+
+class ServoPlant {
+public:
+    /// @brief What the servo does, from the ROTOR_PLANT_... variables
+    struct Mechanics {
+        double delay, tau;          // s
+        double slew, inertia;       // degrees/s and s, 0 for none
+        double deadband;            // us
+        double nonlinearity;        // degrees
+        double backlash;            // degrees
+        int noise;                  // counts
+    };
+
+    /// @param csPin -1 for a potentiometer on adcPin, else the encoder
+    ServoPlant(int servoPin, int adcPin, int csPin, double degrees, const Mechanics &m)
+        : _servoPin(servoPin), _adcPin(adcPin), _csPin(csPin), _degrees(degrees), _delay(m.delay), _tau(m.tau),
+          _slew(m.slew * 2000.0 / degrees), _inertia(m.inertia), _deadband(m.deadband),
+          _nonlinearity(m.nonlinearity * 2000.0 / degrees), _backlash(m.backlash * 2000.0 / degrees), _noise(m.noise) {}
+
+    int servoPin() const { return _servoPin; }
+    int adcPin() const { return _csPin < 0 ? _adcPin : -1; }
+    int csPin() const { return _csPin; }
+
+    /// @brief The shaft stops where it is at this time (us)
+    void jam(uint64_t at) { _jamAt = at; }
+
+    /// @brief A new pulse (us) on the servo pin
+    void input(uint64_t now, double pulse) {
+        if (_inputs.empty()) {
+            _position = _load = pulse;
+            _time = now;
+        }
+        advance(now);
+        _inputs.push_back({now, pulse});
+    }
+
+    /// @brief Move the shaft up to now, in steps of 1 ms
+    void advance(uint64_t now) {
+        while (_time < now) {
+            uint64_t step = std::min<uint64_t>(1000, now - _time);
+            _time += step;
+            double u = _pulseAt(_time - std::min<uint64_t>(_time, _delay * 1e6));
+            if (_jamAt and _time >= _jamAt) {
+                _velocity = 0;
+                continue;
+            }
+            // Where the pulse really puts the shaft, the speed the lag asks for then what the motor makes of it
+            double dt = step / 1e6, error = u + _nonlinearity * sin(M_PI * (u - 500.0) / 2000.0) - _position;
+            double v = fabs(error) <= _deadband / 2 ? 0.0 : (_tau > 0 ? 1 - exp(-dt / _tau) : 1.0) * error / dt;
+            if (_slew > 0) v = std::max(-_slew, std::min(_slew, v));
+            _velocity = _inertia > 0 ? _velocity + (1 - exp(-dt / _inertia)) * (v - _velocity) : v;
+            _position += _velocity * dt;
+            // The load only moves once the shaft took up the play
+            double half = _backlash / 2;
+            if (_position - _load > half) _load = _position - half;
+            else if (_load - _position > half) _load = _position + half;
+        }
+    }
+
+    /// @brief Shaft position in us, where the pulse would have put it
+    double position() const { return _position; }
+    /// @brief What the sensor reads (us), after the play
+    double load() const { return _load; }
+
+    /// @brief The potentiometer
+    int adc(uint64_t now) {
+        advance(now);
+        double counts = (_load - 500.0) / 2000.0 * 4095.0 + _noiseCounts();
+        return std::max(0, std::min(4095, (int)lround(counts)));
+    }
+
+    /// @brief A 16 bit SPI frame while selected, answers the command of the frame before like an AS5048A
+    uint16_t spi(uint64_t now, uint16_t command) {
+        uint16_t response = _response;
+        if ((command & 0x3FFF) == 0x3FFF) {
+            advance(now);
+            double degrees = (_load - 500.0) / 2000.0 * _degrees + 200.0;
+            long counts = lround(degrees / 360.0 * 16384.0 + _noiseCounts());
+            _response = ((counts % 16384) + 16384) % 16384;
+            if (__builtin_parity(_response)) _response |= 0x8000;    // Even parity
+        } else {
+            _response = 0;
+        }
+        return response;
+    }
+
+private:
+    int _noiseCounts() {
+        return _noise ? std::uniform_int_distribution<int>(-_noise, _noise)(_random) : 0;
+    }
+
+    double _pulseAt(uint64_t time) {
+        // Drop what is older than the dead time needs, keep the one in effect then
+        while (_inputs.size() > 1 and _inputs[1].first <= time) _inputs.pop_front();
+        return _inputs.empty() ? _position : _inputs.front().second;
+    }
+
+    int _servoPin, _adcPin, _csPin;
+    double _degrees;
+    double _delay, _tau;    // s
+    double _slew;           // us/s
+    double _inertia;        // s
+    double _deadband, _nonlinearity, _backlash;     // us
+    int _noise;
+    double _velocity = 0.0; // us/s
+    std::deque<std::pair<uint64_t, double>> _inputs;
+    double _position = 1500.0, _load = 1500.0;   // us, of the shaft and after the play
+    uint64_t _time = 0, _jamAt = 0;
+    uint16_t _response = 0;
+    std::minstd_rand _random{1};
+};
+
+/// @brief The plants of ROTOR_PLANT
+class Plants {
+public:
+    Plants() {
+        const char *spec = getenv("ROTOR_PLANT");
+        if (!spec) return;
+        ServoPlant::Mechanics m;
+        m.delay = _env("ROTOR_PLANT_DELAY", 60) / 1000.0;
+        m.tau = _env("ROTOR_PLANT_TAU", 150) / 1000.0;
+        m.slew = _env("ROTOR_PLANT_SLEW", 0);
+        m.inertia = _env("ROTOR_PLANT_INERTIA", 0) / 1000.0;
+        m.deadband = _env("ROTOR_PLANT_DEADBAND", 0);
+        m.nonlinearity = _env("ROTOR_PLANT_NONLINEARITY", 0);
+        m.backlash = _env("ROTOR_PLANT_BACKLASH", 0);
+        m.noise = _env("ROTOR_PLANT_NOISE", 3);
+        int servoPin, pin, used;
+        while (sscanf(spec, "%d:%n", &servoPin, &used) == 1) {
+            spec += used;
+            bool encoder = strncmp(spec, "cs", 2) == 0;
+            if (encoder) spec += 2;
+            if (sscanf(spec, "%d%n", &pin, &used) != 1) break;
+            spec += used;
+            double degrees = 180;
+            if (sscanf(spec, ":%lf%n", &degrees, &used) == 1) spec += used;
+            _plants.emplace_back(servoPin, pin, encoder ? pin : -1, degrees, m);
+            printf("Plant: servo on pin %d, %s on pin %d, %0.0f degrees, delay %0.0f ms, tau %0.0f ms, "
+                   "backlash %0.1f degrees\n", servoPin, encoder ? "encoder" : "feedback", pin, degrees,
+                   m.delay * 1e3, m.tau * 1e3, m.backlash);
+            if (*spec != ',') break;
+            ++spec;
+        }
+        const char *stall = getenv("ROTOR_PLANT_STALL");
+        double after;
+        if (stall and sscanf(stall, "%d:%lf", &servoPin, &after) == 2)
+            for (ServoPlant &plant : _plants)
+                if (plant.servoPin() == servoPin) plant.jam(after * 1000);
+    }
+
+    void write(int servoPin, double pulse) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (ServoPlant &plant : _plants)
+            if (plant.servoPin() == servoPin) plant.input(nowMicros(), pulse);
+    }
+
+    int read(int adcPin) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (ServoPlant &plant : _plants)
+            if (plant.adcPin() == adcPin) return plant.adc(nowMicros());
+        return 0;
+    }
+
+    /// @brief Where the servo on a pin really is (us after the play), NAN when there is none
+    double position(int servoPin) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (ServoPlant &plant : _plants)
+            if (plant.servoPin() == servoPin) {
+                plant.advance(nowMicros());
+                return plant.load();
+            }
+        return NAN;
+    }
+
+    /// @brief A frame on the SPI bus, to the encoder with its chip select low
+    uint16_t spi(uint16_t command) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (ServoPlant &plant : _plants)
+            if (plant.csPin() >= 0 and plant.csPin() < 40 and gpio()[plant.csPin()] == LOW)
+                return plant.spi(nowMicros(), command);
+        return 0xFFFF;      // Nothing drives MISO
+    }
+
+private:
+    static double _env(const char *name, double fallback) {
+        const char *value = getenv(name);
+        return value ? atof(value) : fallback;
+    }
+
+    std::vector<ServoPlant> _plants;
+    std::mutex _mutex;
+};
+
+inline Plants &plants() { static Plants p; return p; }
+
+} // namespace native
@@ -0,0 +1,389 @@
+// Pass simulator of the native build: `program simulate [options]`.
+// Runs the sketch (setup(), loop() and the motion steps) under the virtual clock against the plants
+// of plant.h, feeds it a satellite pass over rotctld like SatDump does, and measures how far the
+// antenna really points off the satellite. Every pass runs in a process of its own with its own
+// copy of config.ini and NVS and its own ports, as many at once as there are cores.
+//
+//   --passes N          passes per setting (10), random maximum elevations (10-90) and headings
+//   --seed N            of the passes (1), the same seed gives the same passes
+//   --jobs N            processes at once (the number of cores)
+//   --set KEY=VALUE     section.KEY of config.ini (servo.SERVO_AZ_MAX_SPEED=30, tracking.ESTIMATOR=0)
+//                       or an environment variable (ROTOR_PLANT_SLEW=40)
+//   --sweep KEY=A,B,..  every pass with each value, more sweeps run every combination
+//   --config PATH       config.ini to start from ($ROTOR_FS_ROOT/config.ini, else data/config.ini)
+//   --orbit KM          height of the orbit (500)
+//   --sample MS         between two rotctld positions (1000)
+//   --acquire DEGREES   a pass counts from when the antenna first gets this close (1)
+//   --keep              keep the run directories (config.ini, nvs.bin, log.txt)
+//
+// ROTOR_PLANT defaults to "16:34,17:35", the servo pins of data/config.ini. rotctld is given the
+// highest priority and Stellarium is switched off, so nothing but the pass is followed.
+#include <Arduino.h>
+#include <WiFi.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <sys/wait.h>
+#include <vector>
+
+namespace native {
+namespace {
+
+const double EARTH_RADIUS = 6371.0;     // km
+const double EARTH_GM = 398600.4418;    // km3/s2
+const uint16_t ROTCTLD = 4533;
+const double RADIANS = M_PI / 180.0;
+
+struct Pass {
+    double maxElevation, heading;       // degrees
+};
+
+/// @brief A circular orbit straight across the sky of the observer, the Earth does not turn
+class PassGeometry {
+public:
+    PassGeometry(const Pass &pass, double orbit) : _heading(pass.heading) {
+        double e = pass.maxElevation * RADIANS;
+        _r = EARTH_RADIUS + orbit;
+        _beta = acos(EARTH_RADIUS * cos(e) / _r) - e;   // From the observer to the closest point, at the centre
+        _rate = sqrt(EARTH_GM / (_r * _r * _r));
+        _half = acos(std::min(1.0, EARTH_RADIUS / (_r * cos(_beta))));
+    }
+
+    /// @brief s from horizon to horizon
+    double duration() const { return 2 * _half / _rate; }
+
+    /// @brief Where the satellite is t s after it rose, degrees
+    void at(double t, double &alt, double &az) const {
+        double phi = -_half + _rate * t;
+        // East, north and up of the observer
+        double x = _r * sin(phi), y = -_r * cos(phi) * sin(_beta), z = _r * cos(phi) * cos(_beta) - EARTH_RADIUS;
+        alt = atan2(z, hypot(x, y)) / RADIANS;
+        az = fmod(atan2(x, y) / RADIANS + _heading + 720.0, 360.0);
+    }
+
+private:
+    double _heading, _r, _beta, _rate, _half;
+};
+
+/// @brief Angle between two directions on the sky, degrees
+double separation(double alt1, double az1, double alt2, double az2) {
+    double c = sin(alt1 * RADIANS) * sin(alt2 * RADIANS) +
+               cos(alt1 * RADIANS) * cos(alt2 * RADIANS) * cos((az1 - az2) * RADIANS);
+    return acos(std::max(-1.0, std::min(1.0, c))) / RADIANS;
+}
+
+struct Setting {
+    std::string key, value;
+};
+
+struct Options {
+    int passes = 10, seed = 1, jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Setting> sets;
+    std::vector<std::pair<std::string, std::vector<std::string>>> sweeps;
+    std::string config;
+    double orbit = 500, acquire = 1.0;
+    int sample = 1000;
+    bool keep = false;
+};
+
+struct Run {
+    std::vector<Setting> settings;
+    std::string label;                  // The swept values
+    size_t combination;
+    int number;                         // Of the pass
+    Pass pass;
+};
+
+/// @brief What a pass process sends back, through a pipe
+struct Result {
+    bool ok = false;
+    char error[96] = "";
+    double duration = 0;                // s from horizon to horizon
+    double acquire = -1;                // s after rising, -1 never
+    double lost = 0;                    // s not tracking after that
+    double sumSquares = 0, p95 = 0, max = 0;
+    uint32_t samples = 0;
+    double hostMs = 0;
+};
+
+Result fail(Result &result, const char *error) {
+    strlcpy(result.error, error, sizeof(result.error));
+    return result;
+}
+
+bool copyFile(const std::string &from, const std::string &to) {
+    std::error_code error;
+    return std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, error);
+}
+
+/// @brief One pass, in its own process
+Result runPass(const Run &run, const Options &options, int slot, const std::string &dir) {
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+
+    // config.ini with the settings after it, a later key wins
+    std::ifstream base(options.config);
+    if (!base) return fail(result, "No config.ini to start from");
+    std::stringstream config;
+    config << base.rdbuf() << "\n[sources]\nROTCTLD = 9\nSTELLARIUM = 0\n";
+    for (const Setting &setting : run.settings) {
+        size_t dot = setting.key.find('.');
+        if (setting.key.rfind("ROTOR_", 0) == 0 or dot == std::string::npos)
+            setenv(setting.key.c_str(), setting.value.c_str(), 1);
+        else
+            config << "[" << setting.key.substr(0, dot) << "]\n" << setting.key.substr(dot + 1) << " = " << setting.value << "\n";
+    }
+    std::ofstream(dir + "/config.ini") << config.str();
+
+    // Each pass starts from the same NVS (lag models, positions) and has its own ports
+    for (const char *name : {"ROTOR_NVS", "ROTOR_EEPROM"}) {
+        const char *path = getenv(name);
+        std::string copy = dir + (strcmp(name, "ROTOR_NVS") == 0 ? "/nvs.bin" : "/eeprom.bin");
+        if (path) copyFile(path, copy);
+        setenv(name, copy.c_str(), 1);
+    }
+    setenv("ROTOR_FS_ROOT", dir.c_str(), 1);
+    setenv("ROTOR_PORT_OFFSET", std::to_string(100 * (slot + 1)).c_str(), 1);
+    setenv("ROTOR_PLANT", "16:34,17:35", 0);
+    if (!freopen((dir + "/log.txt").c_str(), "w", stdout)) return fail(result, "Can't write the log");
+
+    useVirtualClock(0);
+    setup();
+    Simulation &sim = simulation();
+    if (!sim.motionStep or !sim.pointing) return fail(result, "setup() did not start the motion");
+
+    // rotctld listens once the access point is up, in host time
+    WiFiClient rotctld;
+    for (int i = 0; i < 2500 and !rotctld.connect("127.0.0.1", hostPort(ROTCTLD)); ++i) {
+        loop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    if (!rotctld.connected()) return fail(result, "No rotctld");
+
+    PassGeometry geometry(run.pass, options.orbit);
+    result.duration = geometry.duration();
+    uint64_t rise = nowMicros() + 1000000, set = rise + (uint64_t)(result.duration * 1e6), next = rise;
+    std::vector<float> errors;
+    errors.reserve(result.duration * 1e6 / sim.motionPeriod + 1);
+    while (nowMicros() < set) {
+        advance(sim.motionPeriod);
+        uint64_t now = nowMicros();
+        double t = now >= rise ? (now - rise) / 1e6 : 0.0, alt, az;
+        if (now >= next) {
+            geometry.at(t, alt, az);
+            char command[48];
+            snprintf(command, sizeof(command), "P %0.3f %0.3f\n", az, alt);
+            rotctld.write((const uint8_t *)command, strlen(command));
+            next += options.sample * 1000ULL;
+        }
+        loop();
+        sim.motionStep();
+        uint8_t reply[64];
+        while (rotctld.available() > 0 and rotctld.read(reply, sizeof(reply)) > 0) {}
+        if (now < rise) continue;
+
+        float antennaAlt, antennaAz;
+        if (!sim.pointing(antennaAlt, antennaAz)) {
+            if (result.acquire >= 0) result.lost += sim.motionPeriod / 1e6;
+            continue;
+        }
+        geometry.at(t, alt, az);
+        double error = separation(antennaAlt, antennaAz, alt, az);
+        if (result.acquire < 0) {
+            if (error >= options.acquire) continue;
+            result.acquire = t;
+        }
+        errors.push_back(error);
+        result.sumSquares += error * error;
+        result.max = std::max(result.max, error);
+    }
+
+    result.samples = errors.size();
+    if (!errors.empty()) {
+        std::sort(errors.begin(), errors.end());
+        result.p95 = errors[std::min(errors.size() - 1, errors.size() * 95 / 100)];
+    }
+    result.hostMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.ok = true;
+    return result;
+}
+
+bool parse(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto setting = [&](Setting &s) {
+            const char *equals = value ? strchr(value, '=') : nullptr;
+            if (!equals) return false;
+            s.key.assign(value, equals - value);
+            s.value = equals + 1;
+            return true;
+        };
+        Setting s;
+        if (!value and arg != "--keep") {
+            fprintf(stderr, "%s needs a value\n", arg.c_str());
+            return false;
+        }
+        if (arg == "--passes") options.passes = atoi(value);
+        else if (arg == "--seed") options.seed = atoi(value);
+        else if (arg == "--jobs") options.jobs = std::max(1, atoi(value));
+        else if (arg == "--config") options.config = value;
+        else if (arg == "--orbit") options.orbit = atof(value);
+        else if (arg == "--sample") options.sample = std::max(1, atoi(value));
+        else if (arg == "--acquire") options.acquire = atof(value);
+        else if (arg == "--keep") { options.keep = true; continue; }
+        else if (arg == "--set" and setting(s)) options.sets.push_back(s);
+        else if (arg == "--sweep" and setting(s)) {
+            std::vector<std::string> values;
+            std::stringstream list(s.value);
+            for (std::string v; std::getline(list, v, ',');) values.push_back(v);
+            options.sweeps.push_back({s.key, values});
+        } else {
+            fprintf(stderr, "Unknown option %s %s, see native/simulator.cpp\n", arg.c_str(), value);
+            return false;
+        }
+        ++i;
+    }
+    if (options.config.empty()) {
+        const char *root = getenv("ROTOR_FS_ROOT");
+        options.config = std::string(root ? root : "data") + "/config.ini";
+    }
+    return options.passes > 0;
+}
+
+/// @brief Every combination of the swept values, times every pass
+std::vector<Run> runs(const Options &options, std::vector<std::string> &labels) {
+    std::vector<Pass> passes;
+    std::mt19937 random(options.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int i = 0; i < options.passes; ++i) {
+        double elevation = 10 + 80 * unit(random);
+        passes.push_back({elevation, 360 * unit(random)});
+    }
+
+    size_t combinations = 1;
+    for (auto &sweep : options.sweeps) combinations *= sweep.second.size();
+    std::vector<Run> list;
+    for (size_t c = 0; c < combinations; ++c) {
+        std::vector<Setting> settings = options.sets;
+        std::string label;
+        for (size_t s = 0, rest = c; s < options.sweeps.size(); ++s) {
+            auto &sweep = options.sweeps[s];
+            const std::string &value = sweep.second[rest % sweep.second.size()];
+            rest /= sweep.second.size();
+            settings.push_back({sweep.first, value});
+            label += (label.empty() ? "" : " ") + sweep.first + "=" + value;
+        }
+        labels.push_back(label.empty() ? "as configured" : label);
+        for (int p = 0; p < options.passes; ++p) list.push_back({settings, labels.back(), c, p + 1, passes[p]});
+    }
+    return list;
+}
+
+} // namespace
+
+int simulate(int argc, char **argv) {
+    Options options;
+    if (!parse(argc, argv, options)) return 1;
+    std::vector<std::string> labels;
+    std::vector<Run> list = runs(options, labels);
+    std::vector<Result> results(list.size());
+    const char *tmp = getenv("TMPDIR");
+    printf("%zu passes, %d at once\n", list.size(), options.jobs);
+
+    // A process per pass, the sketch has one of everything
+    struct Child {
+        pid_t pid;
+        int fd, slot;
+        size_t run;
+    };
+    std::vector<Child> children;
+    std::vector<bool> busy(options.jobs);
+    size_t next = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (next < list.size() or !children.empty()) {
+        while ((int)children.size() < options.jobs and next < list.size()) {
+            int slot = std::find(busy.begin(), busy.end(), false) - busy.begin(), fds[2];
+            std::string dir = std::string(tmp ? tmp : "/tmp") + "/rotor-sim-XXXXXX";
+            if (pipe(fds) != 0 or !mkdtemp(&dir[0])) {
+                perror("simulate");
+                return 1;
+            }
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                Result result = runPass(list[next], options, slot, dir);
+                fflush(stdout);
+                if (write(fds[1], &result, sizeof(result)) != sizeof(result)) _exit(1);
+                if (!options.keep) std::filesystem::remove_all(dir);
+                _exit(0);   // The tasks of the sketch are still running
+            }
+            close(fds[1]);
+            busy[slot] = true;
+            children.push_back({pid, fds[0], slot, next++});
+        }
+        int status;
+        pid_t pid = wait(&status);
+        for (size_t i = 0; i < children.size(); ++i) {
+            if (children[i].pid != pid) continue;
+            Result &result = results[children[i].run];
+            if (read(children[i].fd, &result, sizeof(result)) != sizeof(result)) fail(result, "The pass process died");
+            close(children[i].fd);
+            busy[children[i].slot] = false;
+            children.erase(children.begin() + i);
+            break;
+        }
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Every pass, then per combination of the swept values (errors in degrees)
+    printf("%-4s %6s %7s %6s %7s %7s %7s %7s %7s %8s  %s\n", "pass", "max_el", "heading", "length", "acquire", "rms",
+           "p95", "max", "lost", "host_ms", "setting");
+    for (size_t i = 0; i < list.size(); ++i) {
+        const Run &run = list[i];
+        const Result &r = results[i];
+        if (!r.ok) {
+            printf("%-4d %6.1f %7.1f  failed: %s  %s\n", run.number, run.pass.maxElevation, run.pass.heading, r.error,
+                   run.label.c_str());
+            continue;
+        }
+        printf("%-4d %6.1f %7.1f %6.0f %7.1f %7.3f %7.3f %7.3f %7.1f %8.0f  %s\n", run.number, run.pass.maxElevation,
+               run.pass.heading, r.duration, r.acquire, r.samples ? sqrt(r.sumSquares / r.samples) : NAN, r.p95, r.max,
+               r.lost, r.hostMs, run.label.c_str());
+    }
+    printf("\n%-7s %7s %7s %7s %7s %7s  %s\n", "passes", "acquire", "rms", "p95", "max", "lost", "setting");
+    for (size_t c = 0; c < labels.size(); ++c) {
+        int passes = 0, failed = 0, acquired = 0;
+        double acquire = 0, squares = 0, p95 = 0, max = 0, lost = 0;
+        uint64_t samples = 0;
+        for (size_t i = 0; i < list.size(); ++i) {
+            const Result &r = results[i];
+            if (list[i].combination != c) continue;
+            if (!r.ok) {
+                ++failed;
+                continue;
+            }
+            ++passes;
+            if (r.acquire >= 0) {
+                ++acquired;
+                acquire += r.acquire;
+            }
+            squares += r.sumSquares;
+            samples += r.samples;
+            p95 += r.p95;
+            max = std::max(max, r.max);
+            lost += r.lost;
+        }
+        printf("%-7d %7.1f %7.3f %7.3f %7.3f %7.1f  %s", passes, acquired ? acquire / acquired : NAN,
+               samples ? sqrt(squares / samples) : NAN, passes ? p95 / passes : NAN, max, lost, labels[c].c_str());
+        if (acquired < passes) printf(", %d never acquired", passes - acquired);
+        if (failed) printf(", %d failed", failed);
+        printf("\n");
+    }
+    printf("\n%zu passes in %0.1f s\n", list.size(), wall);
+    return 0;
+}
+
+} // namespace native
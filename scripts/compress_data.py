@@ -0,0 +1,55 @@
+# Builds the file system image contents from data/: the web assets are stored gzipped with a
+# content hash in assets.txt (the ETag), everything else (config.ini, *.tle) is copied as is.
+# As a PlatformIO pre script it points buildfs/uploadfs at the result, it also runs on its own:
+#   python scripts/compress_data.py [data dir] [output dir]
+import gzip
+import hashlib
+import os
+import shutil
+import sys
+
+# Served by the web server, these only exist gzipped in the image
+WEB_ASSETS = (".html", ".htm", ".css", ".js", ".json", ".svg", ".ico", ".png", ".jpg", ".webmanifest")
+MANIFEST = "assets.txt"
+
+
+def compress_data(source, target):
+    if os.path.isdir(target):
+        shutil.rmtree(target)
+    os.makedirs(target)
+
+    manifest = []
+    for root, _, files in os.walk(source):
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            uri = "/" + os.path.relpath(path, source).replace(os.sep, "/")
+            out = os.path.join(target, os.path.relpath(path, source))
+            os.makedirs(os.path.dirname(out), exist_ok=True)
+            if not name.lower().endswith(WEB_ASSETS):
+                shutil.copyfile(path, out)
+                continue
+            with open(path, "rb") as f:
+                content = f.read()
+            # mtime 0 keeps the image the same when nothing changed
+            with open(out + ".gz", "wb") as f:
+                f.write(gzip.compress(content, compresslevel=9, mtime=0))
+            etag = hashlib.sha256(content).hexdigest()[:16]
+            manifest.append("%s %s" % (uri, etag))
+            print("%-30s %6d -> %6d bytes, ETag %s" % (uri, len(content), os.path.getsize(out + ".gz"), etag))
+
+    with open(os.path.join(target, MANIFEST), "w") as f:
+        f.write("\n".join(manifest) + "\n")
+
+
+try:
+    Import("env")
+except NameError:
+    env = None
+
+if env is not None:
+    source = env.subst("$PROJECT_DATA_DIR")
+    target = os.path.join(env.subst("$PROJECT_BUILD_DIR"), "data")
+    compress_data(source, target)
+    env.Replace(PROJECT_DATA_DIR=target)
+elif __name__ == "__main__":
+    compress_data(sys.argv[1] if len(sys.argv) > 1 else "data", sys.argv[2] if len(sys.argv) > 2 else "build/data")
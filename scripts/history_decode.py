@@ -0,0 +1,70 @@
+# Turns the binary history download of the rotor into CSV
+#   curl -o history.bin "http://192.168.4.1/history?format=bin"
+#   python scripts/history_decode.py history.bin > history.csv
+# Times are in seconds before the download, the layout is described in include/history.h
+import struct
+import sys
+
+HEADER = struct.Struct("<4sHHB3xI")     # magic, block size, period, fields, now
+BLOCK = struct.Struct("<II6iHH")        # sequence, time, key record, count, used
+NIBBLES = 0x80                          # Record flag, the changes are two to a byte
+
+
+def varint(data, at):
+    value = shift = 0
+    while True:
+        byte = data[at]
+        at += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, at
+
+
+def decode(data):
+    magic, _, period, fields, now = HEADER.unpack_from(data, 0)
+    if magic != b"RTH1" or fields != 6:
+        raise ValueError("not a rotor history")
+    at = HEADER.size
+    while at + BLOCK.size <= len(data):
+        sequence, time, *rest = BLOCK.unpack_from(data, at)
+        values, count, used = list(rest[:fields]), rest[fields], rest[fields + 1]
+        at += BLOCK.size
+        block, at = data[at:at + used], at + used
+        yield time, now, values
+        pos = 0
+        for _ in range(count - 1):
+            if pos >= len(block):
+                break
+            flags = block[pos]
+            pos += 1
+            if flags & (1 << fields):
+                step, pos = varint(block, pos)
+            else:
+                step = period
+            time = (time + step) & 0xFFFFFFFF
+            nibble = 0
+            for i in range(fields):
+                if flags & (1 << i):
+                    if flags & NIBBLES:
+                        zigzag = block[pos] >> 4 if nibble & 1 else block[pos] & 0x0F
+                        pos += nibble & 1
+                        nibble += 1
+                    else:
+                        zigzag, pos = varint(block, pos)
+                    values[i] += (zigzag >> 1) ^ -(zigzag & 1)
+            pos += nibble & 1
+            yield time, now, values
+
+
+def main():
+    with open(sys.argv[1], "rb") if len(sys.argv) > 1 else sys.stdin.buffer as f:
+        data = f.read()
+    print("time,seconds_ago,alt,az,alt_command,alt_current,az_command,az_current")
+    for time, now, v in decode(data):
+        ago = ((now - time) & 0xFFFFFFFF) / 1000.0
+        print("%d,%.3f,%.2f,%.2f,%d,%d,%d,%d" % (time, ago, v[0] / 100, v[1] / 100, v[2], v[3], v[4], v[5]))
+
+
+if __name__ == "__main__":
+    main()
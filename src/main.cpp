@@ -1,15 +1,26 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <SPIFFS.h>
-#include <tuple>
 
 #include <ledaction.h>
-#include <iniparser.h>
+#include <configschema.h>
 #include <myserver.h>
 #include <objectData.h>
 #include <stellarium.h>
 #include <rotorservo.h>
+#include <scheduler.h>
 #include <satdump.h>
+#include <estimator.h>
+#include <satellite.h>
+#include <sidereal.h>
+#include <pointing.h>
+#include <motiontask.h>
+#include <telemetry.h>
+#include <history.h>
+#include <boot.h>
+#include <arbiter.h>
+#include <servolag.h>
+#include <closedloop.h>
 
 #define VERSION "0.5.0 (22-AUG 2025)"
 
@@ -19,15 +30,81 @@ extern "C" {
   #include "esp_netif.h"
 }
 
-String ssid;
-String password;
+RotorConfig config;   // As running, POST /config changes the keys that can be applied live
 
 ObjectData data;
+PagePublisher pageData;   // What the web page shows, published by every motion step
 RotorServo servoAZ, servoALT;
+MotionScheduler axes;   // AZ, ALT and the axes of the other [axis NAME] sections
+RotctldServer rotctld;
+StellariumClient stellarium;
 
-const char *iniPath = "/config.ini";
-#define DEFAULT_SSID "ESP32-Hotspot"
-#define DEFAULT_PASSWORD "12345678"
+// Target estimation between the (1 Hz) samples
+AxisEstimator estimatorALT, estimatorAZ;   // config.predictionHorizon: the setpoint runs this far ahead
+
+// Targets computed on the ESP32 itself
+SatelliteTracker satellites;
+SiderealTracker sidereal;
+bool siderealLocked = false;    // RA/Dec tracking asked for, sidereal.active() follows at the next motion step
+
+// Every producer of targets publishes into its own source, the motion step follows the best live one
+TargetArbiter targets;
+
+bool onBoard() { return targets.following(TS_ONBOARD); }
+
+// Maps the target on the servo angles, pose and azimuth turn are planned per pass
+PointingPlanner pointing;
+PassPlanner passPlanner;    // In loop(), hands its plans to pointing
+bool slewing = false;   // Axes are time scaled to arrive together
+
+// How far the servo's run behind their pulse, per axis of config.axis, identified with their FEEDBACK input
+AxisLag lags[MAX_AXES];
+AxisLag &lagALT = lags[0], &lagAZ = lags[1];
+LagIdentifier identifier;
+// The closed loops on the feedback, and the servo of each axis of config.axis (nullptr when it has none)
+AxisLoop loops[MAX_AXES];
+RotorServo *axisServos[MAX_AXES] = {&servoALT, &servoAZ};
+float intendedAlt = 0.0, intendedAz = 0.0;  // Servo angles without the lead, to compare the feedback with
+float onboardRateAlt = 0.0, onboardRateAz = 0.0;  // degrees/s, for the lead of an on-board target
+
+// Motion control runs in its own task, the lock guards what it shares with loop() and the web server
+MotionTask motion;
+SemaphoreHandle_t controlLock;
+#define SLEW_SYNC_START 1.0   // s, shorter moves (tracking) run both axes at their own limits
+#define SLEW_SYNC_END   0.5   // s, back to the own limits when this close to the end of a slew
+
+// For /metrics, the other metrics are defined with what they measure
+Histogram loopPass("rotor_loop_pass_seconds", "Time between the starts of two passes of loop()");
+Histogram motionJitter("rotor_motion_jitter_seconds", "How far a motion step was off its period", &motion.stats().jitter);
+Histogram motionStepTime("rotor_motion_step_seconds", "Time a motion step took", &motion.stats().execution);
+Probe motionOverruns("rotor_motion_overruns_total", "Motion steps that took longer than the period", MT_COUNTER,
+                     [] { return (double)motion.stats().overruns; });
+// Work the tasks measured of themselves, loop() is left out as it never waits
+Probe busyMotion("rotor_task_busy_seconds_total", "Time spent working per task", MT_COUNTER,
+                 [] { return motion.stats().execution.seconds(); }, "task=\"motion\",core=\"1\"");
+Probe busyWeb("rotor_task_busy_seconds_total", "", MT_COUNTER,
+              [] { return httpRequest.histogram().seconds(); }, "task=\"web\",core=\"0\"");
+Probe busyStellarium("rotor_task_busy_seconds_total", "", MT_COUNTER,
+                     [] { return stellariumRequest.histogram().seconds(); }, "task=\"stellarium\",core=\"0\"");
+Probe busyTelemetry("rotor_task_busy_seconds_total", "", MT_COUNTER,
+                    [] { return telemetrySend.histogram().seconds(); }, "task=\"telemetry\",core=\"0\"");
+Probe stellariumInterval("rotor_stellarium_info_interval_seconds", "Time between two Stellarium object infos", MT_GAUGE,
+                        [] { return stellarium.interval() / 1e3; });
+Probe trackingErrorALT("rotor_tracking_error_degrees", "RMS of the measured - intended servo angle while tracking",
+                       MT_GAUGE, [] { return (double)lagALT.trackingError(); }, "axis=\"ALT\"");
+Probe trackingErrorAZ("rotor_tracking_error_degrees", "", MT_GAUGE, [] { return (double)lagAZ.trackingError(); },
+                      "axis=\"AZ\"");
+Probe stallsALT("rotor_servo_stalls_total", "Times the feedback stayed STALL_ERROR off the servo for STALL_TIME",
+                MT_COUNTER, [] { return (double)loops[0].stalls(); }, "axis=\"ALT\"");
+Probe stallsAZ("rotor_servo_stalls_total", "", MT_COUNTER, [] { return (double)loops[1].stalls(); }, "axis=\"AZ\"");
+Probe rotctldClients("rotor_rotctld_clients", "Connected rotctld clients", MT_GAUGE, [] { return (double)rotctld.clients(); });
+
+// Every motion step is recorded, to see afterwards how a pass went
+PointingHistory history;
+Probe historySpan("rotor_history_seconds", "Time covered by the history", MT_GAUGE, [] { return history.span() / 1e3; });
+
+// Page data streamed to the browsers, 0 leaves them polling /data
+TelemetryStream telemetry;
 
 String errorString = "";
 unsigned long errorTime = 0;
@@ -45,68 +122,139 @@ void clearError() {
 if (millis()-errorTime>5000) errorString = "";
 }
 
+/// @brief Limits and smoothing of an axis, these can change while running
+void setAxisLimits(const AxisConfig &axis, RotorServo &servo) {
+  servo.setLimits(axis.speed, axis.accel, axis.jerk);
+  servo.smooth(axis.smooth);
+}
+
+/// @brief Pulse at OFFSET degrees, ALT and AZ are calibrated from the web page unless CALIBRATION is given
+void setAxisCalibration(const AxisConfig &axis, RotorServo &servo) {
+  bool tracked = &servo == &servoALT or &servo == &servoAZ;
+  if (tracked and !axis.has("CALIBRATION")) return;
+  int16_t pulse = axis.has("CALIBRATION") ? axis.calibration : (axis.min + axis.max) / 2;
+  if (!servo.setCalibration(pulse)) addError(String(axis.name) + ": " + servo.getError());
+}
+
+/// @brief Closed loop of an axis, this can change while running
+void setAxisLoop(const AxisConfig &axis, AxisLoop &loop) {
+  loop.configure(axis.kp, axis.ki, axis.kd, axis.loopLimit, axis.stallError, axis.stallTime);
+}
+
+/// @brief Feedback input of an axis, the SPI bus is started with the first encoder
+void beginFeedback(const RotorConfig &config, uint8_t i) {
+  static bool bus = false;
+  const AxisConfig &axis = config.axis[i];
+  FeedbackInput feedback;
+  if (axis.encoderCs >= 0) {
+    if (!bus) FeedbackInput::beginBus(config.encoderSck, config.encoderMiso, config.encoderMosi);
+    bus = true;
+    feedback.beginEncoder(axis.encoderCs);
+    log_i("Axis %s: encoder on CS pin %d", axis.name, axis.encoderCs);
+  } else if (axis.feedback >= 0) {
+    feedback.beginAdc(axis.feedback);
+  }
+  lags[i].begin(axis.name, feedback);
+  setAxisLoop(axis, loops[i]);
+}
+
+/// @brief Init an axis from its config
+void initAxis(const AxisConfig &axis, RotorServo &servo, uint8_t slot) {
+  log_i("Axis %s on pin %d, journal slot %d", axis.name, axis.pin, slot);
+  if (!servo.init(axis.pin, slot, axis.min, axis.max, axis.degrees, axis.direction, axis.offset))
+    addError(String(axis.name) + ": " + servo.getError());
+  setAxisLimits(axis, servo);
+  setAxisCalibration(axis, servo);
+}
+
+/// @brief Estimator and location, at boot and from POST /config
+/// @param previous the config before, nullptr at boot, the estimators only restart when their settings changed
+void applyTracking(const RotorConfig &config, const RotorConfig *previous) {
+  if (!previous or config.measurementNoise != previous->measurementNoise or config.processNoise != previous->processNoise) {
+    estimatorALT.configure(config.measurementNoise, config.processNoise, false);
+    estimatorAZ.configure(config.measurementNoise, config.processNoise, true);
+  }
+  log_i("Estimator: %d, horizon %ld ms", config.estimator, (long)config.predictionHorizon);
+
+  // Observer location for the on-board satellite tracking
+  Observer observer;
+  observer.latitude  = config.latitude;
+  observer.longitude = config.longitude;
+  observer.altitude  = config.altitude;
+  satellites.setObserver(observer);
+  sidereal.setObserver(observer);
+  sidereal.setRefraction(config.refraction);
+  log_i("Location: %0.4f, %0.4f, %0.0f m", observer.latitude, observer.longitude, observer.altitude);
+}
+
+/// @brief Priorities and timeouts of the target sources, at boot and from POST /config
+void applySources(const RotorConfig &config) {
+  targets.source(TS_ONBOARD).configure(config.onboardPriority, 0);   // Released when it stops
+  targets.source(TS_ROTCTLD).configure(config.rotctldPriority, config.rotctldTimeout);
+  targets.source(TS_WEB).configure(config.webPriority, config.webTimeout);
+  targets.source(TS_STELLARIUM).configure(config.stellariumPriority, config.stellariumTimeout);
+  log_i("Sources: onboard %d, rotctld %d, web %d, stellarium %d", config.onboardPriority, config.rotctldPriority,
+        config.webPriority, config.stellariumPriority);
+}
+
 /// @brief Read config parameters from ini file and init servo's
+/// A bad line is reported and skipped, the rest of the file is used
 void readInitConfig() {
-    INIConfig config;
+    ConfigParser parser;
+    ConfigParser::defaults(config);
 
-    if (!config.load(iniPath)) {
-      log_e("Could not open %s\n",iniPath);
+    if (!SPIFFS.exists(CONFIG_PATH)) {
+      log_e("Could not open %s", CONFIG_PATH);
       return;
     }
+    if (!parser.load(SPIFFS, CONFIG_PATH, config)) {
+      log_e("%s:\n%s", CONFIG_PATH, parser.getError().c_str());
+      addError(parser.getError());
+    }
 
-    log_i("Open ini file %s\n",iniPath);
-
-    // Read AP settings
-    ssid = config.get("network", "WIFI_SSID", DEFAULT_SSID);
-    password = config.get("network", "WIFI_PASSWORD", DEFAULT_PASSWORD);
-    log_i("SSID: %s", ssid);
-    log_i("Password: %s", password);
-
-    data.stellariumMode = config.get("mode","STELLARIUM_MODE","0").toInt();
+    log_i("Read ini file %s", CONFIG_PATH);
+    log_i("SSID: %s", config.ssid);
+    log_i("Password: %s", config.password);
 
-    // Read the servo stuff and init those as well
-    auto eepromAddress = 0;
-    auto pin      = config.get("pin","PIN_SERVO_ALT","0").toInt();
-    auto degrees  = config.get("servo","SERVO_ALT_DEGREES","0").toInt();
-    auto min      = config.get("servo","SERVO_ALT_MIN","500").toInt();
-    auto max      = config.get("servo","SERVO_ALT_MAX","2500").toInt();
-    auto direction= config.get("servo","SERVO_ALT_DIRECTION","1").toInt();
-    auto offset   = config.get("servo","SERVO_ALT_OFFSET","0.0").toFloat();
-    bool smooth   = config.get("servo","SERVO_ALT_SMOOTH","1").toInt();
-
-    servoALT.init(pin,eepromAddress,min,max,degrees,direction,offset);
-    addError(servoALT.getError());
-    servoALT.smooth(smooth);
-
-    eepromAddress = 4;
-    pin      = config.get("pin","PIN_SERVO_AZ","0").toInt();
-    degrees  = config.get("servo","SERVO_AZ_DEGREES","0").toInt();
-    min      = config.get("servo","SERVO_AZ_MIN","500").toInt();
-    max      = config.get("servo","SERVO_AZ_MAX","2500").toInt();
-    direction= config.get("servo","SERVO_AZ_DIRECTION","1").toInt();
-    offset   = config.get("servo","SERVO_AZ_OFFSET","0.0").toFloat();
-    smooth   = config.get("servo","SERVO_AZ_SMOOTH","1").toInt();
-
-    servoAZ.init(pin,eepromAddress,min,max,degrees,direction,offset);
-    addError(servoAZ.getError());
-    servoAZ.smooth(smooth);
+    applySources(config);
+    applyTracking(config, nullptr);
 
+    // Init the servo's, ALT and AZ first then any other [axis NAME]
+    initAxis(config.axis[0], servoALT, 0);
+    initAxis(config.axis[1], servoAZ, 1);
+    uint8_t slot = 2;
+    for (uint8_t i = 2; i < config.axes; ++i) {
+      const AxisConfig &axis = config.axis[i];
+      RotorServo *servo = axisServos[i] = axes.create(axis.name);
+      if (!servo) {
+        addError(String("No room for axis ") + axis.name);
+        continue;
+      }
+      uint8_t s = axis.slot >= 0 ? axis.slot : slot;
+      initAxis(axis, *servo, s);
+      slot = std::max<uint8_t>(slot, s + 1);
+    }
+    for (uint8_t i = 0; i < config.axes; ++i) beginFeedback(config, i);
+    log_i("%d axes, %d LEDC channels in use", axes.count(), LedcAllocator::inUse());
 }
 
-void setupWiFiAP() {
-  WiFi.softAP(ssid.c_str(), password.c_str());
-  log_i("Access Point started");
-  log_i("IP address: %s", WiFi.softAPIP().toString());
+void setupWiFiAP(const char *ssid, const char *password) {
+  WiFi.softAP(ssid, password);
+  log_i("Access Point %s started", ssid);
+  log_i("IP address: %s", WiFi.softAPIP().toString().c_str());
 }
 
 // Callback function for the server code
 void setTracking(bool t) {
- data.tracking = t; 
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  data.tracking = t;
+  xSemaphoreGive(controlLock);
 }
 
 // Callback function for the server code
 // When tracking this is a calibration adjustment
 void setCalibrartion(CalibrationData &serverData) {
+  xSemaphoreTake(controlLock, portMAX_DELAY);
   switch (serverData.command) {
     case CC_OK: {
       log_i( "Calibrate: OK North=%d", serverData.direction);
@@ -147,23 +295,635 @@ void setCalibrartion(CalibrationData &serverData) {
       else
         servoALT.move(-serverData.speed);
       break;
+    case CC_NONE:
+      break;
+  }
+  xSemaphoreGive(controlLock);
+}
+
+// Callback function for the server code, move a single axis
+// ALT and AZ belong to the tracking while it is on
+bool axisCommand(AxisData &request) {
+  RotorServo *servo = axes.get(request.name);
+  if (!servo) {
+    request.error = "No axis " + request.name;
+    return false;
+  }
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  bool ok = false;
+  if (data.tracking and (servo == &servoALT or servo == &servoAZ)) {
+    request.error = "Tracking, stop it first";
+  } else if (identifier.moving(servo)) {
+    request.error = "Identifying, stop it first";
+  } else {
+    ok = servo->moveToDegrees(request.degrees);
+    request.error = servo->getError();
+  }
+  xSemaphoreGive(controlLock);
+  return ok;
+}
+
+// Callback function for the server code, the axes with their position and range
+uint8_t axesCommand(AxisData *list, uint8_t size) {
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  uint8_t count = std::min(axes.count(), size);
+  for (uint8_t i = 0; i < count; ++i) {
+    RotorServo *servo = axes.axis(i);
+    list[i].name = axes.name(i);
+    list[i].degrees = servo->getDegrees();
+    servo->getRange(list[i].min, list[i].max);
+  }
+  xSemaphoreGive(controlLock);
+  return count;
+}
+
+// Callback function for the server code, identify the lag of an axis with its feedback input
+bool identifyCommand(IdentifyData &request) {
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  bool ok = true;
+  if (request.command == IC_STOP) {
+    identifier.stop("Stopped");
+  } else {
+    const AxisConfig *axis = config.find(request.axis.c_str());
+    RotorServo *servo = axes.get(request.axis);
+    if (!axis or !servo) {
+      request.error = "No axis " + request.axis;
+      ok = false;
+    } else if (data.tracking and (servo == &servoALT or servo == &servoAZ)) {
+      request.error = "Tracking, stop it first";
+      ok = false;
+    } else {
+      ok = identifier.start(*servo, lags[axis - config.axis], request.error);
+    }
+  }
+  xSemaphoreGive(controlLock);
+  return ok;
+}
+
+// Stellarium is polled while its source is on, not while its object is tracked as RA/Dec (under controlLock)
+void pollStellarium() {
+  bool on = targets.source(TS_STELLARIUM).priority();
+  if (on) stellarium.begin(&targets.source(TS_STELLARIUM));
+  stellarium.pause(!on or siderealLocked);
+}
+
+// Callback function for the server code, check a new config and apply what can change while running
+// The axes keep their calibration and position
+bool configCommand(const RotorConfig &next, bool apply, String &message) {
+  static RotorConfig previous;  // Only the web server calls this
+  String live, restart;
+  ConfigParser::compare(config, next, live, restart);
+  message = "Changed: " + (live == "" ? String("nothing") : live);
+  if (restart != "") message += "\nAfter a restart: " + restart;
+  if (!apply) return true;
+
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  previous = config;
+  ConfigParser::copyLive(config, next);
+  bool ok = true;
+  for (uint8_t i = 0; i < config.axes; ++i) {
+    const AxisConfig &axis = config.axis[i], &was = previous.axis[i];
+    RotorServo *servo = axes.get(axis.name);
+    if (!servo) continue;
+    bool geometry = axis.min != was.min or axis.max != was.max or axis.degrees != was.degrees or
+                    axis.direction != was.direction or axis.offset != was.offset;
+    if (geometry) {
+      if (!servo->configure(axis.min, axis.max, axis.degrees, axis.direction, axis.offset)) {
+        message += String("\n") + axis.name + ": " + servo->getError();
+        ok = false;
+      }
+    }
+    // Only when changed (the limits are in pulses, so also with the geometry), they take over a move in progress
+    if (geometry or axis.speed != was.speed or axis.accel != was.accel or axis.jerk != was.jerk or axis.smooth != was.smooth)
+      setAxisLimits(axis, *servo);
+    setAxisLoop(axis, loops[i]);
+    if (axis.calibration != was.calibration or axis.has("CALIBRATION") != was.has("CALIBRATION"))
+      setAxisCalibration(axis, *servo);
+  }
+  applyTracking(config, &previous);
+  applySources(config);
+  pollStellarium();
+  xSemaphoreGive(controlLock);
+  return ok;
+}
+
+// Feed a new target sample to the estimators
+void newTarget(unsigned long time) {
+  estimatorALT.update(time, data.altitude);
+  estimatorAZ.update(time, data.azimuth);
+}
+
+// Look ahead for the pass planner, the on-board targets know the whole pass
+// Called from loop(), under the lock per prediction as the motion task updates the targets meanwhile
+bool predictOnBoard(long offsetMs, float &alt, float &az) {
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  const char *error = satellites.active() ? satellites.position(offsetMs, alt, az)
+                                          : sidereal.position(offsetMs, alt, az);
+  xSemaphoreGive(controlLock);
+  return error == nullptr;
+}
+
+// rotctld/Stellarium only send the current position, extrapolate it with the estimated rate
+// The position and rates are taken by planPass(), the motion task changes them meanwhile
+float externalAlt, externalAz, externalRateAlt, externalRateAz;
+bool predictExternal(long offsetMs, float &alt, float &az) {
+  float t = offsetMs / 1000.0;
+  alt = externalAlt + externalRateAlt * t;
+  az = externalAz + externalRateAz * t;
+  return true;
+}
+
+// Choose the pose for the pass from the current servo ranges (they depend on the calibration)
+// From loop(), that takes up to POINTING_MAX_SAMPLES predictions. The motion task holds the axes until
+// the plan is handed over, a plan for a target that changed meanwhile is not taken
+void planPass() {
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  bool due = pointing.due() and data.tracking and data.valid and (data.visible or onBoard());
+  uint32_t generation = pointing.generation();
+  bool onboard = onBoard();
+  externalAlt = data.altitude;
+  externalAz = data.azimuth;
+  externalRateAlt = estimatorALT.rate();
+  externalRateAz = estimatorAZ.rate();
+  float altLow, altHigh, azLow, azHigh;
+  servoALT.getRange(altLow, altHigh);
+  servoAZ.getRange(azLow, azHigh);
+  float servoAlt = servoALT.getDegrees(), servoAz = servoAZ.getDegrees();
+  xSemaphoreGive(controlLock);
+  if (!due) return;
+
+  passPlanner.setRange(altLow, altHigh, azLow, azHigh);
+  PassPlan plan = passPlanner.plan(onboard ? predictOnBoard : predictExternal, servoAlt, servoAz);
+  plan.generation = generation;
+
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  bool applied = pointing.apply(plan);
+  if (applied) pointing.setRange(altLow, altHigh, azLow, azHigh);
+  if (applied and plan.covered == 0) {  // Not even the start of the pass fits
+    addError("Target out of range");
+    data.tracking = false;
   }
+  xSemaphoreGive(controlLock);
+  if (applied and plan.covered < POINTING_MAX_PASS) log_i("Pass leaves the servo range after %ld s", plan.covered / 1000);
+}
+
+// Back to the own limits of each axis
+void endSlew() {
+  slewing = false;
+  servoALT.setTimeScale(1.0);
+  servoAZ.setTimeScale(1.0);
+}
+
+// Move both servo's to servo angles
+// At the start of a slew the quicker axis is slowed down so both arrive together
+void moveAxes(float alt, float az) {
+  float timeALT = servoALT.slewTime(alt), timeAZ = servoAZ.slewTime(az);
+  float time = std::max(timeALT, timeAZ);
+  if (!slewing and time > SLEW_SYNC_START) {
+    slewing = true;
+    servoALT.setTimeScale(timeALT / time);
+    servoAZ.setTimeScale(timeAZ / time);
+    log_d("Slew of %0.1f s", time);
+  } else if (slewing and time < SLEW_SYNC_END) {
+    endSlew();
+  }
+
+  if (!servoALT.moveToDegrees(alt)) {
+    addError(servoALT.getError());
+    data.tracking = false;
+  }
+  if (!servoAZ.moveToDegrees(az)) {
+    addError(servoAZ.getError());
+    data.tracking = false;
+  }
+}
+
+// How far (s) an axis runs behind its setpoint while tracking
+float axisLead(RotorServo &servo, const AxisLag &lag) {
+  return servo.smoothingDelay() + lag.lead();
+}
+
+// The feedback of an axis stayed off, stop it rather than keep pushing
+void axisStalled(uint8_t i) {
+  String error = String(config.axis[i].name) + " stalled, " + String(loops[i].error(), 1) + " degrees off";
+  log_e("%s", error.c_str());
+  addError(error);
+  if (axisServos[i] == &servoALT or axisServos[i] == &servoAZ) data.tracking = false;
+  axisServos[i]->stop();
+}
+
+// Move the servo's to the current target, stops tracking when the target is out of range
+// With the estimator the setpoint is the estimated target position config.predictionHorizon ms from now
+void moveToTarget() {
+  float alt = data.altitude, az = data.azimuth;
+  bool ahead = onBoard();   // The on-board target is already computed config.predictionHorizon ahead
+  if (config.estimator and estimatorALT.valid() and !onBoard()) {
+    unsigned long t = millis() + config.predictionHorizon;
+    alt = estimatorALT.predict(t);
+    az = estimatorAZ.predict(t);
+    ahead = true;
+  }
+  // Without the estimator each sample is moved to as it is
+  float rateAlt = !ahead ? 0.0 : onBoard() ? onboardRateAlt : estimatorALT.rate();
+  float rateAz = !ahead ? 0.0 : onBoard() ? onboardRateAz : estimatorAZ.rate();
+
+  if (!pointing.planned()) return;  // Hold until loop() has planned the pass
+  float servoAlt, servoAz;
+  if (!pointing.toServo(alt, az, servoAlt, servoAz)) {
+    // The pass left the planned range after all (a rotctld/Stellarium look ahead is a guess), plan again from
+    // here. When it is out of range of that plan too, it can't be reached
+    if (!pointing.replanned()) {
+      pointing.replan();
+      return;
+    }
+    addError("Target out of range");
+    data.tracking = false;
+    return;
+  }
+
+  // Where the axes should be right now, to compare the feedback with
+  float back = ahead ? config.predictionHorizon / 1000.0 : 0.0;
+  pointing.toServo(alt - rateAlt * back, az - rateAz * back, intendedAlt, intendedAz);
+
+  // The pulse runs behind the setpoint by the smoothing and the servo behind the pulse by its lag, each axis
+  // is commanded that far ahead. Near the end of the range the lead is dropped rather than the target
+  float leadAlt, leadAz;
+  if (config.leadCompensation and pointing.toServo(alt + rateAlt * axisLead(servoALT, lagALT),
+                                                   az + rateAz * axisLead(servoAZ, lagAZ), leadAlt, leadAz)) {
+    servoAlt = leadAlt;
+    servoAz = leadAz;
+  }
+  moveAxes(servoAlt, servoAz);
+}
+
+// Wait for an on-board target to rise where its pass starts
+void moveToPassStart() {
+  float servoAlt, servoAz;
+  if (pointing.start(servoAlt, servoAz)) moveAxes(servoAlt, servoAz);
+}
+
+// Callback function for the rotctld S (stop) and M (move) commands
+int rotctldCommand(const RotctldRequest &request) {
+  targets.source(TS_ROTCTLD).release();   // Manual moves, a lower source may take over
+
+  // Move towards the end of the range until stopped, the servo moves at its own rate so the speed is not used
+  RotorServo *servo = nullptr;
+  bool increase = true; // increasing degrees
+  if (request.command != RC_STOP) {
+    switch ((int)request.args[0]) {
+      case ROT_MOVE_UP:    servo = &servoALT; break;
+      case ROT_MOVE_DOWN:  servo = &servoALT; increase = false; break;
+      case ROT_MOVE_RIGHT: servo = &servoAZ; break;
+      case ROT_MOVE_LEFT:  servo = &servoAZ; increase = false; break;
+      default:             break;
+    }
+  }
+
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  data.tracking = false;
+  if (request.command == RC_STOP) {
+    servoALT.stop();
+    servoAZ.stop();
+  } else if (servo) {
+    bool toMax = increase == (servo->getDirection() > 0);
+    servo->moveTo(toMax ? servo->getMax() : servo->getMin());
+  }
+  xSemaphoreGive(controlLock);
+  return request.command == RC_STOP or servo ? RPRT_OK : RPRT_EINVAL;
+}
+
+// What \dump_state reports: the sky the servo ranges reach with the current config and calibration,
+// kept up to date from loop() as both can change at any time. When the ALT servo goes past the zenith
+// the flipped pose adds half a turn to the azimuth range.
+void setRotctldLimits() {
+  if (!servoALT.calibrated() or !servoAZ.calibrated()) return;   // The defaults until then
+  float altLow, altHigh, azLow, azHigh;
+  servoALT.getRange(altLow, altHigh);
+  servoAZ.getRange(azLow, azHigh);
+  if (altHigh > 90.0 and azHigh - azLow >= 180.0) azHigh = std::min(azHigh + 180.0f, azLow + 360.0f);
+  rotctld.setLimits(azLow, azHigh, altLow, std::min(altHigh, 90.0f));
+}
+
+// rotctld commands are handled on every pass of loop(), a new target (e.g. from SatDump) is published right away
+// Clients are always answered, the target is only followed while no source with a higher priority has one
+void handleRotctld() {
+  float alt, az;
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  pointing.toSky(servoALT.toDegrees(lagALT.position()), servoAZ.toDegrees(lagAZ.position()), alt, az);
+  setRotctldLimits();
+  xSemaphoreGive(controlLock);
+  if (!rotctld.poll(alt, az)) return;
+
+  TargetSample sample;
+  sample.altitude = rotctld.getTargetAlt();
+  sample.azimuth = rotctld.getTargetAz();
+  sample.visible = sample.altitude >= 0.0;
+  sample.valid = true;
+  sample.track = true;    // Tracking goes on with the first position
+  sample.time = rotctld.getTargetTime();
+  strlcpy(sample.name, "<see Satdump>", sizeof(sample.name));
+  targets.source(TS_ROTCTLD).publish(sample);
+  log_d("rotctld target ALT=%0.2f AZ=%0.2f", sample.altitude, sample.azimuth);
+}
+
+// Callback function for the server code, a target from the web page
+bool targetCommand(TargetData &request) {
+  if (request.command == TC_RELEASE) {
+    targets.source(TS_WEB).release();
+    return true;
+  }
+  if (request.altitude < -90 or request.altitude > 90 or request.azimuth < 0 or request.azimuth >= 360) {
+    request.error = "alt must be -90..90 and az 0..360 degrees";
+    return false;
+  }
+  if (!targets.source(TS_WEB).priority()) {
+    request.error = "The web source is off in [sources]";
+    return false;
+  }
+  TargetSample sample;
+  sample.altitude = request.altitude;
+  sample.azimuth = request.azimuth;
+  sample.visible = sample.altitude >= 0.0;
+  sample.valid = true;
+  sample.track = true;
+  sample.time = millis();
+  strlcpy(sample.name, request.name.c_str(), sizeof(sample.name));
+  targets.source(TS_WEB).publish(sample);
+  return true;
+}
+
+// Callback function for the server code, lock or release the RA/Dec tracking
+bool siderealCommand(SiderealData &request) {
+  if (request.command == SC_RELEASE) {
+    xSemaphoreTake(controlLock, portMAX_DELAY);
+    sidereal.clear();
+    siderealLocked = false;
+    pollStellarium();
+    xSemaphoreGive(controlLock);
+    return true;
+  }
+
+  if (!request.coordinates) {
+    // Take the coordinates of the object selected in Stellarium
+    uint32_t version = 0;
+    StellariumSample sample;
+    if (!targets.source(TS_STELLARIUM).priority() or !stellarium.read(sample, version) or !sample.valid or
+        millis() - sample.time > STELLARIUM_STALE) {
+      request.error = "No object from Stellarium";
+      return false;
+    }
+    if (!sample.hasRaDec) {
+      request.error = "Stellarium sent no RA/Dec";
+      return false;
+    }
+    request.ra = sample.ra;
+    request.dec = sample.dec;
+    request.name = sample.name;
+  }
+
+  satellites.select("");    // A TLE satellite would take priority
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  sidereal.set(request.name.c_str(), request.ra, request.dec);
+  siderealLocked = true;
+  pollStellarium();
+  xSemaphoreGive(controlLock);
+  return true;
+}
+
+// On-board source: the position of the TLE satellite or the RA/Dec is computed at the servo update rate,
+// no estimator needed
+void computeTarget() {
+  float alt = 0.0, az = 0.0;
+  const char *error = satellites.active() ? satellites.position(config.predictionHorizon, alt, az)
+                                          : sidereal.position(config.predictionHorizon, alt, az);
+  TargetSample sample;
+  sample.altitude = alt;
+  sample.azimuth = az;
+  sample.visible = alt >= 0.0;
+  sample.valid = error == nullptr;
+  sample.time = millis();
+  strlcpy(sample.name, satellites.active() ? satellites.name() : sidereal.name(), sizeof(sample.name));
+  strlcpy(sample.error, error ? error : "", sizeof(sample.error));
+  targets.source(TS_ONBOARD).publish(sample);
+
+  // The rate from the position before, for the lead
+  static TargetSample last;
+  float dt = (sample.time - last.time) / 1000.0;
+  if (sample.valid and last.valid and dt > 0 and strcmp(sample.name, last.name) == 0) {
+    onboardRateAlt = (alt - last.altitude) / dt;
+    onboardRateAz = (fmodf(az - last.azimuth + 540.0f, 360.0f) - 180.0f) / dt;
+  } else {
+    onboardRateAlt = onboardRateAz = 0.0;
+  }
+  last = sample;
+}
+
+// Take the target of the source followed, at most once per control tick
+void followTarget() {
+  uint32_t now = millis();
+  if (!targets.update(now)) return;
+
+  if (targets.takeHandover()) {
+    data.source = targets.active();
+    estimatorALT.reset();
+    estimatorAZ.reset();
+    pointing.reset();
+    if (targets.active() < 0) {
+      data.valid = false;
+      if (data.error != targets.reason()) data.error = targets.reason();
+      return;
+    }
+  }
+
+  // Strings only change with the target, loop() and the web server read them meanwhile
+  const TargetSample &sample = targets.current();
+  data.altitude = sample.altitude;
+  data.azimuth = sample.azimuth;
+  data.visible = sample.visible;
+  data.valid = sample.valid;
+  if (data.name != sample.name) data.name = sample.name;
+  if (data.error != sample.error) data.error = sample.error;
+  if (sample.track) data.tracking = true;
+  if (!onBoard()) newTarget(sample.time);
+}
+
+// One step of the motion control, from the motion task at MOTION_RATE
+void motionStep() {
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  satellites.update();
+  sidereal.update();
+
+  // An on-board target is computed every update interval, the servo's get a setpoint every step
+  static unsigned long lastTarget = 0;
+  static bool computing = false;
+  if (satellites.active() or sidereal.active()) {
+    if (!computing or millis() - lastTarget >= UPDATE_INTERVAL) {
+      lastTarget = millis();
+      computeTarget();
+    }
+    computing = true;
+  } else if (computing) {
+    targets.source(TS_ONBOARD).release();
+    computing = false;
+  }
+  followTarget();
+
+  // A new pass is planned when tracking starts, the target changes or the target has set
+  static bool wasVisible = false;
+  static String passName;
+  if (!data.tracking or data.name != passName or (wasVisible and !data.visible)) pointing.reset();
+  if (!data.tracking and slewing) endSlew();  // Manual moves run at the full limits
+  wasVisible = data.visible;
+  if (passName != data.name) passName = data.name;
+
+  // Tracking takes the axes back from an identification
+  if (data.tracking and (identifier.moving(&servoALT) or identifier.moving(&servoAZ))) identifier.stop("Tracking started");
+
+  bool following = data.tracking and data.valid and data.visible;
+  if (following) moveToTarget();
+  else if (data.tracking and data.valid and onBoard()) moveToPassStart();
+
+  // Move servo's to their target location very smoothly only does something if smooth=1 in config.ini ....
+  if (!axes.run()) addError(axes.getError());
+
+  // Where the servo's are behind their pulse, measured and modelled, then the closed loops correct the difference
+  float dt = motion.period() / 1e6;
+  for (uint8_t i = 0; i < config.axes; ++i) {
+    if (!axisServos[i]) continue;
+    lags[i].sample();
+    lags[i].step(axisServos[i]->getCurrent(), dt);
+  }
+  identifier.step(dt);  // Records the pulses just sent
+  for (uint8_t i = 0; i < config.axes; ++i)
+    if (axisServos[i] and loops[i].run(*axisServos[i], lags[i], dt, identifier.moving(axisServos[i]))) axisStalled(i);
+
+  // How far the servo's are off while tracking when there is feedback
+  float measured;
+  if (following and data.tracking and !slewing) {
+    if (lagALT.measured(measured)) lagALT.error(servoALT.toDegrees(measured) - intendedAlt, dt);
+    if (lagAZ.measured(measured)) lagAZ.error(servoAZ.toDegrees(measured) - intendedAz, dt);
+  }
+
+  // Servo angles for the page every step, then everything for the page is published at once
+  pointing.toSky(servoALT.toDegrees(lagALT.position()), servoAZ.toDegrees(lagAZ.position()), data.currAlt, data.currAz);
+  pageData.publish(data, targets);
+
+  HistorySample sample;
+  sample.time = millis();
+  sample.value[0] = lroundf(data.altitude * 100);
+  sample.value[1] = lroundf(data.azimuth * 100);
+  sample.value[2] = servoALT.getTarget();
+  sample.value[3] = servoALT.getCurrent();
+  sample.value[4] = servoAZ.getTarget();
+  sample.value[5] = servoAZ.getCurrent();
+  history.record(sample);
+  xSemaphoreGive(controlLock);
+}
+
+// Log the non empty bins of a timing histogram
+void logHistogram(const char *name, const TimingHistogram &histogram) {
+  String line;
+  for (uint8_t bin = 0; bin < MOTION_HISTOGRAM_BINS; ++bin) {
+    if (!histogram.bins[bin]) continue;
+    if (bin == MOTION_HISTOGRAM_BINS - 1)
+      line += " >" + String(TimingHistogram::edge(bin - 1)) + ":" + String(histogram.bins[bin]);
+    else
+      line += " <" + String(TimingHistogram::edge(bin)) + ":" + String(histogram.bins[bin]);
+  }
+  log_i("%s (us):%s", name, line.c_str());
 }
 
 // Only continue if the setup was successful
 bool setupSucces;
 
+// Boot stages, setup() and the network task wait for each other's
+BootTimeline boot;
+EventGroupHandle_t bootEvents;
+#define BOOT_FILESYSTEM BIT0
+#define BOOT_CONFIG     BIT1    // Axes, callbacks and links are all set
+#define BOOT_NETWORK    BIT2
+Probe bootRotctld("rotor_boot_rotctld_seconds", "Time from the start to the first rotctld command, 0 before it",
+                  MT_GAUGE, [] { return boot.at("First rotctld command") / 1e6; });
+
+bool networkUp() { return xEventGroupGetBits(bootEvents) & BOOT_NETWORK; }
+
+/// @brief Starts the access point while setup() mounts the file system and reads the config, then
+/// runs the web server
+/// The access point starts with the credentials of the previous boot, only the first boot waits for config.ini
+void NetworkTask(void *pvParameters) {
+  BootCredentials credentials;
+  bool cached = CredentialCache::read(credentials);
+  if (!cached) {
+    xEventGroupWaitBits(bootEvents, BOOT_CONFIG, pdFALSE, pdTRUE, portMAX_DELAY);
+    strlcpy(credentials.ssid, config.ssid, sizeof(credentials.ssid));
+    strlcpy(credentials.password, config.password, sizeof(credentials.password));
+  }
+  setupWiFiAP(credentials.ssid, credentials.password);
+  boot.mark("Access point");
+  xEventGroupSetBits(bootEvents, BOOT_NETWORK);
+
+  xEventGroupWaitBits(bootEvents, BOOT_CONFIG, pdFALSE, pdTRUE, portMAX_DELAY);
+  if (strcmp(credentials.ssid, config.ssid) or strcmp(credentials.password, config.password)) {
+    log_i("config.ini has another access point");
+    setupWiFiAP(config.ssid, config.password);
+  }
+  CredentialCache::write(config.ssid, config.password);
+
+  // Stellarium is polled from its own task on core 0
+  xSemaphoreTake(controlLock, portMAX_DELAY);
+  pollStellarium();
+  xSemaphoreGive(controlLock);
+
+  // Push the page data to the browsers, also on core 0
+  telemetry.begin(&pageData, config.telemetryRate);
+
+  boot.mark("Web server");
+  WebServerTask(pvParameters);    // Does not return
+}
+
+#ifdef NATIVE_BUILD
+// Where the antenna really points, from the simulated servo's, for the pass simulator
+bool simulatedPointing(float &alt, float &az) {
+  double pulseAlt = native::plants().position(config.axis[0].pin), pulseAz = native::plants().position(config.axis[1].pin);
+  if (std::isnan(pulseAlt) or std::isnan(pulseAz)) return false;
+  pointing.toSky(servoALT.toDegrees(pulseAlt), servoAZ.toDegrees(pulseAz), alt, az);
+  return data.tracking and pointing.planned();  // Not while holding for a plan
+}
+#endif
+
 void setup() {
 
   setupSucces = false;
 
+  // Drive the servo's at their saved position before anything else, everything after this takes a while
+  boot.mark("Setup");
+  Journal.begin();
+  uint8_t held = ServoHold::begin();
+  boot.mark("Servo's held");
+
   Serial.begin(115200);
-  delay(100);
+  log_i("%u servo's held at their saved position", held);
+
+  controlLock = xSemaphoreCreateMutex();
+  bootEvents = xEventGroupCreate();
+
+  // Access point and web server on core 0, meanwhile the file system and config here
+  xTaskCreatePinnedToCore(
+      NetworkTask,     // Task function
+      "Network",       // Task name
+      10000,           // Stack size (bytes)
+      NULL,            // Task parameters
+      1,               // Priority
+      NULL,            // Task handle
+      0);              // Pin to Core 0
+
   if (!SPIFFS.begin(true)) {
       log_e("SPIFFS mount failed => Not usefull to continue");
       ledAction(ledErrorBlink);
       return;
   }
+  boot.mark("File system");
+  xEventGroupSetBits(bootEvents, BOOT_FILESYSTEM);
 
 #ifdef DEBUG_BUILD
   constexpr const char* build = "Debug build";
@@ -173,128 +933,160 @@ void setup() {
 
   log_i("%s version %s.\n",build,VERSION);
 
+  axes.add("ALT", &servoALT);
+  axes.add("AZ", &servoAZ);
   readInitConfig(); 
-  setupWiFiAP();
+  ServoHold::release();   // Slots no axis uses any more
+  boot.mark("Config");
   ledAction(ledOff);
 
   setCallBack(setTracking);
   setCalibrationCallBack(setCalibrartion);
-
-  // Setup webserver
-  xTaskCreatePinnedToCore(
-      WebServerTask,   // Task function
-      "WebServer",     // Task name
-      10000,           // Stack size (bytes)
-      NULL,            // Task parameters
-      1,               // Priority
-      NULL,            // Task handle
-      0);              // Pin to Core 0
+  setConfigCallBack(configCommand);
+  rotctld.setCallBack(rotctldCommand);
 
   // Give myserver Access to the data
-  linkData(&data);
+  linkData(&pageData);
+  linkSatellites(&satellites);
+  setAxisCallBack(axisCommand);
+  setAxesCallBack(axesCommand);
+  setSiderealCallBack(siderealCommand);
+  setTargetCallBack(targetCommand);
+  setIdentifyCallBack(identifyCommand);
+  linkIdentifier(&identifier);
+
+  // Motion control on core 1, above loop(), with the history of every step
+  history.begin(config.historySize, 1000 / constrain(config.motionRate, MOTION_RATE_MIN, MOTION_RATE_MAX));
+  linkHistory(&history);
+  motion.begin(motionStep, config.motionRate);
+#ifdef NATIVE_BUILD
+  native::simulation().pointing = simulatedPointing;
+#endif
+  boot.mark("Motion");
+  xEventGroupSetBits(bootEvents, BOOT_CONFIG);
 
   setupSucces = true;
-  log_i("Setup() is complete. Main loop will run on Core 1. Server runs on Core 0");
+  log_i("Setup() is complete. Main loop and motion run on Core 1. Server runs on Core 0");
 }
 
 void loop() {
   static unsigned long lastCheck = 0;
   static unsigned long loopCounter = 0;
-  
-
-//satDumpTest() ;
 
   loopCounter++;
+  static unsigned long lastPass = 0;
+  unsigned long pass = micros();
+  if (lastPass) loopPass.add(pass - lastPass);
+  lastPass = pass;
   ledAction();
 
   // Don't continue if the setup failed (probably because of a SPIFFS error), led should be very fast "bleeping"
   if (!setupSucces) return;
 
-  // Clear errorString after a while
-  clearError();
-
-  // Move servo's to their target location very smoothly only does something if smooth=1 in config.ini ....
-  if (!servoAZ.run()) {
-    addError("Failed to track azimuth");
+  // rotctld clients can come in as soon as the access point is up
+  if (networkUp()) {
+    handleRotctld();
+    static bool first = true;
+    if (first and rotctld.commands()) {
+      first = false;
+      boot.mark("First rotctld command");
+      log_i("Boot: %s", boot.summary().c_str());
+    }
   }
 
-  if (!servoALT.run()){
-    addError("Failed to track altitude");
+  // Positions are saved here, the flash write would stall the motion task
+  Journal.loop();
+
+  // So is the fit of a servo lag identification, it takes a while
+  if (identifier.fitDue() and identifier.fit()) {
+    xSemaphoreTake(controlLock, portMAX_DELAY);
+    identifier.apply();
+    xSemaphoreGive(controlLock);
   }
 
+  // And the pass planning, the look ahead takes many predictions
+  planPass();
+
   if (millis() - lastCheck > 1000) {  // every second
+    lastCheck = millis();
 
-    log_i("****** INFO ******");
-    log_i("AZ  target=%0.2f (%4d)",servoAZ.getDegrees(),  servoAZ.getTarget());
-    log_i("ALT target=%0.2f (%4d)", servoALT.getDegrees(),  servoALT.getTarget());
+    // Status first, under the lock as the motion task uses the same data
+    xSemaphoreTake(controlLock, portMAX_DELAY);
+    clearError();   // Clear errorString after a while
+    // Which source is followed is up to followTarget(), when none is live the data is not valid
 
-    // Save if tracking and restore after getting new data
-    if (data.stellariumMode) {
+    if (data.error!="") { // The source has no position (e.g. no response from Stellarium)
+      errorTime = millis();
+    } else
+      data.error = errorString;
 
-      bool tracking = data.tracking;
-      data = getStellariumData();
-      data.tracking = tracking;
+    if (!data.valid) {
+      data.tracking = false;
+      addError("Invalid data. Stop Tracking.");
+    }
 
-    } else {
+    data.sidereal = sidereal.active();
 
-      // Satdump mode
-      auto satDump = handleSatDump(servoALT.getDegrees(),servoAZ.getDegrees());
-      float alt = std::get<0>(satDump); 
-      float az = std::get<1>(satDump); 
-
-      if (alt!=0.0 and az!=0.0) {
-        log_i("****** SATDUMP ******");
-        log_i("ALT = %0.2f",alt);
-        log_i("AZ  = %0.2f",az);
-        // Ah we have Satdump tracking
-        data.altitude = alt;
-        data.azimuth = az;
-        data.name = "<see Satdump>";
-        data.valid = true;
-        data.visible = alt>=0.0;
-        data.valid = true;
-        data.tracking = true; // Force tracking on
-      } else {
-        data.tracking = false;
-      }
-  }   // End SatDump stuff
+    // A satellite or RA/Dec keeps tracking on while below the horizon, it starts moving when it rises
+    if (!data.visible and !onBoard()) data.tracking = false;
 
-    data.currAlt = servoALT.getDegrees();
-    data.currAz = servoAZ.getDegrees();
-    if (data.error!="") { // We couldn't retrieve data from Stellarium
-      errorTime = millis();
-    } else
-      data.error = errorString;
+    // What is logged is copied here, the motion task changes it meanwhile
+    char name[TARGET_TEXT_LENGTH];
+    strlcpy(name, data.name.c_str(), sizeof(name));
+    float altitude = data.altitude, azimuth = data.azimuth;
+    bool valid = data.valid, visible = data.visible, tracking = data.tracking;
+    bool onboard = onBoard(), satellite = satellites.active(), rotctldFollowed = targets.following(TS_ROTCTLD);
+    float degreesAZ = servoAZ.getDegrees(), degreesALT = servoALT.getDegrees();
+    int targetAZ = servoAZ.getTarget(), targetALT = servoALT.getTarget();
+    bool feedback = lagALT.hasFeedback() or lagAZ.hasFeedback();
+    float errorALT = lagALT.trackingError(), errorAZ = lagAZ.trackingError();
+    xSemaphoreGive(controlLock);
+
+    // Then the logging, outside the lock as the serial port is slow
+    log_i("****** INFO ******");
+    log_i("AZ  target=%0.2f (%4d)", degreesAZ, targetAZ);
+    log_i("ALT target=%0.2f (%4d)", degreesALT, targetALT);
+    for (uint8_t i = 0; i < TS_COUNT; ++i) {
+      TargetSourceId id = (TargetSourceId)i;
+      if (targets.age(id, millis()) >= 0)
+        log_d("Source %s%s: age %ld ms, latency %lu ms", TargetArbiter::name(id), targets.following(id) ? " (followed)" : "",
+              (long)targets.age(id, millis()), (unsigned long)targets.status(id).latency);
+    }
+    if (tracking and feedback) log_i("Tracking error ALT %0.2f AZ %0.2f degrees rms", errorALT, errorAZ);
+    const JournalStats &journal = Journal.stats();
+    log_i("Journal: %u records, last %u us, max %u us", journal.commits, journal.lastMicros, journal.maxMicros);
+    const MotionStats &timing = motion.stats();
+    log_i("Motion: period %u us, jitter max %u us, step max %u us, %u overruns", motion.period(),
+          timing.jitter.max, timing.execution.max, timing.overruns);
+    static unsigned long checks = 0;
+    if (++checks % 60 == 0) {   // Every minute
+      logHistogram("Jitter", timing.jitter);
+      logHistogram("Step", timing.execution);
+      log_i("History: last %lu s, %lu steps thinned", (unsigned long)history.span() / 1000, (unsigned long)history.thinned());
+    }
+
+    if (onboard) {
+      log_i("****** %s ******", satellite ? "SATELLITE" : "SIDEREAL");
+      log_i("%s ALT = %0.2f AZ = %0.2f", name, altitude, azimuth);
+    } else if (rotctldFollowed) {
+      log_i("****** ROTCTLD ******");
+      log_i("ALT = %0.2f",altitude);
+      log_i("AZ  = %0.2f",azimuth);
+      log_i("Clients = %d",rotctld.clients());
+    }
 
-    if (data.valid) {
+    if (valid) {
       ledAction(ledOff);
       if (loopCounter%5==0) { // Every 5 seconds
         log_i("****** OBJECT ******");
-        log_i("Object\t: %s",data.name);
-        log_i("Altitude\t: %0.4f",data.altitude);
-        log_i("Azimuth\t: %0.4f",data.azimuth);
-        log_i("Visible\t: %d",data.visible);
+        log_i("Object\t: %s",name);
+        log_i("Altitude\t: %0.4f",altitude);
+        log_i("Azimuth\t: %0.4f",azimuth);
+        log_i("Visible\t: %d",visible);
       }
-      // When tracking move it!
-      if (data.tracking) {
-        if (!servoALT.moveToDegrees(data.altitude)) {
-          addError(servoALT.getError());
-          data.tracking = false;
-        }
-        if (!servoAZ.moveToDegrees(data.azimuth)) {
-          addError(servoAZ.getError());
-          data.tracking = false;         
-        }
-      }
-
     } else {
       ledAction(ledBlink);
-      data.tracking = false;
-      addError("Invalid data. Stop Tracking.");
       log_i("Invalid data. Stop tracking");
     }
-
-    if (!data.visible) data.tracking = false;
-    lastCheck = millis();
   }
 }
\ No newline at end of file
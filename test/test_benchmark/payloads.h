@@ -0,0 +1,61 @@
+// Bodies of /api/objects/info?format=json the way Stellarium (1.x) sends them
+#pragma once
+
+static const char STELLARIUM_STAR[] = R"json({"above-horizon":true,"absolute-mag":0.582,"airmass":1.02093,)json"
+    R"json("altitude":78.3406,"altitude-geometric":78.3369,"ambientInt":0.0021,"ambientLum":0.00023,)json"
+    R"json("appSidTm":"19h32m10.4s","azimuth":252.7416,"azimuth-geometric":252.7416,"bV":0,)json"
+    R"json("constellation-extinction":"Lyr","dec":38.8087,"decJ2000":38.7837,"designations":"HIP 91262 - HD 172167 - SAO 67174 - HR 7001 - 3 Lyrae - Alpha Lyrae",)json"
+    R"json("distance-ly":25.04,"elat":61.7355,"elong":285.3159,"found":true,"glat":19.2384,"glong":67.4482,)json"
+    R"json("hourAngle-dd":-4.1287,"hourAngle-hms":"-0h16m30.9s","iauConstellation":"Lyr","localized-name":"Vega",)json"
+    R"json("meanSidTm":"19h32m11.0s","name":"Vega","object-type":"star","parallacticAngle":-7.2431,)json"
+    R"json("parallax":0.13023,"ra":279.5173,"raJ2000":279.2347,"rise":"10h21m","rise-dhr":10.3588,)json"
+    R"json("set":"6h16m","set-dhr":6.2764,"spectral-class":"A0Va","star-type":"star","transit":"19h48m",)json"
+    R"json("transit-dhr":19.8087,"type":"Star","variable-star":"no","vmag":0.03,"vmage":0.0353})json";
+
+static const char STELLARIUM_PLANET[] = R"json({"above-horizon":true,"absolute-mag":-9.4,"airmass":1.43218,"albedo":0.538,)json"
+    R"json("altitude":44.1295,"altitude-geometric":44.1127,"appSidTm":"5h12m44.1s","azimuth":141.0864,"azimuth-geometric":141.0864,)json"
+    R"json("dec":22.3461,"decJ2000":22.2512,"distance":4.21735,"distance-km":630906812.4,"ecl-elong":72.6183,"ecl-elong-J2000":72.2865,)json"
+    R"json("ecl-obl":23.4368,"elat":-0.3874,"elatJ2000":-0.3874,"elong":72.6183,"elongJ2000":72.2865,"found":true,"glat":-2.2719,)json"
+    R"json("glong":187.0981,"heliocentric-distance":5.04921,"heliocentric-distance-km":755345186.1,"heliocentric-velocity":"[-6.10 3.97 1.85]",)json"
+    R"json("heliocentric-velocity-kms":12.59,"hourAngle-dd":-2.7621,"hourAngle-hms":"-2h45m43.6s","iauConstellation":"Tau",)json"
+    R"json("illumination":99.1265,"light-time":"0h34m58.6s","localized-name":"Jupiter","meanSidTm":"5h12m44.8s","name":"Jupiter",)json"
+    R"json("object-type":"planet","orbital-velocity":"[-0.56 -0.92 -0.38]","orbital-velocity-kms":13.06,"parallacticAngle":-31.5172,)json"
+    R"json("phase":0.991265,"phase-angle":0.1871,"phase-angle-deg":"10.72","phase-angle-dms":"+10°43'03.7\"","ra":77.9764,)json"
+    R"json("raJ2000":77.6331,"rise":"9h18m","rise-dhr":9.3035,"set":"1h24m","set-dhr":1.4008,"sidereal-day":"9h55m29.7s",)json"
+    R"json("sidereal-year":4332.59,"size":0.0121,"size-dd":"0.012127","size-deg":"0.01213°","size-dms":"+0°00'43.66\"",)json"
+    R"json("transit":"17h21m","transit-dhr":17.3547,"type":"Planet","velocity":"[-4.91 2.63 1.22]","velocity-kms":5.71,)json"
+    R"json("vmag":-2.35,"vmage":-2.3381})json";
+
+static const char STELLARIUM_SATELLITE[] = R"json({"above-horizon":true,"airmass":1.91862,"altitude":31.4578,)json"
+    R"json("altitude-geometric":31.4323,"appSidTm":"21h03m12.0s","azimuth":312.7759,"azimuth-geometric":312.7759,)json"
+    R"json("catalog-number":"25544","dec":55.1184,"decJ2000":55.0238,"elong":132.4215,"found":true,"glat":8.1632,"glong":91.5412,)json"
+    R"json("height":419.84,"hourAngle-dd":-21.0544,"hourAngle-hms":"-1h24m13.1s","iauConstellation":"Cyg",)json"
+    R"json("inclination":51.6416,"international-designator":"1998-067A","localized-name":"ISS (ZARYA)","meanSidTm":"21h03m12.7s",)json"
+    R"json("name":"ISS (ZARYA)","object-type":"artificial","orbital-period":92.84,"parallacticAngle":61.0422,"perigee-altitude":413.2,)json"
+    R"json("apogee-altitude":421.7,"ra":336.8425,"raJ2000":336.5631,"range":767.93,"range-rate":-6.117,"size":0.0,)json"
+    R"json("sun-reflection-angle":81.26,"type":"Satellite","velocity":"[4.51 -5.88 1.02]","velocity-kms":7.66,"vmag":-2.1,"vmage":-1.8317})json";
+
+static const char STELLARIUM_NEBULA[] = R"json({"above-horizon":true,"airmass":1.10518,"altitude":64.9581,)json"
+    R"json("altitude-geometric":64.9505,"appSidTm":"0h58m20.5s","azimuth":63.1084,"azimuth-geometric":63.1084,"bmag":4.36,)json"
+    R"json("dec":41.4082,"decJ2000":41.2692,"designations":"M 31 - NGC 224 - UGC 454 - PGC 2557 - MCG 7-2-16 - CGCG 535-17 - Arp 0",)json"
+    R"json("distance":0.77,"distance-ly":2510000,"elat":33.3502,"elong":27.8441,"found":true,"glat":-21.5736,"glong":121.1744,)json"
+    R"json("hourAngle-dd":0.0131,"hourAngle-hms":"0h00m03.1s","iauConstellation":"And","localized-name":"Andromeda Galaxy",)json"
+    R"json("meanSidTm":"0h58m21.1s","morphological-type":"SA(s)b","name":"Andromeda Galaxy","object-type":"galaxy",)json"
+    R"json("parallacticAngle":0.0112,"ra":11.0235,"raJ2000":10.6848,"redshift":-0.001,"rise":"15h44m","rise-dhr":15.7413,)json"
+    R"json("set":"-","size":3.17,"size-dd":"3.166667","size-deg":"3.16667°","size-dms":"+3°10'00.00\"","surface-brightness":13.35,)json"
+    R"json("transit":"0h58m","transit-dhr":0.9694,"type":"Galaxy","vmag":3.44,"vmage":3.5417})json";
+
+// What Stellarium answers without a selection, not JSON
+static const char STELLARIUM_NOTHING[] = "no current selection, and no name parameter provided";
+
+struct StellariumPayload {
+    const char *kind, *body, *name;     // name is nullptr when the sample is not valid
+};
+
+static const StellariumPayload STELLARIUM_PAYLOADS[] = {
+    {"star", STELLARIUM_STAR, "Vega"},
+    {"planet", STELLARIUM_PLANET, "Jupiter"},
+    {"satellite", STELLARIUM_SATELLITE, "ISS (ZARYA)"},
+    {"galaxy", STELLARIUM_NEBULA, "Andromeda Galaxy"},
+    {"nothing selected", STELLARIUM_NOTHING, nullptr},
+};
@@ -0,0 +1,299 @@
+// Benchmarks of the hot paths on the host: `pio test -e native -f test_benchmark -v`.
+// Every case prints the time per operation and the heap allocations per operation. Host times
+// only compare versions of the code with each other, the ESP32 is some 20 times slower. The
+// assertions guard the paths that are meant not to allocate at all.
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <satdump.h>
+#include <stellarium.h>
+#include <rotorservo.h>
+#include <pagedata.h>
+#include "payloads.h"
+
+// Heap calls and bytes of the code under test. ArduinoJson allocates with malloc, so where the C
+// library lets a program replace malloc (glibc) that is counted, elsewhere only operator new.
+static size_t heapCalls = 0, heapBytes = 0, heapPeak = 0;
+
+static void heapAdd(size_t bytes) {
+    heapBytes += bytes;
+    heapPeak = std::max(heapPeak, heapBytes);
+}
+
+#ifdef __GLIBC__
+#include <malloc.h>
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void __libc_free(void *p);
+
+void *malloc(size_t size) {
+    void *p = __libc_malloc(size);
+    heapCalls++;
+    heapAdd(malloc_usable_size(p));
+    return p;
+}
+void *calloc(size_t count, size_t size) {
+    void *p = __libc_calloc(count, size);
+    heapCalls++;
+    heapAdd(malloc_usable_size(p));
+    return p;
+}
+void *realloc(void *p, size_t size) {
+    heapBytes -= malloc_usable_size(p);
+    p = __libc_realloc(p, size);
+    heapCalls++;
+    heapAdd(malloc_usable_size(p));
+    return p;
+}
+void free(void *p) {
+    heapBytes -= malloc_usable_size(p);
+    __libc_free(p);
+}
+}
+#else
+void *operator new(size_t size) {
+    size_t *p = (size_t *)malloc(size + 16);     // The size in front, keeps the alignment
+    if (!p) throw std::bad_alloc();
+    *p = size;
+    heapCalls++;
+    heapAdd(size);
+    return (uint8_t *)p + 16;
+}
+void operator delete(void *p) noexcept {
+    if (!p) return;
+    size_t *block = (size_t *)((uint8_t *)p - 16);
+    heapBytes -= *block;
+    free(block);
+}
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+#endif
+
+/// @brief A response body in memory, read like the socket it arrives on
+class MemoryStream : public Stream {
+public:
+    MemoryStream(const char *data) : _data(data), _length(strlen(data)) {}
+
+    int available() override { return _length - _at; }
+    int read() override { return _at < _length ? (uint8_t)_data[_at++] : -1; }
+    int peek() override { return _at < _length ? (uint8_t)_data[_at] : -1; }
+    size_t readBytes(char *buffer, size_t length) override {
+        length = std::min(length, _length - _at);
+        memcpy(buffer, _data + _at, length);
+        _at += length;
+        return length;
+    }
+    size_t write(uint8_t) override { return 0; }
+    void rewind() { _at = 0; }
+
+private:
+    const char *_data;
+    size_t _length, _at = 0;
+};
+
+struct BenchResult {
+    double ns;          // Per operation
+    double allocations; // Per operation
+};
+
+/// @brief Run f(i) for i = 0 .. operations - 1 and print what one call costs, unless name is empty
+template <typename F>
+static BenchResult bench(const char *name, uint32_t operations, F f) {
+    for (uint32_t i = 0; i < operations / 10; ++i) f(i);     // Warm up
+    size_t calls = heapCalls;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < operations; ++i) f(i);
+    auto end = std::chrono::steady_clock::now();
+    BenchResult result;
+    result.ns = std::chrono::duration<double, std::nano>(end - start).count() / operations;
+    result.allocations = (double)(heapCalls - calls) / operations;
+    if (!*name) return result;  // The caller prints it
+    char line[120];
+    snprintf(line, sizeof(line), "%-24s %10.1f ns/op %8.2f allocs/op", name, result.ns, result.allocations);
+    TEST_MESSAGE(line);
+    return result;
+}
+
+#define BENCH_ROTCTLD_PORT  45333   // Not 4533, a running rotor may have that
+
+// Pulses 500 - 2500 over 180 degrees, like data/config.ini
+static RotorServo servo;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_rotctld_parse(void) {
+    static const char *lines[] = {"P 180.25 45.50\n", "p\n", "\\set_pos 12.5 -0.25\n", "+\\get_pos\n"};
+    RotctldParser parser;
+    uint32_t requests = 0;
+    BenchResult result = bench("rotctld_parse", 200000, [&](uint32_t i) {
+        for (const char *c = lines[i % 4]; *c; ++c) requests += parser.feed(*c);
+    });
+    TEST_ASSERT_EQUAL(0, result.allocations);
+    TEST_ASSERT_TRUE(parser.request().valid);
+    TEST_ASSERT_GREATER_THAN(0, requests);
+}
+
+void test_rotctld_server(void) {
+    // A client sending bursts of pipelined commands over a loopback socket, like SatDump does
+    static const char burst[] = "P 180.25 45.50\np\nP 180.50 45.75\np\n\\get_pos\nP 180.75 46.00\n"
+                                "+\\get_pos\n\\dump_state\nP 181.00 46.25\np\nP 181.25 46.50\np\n"
+                                "P 181.50 46.75\np\nP 181.75 47.00\np\n";
+    const uint32_t commands = 16;
+    static RotctldServer server(BENCH_ROTCTLD_PORT);
+    server.poll(0.0, 0.0);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(native::hostPort(BENCH_ROTCTLD_PORT));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL(0, connect(client, (sockaddr *)&address, sizeof(address)));
+    while (!server.clients()) server.poll(0.0, 0.0);
+
+    char replies[4096];
+    uint32_t handled = server.commands(), bursts = 0, answered = 0;
+    BenchResult result = bench("rotctld_server (burst)", 5000, [&](uint32_t) {
+        bursts++;
+        send(client, burst, sizeof(burst) - 1, 0);
+        uint32_t until = server.commands() + commands;
+        while (server.commands() < until) server.poll(45.0, 180.0);
+        ssize_t n;
+        while ((n = recv(client, replies, sizeof(replies), MSG_DONTWAIT)) > 0) answered += n;
+    });
+    close(client);
+    server.poll(0.0, 0.0);
+    char line[120];
+    snprintf(line, sizeof(line), "%-24s %10.0f commands/s %8.2f allocs/command", "rotctld_server",
+             commands * 1e9 / result.ns, result.allocations / commands);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL(0, result.allocations);
+    TEST_ASSERT_EQUAL(bursts * commands, server.commands() - handled);
+    TEST_ASSERT_GREATER_THAN(0, answered);
+}
+
+void test_stellarium_parse(void) {
+    static JsonArena<STELLARIUM_ARENA_SIZE> arena;
+    JsonDocument doc(&arena);
+    StellariumSample sample;
+    MemoryStream body(STELLARIUM_STAR);
+    stellariumFilter();     // Built once, on the first call
+    bench("stellarium_parse", 20000, [&](uint32_t) {
+        body.rewind();
+        parseStellariumJson(body, doc, sample);
+    });
+    TEST_ASSERT_TRUE(sample.valid);
+    TEST_ASSERT_EQUAL_STRING("Vega", sample.name);
+}
+
+// How the object info was parsed before: the body copied into a String and parsed whole on the heap
+static bool parseWhole(MemoryStream &body, StellariumSample &sample) {
+    String payload;
+    payload.reserve(body.available());
+    for (int c; (c = body.read()) >= 0;) payload += (char)c;
+    JsonDocument doc;
+    if (deserializeJson(doc, payload)) return false;
+    sample.valid = doc["altitude"].is<float>() && doc["azimuth"].is<float>() && doc["localized-name"].is<const char *>();
+    if (sample.valid) strlcpy(sample.name, doc["localized-name"].as<const char *>(), sizeof(sample.name));
+    return sample.valid;
+}
+
+void test_stellarium_payloads(void) {
+    // Every payload the old and the new way: parse time, peak heap and what the arena needed
+    char line[160];
+    TEST_MESSAGE("payload            bytes   old ns  old heap   new ns  new heap  arena peak");
+    for (const StellariumPayload &payload : STELLARIUM_PAYLOADS) {
+        MemoryStream body(payload.body);
+        StellariumSample sample;
+        uint32_t operations = payload.name ? 2000 : 1;  // A failed parse is logged every time
+
+        size_t base = heapPeak = heapBytes;
+        BenchResult old = bench("", operations, [&](uint32_t) {
+            body.rewind();
+            parseWhole(body, sample);
+        });
+        size_t oldHeap = heapPeak - base;
+
+        static JsonArena<STELLARIUM_ARENA_SIZE> arena;
+        JsonDocument doc(&arena);
+        size_t bytes = 0;
+        base = heapPeak = heapBytes;
+        BenchResult now = bench("", operations, [&](uint32_t) {
+            doc.clear();
+            arena.reset();
+            LimitedStream limited(body, strlen(payload.body));
+            body.rewind();
+            parseStellariumJson(limited, doc, sample);
+            limited.drain();
+            bytes = limited.count();
+        });
+        size_t newHeap = heapPeak - base;
+
+        snprintf(line, sizeof(line), "%-16s %7u %8.0f %9u %8.0f %9u %11u", payload.kind, (unsigned)bytes, old.ns,
+                 (unsigned)oldHeap, now.ns, (unsigned)newHeap, (unsigned)arena.peak());
+        TEST_MESSAGE(line);
+
+        // The filtered document fits the arena and the heap is not touched
+        TEST_ASSERT_EQUAL_MESSAGE(0, arena.failures(), payload.kind);
+        TEST_ASSERT_EQUAL_MESSAGE(0, now.allocations, payload.kind);
+        TEST_ASSERT_EQUAL_MESSAGE(strlen(payload.body), bytes, payload.kind);
+        TEST_ASSERT_EQUAL_MESSAGE(payload.name != nullptr, sample.valid, payload.kind);
+        if (payload.name) TEST_ASSERT_EQUAL_STRING_MESSAGE(payload.name, sample.name, payload.kind);
+    }
+}
+
+void test_degrees(void) {
+    float sum = 0.0;
+    BenchResult result = bench("moveToDegrees/getDegrees", 500000, [&](uint32_t i) {
+        servo.moveToDegrees((i % 1800) / 10.0f);
+        sum += servo.getDegrees();
+    });
+    TEST_ASSERT_EQUAL(0, result.allocations);
+    TEST_ASSERT_TRUE(sum > 0.0);
+}
+
+void test_data_serialization(void) {
+    PageData page;
+    page.altitude = 45.25;
+    page.azimuth = 180.5;
+    page.currAlt = 45.0;
+    page.currAz = 180.0;
+    page.tracking = page.valid = page.visible = true;
+    strlcpy(page.name, "NOAA 19", sizeof(page.name));
+    strlcpy(page.source, "rotctld", sizeof(page.source));
+    char buffer[PAGE_JSON_SIZE];
+    size_t length = 0;
+    bench("data_serialization", 20000, [&](uint32_t i) {
+        page.altitude = (i % 900) / 10.0f;
+        length = serializePage(page, buffer, sizeof(buffer));
+    });
+    TEST_ASSERT_GREATER_THAN(0, length);
+    TEST_ASSERT_LESS_THAN(sizeof(buffer), length);
+}
+
+void test_servo_run(void) {
+    // A target moving at 2 degrees/s, a motion step every 20 ms of virtual time
+    BenchResult result = bench("RotorServo::run", 200000, [&](uint32_t i) {
+        native::advance(UPDATE_INTERVAL * 1000);
+        servo.moveToDegrees(10.0f + (i % 4000) * 0.04f);
+        servo.run();
+    });
+    TEST_ASSERT_EQUAL(0, result.allocations);
+}
+
+int main(int argc, char **argv) {
+    native::useVirtualClock();
+    servo.init(16, 0, 500, 2500, 180, 1, 0.0);
+    servo.smooth(true);
+    UNITY_BEGIN();
+    RUN_TEST(test_rotctld_parse);
+    RUN_TEST(test_rotctld_server);
+    RUN_TEST(test_stellarium_parse);
+    RUN_TEST(test_stellarium_payloads);
+    RUN_TEST(test_degrees);
+    RUN_TEST(test_data_serialization);
+    RUN_TEST(test_servo_run);
+    return UNITY_END();
+}
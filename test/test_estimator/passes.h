@@ -0,0 +1,1686 @@
+// Target samples of three ISS passes, the way Stellarium or rotctld hand them to the rotor: about
+// once a second with some jitter, in degrees with two decimals. They were recorded from the SGP4 of
+// include/sgp4.h rather than a live session, so the test can compute the true position between
+// the samples from the same elements.
+#pragma once
+
+#define PASS_TLE_NAME   "ISS (ZARYA)"
+#define PASS_TLE_LINE1  "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927"
+#define PASS_TLE_LINE2  "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537"
+
+struct PassSample {
+    long  ms;           // since the first sample
+    float alt, az;      // degrees
+};
+
+// 52N 5E, nearly overhead (83.7 degrees), the azimuth turns 10 degrees/s at the top
+static const PassSample PASS_OVERHEAD[] = {
+    {0, 0.00, 272.58},
+    {924, 0.06, 272.58},
+    {1847, 0.12, 272.58},
+    {2853, 0.19, 272.58},
+    {3874, 0.25, 272.58},
+    {4939, 0.32, 272.58},
+    {5877, 0.38, 272.58},
+    {6877, 0.44, 272.58},
+    {7884, 0.51, 272.58},
+    {8899, 0.57, 272.58},
+    {9944, 0.64, 272.58},
+    {10871, 0.70, 272.57},
+    {11910, 0.77, 272.57},
+    {12984, 0.84, 272.57},
+    {13916, 0.90, 272.57},
+    {14947, 0.97, 272.57},
+    {15941, 1.03, 272.57},
+    {16925, 1.10, 272.57},
+    {17998, 1.17, 272.57},
+    {18983, 1.24, 272.57},
+    {20055, 1.31, 272.57},
+    {21133, 1.38, 272.57},
+    {22159, 1.45, 272.57},
+    {23147, 1.52, 272.57},
+    {24147, 1.59, 272.57},
+    {25113, 1.65, 272.57},
+    {26101, 1.72, 272.56},
+    {27129, 1.79, 272.56},
+    {28074, 1.86, 272.56},
+    {29009, 1.92, 272.56},
+    {30065, 2.00, 272.56},
+    {31035, 2.06, 272.56},
+    {31957, 2.13, 272.56},
+    {32952, 2.20, 272.56},
+    {33919, 2.27, 272.56},
+    {34930, 2.34, 272.56},
+    {36003, 2.42, 272.55},
+    {36926, 2.48, 272.55},
+    {37970, 2.56, 272.55},
+    {38939, 2.63, 272.55},
+    {39911, 2.70, 272.55},
+    {40983, 2.78, 272.55},
+    {41990, 2.85, 272.55},
+    {43016, 2.93, 272.54},
+    {44041, 3.00, 272.54},
+    {45060, 3.08, 272.54},
+    {46006, 3.15, 272.54},
+    {47074, 3.23, 272.54},
+    {48116, 3.31, 272.54},
+    {49110, 3.38, 272.53},
+    {50146, 3.46, 272.53},
+    {51120, 3.54, 272.53},
+    {52154, 3.62, 272.53},
+    {53166, 3.69, 272.53},
+    {54207, 3.77, 272.53},
+    {55198, 3.85, 272.52},
+    {56151, 3.93, 272.52},
+    {57145, 4.00, 272.52},
+    {58172, 4.09, 272.52},
+    {59175, 4.17, 272.52},
+    {60234, 4.25, 272.51},
+    {61217, 4.33, 272.51},
+    {62285, 4.41, 272.51},
+    {63323, 4.50, 272.51},
+    {64266, 4.58, 272.50},
+    {65295, 4.66, 272.50},
+    {66272, 4.74, 272.50},
+    {67250, 4.82, 272.50},
+    {68296, 4.91, 272.49},
+    {69343, 4.99, 272.49},
+    {70292, 5.07, 272.49},
+    {71232, 5.15, 272.49},
+    {72217, 5.24, 272.48},
+    {73276, 5.33, 272.48},
+    {74311, 5.42, 272.48},
+    {75316, 5.50, 272.47},
+    {76276, 5.59, 272.47},
+    {77259, 5.67, 272.47},
+    {78318, 5.76, 272.47},
+    {79368, 5.86, 272.46},
+    {80348, 5.94, 272.46},
+    {81401, 6.04, 272.46},
+    {82431, 6.13, 272.45},
+    {83435, 6.22, 272.45},
+    {84498, 6.32, 272.45},
+    {85519, 6.41, 272.44},
+    {86586, 6.51, 272.44},
+    {87568, 6.60, 272.43},
+    {88613, 6.69, 272.43},
+    {89665, 6.79, 272.43},
+    {90601, 6.88, 272.42},
+    {91619, 6.98, 272.42},
+    {92636, 7.07, 272.42},
+    {93574, 7.16, 272.41},
+    {94586, 7.26, 272.41},
+    {95648, 7.36, 272.40},
+    {96583, 7.45, 272.40},
+    {97548, 7.55, 272.39},
+    {98592, 7.65, 272.39},
+    {99628, 7.76, 272.39},
+    {100609, 7.85, 272.38},
+    {101558, 7.95, 272.38},
+    {102524, 8.05, 272.37},
+    {103585, 8.16, 272.37},
+    {104568, 8.26, 272.36},
+    {105612, 8.36, 272.36},
+    {106646, 8.47, 272.35},
+    {107581, 8.57, 272.35},
+    {108619, 8.68, 272.34},
+    {109673, 8.79, 272.34},
+    {110682, 8.90, 272.33},
+    {111637, 9.00, 272.33},
+    {112701, 9.12, 272.32},
+    {113685, 9.23, 272.31},
+    {114638, 9.33, 272.31},
+    {115666, 9.44, 272.30},
+    {116717, 9.56, 272.30},
+    {117796, 9.68, 272.29},
+    {118717, 9.79, 272.28},
+    {119742, 9.91, 272.28},
+    {120666, 10.01, 272.27},
+    {121643, 10.13, 272.26},
+    {122581, 10.24, 272.26},
+    {123582, 10.35, 272.25},
+    {124647, 10.48, 272.24},
+    {125724, 10.61, 272.24},
+    {126693, 10.73, 272.23},
+    {127668, 10.84, 272.22},
+    {128736, 10.97, 272.21},
+    {129800, 11.11, 272.21},
+    {130750, 11.23, 272.20},
+    {131785, 11.36, 272.19},
+    {132801, 11.48, 272.18},
+    {133789, 11.61, 272.18},
+    {134765, 11.74, 272.17},
+    {135841, 11.88, 272.16},
+    {136884, 12.01, 272.15},
+    {137908, 12.15, 272.14},
+    {138900, 12.28, 272.13},
+    {139897, 12.42, 272.12},
+    {140896, 12.55, 272.11},
+    {141876, 12.69, 272.11},
+    {142853, 12.82, 272.10},
+    {143923, 12.97, 272.09},
+    {144905, 13.11, 272.08},
+    {145844, 13.24, 272.07},
+    {146864, 13.39, 272.06},
+    {147891, 13.54, 272.05},
+    {148883, 13.68, 272.04},
+    {149939, 13.84, 272.03},
+    {150882, 13.98, 272.01},
+    {151823, 14.12, 272.00},
+    {152839, 14.28, 271.99},
+    {153850, 14.43, 271.98},
+    {154872, 14.59, 271.97},
+    {155865, 14.74, 271.96},
+    {156859, 14.90, 271.95},
+    {157871, 15.06, 271.93},
+    {158849, 15.22, 271.92},
+    {159870, 15.39, 271.91},
+    {160810, 15.54, 271.90},
+    {161780, 15.70, 271.88},
+    {162730, 15.86, 271.87},
+    {163742, 16.04, 271.86},
+    {164663, 16.19, 271.85},
+    {165599, 16.36, 271.83},
+    {166658, 16.54, 271.82},
+    {167618, 16.71, 271.80},
+    {168684, 16.90, 271.79},
+    {169619, 17.07, 271.77},
+    {170596, 17.25, 271.76},
+    {171604, 17.44, 271.74},
+    {172526, 17.61, 271.73},
+    {173481, 17.79, 271.71},
+    {174425, 17.97, 271.70},
+    {175468, 18.17, 271.68},
+    {176424, 18.36, 271.66},
+    {177347, 18.54, 271.65},
+    {178320, 18.74, 271.63},
+    {179334, 18.94, 271.61},
+    {180315, 19.14, 271.59},
+    {181343, 19.36, 271.57},
+    {182379, 19.58, 271.55},
+    {183318, 19.78, 271.53},
+    {184254, 19.98, 271.51},
+    {185271, 20.20, 271.49},
+    {186212, 20.41, 271.47},
+    {187195, 20.63, 271.45},
+    {188128, 20.84, 271.43},
+    {189092, 21.06, 271.41},
+    {190135, 21.30, 271.39},
+    {191098, 21.53, 271.36},
+    {192102, 21.77, 271.34},
+    {193074, 22.00, 271.32},
+    {194060, 22.24, 271.29},
+    {195097, 22.50, 271.27},
+    {196135, 22.76, 271.24},
+    {197076, 23.00, 271.21},
+    {198099, 23.27, 271.19},
+    {199177, 23.55, 271.16},
+    {200112, 23.80, 271.13},
+    {201071, 24.06, 271.10},
+    {202053, 24.33, 271.07},
+    {203111, 24.62, 271.04},
+    {204180, 24.93, 271.01},
+    {205167, 25.21, 270.98},
+    {206181, 25.50, 270.94},
+    {207168, 25.80, 270.91},
+    {208124, 26.08, 270.88},
+    {209077, 26.37, 270.84},
+    {210111, 26.69, 270.81},
+    {211148, 27.02, 270.77},
+    {212204, 27.36, 270.73},
+    {213174, 27.67, 270.69},
+    {214162, 28.00, 270.65},
+    {215145, 28.32, 270.61},
+    {216219, 28.69, 270.57},
+    {217163, 29.02, 270.53},
+    {218168, 29.37, 270.48},
+    {219246, 29.76, 270.43},
+    {220282, 30.13, 270.39},
+    {221250, 30.49, 270.34},
+    {222222, 30.86, 270.29},
+    {223251, 31.25, 270.24},
+    {224234, 31.63, 270.19},
+    {225287, 32.05, 270.13},
+    {226290, 32.45, 270.07},
+    {227343, 32.89, 270.01},
+    {228365, 33.31, 269.95},
+    {229404, 33.75, 269.89},
+    {230437, 34.20, 269.83},
+    {231508, 34.68, 269.76},
+    {232502, 35.12, 269.69},
+    {233555, 35.60, 269.62},
+    {234477, 36.03, 269.55},
+    {235505, 36.52, 269.48},
+    {236434, 36.97, 269.40},
+    {237492, 37.49, 269.32},
+    {238430, 37.96, 269.24},
+    {239437, 38.48, 269.16},
+    {240448, 39.00, 269.07},
+    {241508, 39.56, 268.97},
+    {242458, 40.08, 268.88},
+    {243473, 40.64, 268.79},
+    {244514, 41.22, 268.68},
+    {245578, 41.83, 268.57},
+    {246522, 42.38, 268.46},
+    {247471, 42.94, 268.35},
+    {248481, 43.55, 268.23},
+    {249476, 44.17, 268.11},
+    {250450, 44.78, 267.98},
+    {251465, 45.43, 267.85},
+    {252466, 46.08, 267.70},
+    {253496, 46.76, 267.55},
+    {254508, 47.45, 267.40},
+    {255475, 48.12, 267.24},
+    {256451, 48.80, 267.07},
+    {257503, 49.55, 266.88},
+    {258451, 50.25, 266.71},
+    {259487, 51.02, 266.50},
+    {260431, 51.73, 266.30},
+    {261434, 52.50, 266.08},
+    {262414, 53.27, 265.86},
+    {263387, 54.04, 265.62},
+    {264319, 54.80, 265.38},
+    {265269, 55.58, 265.12},
+    {266222, 56.38, 264.84},
+    {267293, 57.29, 264.51},
+    {268259, 58.12, 264.19},
+    {269223, 58.97, 263.85},
+    {270285, 59.91, 263.44},
+    {271333, 60.86, 263.02},
+    {272391, 61.84, 262.55},
+    {273360, 62.74, 262.09},
+    {274306, 63.64, 261.60},
+    {275365, 64.65, 261.00},
+    {276382, 65.63, 260.38},
+    {277450, 66.68, 259.66},
+    {278387, 67.61, 258.97},
+    {279332, 68.55, 258.20},
+    {280274, 69.50, 257.36},
+    {281261, 70.50, 256.38},
+    {282264, 71.53, 255.26},
+    {283230, 72.51, 254.06},
+    {284259, 73.57, 252.60},
+    {285234, 74.57, 251.03},
+    {286289, 75.64, 249.08},
+    {287278, 76.64, 246.94},
+    {288267, 77.63, 244.45},
+    {289246, 78.59, 241.55},
+    {290175, 79.47, 238.31},
+    {291169, 80.37, 234.18},
+    {292146, 81.21, 229.29},
+    {293122, 81.97, 223.42},
+    {294075, 82.62, 216.57},
+    {295119, 83.19, 207.70},
+    {296175, 83.58, 197.35},
+    {297124, 83.73, 187.25},
+    {298120, 83.67, 176.49},
+    {299095, 83.41, 166.46},
+    {300127, 82.94, 156.97},
+    {301076, 82.36, 149.47},
+    {302138, 81.58, 142.45},
+    {303178, 80.72, 136.80},
+    {304109, 79.89, 132.61},
+    {305161, 78.91, 128.66},
+    {306096, 78.01, 125.71},
+    {307092, 77.02, 123.04},
+    {308103, 76.00, 120.74},
+    {309056, 75.03, 118.86},
+    {310094, 73.97, 117.09},
+    {311086, 72.95, 115.61},
+    {312135, 71.88, 114.24},
+    {313122, 70.87, 113.10},
+    {314136, 69.84, 112.05},
+    {315186, 68.78, 111.08},
+    {316205, 67.76, 110.24},
+    {317275, 66.69, 109.44},
+    {318231, 65.75, 108.79},
+    {319218, 64.80, 108.18},
+    {320148, 63.90, 107.64},
+    {321160, 62.94, 107.11},
+    {322217, 61.95, 106.60},
+    {323184, 61.06, 106.16},
+    {324263, 60.08, 105.72},
+    {325255, 59.19, 105.33},
+    {326183, 58.37, 105.00},
+    {327168, 57.51, 104.67},
+    {328191, 56.64, 104.34},
+    {329157, 55.82, 104.06},
+    {330209, 54.95, 103.76},
+    {331164, 54.18, 103.51},
+    {332166, 53.37, 103.27},
+    {333238, 52.53, 103.01},
+    {334289, 51.72, 102.78},
+    {335358, 50.91, 102.56},
+    {336364, 50.17, 102.36},
+    {337424, 49.40, 102.16},
+    {338412, 48.69, 101.99},
+    {339412, 47.99, 101.82},
+    {340405, 47.30, 101.66},
+    {341462, 46.59, 101.50},
+    {342507, 45.90, 101.34},
+    {343530, 45.23, 101.20},
+    {344548, 44.58, 101.07},
+    {345546, 43.96, 100.94},
+    {346558, 43.34, 100.81},
+    {347582, 42.72, 100.69},
+    {348638, 42.10, 100.57},
+    {349563, 41.56, 100.47},
+    {350571, 40.99, 100.37},
+    {351571, 40.43, 100.27},
+    {352498, 39.92, 100.18},
+    {353527, 39.37, 100.08},
+    {354496, 38.86, 99.99},
+    {355524, 38.32, 99.90},
+    {356515, 37.82, 99.82},
+    {357495, 37.33, 99.74},
+    {358416, 36.88, 99.67},
+    {359459, 36.37, 99.59},
+    {360406, 35.92, 99.52},
+    {361413, 35.46, 99.45},
+    {362460, 34.98, 99.38},
+    {363484, 34.52, 99.31},
+    {364414, 34.11, 99.25},
+    {365459, 33.66, 99.18},
+    {366407, 33.25, 99.12},
+    {367459, 32.81, 99.06},
+    {368386, 32.43, 99.01},
+    {369458, 32.00, 98.95},
+    {370478, 31.59, 98.90},
+    {371438, 31.22, 98.85},
+    {372468, 30.83, 98.79},
+    {373447, 30.46, 98.74},
+    {374403, 30.10, 98.70},
+    {375448, 29.72, 98.65},
+    {376443, 29.36, 98.60},
+    {377395, 29.03, 98.56},
+    {378318, 28.71, 98.52},
+    {379393, 28.34, 98.48},
+    {380322, 28.03, 98.44},
+    {381395, 27.67, 98.40},
+    {382388, 27.35, 98.36},
+    {383453, 27.01, 98.32},
+    {384464, 26.69, 98.28},
+    {385538, 26.36, 98.24},
+    {386477, 26.07, 98.21},
+    {387441, 25.78, 98.17},
+    {388475, 25.47, 98.14},
+    {389396, 25.20, 98.11},
+    {390389, 24.92, 98.08},
+    {391451, 24.62, 98.04},
+    {392374, 24.36, 98.02},
+    {393389, 24.08, 97.99},
+    {394378, 23.81, 97.96},
+    {395366, 23.55, 97.93},
+    {396418, 23.27, 97.90},
+    {397450, 23.00, 97.87},
+    {398402, 22.76, 97.85},
+    {399462, 22.49, 97.82},
+    {400497, 22.23, 97.79},
+    {401518, 21.98, 97.77},
+    {402470, 21.75, 97.74},
+    {403430, 21.52, 97.72},
+    {404411, 21.29, 97.70},
+    {405413, 21.05, 97.67},
+    {406382, 20.83, 97.65},
+    {407358, 20.61, 97.63},
+    {408306, 20.39, 97.61},
+    {409340, 20.17, 97.59},
+    {410411, 19.93, 97.57},
+    {411435, 19.71, 97.55},
+    {412359, 19.51, 97.53},
+    {413426, 19.29, 97.51},
+    {414397, 19.09, 97.49},
+    {415444, 18.87, 97.47},
+    {416405, 18.68, 97.45},
+    {417452, 18.47, 97.43},
+    {418379, 18.28, 97.42},
+    {419450, 18.07, 97.40},
+    {420445, 17.88, 97.38},
+    {421451, 17.69, 97.36},
+    {422375, 17.51, 97.35},
+    {423333, 17.34, 97.33},
+    {424366, 17.14, 97.32},
+    {425386, 16.96, 97.30},
+    {426351, 16.78, 97.29},
+    {427430, 16.59, 97.27},
+    {428422, 16.42, 97.26},
+    {429431, 16.24, 97.24},
+    {430495, 16.06, 97.23},
+    {431492, 15.89, 97.21},
+    {432431, 15.73, 97.20},
+    {433443, 15.56, 97.19},
+    {434463, 15.39, 97.17},
+    {435416, 15.23, 97.16},
+    {436374, 15.08, 97.15},
+    {437363, 14.92, 97.14},
+    {438372, 14.76, 97.13},
+    {439338, 14.61, 97.11},
+    {440325, 14.45, 97.10},
+    {441371, 14.29, 97.09},
+    {442443, 14.13, 97.08},
+    {443406, 13.98, 97.07},
+    {444438, 13.83, 97.06},
+    {445507, 13.67, 97.05},
+    {446472, 13.53, 97.04},
+    {447438, 13.38, 97.03},
+    {448367, 13.25, 97.02},
+    {449388, 13.10, 97.01},
+    {450440, 12.96, 97.00},
+    {451481, 12.81, 96.99},
+    {452559, 12.66, 96.98},
+    {453564, 12.52, 96.97},
+    {454583, 12.38, 96.96},
+    {455617, 12.24, 96.95},
+    {456637, 12.11, 96.94},
+    {457624, 11.98, 96.93},
+    {458613, 11.85, 96.92},
+    {459622, 11.71, 96.91},
+    {460652, 11.58, 96.90},
+    {461578, 11.46, 96.90},
+    {462510, 11.34, 96.89},
+    {463584, 11.21, 96.88},
+    {464528, 11.09, 96.87},
+    {465531, 10.96, 96.87},
+    {466523, 10.84, 96.86},
+    {467449, 10.73, 96.85},
+    {468469, 10.60, 96.84},
+    {469478, 10.48, 96.84},
+    {470520, 10.36, 96.83},
+    {471598, 10.23, 96.82},
+    {472646, 10.11, 96.82},
+    {473684, 9.99, 96.81},
+    {474623, 9.88, 96.80},
+    {475558, 9.77, 96.80},
+    {476510, 9.66, 96.79},
+    {477564, 9.54, 96.78},
+    {478527, 9.44, 96.78},
+    {479519, 9.32, 96.77},
+    {480497, 9.22, 96.77},
+    {481575, 9.10, 96.76},
+    {482539, 8.99, 96.75},
+    {483616, 8.88, 96.75},
+    {484573, 8.77, 96.74},
+    {485627, 8.66, 96.74},
+    {486615, 8.56, 96.73},
+    {487647, 8.45, 96.73},
+    {488578, 8.35, 96.72},
+    {489552, 8.25, 96.72},
+    {490547, 8.15, 96.71},
+    {491625, 8.04, 96.71},
+    {492619, 7.93, 96.70},
+    {493640, 7.83, 96.70},
+    {494602, 7.73, 96.69},
+    {495626, 7.63, 96.69},
+    {496568, 7.54, 96.68},
+    {497534, 7.44, 96.68},
+    {498482, 7.35, 96.68},
+    {499540, 7.25, 96.67},
+    {500551, 7.15, 96.67},
+    {501579, 7.05, 96.66},
+    {502655, 6.95, 96.66},
+    {503626, 6.86, 96.65},
+    {504673, 6.76, 96.65},
+    {505665, 6.67, 96.65},
+    {506590, 6.58, 96.64},
+    {507529, 6.49, 96.64},
+    {508565, 6.40, 96.64},
+    {509536, 6.31, 96.63},
+    {510607, 6.21, 96.63},
+    {511577, 6.12, 96.62},
+    {512644, 6.03, 96.62},
+    {513640, 5.94, 96.62},
+    {514584, 5.85, 96.61},
+    {515519, 5.77, 96.61},
+    {516559, 5.68, 96.61},
+    {517582, 5.59, 96.60},
+    {518636, 5.50, 96.60},
+    {519561, 5.42, 96.60},
+    {520511, 5.34, 96.60},
+    {521480, 5.25, 96.59},
+    {522480, 5.17, 96.59},
+    {523540, 5.08, 96.59},
+    {524589, 4.99, 96.58},
+    {525621, 4.90, 96.58},
+    {526664, 4.82, 96.58},
+    {527707, 4.73, 96.58},
+    {528752, 4.64, 96.57},
+    {529793, 4.56, 96.57},
+    {530772, 4.48, 96.57},
+    {531695, 4.40, 96.57},
+    {532727, 4.32, 96.56},
+    {533791, 4.23, 96.56},
+    {534792, 4.15, 96.56},
+    {535802, 4.07, 96.56},
+    {536845, 3.99, 96.55},
+    {537830, 3.91, 96.55},
+    {538879, 3.83, 96.55},
+    {539804, 3.76, 96.55},
+    {540830, 3.68, 96.55},
+    {541887, 3.60, 96.54},
+    {542931, 3.52, 96.54},
+    {543985, 3.44, 96.54},
+    {545049, 3.35, 96.54},
+    {546092, 3.28, 96.54},
+    {547055, 3.20, 96.53},
+    {548096, 3.12, 96.53},
+    {549140, 3.05, 96.53},
+    {550138, 2.97, 96.53},
+    {551153, 2.90, 96.53},
+    {552229, 2.82, 96.53},
+    {553157, 2.75, 96.53},
+    {554212, 2.67, 96.52},
+    {555158, 2.60, 96.52},
+    {556158, 2.53, 96.52},
+    {557227, 2.45, 96.52},
+    {558211, 2.38, 96.52},
+    {559240, 2.31, 96.52},
+    {560247, 2.24, 96.52},
+    {561199, 2.17, 96.51},
+    {562264, 2.09, 96.51},
+    {563278, 2.02, 96.51},
+    {564200, 1.96, 96.51},
+    {565171, 1.89, 96.51},
+    {566195, 1.82, 96.51},
+    {567265, 1.74, 96.51},
+    {568263, 1.67, 96.51},
+    {569341, 1.60, 96.51},
+    {570365, 1.53, 96.50},
+    {571300, 1.46, 96.50},
+    {572255, 1.40, 96.50},
+    {573258, 1.33, 96.50},
+    {574305, 1.26, 96.50},
+    {575378, 1.19, 96.50},
+    {576455, 1.12, 96.50},
+    {577509, 1.05, 96.50},
+    {578531, 0.98, 96.50},
+    {579524, 0.91, 96.50},
+    {580581, 0.84, 96.50},
+    {581530, 0.78, 96.50},
+    {582481, 0.72, 96.49},
+    {583503, 0.65, 96.49},
+    {584466, 0.59, 96.49},
+    {585485, 0.52, 96.49},
+    {586414, 0.46, 96.49},
+    {587425, 0.40, 96.49},
+    {588484, 0.33, 96.49},
+    {589429, 0.27, 96.49},
+    {590462, 0.20, 96.49},
+    {591518, 0.13, 96.49},
+    {592458, 0.07, 96.49},
+    {593515, 0.01, 96.49},
+};
+
+// 52N 5E, up to 33.8 degrees in the south
+static const PassSample PASS_MEDIUM[] = {
+    {0, 0.00, 231.11},
+    {924, 0.06, 231.07},
+    {1847, 0.12, 231.03},
+    {2853, 0.18, 230.98},
+    {3874, 0.24, 230.94},
+    {4939, 0.31, 230.89},
+    {5877, 0.37, 230.85},
+    {6877, 0.43, 230.80},
+    {7884, 0.49, 230.76},
+    {8899, 0.56, 230.71},
+    {9944, 0.62, 230.66},
+    {10871, 0.68, 230.62},
+    {11910, 0.75, 230.57},
+    {12984, 0.82, 230.52},
+    {13916, 0.88, 230.48},
+    {14947, 0.94, 230.43},
+    {15941, 1.01, 230.38},
+    {16925, 1.07, 230.33},
+    {17998, 1.14, 230.28},
+    {18983, 1.21, 230.23},
+    {20055, 1.28, 230.18},
+    {21133, 1.35, 230.12},
+    {22159, 1.41, 230.07},
+    {23147, 1.48, 230.02},
+    {24147, 1.55, 229.97},
+    {25113, 1.61, 229.92},
+    {26101, 1.68, 229.87},
+    {27129, 1.75, 229.82},
+    {28074, 1.81, 229.77},
+    {29009, 1.87, 229.72},
+    {30065, 1.94, 229.66},
+    {31035, 2.01, 229.61},
+    {31957, 2.07, 229.56},
+    {32952, 2.14, 229.51},
+    {33919, 2.21, 229.45},
+    {34930, 2.28, 229.40},
+    {36003, 2.35, 229.34},
+    {36926, 2.42, 229.29},
+    {37970, 2.49, 229.23},
+    {38939, 2.56, 229.17},
+    {39911, 2.62, 229.12},
+    {40983, 2.70, 229.06},
+    {41990, 2.77, 229.00},
+    {43016, 2.84, 228.94},
+    {44041, 2.92, 228.88},
+    {45060, 2.99, 228.82},
+    {46006, 3.06, 228.76},
+    {47074, 3.14, 228.70},
+    {48116, 3.21, 228.63},
+    {49110, 3.28, 228.57},
+    {50146, 3.36, 228.51},
+    {51120, 3.43, 228.45},
+    {52154, 3.51, 228.38},
+    {53166, 3.58, 228.32},
+    {54207, 3.66, 228.25},
+    {55198, 3.73, 228.19},
+    {56151, 3.80, 228.12},
+    {57145, 3.88, 228.06},
+    {58172, 3.96, 227.99},
+    {59175, 4.03, 227.92},
+    {60234, 4.11, 227.85},
+    {61217, 4.19, 227.79},
+    {62285, 4.27, 227.71},
+    {63323, 4.35, 227.64},
+    {64266, 4.42, 227.58},
+    {65295, 4.50, 227.50},
+    {66272, 4.58, 227.44},
+    {67250, 4.66, 227.37},
+    {68296, 4.74, 227.29},
+    {69343, 4.82, 227.21},
+    {70292, 4.90, 227.15},
+    {71232, 4.97, 227.08},
+    {72217, 5.05, 227.00},
+    {73276, 5.14, 226.92},
+    {74311, 5.22, 226.85},
+    {75316, 5.31, 226.77},
+    {76276, 5.38, 226.69},
+    {77259, 5.46, 226.62},
+    {78318, 5.55, 226.54},
+    {79368, 5.64, 226.45},
+    {80348, 5.72, 226.37},
+    {81401, 5.81, 226.29},
+    {82431, 5.90, 226.21},
+    {83435, 5.98, 226.12},
+    {84498, 6.07, 226.04},
+    {85519, 6.16, 225.95},
+    {86586, 6.25, 225.86},
+    {87568, 6.34, 225.78},
+    {88613, 6.43, 225.69},
+    {89665, 6.52, 225.60},
+    {90601, 6.60, 225.52},
+    {91619, 6.69, 225.43},
+    {92636, 6.78, 225.33},
+    {93574, 6.87, 225.25},
+    {94586, 6.96, 225.16},
+    {95648, 7.05, 225.06},
+    {96583, 7.14, 224.98},
+    {97548, 7.22, 224.89},
+    {98592, 7.32, 224.79},
+    {99628, 7.42, 224.69},
+    {100609, 7.51, 224.59},
+    {101558, 7.60, 224.50},
+    {102524, 7.69, 224.41},
+    {103585, 7.79, 224.30},
+    {104568, 7.88, 224.21},
+    {105612, 7.98, 224.10},
+    {106646, 8.08, 224.00},
+    {107581, 8.17, 223.90},
+    {108619, 8.27, 223.79},
+    {109673, 8.37, 223.68},
+    {110682, 8.47, 223.57},
+    {111637, 8.56, 223.47},
+    {112701, 8.67, 223.36},
+    {113685, 8.77, 223.25},
+    {114638, 8.86, 223.14},
+    {115666, 8.96, 223.03},
+    {116717, 9.07, 222.91},
+    {117796, 9.18, 222.79},
+    {118717, 9.28, 222.68},
+    {119742, 9.38, 222.57},
+    {120666, 9.48, 222.46},
+    {121643, 9.58, 222.34},
+    {122581, 9.68, 222.23},
+    {123582, 9.78, 222.11},
+    {124647, 9.90, 221.98},
+    {125724, 10.01, 221.85},
+    {126693, 10.12, 221.72},
+    {127668, 10.22, 221.60},
+    {128736, 10.34, 221.47},
+    {129800, 10.46, 221.33},
+    {130750, 10.56, 221.20},
+    {131785, 10.67, 221.07},
+    {132801, 10.79, 220.93},
+    {133789, 10.90, 220.80},
+    {134765, 11.01, 220.67},
+    {135841, 11.13, 220.52},
+    {136884, 11.25, 220.37},
+    {137908, 11.37, 220.23},
+    {138900, 11.49, 220.09},
+    {139897, 11.60, 219.94},
+    {140896, 11.72, 219.80},
+    {141876, 11.84, 219.65},
+    {142853, 11.95, 219.51},
+    {143923, 12.08, 219.35},
+    {144905, 12.20, 219.20},
+    {145844, 12.32, 219.05},
+    {146864, 12.44, 218.89},
+    {147891, 12.57, 218.73},
+    {148883, 12.69, 218.57},
+    {149939, 12.82, 218.40},
+    {150882, 12.94, 218.25},
+    {151823, 13.06, 218.09},
+    {152839, 13.19, 217.92},
+    {153850, 13.32, 217.75},
+    {154872, 13.45, 217.58},
+    {155865, 13.58, 217.40},
+    {156859, 13.71, 217.23},
+    {157871, 13.85, 217.05},
+    {158849, 13.98, 216.87},
+    {159870, 14.11, 216.69},
+    {160810, 14.24, 216.52},
+    {161780, 14.37, 216.33},
+    {162730, 14.50, 216.15},
+    {163742, 14.64, 215.96},
+    {164663, 14.77, 215.78},
+    {165599, 14.90, 215.60},
+    {166658, 15.05, 215.39},
+    {167618, 15.18, 215.20},
+    {168684, 15.33, 214.98},
+    {169619, 15.47, 214.79},
+    {170596, 15.61, 214.59},
+    {171604, 15.75, 214.37},
+    {172526, 15.89, 214.18},
+    {173481, 16.03, 213.97},
+    {174425, 16.17, 213.76},
+    {175468, 16.33, 213.53},
+    {176424, 16.47, 213.32},
+    {177347, 16.61, 213.11},
+    {178320, 16.76, 212.88},
+    {179334, 16.91, 212.65},
+    {180315, 17.06, 212.41},
+    {181343, 17.22, 212.17},
+    {182379, 17.39, 211.92},
+    {183318, 17.53, 211.68},
+    {184254, 17.68, 211.45},
+    {185271, 17.85, 211.19},
+    {186212, 18.00, 210.95},
+    {187195, 18.16, 210.70},
+    {188128, 18.31, 210.45},
+    {189092, 18.47, 210.20},
+    {190135, 18.64, 209.91},
+    {191098, 18.80, 209.65},
+    {192102, 18.97, 209.37},
+    {193074, 19.13, 209.10},
+    {194060, 19.30, 208.82},
+    {195097, 19.47, 208.52},
+    {196135, 19.65, 208.21},
+    {197076, 19.81, 207.93},
+    {198099, 19.99, 207.62},
+    {199177, 20.18, 207.29},
+    {200112, 20.34, 207.00},
+    {201071, 20.51, 206.70},
+    {202053, 20.69, 206.38},
+    {203111, 20.88, 206.04},
+    {204180, 21.07, 205.69},
+    {205167, 21.25, 205.36},
+    {206181, 21.43, 205.01},
+    {207168, 21.61, 204.67},
+    {208124, 21.79, 204.34},
+    {209077, 21.97, 204.00},
+    {210111, 22.16, 203.63},
+    {211148, 22.35, 203.25},
+    {212204, 22.55, 202.86},
+    {213174, 22.73, 202.50},
+    {214162, 22.92, 202.12},
+    {215145, 23.11, 201.74},
+    {216219, 23.31, 201.32},
+    {217163, 23.49, 200.94},
+    {218168, 23.69, 200.53},
+    {219246, 23.89, 200.09},
+    {220282, 24.10, 199.66},
+    {221250, 24.28, 199.25},
+    {222222, 24.47, 198.83},
+    {223251, 24.67, 198.38},
+    {224234, 24.87, 197.95},
+    {225287, 25.07, 197.47},
+    {226290, 25.27, 197.02},
+    {227343, 25.48, 196.53},
+    {228365, 25.68, 196.05},
+    {229404, 25.88, 195.55},
+    {230437, 26.09, 195.05},
+    {231508, 26.30, 194.52},
+    {232502, 26.49, 194.03},
+    {233555, 26.70, 193.49},
+    {234477, 26.88, 193.02},
+    {235505, 27.08, 192.48},
+    {236434, 27.26, 191.99},
+    {237492, 27.47, 191.42},
+    {238430, 27.65, 190.91},
+    {239437, 27.85, 190.36},
+    {240448, 28.04, 189.79},
+    {241508, 28.25, 189.19},
+    {242458, 28.43, 188.65},
+    {243473, 28.62, 188.05},
+    {244514, 28.82, 187.44},
+    {245578, 29.02, 186.80},
+    {246522, 29.19, 186.23},
+    {247471, 29.37, 185.64},
+    {248481, 29.55, 185.01},
+    {249476, 29.73, 184.38},
+    {250450, 29.90, 183.76},
+    {251465, 30.08, 183.10},
+    {252466, 30.26, 182.45},
+    {253496, 30.43, 181.76},
+    {254508, 30.61, 181.08},
+    {255475, 30.77, 180.43},
+    {256451, 30.93, 179.76},
+    {257503, 31.10, 179.02},
+    {258451, 31.24, 178.36},
+    {259487, 31.40, 177.62},
+    {260431, 31.55, 176.94},
+    {261434, 31.69, 176.22},
+    {262414, 31.83, 175.50},
+    {263387, 31.97, 174.78},
+    {264319, 32.10, 174.08},
+    {265269, 32.22, 173.37},
+    {266222, 32.34, 172.64},
+    {267293, 32.47, 171.82},
+    {268259, 32.59, 171.08},
+    {269223, 32.70, 170.33},
+    {270285, 32.81, 169.49},
+    {271333, 32.92, 168.67},
+    {272391, 33.02, 167.82},
+    {273360, 33.11, 167.05},
+    {274306, 33.20, 166.28},
+    {275365, 33.28, 165.43},
+    {276382, 33.36, 164.60},
+    {277450, 33.43, 163.72},
+    {278387, 33.49, 162.95},
+    {279332, 33.55, 162.17},
+    {280274, 33.60, 161.39},
+    {281261, 33.64, 160.57},
+    {282264, 33.69, 159.73},
+    {283230, 33.72, 158.92},
+    {284259, 33.75, 158.06},
+    {285234, 33.77, 157.24},
+    {286289, 33.78, 156.35},
+    {287278, 33.79, 155.52},
+    {288267, 33.80, 154.68},
+    {289246, 33.79, 153.86},
+    {290175, 33.78, 153.08},
+    {291169, 33.77, 152.24},
+    {292146, 33.75, 151.42},
+    {293122, 33.72, 150.60},
+    {294075, 33.69, 149.81},
+    {295119, 33.64, 148.93},
+    {296175, 33.59, 148.06},
+    {297124, 33.54, 147.27},
+    {298120, 33.49, 146.45},
+    {299095, 33.42, 145.64},
+    {300127, 33.35, 144.80},
+    {301076, 33.28, 144.03},
+    {302138, 33.19, 143.16},
+    {303178, 33.10, 142.33},
+    {304109, 33.01, 141.58},
+    {305161, 32.91, 140.75},
+    {306096, 32.81, 140.01},
+    {307092, 32.70, 139.23},
+    {308103, 32.59, 138.44},
+    {309056, 32.48, 137.70},
+    {310094, 32.35, 136.91},
+    {311086, 32.22, 136.15},
+    {312135, 32.08, 135.37},
+    {313122, 31.95, 134.63},
+    {314136, 31.81, 133.88},
+    {315186, 31.66, 133.11},
+    {316205, 31.51, 132.38},
+    {317275, 31.34, 131.61},
+    {318231, 31.20, 130.94},
+    {319218, 31.04, 130.24},
+    {320148, 30.89, 129.60},
+    {321160, 30.72, 128.91},
+    {322217, 30.55, 128.19},
+    {323184, 30.38, 127.55},
+    {324263, 30.20, 126.83},
+    {325255, 30.02, 126.19},
+    {326183, 29.86, 125.59},
+    {327168, 29.68, 124.96},
+    {328191, 29.50, 124.32},
+    {329157, 29.32, 123.72},
+    {330209, 29.13, 123.07},
+    {331164, 28.95, 122.50},
+    {332166, 28.76, 121.90},
+    {333238, 28.56, 121.27},
+    {334289, 28.36, 120.66},
+    {335358, 28.15, 120.05},
+    {336364, 27.96, 119.48},
+    {337424, 27.76, 118.89},
+    {338412, 27.56, 118.35},
+    {339412, 27.37, 117.81},
+    {340405, 27.18, 117.28},
+    {341462, 26.97, 116.73},
+    {342507, 26.76, 116.19},
+    {343530, 26.56, 115.67},
+    {344548, 26.36, 115.16},
+    {345546, 26.17, 114.66},
+    {346558, 25.97, 114.17},
+    {347582, 25.76, 113.68},
+    {348638, 25.56, 113.18},
+    {349563, 25.38, 112.75},
+    {350571, 25.18, 112.29},
+    {351571, 24.98, 111.83},
+    {352498, 24.80, 111.42},
+    {353527, 24.60, 110.97},
+    {354496, 24.41, 110.55},
+    {355524, 24.21, 110.11},
+    {356515, 24.02, 109.69},
+    {357495, 23.83, 109.29},
+    {358416, 23.65, 108.91},
+    {359459, 23.45, 108.49},
+    {360406, 23.27, 108.11},
+    {361413, 23.08, 107.72},
+    {362460, 22.88, 107.32},
+    {363484, 22.69, 106.93},
+    {364414, 22.51, 106.58},
+    {365459, 22.32, 106.19},
+    {366407, 22.14, 105.85},
+    {367459, 21.94, 105.47},
+    {368386, 21.77, 105.15},
+    {369458, 21.58, 104.77},
+    {370478, 21.39, 104.42},
+    {371438, 21.21, 104.10},
+    {372468, 21.03, 103.76},
+    {373447, 20.85, 103.43},
+    {374403, 20.68, 103.13},
+    {375448, 20.50, 102.79},
+    {376443, 20.32, 102.48},
+    {377395, 20.15, 102.18},
+    {378318, 19.99, 101.90},
+    {379393, 19.81, 101.58},
+    {380322, 19.65, 101.30},
+    {381395, 19.46, 100.99},
+    {382388, 19.29, 100.70},
+    {383453, 19.11, 100.40},
+    {384464, 18.94, 100.11},
+    {385538, 18.76, 99.82},
+    {386477, 18.61, 99.56},
+    {387441, 18.45, 99.30},
+    {388475, 18.28, 99.03},
+    {389396, 18.13, 98.79},
+    {390389, 17.97, 98.53},
+    {391451, 17.80, 98.26},
+    {392374, 17.65, 98.03},
+    {393389, 17.49, 97.77},
+    {394378, 17.34, 97.53},
+    {395366, 17.18, 97.29},
+    {396418, 17.02, 97.04},
+    {397450, 16.86, 96.80},
+    {398402, 16.72, 96.58},
+    {399462, 16.55, 96.34},
+    {400497, 16.40, 96.10},
+    {401518, 16.25, 95.88},
+    {402470, 16.10, 95.67},
+    {403430, 15.96, 95.46},
+    {404411, 15.82, 95.25},
+    {405413, 15.67, 95.04},
+    {406382, 15.53, 94.83},
+    {407358, 15.39, 94.63},
+    {408306, 15.26, 94.44},
+    {409340, 15.11, 94.23},
+    {410411, 14.96, 94.02},
+    {411435, 14.82, 93.82},
+    {412359, 14.69, 93.64},
+    {413426, 14.54, 93.43},
+    {414397, 14.41, 93.25},
+    {415444, 14.27, 93.06},
+    {416405, 14.14, 92.88},
+    {417452, 14.00, 92.69},
+    {418379, 13.87, 92.52},
+    {419450, 13.73, 92.33},
+    {420445, 13.60, 92.16},
+    {421451, 13.47, 91.98},
+    {422375, 13.35, 91.82},
+    {423333, 13.23, 91.66},
+    {424366, 13.10, 91.49},
+    {425386, 12.97, 91.32},
+    {426351, 12.85, 91.16},
+    {427430, 12.71, 90.99},
+    {428422, 12.59, 90.83},
+    {429431, 12.46, 90.67},
+    {430495, 12.33, 90.50},
+    {431492, 12.21, 90.35},
+    {432431, 12.10, 90.21},
+    {433443, 11.98, 90.06},
+    {434463, 11.86, 89.90},
+    {435416, 11.74, 89.76},
+    {436374, 11.63, 89.62},
+    {437363, 11.51, 89.48},
+    {438372, 11.40, 89.34},
+    {439338, 11.29, 89.20},
+    {440325, 11.17, 89.07},
+    {441371, 11.05, 88.92},
+    {442443, 10.93, 88.78},
+    {443406, 10.82, 88.65},
+    {444438, 10.71, 88.51},
+    {445507, 10.59, 88.37},
+    {446472, 10.48, 88.24},
+    {447438, 10.38, 88.12},
+    {448367, 10.27, 88.00},
+    {449388, 10.16, 87.87},
+    {450440, 10.05, 87.74},
+    {451481, 9.94, 87.61},
+    {452559, 9.82, 87.48},
+    {453564, 9.72, 87.36},
+    {454583, 9.61, 87.24},
+    {455617, 9.50, 87.11},
+    {456637, 9.40, 87.00},
+    {457624, 9.30, 86.88},
+    {458613, 9.19, 86.77},
+    {459622, 9.09, 86.65},
+    {460652, 8.99, 86.54},
+    {461578, 8.89, 86.44},
+    {462510, 8.80, 86.33},
+    {463584, 8.69, 86.22},
+    {464528, 8.60, 86.11},
+    {465531, 8.50, 86.01},
+    {466523, 8.40, 85.90},
+    {467449, 8.31, 85.81},
+    {468469, 8.21, 85.70},
+    {469478, 8.12, 85.60},
+    {470520, 8.02, 85.49},
+    {471598, 7.92, 85.38},
+    {472646, 7.82, 85.28},
+    {473684, 7.72, 85.18},
+    {474623, 7.63, 85.08},
+    {475558, 7.54, 84.99},
+    {476510, 7.46, 84.90},
+    {477564, 7.36, 84.80},
+    {478527, 7.27, 84.71},
+    {479519, 7.18, 84.62},
+    {480497, 7.09, 84.53},
+    {481575, 6.99, 84.43},
+    {482539, 6.91, 84.34},
+    {483616, 6.81, 84.25},
+    {484573, 6.73, 84.16},
+    {485627, 6.63, 84.07},
+    {486615, 6.55, 83.98},
+    {487647, 6.46, 83.89},
+    {488578, 6.37, 83.81},
+    {489552, 6.29, 83.73},
+    {490547, 6.20, 83.65},
+    {491625, 6.11, 83.56},
+    {492619, 6.03, 83.48},
+    {493640, 5.94, 83.39},
+    {494602, 5.86, 83.31},
+    {495626, 5.77, 83.23},
+    {496568, 5.69, 83.16},
+    {497534, 5.61, 83.08},
+    {498482, 5.54, 83.01},
+    {499540, 5.45, 82.92},
+    {500551, 5.37, 82.85},
+    {501579, 5.28, 82.77},
+    {502655, 5.19, 82.69},
+    {503626, 5.12, 82.61},
+    {504673, 5.03, 82.54},
+    {505665, 4.95, 82.46},
+    {506590, 4.88, 82.40},
+    {507529, 4.80, 82.33},
+    {508565, 4.72, 82.25},
+    {509536, 4.64, 82.19},
+    {510607, 4.56, 82.11},
+    {511577, 4.48, 82.04},
+    {512644, 4.40, 81.97},
+    {513640, 4.32, 81.90},
+    {514584, 4.25, 81.84},
+    {515519, 4.18, 81.77},
+    {516559, 4.10, 81.70},
+    {517582, 4.02, 81.63},
+    {518636, 3.94, 81.56},
+    {519561, 3.87, 81.50},
+    {520511, 3.80, 81.44},
+    {521480, 3.73, 81.38},
+    {522480, 3.65, 81.32},
+    {523540, 3.58, 81.25},
+    {524589, 3.50, 81.18},
+    {525621, 3.42, 81.12},
+    {526664, 3.35, 81.05},
+    {527707, 3.27, 80.99},
+    {528752, 3.19, 80.93},
+    {529793, 3.12, 80.86},
+    {530772, 3.05, 80.81},
+    {531695, 2.98, 80.75},
+    {532727, 2.91, 80.69},
+    {533791, 2.83, 80.63},
+    {534792, 2.76, 80.57},
+    {535802, 2.69, 80.51},
+    {536845, 2.62, 80.45},
+    {537830, 2.55, 80.40},
+    {538879, 2.47, 80.34},
+    {539804, 2.41, 80.29},
+    {540830, 2.34, 80.23},
+    {541887, 2.27, 80.17},
+    {542931, 2.19, 80.11},
+    {543985, 2.12, 80.06},
+    {545049, 2.05, 80.00},
+    {546092, 1.98, 79.94},
+    {547055, 1.91, 79.89},
+    {548096, 1.84, 79.84},
+    {549140, 1.77, 79.78},
+    {550138, 1.71, 79.73},
+    {551153, 1.64, 79.68},
+    {552229, 1.57, 79.63},
+    {553157, 1.50, 79.58},
+    {554212, 1.43, 79.53},
+    {555158, 1.37, 79.48},
+    {556158, 1.31, 79.43},
+    {557227, 1.24, 79.38},
+    {558211, 1.17, 79.33},
+    {559240, 1.11, 79.28},
+    {560247, 1.04, 79.23},
+    {561199, 0.98, 79.19},
+    {562264, 0.91, 79.14},
+    {563278, 0.84, 79.09},
+    {564200, 0.79, 79.05},
+    {565171, 0.72, 79.00},
+    {566195, 0.66, 78.95},
+    {567265, 0.59, 78.91},
+    {568263, 0.53, 78.86},
+    {569341, 0.46, 78.81},
+    {570365, 0.40, 78.77},
+    {571300, 0.34, 78.73},
+    {572255, 0.28, 78.68},
+    {573258, 0.22, 78.64},
+    {574305, 0.15, 78.59},
+    {575378, 0.08, 78.55},
+    {576455, 0.02, 78.50},
+};
+
+// 40N 75W, low (9.2 degrees) in the north, the azimuth wraps through 0
+static const PassSample PASS_NORTH[] = {
+    {0, 0.00, 311.74},
+    {924, 0.05, 311.85},
+    {1847, 0.09, 311.97},
+    {2853, 0.14, 312.10},
+    {3874, 0.19, 312.22},
+    {4939, 0.24, 312.36},
+    {5877, 0.29, 312.48},
+    {6877, 0.34, 312.61},
+    {7884, 0.38, 312.74},
+    {8899, 0.43, 312.87},
+    {9944, 0.49, 313.01},
+    {10871, 0.53, 313.13},
+    {11910, 0.58, 313.27},
+    {12984, 0.63, 313.41},
+    {13916, 0.68, 313.53},
+    {14947, 0.73, 313.67},
+    {15941, 0.78, 313.80},
+    {16925, 0.83, 313.94},
+    {17998, 0.88, 314.08},
+    {18983, 0.93, 314.22},
+    {20055, 0.98, 314.36},
+    {21133, 1.04, 314.51},
+    {22159, 1.09, 314.66},
+    {23147, 1.13, 314.79},
+    {24147, 1.18, 314.93},
+    {25113, 1.23, 315.07},
+    {26101, 1.28, 315.21},
+    {27129, 1.33, 315.36},
+    {28074, 1.38, 315.49},
+    {29009, 1.42, 315.62},
+    {30065, 1.48, 315.78},
+    {31035, 1.53, 315.92},
+    {31957, 1.57, 316.05},
+    {32952, 1.62, 316.20},
+    {33919, 1.67, 316.34},
+    {34930, 1.72, 316.49},
+    {36003, 1.77, 316.65},
+    {36926, 1.82, 316.79},
+    {37970, 1.87, 316.94},
+    {38939, 1.92, 317.09},
+    {39911, 1.97, 317.24},
+    {40983, 2.02, 317.40},
+    {41990, 2.07, 317.56},
+    {43016, 2.12, 317.71},
+    {44041, 2.17, 317.87},
+    {45060, 2.22, 318.03},
+    {46006, 2.27, 318.18},
+    {47074, 2.33, 318.35},
+    {48116, 2.38, 318.51},
+    {49110, 2.43, 318.67},
+    {50146, 2.48, 318.84},
+    {51120, 2.53, 318.99},
+    {52154, 2.58, 319.16},
+    {53166, 2.63, 319.32},
+    {54207, 2.68, 319.49},
+    {55198, 2.73, 319.66},
+    {56151, 2.78, 319.81},
+    {57145, 2.83, 319.98},
+    {58172, 2.88, 320.15},
+    {59175, 2.93, 320.32},
+    {60234, 2.98, 320.49},
+    {61217, 3.03, 320.66},
+    {62285, 3.09, 320.84},
+    {63323, 3.14, 321.02},
+    {64266, 3.19, 321.18},
+    {65295, 3.24, 321.36},
+    {66272, 3.29, 321.53},
+    {67250, 3.34, 321.70},
+    {68296, 3.39, 321.88},
+    {69343, 3.44, 322.07},
+    {70292, 3.49, 322.24},
+    {71232, 3.54, 322.40},
+    {72217, 3.58, 322.58},
+    {73276, 3.64, 322.77},
+    {74311, 3.69, 322.96},
+    {75316, 3.74, 323.14},
+    {76276, 3.79, 323.31},
+    {77259, 3.84, 323.49},
+    {78318, 3.89, 323.69},
+    {79368, 3.94, 323.88},
+    {80348, 3.99, 324.07},
+    {81401, 4.04, 324.26},
+    {82431, 4.09, 324.46},
+    {83435, 4.14, 324.65},
+    {84498, 4.20, 324.85},
+    {85519, 4.25, 325.05},
+    {86586, 4.30, 325.25},
+    {87568, 4.35, 325.44},
+    {88613, 4.40, 325.64},
+    {89665, 4.45, 325.85},
+    {90601, 4.50, 326.03},
+    {91619, 4.55, 326.23},
+    {92636, 4.60, 326.44},
+    {93574, 4.64, 326.62},
+    {94586, 4.69, 326.82},
+    {95648, 4.75, 327.04},
+    {96583, 4.79, 327.23},
+    {97548, 4.84, 327.42},
+    {98592, 4.89, 327.64},
+    {99628, 4.94, 327.85},
+    {100609, 4.99, 328.05},
+    {101558, 5.03, 328.25},
+    {102524, 5.08, 328.45},
+    {103585, 5.13, 328.67},
+    {104568, 5.18, 328.88},
+    {105612, 5.23, 329.10},
+    {106646, 5.28, 329.32},
+    {107581, 5.33, 329.52},
+    {108619, 5.37, 329.74},
+    {109673, 5.43, 329.97},
+    {110682, 5.47, 330.19},
+    {111637, 5.52, 330.39},
+    {112701, 5.57, 330.63},
+    {113685, 5.62, 330.84},
+    {114638, 5.66, 331.05},
+    {115666, 5.71, 331.28},
+    {116717, 5.76, 331.51},
+    {117796, 5.81, 331.76},
+    {118717, 5.85, 331.96},
+    {119742, 5.90, 332.20},
+    {120666, 5.94, 332.41},
+    {121643, 5.99, 332.63},
+    {122581, 6.03, 332.84},
+    {123582, 6.08, 333.07},
+    {124647, 6.13, 333.32},
+    {125724, 6.17, 333.57},
+    {126693, 6.22, 333.80},
+    {127668, 6.26, 334.03},
+    {128736, 6.31, 334.28},
+    {129800, 6.36, 334.53},
+    {130750, 6.40, 334.75},
+    {131785, 6.45, 335.00},
+    {132801, 6.49, 335.25},
+    {133789, 6.54, 335.48},
+    {134765, 6.58, 335.72},
+    {135841, 6.63, 335.98},
+    {136884, 6.67, 336.24},
+    {137908, 6.72, 336.49},
+    {138900, 6.76, 336.73},
+    {139897, 6.80, 336.98},
+    {140896, 6.84, 337.23},
+    {141876, 6.89, 337.47},
+    {142853, 6.93, 337.72},
+    {143923, 6.97, 337.99},
+    {144905, 7.01, 338.23},
+    {145844, 7.05, 338.47},
+    {146864, 7.09, 338.73},
+    {147891, 7.13, 339.00},
+    {148883, 7.18, 339.25},
+    {149939, 7.22, 339.52},
+    {150882, 7.26, 339.77},
+    {151823, 7.29, 340.01},
+    {152839, 7.33, 340.28},
+    {153850, 7.37, 340.54},
+    {154872, 7.41, 340.81},
+    {155865, 7.45, 341.07},
+    {156859, 7.49, 341.34},
+    {157871, 7.53, 341.61},
+    {158849, 7.57, 341.87},
+    {159870, 7.60, 342.14},
+    {160810, 7.64, 342.39},
+    {161780, 7.67, 342.66},
+    {162730, 7.71, 342.91},
+    {163742, 7.75, 343.19},
+    {164663, 7.78, 343.44},
+    {165599, 7.81, 343.70},
+    {166658, 7.85, 343.99},
+    {167618, 7.88, 344.25},
+    {168684, 7.92, 344.55},
+    {169619, 7.95, 344.81},
+    {170596, 7.98, 345.08},
+    {171604, 8.02, 345.36},
+    {172526, 8.05, 345.62},
+    {173481, 8.08, 345.89},
+    {174425, 8.11, 346.15},
+    {175468, 8.14, 346.45},
+    {176424, 8.17, 346.72},
+    {177347, 8.20, 346.98},
+    {178320, 8.23, 347.26},
+    {179334, 8.26, 347.55},
+    {180315, 8.29, 347.83},
+    {181343, 8.32, 348.13},
+    {182379, 8.35, 348.43},
+    {183318, 8.38, 348.70},
+    {184254, 8.41, 348.97},
+    {185271, 8.44, 349.27},
+    {186212, 8.46, 349.54},
+    {187195, 8.49, 349.83},
+    {188128, 8.51, 350.10},
+    {189092, 8.54, 350.39},
+    {190135, 8.56, 350.70},
+    {191098, 8.59, 350.98},
+    {192102, 8.61, 351.28},
+    {193074, 8.64, 351.57},
+    {194060, 8.66, 351.86},
+    {195097, 8.69, 352.17},
+    {196135, 8.71, 352.48},
+    {197076, 8.73, 352.76},
+    {198099, 8.75, 353.07},
+    {199177, 8.78, 353.40},
+    {200112, 8.80, 353.68},
+    {201071, 8.82, 353.97},
+    {202053, 8.83, 354.27},
+    {203111, 8.86, 354.59},
+    {204180, 8.88, 354.91},
+    {205167, 8.89, 355.21},
+    {206181, 8.91, 355.52},
+    {207168, 8.93, 355.82},
+    {208124, 8.94, 356.12},
+    {209077, 8.96, 356.41},
+    {210111, 8.98, 356.73},
+    {211148, 8.99, 357.05},
+    {212204, 9.01, 357.37},
+    {213174, 9.02, 357.67},
+    {214162, 9.03, 357.98},
+    {215145, 9.05, 358.28},
+    {216219, 9.06, 358.61},
+    {217163, 9.07, 358.91},
+    {218168, 9.08, 359.22},
+    {219246, 9.10, 359.55},
+    {220282, 9.11, 359.88},
+    {221250, 9.12, 0.18},
+    {222222, 9.12, 0.48},
+    {223251, 9.13, 0.80},
+    {224234, 9.14, 1.11},
+    {225287, 9.15, 1.44},
+    {226290, 9.16, 1.75},
+    {227343, 9.16, 2.08},
+    {228365, 9.17, 2.40},
+    {229404, 9.17, 2.73},
+    {230437, 9.18, 3.05},
+    {231508, 9.18, 3.39},
+    {232502, 9.18, 3.70},
+    {233555, 9.19, 4.03},
+    {234477, 9.19, 4.32},
+    {235505, 9.19, 4.64},
+    {236434, 9.19, 4.94},
+    {237492, 9.19, 5.27},
+    {238430, 9.19, 5.56},
+    {239437, 9.19, 5.88},
+    {240448, 9.19, 6.20},
+    {241508, 9.19, 6.53},
+    {242458, 9.19, 6.83},
+    {243473, 9.18, 7.15},
+    {244514, 9.18, 7.47},
+    {245578, 9.17, 7.81},
+    {246522, 9.17, 8.10},
+    {247471, 9.16, 8.40},
+    {248481, 9.16, 8.72},
+    {249476, 9.15, 9.03},
+    {250450, 9.14, 9.33},
+    {251465, 9.14, 9.65},
+    {252466, 9.13, 9.96},
+    {253496, 9.12, 10.29},
+    {254508, 9.11, 10.60},
+    {255475, 9.10, 10.90},
+    {256451, 9.09, 11.21},
+    {257503, 9.08, 11.53},
+    {258451, 9.07, 11.83},
+    {259487, 9.05, 12.15},
+    {260431, 9.04, 12.44},
+    {261434, 9.03, 12.75},
+    {262414, 9.02, 13.06},
+    {263387, 9.00, 13.36},
+    {264319, 8.99, 13.64},
+    {265269, 8.97, 13.94},
+    {266222, 8.96, 14.23},
+    {267293, 8.94, 14.56},
+    {268259, 8.92, 14.85},
+    {269223, 8.91, 15.15},
+    {270285, 8.89, 15.47},
+    {271333, 8.87, 15.79},
+    {272391, 8.85, 16.12},
+    {273360, 8.83, 16.41},
+    {274306, 8.81, 16.70},
+    {275365, 8.79, 17.02},
+    {276382, 8.77, 17.32},
+    {277450, 8.74, 17.65},
+    {278387, 8.72, 17.93},
+    {279332, 8.70, 18.21},
+    {280274, 8.68, 18.49},
+    {281261, 8.66, 18.79},
+    {282264, 8.63, 19.09},
+    {283230, 8.61, 19.38},
+    {284259, 8.58, 19.68},
+    {285234, 8.56, 19.97},
+    {286289, 8.53, 20.28},
+    {287278, 8.51, 20.57},
+    {288267, 8.48, 20.86},
+    {289246, 8.45, 21.15},
+    {290175, 8.43, 21.42},
+    {291169, 8.40, 21.71},
+    {292146, 8.37, 22.00},
+    {293122, 8.34, 22.28},
+    {294075, 8.32, 22.55},
+    {295119, 8.28, 22.86},
+    {296175, 8.25, 23.16},
+    {297124, 8.22, 23.43},
+    {298120, 8.19, 23.72},
+    {299095, 8.16, 23.99},
+    {300127, 8.13, 24.29},
+    {301076, 8.10, 24.55},
+    {302138, 8.06, 24.85},
+    {303178, 8.03, 25.15},
+    {304109, 8.00, 25.41},
+    {305161, 7.96, 25.70},
+    {306096, 7.93, 25.96},
+    {307092, 7.90, 26.24},
+    {308103, 7.86, 26.52},
+    {309056, 7.83, 26.78},
+    {310094, 7.79, 27.07},
+    {311086, 7.76, 27.34},
+    {312135, 7.72, 27.63},
+    {313122, 7.68, 27.89},
+    {314136, 7.64, 28.17},
+    {315186, 7.61, 28.45},
+    {316205, 7.57, 28.73},
+    {317275, 7.53, 29.01},
+    {318231, 7.49, 29.27},
+    {319218, 7.45, 29.53},
+    {320148, 7.42, 29.78},
+    {321160, 7.38, 30.04},
+    {322217, 7.33, 30.32},
+    {323184, 7.30, 30.57},
+    {324263, 7.25, 30.86},
+    {325255, 7.21, 31.11},
+    {326183, 7.18, 31.35},
+    {327168, 7.14, 31.61},
+    {328191, 7.09, 31.87},
+    {329157, 7.05, 32.12},
+    {330209, 7.01, 32.39},
+    {331164, 6.97, 32.63},
+    {332166, 6.93, 32.88},
+    {333238, 6.88, 33.15},
+    {334289, 6.84, 33.41},
+    {335358, 6.79, 33.68},
+    {336364, 6.75, 33.93},
+    {337424, 6.70, 34.19},
+    {338412, 6.66, 34.43},
+    {339412, 6.62, 34.68},
+    {340405, 6.57, 34.92},
+    {341462, 6.53, 35.18},
+    {342507, 6.48, 35.43},
+    {343530, 6.43, 35.68},
+    {344548, 6.39, 35.92},
+    {345546, 6.34, 36.16},
+    {346558, 6.30, 36.40},
+    {347582, 6.25, 36.64},
+    {348638, 6.20, 36.89},
+    {349563, 6.16, 37.10},
+    {350571, 6.12, 37.34},
+    {351571, 6.07, 37.57},
+    {352498, 6.03, 37.79},
+    {353527, 5.98, 38.02},
+    {354496, 5.94, 38.24},
+    {355524, 5.89, 38.48},
+    {356515, 5.84, 38.70},
+    {357495, 5.80, 38.92},
+    {358416, 5.75, 39.13},
+    {359459, 5.70, 39.36},
+    {360406, 5.66, 39.57},
+    {361413, 5.61, 39.80},
+    {362460, 5.56, 40.03},
+    {363484, 5.51, 40.25},
+    {364414, 5.47, 40.46},
+    {365459, 5.42, 40.68},
+    {366407, 5.37, 40.89},
+    {367459, 5.32, 41.11},
+    {368386, 5.28, 41.31},
+    {369458, 5.23, 41.54},
+    {370478, 5.18, 41.76},
+    {371438, 5.13, 41.96},
+    {372468, 5.08, 42.18},
+    {373447, 5.03, 42.38},
+    {374403, 4.99, 42.58},
+    {375448, 4.93, 42.80},
+    {376443, 4.89, 43.00},
+    {377395, 4.84, 43.20},
+    {378318, 4.79, 43.38},
+    {379393, 4.74, 43.60},
+    {380322, 4.70, 43.79},
+    {381395, 4.64, 44.01},
+    {382388, 4.59, 44.20},
+    {383453, 4.54, 44.42},
+    {384464, 4.49, 44.62},
+    {385538, 4.44, 44.83},
+    {386477, 4.39, 45.01},
+    {387441, 4.34, 45.20},
+    {388475, 4.29, 45.40},
+    {389396, 4.25, 45.58},
+    {390389, 4.20, 45.77},
+    {391451, 4.14, 45.97},
+    {392374, 4.10, 46.15},
+    {393389, 4.05, 46.34},
+    {394378, 4.00, 46.53},
+    {395366, 3.95, 46.71},
+    {396418, 3.90, 46.91},
+    {397450, 3.84, 47.10},
+    {398402, 3.80, 47.27},
+    {399462, 3.74, 47.47},
+    {400497, 3.69, 47.66},
+    {401518, 3.64, 47.84},
+    {402470, 3.59, 48.02},
+    {403430, 3.54, 48.19},
+    {404411, 3.50, 48.36},
+    {405413, 3.45, 48.54},
+    {406382, 3.40, 48.71},
+    {407358, 3.35, 48.89},
+    {408306, 3.30, 49.05},
+    {409340, 3.25, 49.23},
+    {410411, 3.19, 49.42},
+    {411435, 3.14, 49.60},
+    {412359, 3.10, 49.75},
+    {413426, 3.04, 49.94},
+    {414397, 2.99, 50.10},
+    {415444, 2.94, 50.28},
+    {416405, 2.89, 50.44},
+    {417452, 2.84, 50.62},
+    {418379, 2.79, 50.77},
+    {419450, 2.74, 50.95},
+    {420445, 2.69, 51.11},
+    {421451, 2.64, 51.28},
+    {422375, 2.59, 51.43},
+    {423333, 2.54, 51.58},
+    {424366, 2.49, 51.75},
+    {425386, 2.44, 51.91},
+    {426351, 2.39, 52.07},
+    {427430, 2.34, 52.24},
+    {428422, 2.29, 52.40},
+    {429431, 2.24, 52.56},
+    {430495, 2.18, 52.72},
+    {431492, 2.13, 52.88},
+    {432431, 2.09, 53.02},
+    {433443, 2.04, 53.18},
+    {434463, 1.99, 53.34},
+    {435416, 1.94, 53.48},
+    {436374, 1.89, 53.63},
+    {437363, 1.84, 53.78},
+    {438372, 1.79, 53.93},
+    {439338, 1.74, 54.07},
+    {440325, 1.69, 54.22},
+    {441371, 1.64, 54.38},
+    {442443, 1.59, 54.54},
+    {443406, 1.54, 54.68},
+    {444438, 1.49, 54.83},
+    {445507, 1.43, 54.98},
+    {446472, 1.39, 55.12},
+    {447438, 1.34, 55.26},
+    {448367, 1.29, 55.39},
+    {449388, 1.24, 55.54},
+    {450440, 1.19, 55.69},
+    {451481, 1.14, 55.83},
+    {452559, 1.08, 55.99},
+    {453564, 1.03, 56.13},
+    {454583, 0.98, 56.27},
+    {455617, 0.93, 56.41},
+    {456637, 0.88, 56.55},
+    {457624, 0.83, 56.68},
+    {458613, 0.78, 56.82},
+    {459622, 0.73, 56.96},
+    {460652, 0.68, 57.09},
+    {461578, 0.64, 57.22},
+    {462510, 0.59, 57.34},
+    {463584, 0.54, 57.49},
+    {464528, 0.49, 57.61},
+    {465531, 0.44, 57.74},
+    {466523, 0.40, 57.87},
+    {467449, 0.35, 57.99},
+    {468469, 0.30, 58.12},
+    {469478, 0.25, 58.25},
+    {470520, 0.20, 58.39},
+    {471598, 0.15, 58.52},
+    {472646, 0.10, 58.66},
+    {473684, 0.05, 58.79},
+};
+
+struct RecordedPass {
+    const char *name;
+    double latitude, longitude;     // observer, degrees
+    double start;                   // Julian date of the first sample
+    const PassSample *samples;
+    size_t count;
+};
+
+#define RECORDED_PASS(name, latitude, longitude, start, samples) \
+    {name, latitude, longitude, start, samples, sizeof(samples) / sizeof(samples[0])}
+
+static const RecordedPass RECORDED_PASSES[] = {
+    RECORDED_PASS("overhead", 52.0, 5.0, 2454731.41245528, PASS_OVERHEAD),
+    RECORDED_PASS("medium", 52.0, 5.0, 2454730.32802855, PASS_MEDIUM),
+    RECORDED_PASS("north", 40.0, -75.0, 2454730.65064617, PASS_NORTH),
+};
@@ -0,0 +1,112 @@
+// Replays recorded passes through the target estimator: `pio test -e native -f test_estimator -v`.
+// Every 20 ms motion step the setpoint is taken both from the estimator and, as without it, from
+// the last sample (stair-step tracking). The pointing error of both against the true position of
+// the satellite is printed per pass, the estimator has to beat the stair-step by far.
+#include <Arduino.h>
+#include <unity.h>
+#include <estimator.h>
+#include <configschema.h>
+#include <sgp4.h>
+#include <astro.h>
+#include "passes.h"
+
+#define REPLAY_STEP     20      // ms, the motion step at the default MOTION_RATE
+
+struct PointingError {
+    double rms, max;
+};
+
+struct ReplayResult {
+    PointingError estimator, stairStep;
+    uint32_t steps, failures;    // failures: steps the truth could not be propagated
+};
+
+static double radians(double d) { return d * M_PI / 180.0; }
+
+// Angle on the sky between two directions, what is off in the eyepiece or the antenna beam
+static double separation(double alt1, double az1, double alt2, double az2) {
+    double c = sin(radians(alt1)) * sin(radians(alt2)) + cos(radians(alt1)) * cos(radians(alt2)) * cos(radians(az1 - az2));
+    return acos(std::min(1.0, std::max(-1.0, c))) * 180.0 / M_PI;
+}
+
+static ReplayResult replay(const RecordedPass &pass, Sgp4 &sgp4) {
+    Observer observer;
+    observer.latitude = pass.latitude;
+    observer.longitude = pass.longitude;
+
+    RotorConfig config;
+    AxisEstimator alt, az;
+    alt.configure(config.measurementNoise, config.processNoise, false);
+    az.configure(config.measurementNoise, config.processNoise, true);
+
+    double sumEstimator = 0, sumStairStep = 0;
+    ReplayResult result = {};
+    size_t next = 0;
+    for (long ms = 0; ms <= pass.samples[pass.count - 1].ms; ms += REPLAY_STEP) {
+        while (next < pass.count and pass.samples[next].ms <= ms) {
+            alt.update(pass.samples[next].ms, pass.samples[next].alt);
+            az.update(pass.samples[next].ms, pass.samples[next].az);
+            next++;
+        }
+        const PassSample &last = pass.samples[next - 1];
+
+        double jd = pass.start + ms / 86400000.0, r[3], v[3], trueAlt, trueAz;
+        if (!sgp4.propagateTo(jd, r, v)) {
+            result.failures++;
+            continue;
+        }
+        temeToAltAz(observer, jd, r, trueAlt, trueAz);
+
+        double estimator = separation(alt.predict(ms), az.predict(ms), trueAlt, trueAz);
+        double stairStep = separation(last.alt, last.az, trueAlt, trueAz);
+        sumEstimator += estimator * estimator;
+        sumStairStep += stairStep * stairStep;
+        result.estimator.max = std::max(result.estimator.max, estimator);
+        result.stairStep.max = std::max(result.stairStep.max, stairStep);
+        result.steps++;
+    }
+    result.estimator.rms = sqrt(sumEstimator / result.steps);
+    result.stairStep.rms = sqrt(sumStairStep / result.steps);
+    return result;
+}
+
+void test_estimator_against_stair_step() {
+    Tle tle;
+    TEST_ASSERT_TRUE(parseTle(PASS_TLE_NAME, PASS_TLE_LINE1, PASS_TLE_LINE2, tle));
+    Sgp4 sgp4;
+    TEST_ASSERT_TRUE(sgp4.init(tle));
+
+    printf("%-10s %8s %14s %14s %14s %14s\n", "pass", "steps", "estimator rms", "max", "stair rms", "max");
+    for (const RecordedPass &pass : RECORDED_PASSES) {
+        ReplayResult result = replay(pass, sgp4);
+        printf("%-10s %8u %14.4f %14.4f %14.4f %14.4f\n", pass.name, (unsigned)result.steps,
+               result.estimator.rms, result.estimator.max, result.stairStep.rms, result.stairStep.max);
+
+        TEST_ASSERT_EQUAL(0, result.failures);
+        // The samples themselves are only good to 0.01 degrees, the steps lag up to a second of motion
+        TEST_ASSERT_LESS_THAN_DOUBLE(result.stairStep.rms / 4, result.estimator.rms);
+        TEST_ASSERT_LESS_THAN_DOUBLE(result.stairStep.max, result.estimator.max);
+    }
+}
+
+// Samples stop (Stellarium closed): the setpoint runs on for ESTIMATOR_MAX_EXTRAPOLATION and then holds
+void test_estimator_extrapolation_limit() {
+    AxisEstimator alt;
+    alt.configure(0.05, 1.0, false);
+    for (long ms = 0; ms <= 10000; ms += 1000) alt.update(ms, 10.0 + ms / 1000.0);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 1.0, alt.rate());
+    TEST_ASSERT_FLOAT_WITHIN(0.1, 20.0 + ESTIMATOR_MAX_EXTRAPOLATION / 1000.0, alt.predict(10000 + ESTIMATOR_MAX_EXTRAPOLATION));
+    TEST_ASSERT_EQUAL_FLOAT(alt.predict(10000 + ESTIMATOR_MAX_EXTRAPOLATION), alt.predict(60000));
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_estimator_against_stair_step);
+    RUN_TEST(test_estimator_extrapolation_limit);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// The span of the motion history: `pio test -e native -f test_history -v`.
+// Steps at the default 50 Hz go into the default 96 kB ring for longer than it can hold. In the
+// worst case every field jumps every step, each record takes nearly HISTORY_RECORD_MAX, and the
+// ring must still hold HISTORY_MIN_SPAN by thinning out the steps. Smooth tracking fits without
+// thinning. Every decoded step is checked against what was recorded, the span, the records in
+// the last HISTORY_MIN_SPAN and the thinned steps are printed.
+#include <Arduino.h>
+#include <unity.h>
+#include <history.h>
+#include <vector>
+
+#define RING_PERIOD     20          // ms, the default MOTION_RATE
+#define RING_DURATION   1800000     // ms of steps per run
+
+struct RingResult {
+    uint32_t span, minSpan;         // ms, minSpan: the shortest once HISTORY_MIN_SPAN has passed
+    uint32_t recent, thinned;       // recent: records in the last HISTORY_MIN_SPAN
+    uint32_t decoded, mismatches, gaps;    // gaps: records further apart than the period
+};
+
+static uint32_t seed;
+
+static int32_t random32() {
+    seed = seed * 1664525u + 1013904223u;
+    return (int32_t)seed;
+}
+
+// Every field jumps to a new value anywhere in the int32 range, five byte varints
+static void jumping(uint32_t step, HistorySample &sample) {
+    for (int32_t &value : sample.value) value = random32();
+}
+
+// Target and pulses move a little, a step or two at a time
+static void tracking(uint32_t step, HistorySample &sample) {
+    sample.value[0] = 4500 + step / 3;
+    sample.value[1] = 9000 + step / 2;
+    sample.value[2] = 1500 + step / 40;
+    sample.value[3] = 1500 + step / 40 - (step % 7 == 0);
+    sample.value[4] = 1600 + step / 25;
+    sample.value[5] = 1600 + step / 25 - (step % 5 == 0);
+}
+
+template <typename F>
+static RingResult run(F motion) {
+    seed = 12345;
+    PointingHistory history;
+    history.begin(HISTORY_SIZE, RING_PERIOD);
+    std::vector<HistorySample> recorded;
+    RingResult result = {};
+    result.minSpan = UINT32_MAX;
+    for (uint32_t step = 0; step * RING_PERIOD < RING_DURATION; ++step) {
+        HistorySample sample;
+        sample.time = step * RING_PERIOD;
+        motion(step, sample);
+        history.record(sample);
+        recorded.push_back(sample);
+        if (sample.time >= HISTORY_MIN_SPAN + 1000) result.minSpan = std::min(result.minSpan, history.span());
+    }
+    result.span = history.span();
+    result.thinned = history.thinned();
+
+    uint32_t end = recorded.back().time, last = 0;
+    history.forEach(0, [&](const HistoryBlock &block) {
+        PointingHistory::decode(block, RING_PERIOD, [&](const HistorySample &sample) {
+            const HistorySample &expected = recorded[sample.time / RING_PERIOD];
+            if (sample.time != expected.time or memcmp(sample.value, expected.value, sizeof(sample.value)))
+                result.mismatches++;
+            if (result.decoded and sample.time - last != RING_PERIOD) result.gaps++;
+            if (end - sample.time < HISTORY_MIN_SPAN) result.recent++;
+            last = sample.time;
+            result.decoded++;
+        });
+        return true;
+    });
+    printf("%-10s span %6.1f s, shortest %6.1f s, %6u records in the last %u s, %6u thinned\n",
+           "", result.span / 1e3, result.minSpan / 1e3, (unsigned)result.recent,
+           HISTORY_MIN_SPAN / 1000, (unsigned)result.thinned);
+    return result;
+}
+
+// Nearly HISTORY_RECORD_MAX a step, only a few steps a second fit but HISTORY_MIN_SPAN is kept
+void test_every_field_jumping() {
+    RingResult result = run(jumping);
+    TEST_ASSERT_EQUAL(0, result.mismatches);
+    TEST_ASSERT_GREATER_OR_EQUAL(HISTORY_MIN_SPAN, result.minSpan);
+    TEST_ASSERT_GREATER_THAN(0, result.thinned);
+    // All but one block full of records of 31 bytes
+    TEST_ASSERT_GREATER_THAN((HISTORY_SIZE - 1) * (HISTORY_BLOCK_SIZE - 36) / 31 / 2, result.recent);
+}
+
+// Two or three bytes a step, every step is kept and the ring holds more than HISTORY_MIN_SPAN
+void test_tracking_full_rate() {
+    RingResult result = run(tracking);
+    TEST_ASSERT_EQUAL(0, result.mismatches);
+    TEST_ASSERT_EQUAL(0, result.thinned);
+    TEST_ASSERT_EQUAL(0, result.gaps);
+    TEST_ASSERT_GREATER_THAN(HISTORY_MIN_SPAN, result.minSpan);
+    TEST_ASSERT_EQUAL(HISTORY_MIN_SPAN / RING_PERIOD, result.recent);
+}
+
+// Tracking, then a while of jumps, then tracking again: the span never drops below HISTORY_MIN_SPAN
+void test_jumps_while_tracking() {
+    RingResult result = run([](uint32_t step, HistorySample &sample) {
+        uint32_t ms = step * RING_PERIOD;
+        if (ms >= 700000 and ms < 1000000) jumping(step, sample);
+        else tracking(step, sample);
+    });
+    TEST_ASSERT_EQUAL(0, result.mismatches);
+    TEST_ASSERT_GREATER_OR_EQUAL(HISTORY_MIN_SPAN, result.minSpan);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_field_jumping);
+    RUN_TEST(test_tracking_full_rate);
+    RUN_TEST(test_jumps_while_tracking);
+    return UNITY_END();
+}
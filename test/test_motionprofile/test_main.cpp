@@ -0,0 +1,132 @@
+// Bounds of the S-curve motion: `pio test -e native -f test_motionprofile -v`.
+// Steps and reversals at the default limits, in degrees. Every step of the smoothing the speed,
+// acceleration and jerk of the output are taken, the largest of each and the overshoot past the
+// target are printed per move and have to stay within the configured limits.
+#include <Arduino.h>
+#include <unity.h>
+#include <motionprofile.h>
+#include <rotorservo.h>
+
+#define PROFILE_STEP    ((float)(2.0 * DEFAULT_MAX_ACCEL / DEFAULT_MAX_JERK / MOTION_SLOTS))  // s, one step of the smoothing
+#define PROFILE_TIMEOUT 20.0f   // s
+
+struct MoveResult {
+    float time;                 // s until done()
+    float speed, acceleration, jerk;
+    float overshoot;            // past the last target, in the direction the axis came from
+    float error;                // position - target at the end
+    bool done;
+};
+
+// Move from 0 to target, reverse to reverse once the position passed at (if at != 0)
+static MoveResult move(const char *name, float target, float at = 0.0f, float reverse = 0.0f) {
+    MotionProfile profile;
+    profile.configure(DEFAULT_MAX_SPEED, DEFAULT_MAX_ACCEL, DEFAULT_MAX_JERK);
+    profile.reset(0.0f);
+    profile.setTarget(target);
+
+    MoveResult result = {};
+    float acceleration = 0.0f, start = 0.0f;
+    bool reversed = at == 0.0f;
+    for (float t = PROFILE_STEP; t < PROFILE_TIMEOUT and !profile.done(); t += PROFILE_STEP) {
+        profile.update(PROFILE_STEP);
+        if (!reversed and profile.position() > at) {
+            profile.setTarget(reverse);
+            target = reverse;
+            start = at;
+            reversed = true;
+        }
+
+        result.time = t;
+        result.speed = std::max(result.speed, fabsf(profile.velocity()));
+        result.acceleration = std::max(result.acceleration, fabsf(profile.acceleration()));
+        result.jerk = std::max(result.jerk, fabsf(profile.acceleration() - acceleration) / PROFILE_STEP);
+        acceleration = profile.acceleration();
+        float past = target >= start ? profile.position() - target : target - profile.position();
+        result.overshoot = std::max(result.overshoot, past);
+    }
+
+    result.error = profile.position() - target;
+    result.done = profile.done();
+    printf("%-28s %6.2f s %8.2f %8.2f %8.1f %10.6f%s\n", name, result.time, result.speed, result.acceleration,
+           result.jerk, result.overshoot, result.done ? "" : " not done");
+    return result;
+}
+
+static void assertBounds(const MoveResult &result) {
+    TEST_ASSERT_TRUE(result.done);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, result.error);
+    // The output is a float position in degrees, its second and third difference carry some rounding
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(DEFAULT_MAX_SPEED * 1.001f, result.speed);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(DEFAULT_MAX_ACCEL * 1.01f, result.acceleration);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(DEFAULT_MAX_JERK * 1.05f, result.jerk);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(1e-4f, result.overshoot);
+}
+
+static void header() {
+    printf("%-28s %8s %8s %8s %8s %10s\n", "move", "time", "speed", "accel", "jerk", "overshoot");
+}
+
+void test_step() {
+    header();
+    assertBounds(move("step 90", 90.0f));
+    // Too short to reach full speed: the trapezoid goes from full acceleration straight to braking
+    assertBounds(move("step 2", 2.0f));
+}
+
+void test_reversal() {
+    header();
+    // At full speed, and while still accelerating: the trapezoid goes from +acceleration to -acceleration
+    assertBounds(move("reverse at full speed", 90.0f, 45.0f, 0.0f));
+    assertBounds(move("reverse accelerating", 90.0f, 3.0f, 0.0f));
+    assertBounds(move("reverse past the start", 90.0f, 20.0f, -30.0f));
+}
+
+// A POST /config while moving: the same limits change nothing, lower ones take over the move from where it is
+void test_configure_while_moving() {
+    MotionProfile profile;
+    profile.configure(DEFAULT_MAX_SPEED, DEFAULT_MAX_ACCEL, DEFAULT_MAX_JERK);
+    profile.reset(0.0f);
+    profile.setTarget(90.0f);
+    for (float t = 0.0f; t < 1.5f; t += PROFILE_STEP) profile.update(PROFILE_STEP);
+    float position = profile.position(), speed = profile.velocity();
+    TEST_ASSERT_GREATER_THAN_FLOAT(DEFAULT_MAX_SPEED / 2, speed);
+
+    profile.configure(DEFAULT_MAX_SPEED, DEFAULT_MAX_ACCEL, DEFAULT_MAX_JERK);
+    TEST_ASSERT_EQUAL_FLOAT(position, profile.position());
+    TEST_ASSERT_EQUAL_FLOAT(speed, profile.velocity());
+    profile.update(PROFILE_STEP);
+    TEST_ASSERT_FLOAT_WITHIN(DEFAULT_MAX_ACCEL * PROFILE_STEP, speed, profile.velocity());
+
+    float slower = DEFAULT_MAX_SPEED / 4;
+    profile.configure(slower, DEFAULT_MAX_ACCEL, DEFAULT_MAX_JERK);
+    position = profile.position();
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(slower, fabsf(profile.velocity()));
+    float jump = 0.0f, fastest = 0.0f;
+    for (float t = 0.0f; t < PROFILE_TIMEOUT and !profile.done(); t += PROFILE_STEP) {
+        float before = profile.position();
+        profile.update(PROFILE_STEP);
+        if (jump == 0.0f) jump = fabsf(profile.position() - position);
+        // Once the smoothing window has passed
+        if (t > 2.0f * DEFAULT_MAX_ACCEL / DEFAULT_MAX_JERK) fastest = std::max(fastest, (profile.position() - before) / PROFILE_STEP);
+    }
+    printf("configure while moving: first step %0.3f degrees, then at most %0.2f degrees/s\n", jump, fastest);
+    TEST_ASSERT_TRUE(profile.done());
+    TEST_ASSERT_EQUAL_FLOAT(90.0f, profile.position());
+    // It goes on from where it was, no stop and no jump
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.0f, jump);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(speed * PROFILE_STEP * 1.01f, jump);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(slower * 1.001f, fastest);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_step);
+    RUN_TEST(test_reversal);
+    RUN_TEST(test_configure_while_moving);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+// The split of motion and network work under the virtual clock: `pio test -e native -f test_motiontask -v`.
+// A fixed script of network work (rotctld, a web request, the status, logging, a journal write), with
+// the short parts that hold controlLock marked, runs for a while of virtual time. With the split the
+// motion task preempts it at every period and only waits while the lock is held; as before the
+// split a motion step runs between two passes of the script. The jitter and overruns MotionTask
+// records are printed for both, every run gives the same numbers.
+#include <Arduino.h>
+#include <unity.h>
+#include <motiontask.h>
+
+#define SPLIT_RATE          50          // Hz, the default MOTION_RATE
+#define SPLIT_STEP          300         // us a motion step takes
+#define SPLIT_DURATION      10000000    // us of virtual time per run
+
+struct NetworkWork {
+    const char *name;
+    uint32_t us;
+    bool locked;                        // Holds controlLock
+};
+
+static const NetworkWork SCRIPT[] = {
+    {"rotctld pointing", 200, true},
+    {"rotctld reply", 1500, false},
+    {"pass plan snapshot", 500, true},
+    {"web request", 30000, false},
+    {"status", 300, true},
+    {"logging", 8000, false},
+    {"journal write", 25000, false},
+};
+
+struct SplitResult {
+    uint32_t steps, overruns, jitter;   // jitter: largest, us
+    uint64_t elapsed;                   // us, the last pass of the script runs past SPLIT_DURATION
+};
+
+static uint32_t steps;
+
+static void motionStep() {
+    steps++;
+    native::advance(SPLIT_STEP);
+}
+
+static uint32_t longestLock() {
+    uint32_t us = 0;
+    for (const NetworkWork &work : SCRIPT) if (work.locked) us = std::max(us, work.us);
+    return us;
+}
+
+static SplitResult result(const MotionTask &motion, uint64_t start) {
+    SplitResult r = {steps, motion.stats().overruns, motion.stats().jitter.max, native::nowMicros() - start};
+    return r;
+}
+
+// Motion task above the network work: every period it preempts it, unless the lock is held
+static SplitResult runSplit() {
+    native::useVirtualClock(1000000);
+    steps = 0;
+    MotionTask motion;
+    motion.begin(motionStep, SPLIT_RATE);
+    uint64_t start = native::nowMicros(), end = start + SPLIT_DURATION, wake = start;
+    while (native::nowMicros() < end) {
+        for (const NetworkWork &work : SCRIPT) {
+            uint64_t remaining = work.us;
+            while (remaining > 0) {
+                uint64_t now = native::nowMicros();
+                if (wake <= now) {              // vTaskDelayUntil keeps the wake times on the grid
+                    native::simulation().motionStep();
+                    wake += motion.period();
+                } else if (work.locked) {       // The motion task waits for the lock
+                    native::advance(remaining);
+                    remaining = 0;
+                } else {
+                    uint64_t run = std::min(remaining, wake - now);
+                    native::advance(run);
+                    remaining -= run;
+                }
+            }
+        }
+    }
+    return result(motion, start);
+}
+
+// Motion from loop(): a step when it is due, after a whole pass of the network work
+static SplitResult runInLoop() {
+    native::useVirtualClock(1000000);
+    steps = 0;
+    MotionTask motion;
+    motion.begin(motionStep, SPLIT_RATE);
+    uint64_t start = native::nowMicros(), end = start + SPLIT_DURATION, last = 0;
+    while (native::nowMicros() < end) {
+        for (const NetworkWork &work : SCRIPT) native::advance(work.us);
+        if (native::nowMicros() - last >= motion.period()) {
+            last = native::nowMicros();
+            native::simulation().motionStep();
+        }
+    }
+    return result(motion, start);
+}
+
+static void print(const char *name, const SplitResult &r) {
+    printf("%-16s %8u %8u %12u\n", name, (unsigned)r.steps, (unsigned)r.overruns, (unsigned)r.jitter);
+}
+
+void test_split_jitter() {
+    SplitResult split = runSplit(), inLoop = runInLoop();
+    printf("%-16s %8s %8s %12s\n", "motion", "steps", "overruns", "jitter max us");
+    print("task", split);
+    print("in loop()", inLoop);
+
+    uint32_t period = 1000000 / SPLIT_RATE;
+    TEST_ASSERT_UINT32_WITHIN(1, split.elapsed / period, split.steps);
+    TEST_ASSERT_EQUAL(0, split.overruns);
+    TEST_ASSERT_LESS_OR_EQUAL(longestLock(), split.jitter);
+    // A pass of the network work is longer than the period, in loop() the steps fall behind
+    TEST_ASSERT_LESS_THAN(split.steps / 2, inLoop.steps);
+    TEST_ASSERT_GREATER_THAN(period, inLoop.jitter);
+}
+
+// The virtual clock only moves with the script, the same run gives the same timing
+void test_split_deterministic() {
+    SplitResult first = runSplit(), second = runSplit();
+    TEST_ASSERT_EQUAL(first.steps, second.steps);
+    TEST_ASSERT_EQUAL(first.jitter, second.jitter);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_split_jitter);
+    RUN_TEST(test_split_deterministic);
+    return UNITY_END();
+}
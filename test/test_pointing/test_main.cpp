@@ -0,0 +1,182 @@
+// Pass planning over a catalogue of passes: `pio test -e native -f test_pointing -v`.
+// Every pass is a great circle over the sky, from the horizon through its culmination back to the
+// horizon, for culminations all around and from low to overhead, both ways. It is planned a minute
+// before it rises the way loop() does (PassPlanner, then PointingPlanner::apply()) and followed
+// every second. Per servo range the total slew time (to the start of each pass and after a replan),
+// the replans and the dropouts (passes that went out of range after a replan too, tracking stops)
+// are printed.
+#include <Arduino.h>
+#include <unity.h>
+#include <pointing.h>
+#include <motionprofile.h>
+#include <rotorservo.h>
+
+#define CATALOGUE_PASS      600     // s from rise to set
+#define CATALOGUE_LEAD      60      // s before the rise a pass is planned
+
+struct CataloguePass {
+    float azimuth, elevation;       // of the culmination, degrees
+    float direction;                // 1 clockwise, -1 anticlockwise
+};
+
+struct ServoRange {
+    const char *name;
+    float altMin, altMax, azMin, azMax;
+};
+
+struct CatalogueResult {
+    uint32_t passes, replans, dropouts;     // dropouts: passes, the rest of the pass is lost
+    float slew;                     // s
+};
+
+static const CataloguePass *current;
+static long currentMs;              // Time of the pass the predictions start from
+
+static float radians(float d) { return d * M_PI / 180.0f; }
+static float degrees(float r) { return r * 180.0f / M_PI; }
+
+// The pass moves on a great circle at a constant rate, through the culmination halfway
+static void sky(const CataloguePass &pass, long ms, float &alt, float &az) {
+    float theta = radians(-90.0f + 180.0f * ms / (CATALOGUE_PASS * 1000.0f));
+    float e = radians(pass.elevation), a = radians(pass.azimuth), b = a + radians(90.0f) * pass.direction;
+    float x = cosf(theta) * cosf(e) * cosf(a) + sinf(theta) * cosf(b);
+    float y = cosf(theta) * cosf(e) * sinf(a) + sinf(theta) * sinf(b);
+    float z = cosf(theta) * sinf(e);
+    alt = degrees(asinf(z));
+    az = fmodf(degrees(atan2f(y, x)) + 360.0f, 360.0f);
+}
+
+static bool predict(long offsetMs, float &alt, float &az) {
+    sky(*current, currentMs + offsetMs, alt, az);
+    return true;
+}
+
+// Time the slower axis takes to get there at the default limits
+static float slewTime(float fromAlt, float fromAz, float toAlt, float toAz) {
+    MotionProfile profile;
+    profile.configure(DEFAULT_MAX_SPEED, DEFAULT_MAX_ACCEL, DEFAULT_MAX_JERK);
+    return std::max(profile.duration(toAlt - fromAlt), profile.duration(toAz - fromAz));
+}
+
+// Plan from the current time of the pass and hand the plan over, as planPass() in loop() does
+static void planPass(PassPlanner &planner, PointingPlanner &pointing, const ServoRange &range, float servoAlt, float servoAz) {
+    planner.setRange(range.altMin, range.altMax, range.azMin, range.azMax);
+    PassPlan plan = planner.plan(predict, servoAlt, servoAz);
+    plan.generation = pointing.generation();
+    pointing.apply(plan);
+    pointing.setRange(range.altMin, range.altMax, range.azMin, range.azMax);
+}
+
+static CatalogueResult followCatalogue(const ServoRange &range) {
+    PassPlanner planner;
+    PointingPlanner pointing;
+    CatalogueResult result = {};
+    float servoAlt = range.altMin, servoAz = (range.azMin + range.azMax) / 2;  // Parked
+    const float elevations[] = {5.0f, 20.0f, 45.0f, 70.0f, 89.5f};
+    for (float direction : {1.0f, -1.0f}) {
+        for (float elevation : elevations) {
+            for (float azimuth = 0.0f; azimuth < 360.0f; azimuth += 15.0f) {
+                CataloguePass pass = {azimuth, elevation, direction};
+                current = &pass;
+                result.passes++;
+
+                // Wait for the rise at the start of the pass
+                pointing.reset();
+                currentMs = -CATALOGUE_LEAD * 1000L;
+                planPass(planner, pointing, range, servoAlt, servoAz);
+                float startAlt, startAz;
+                if (pointing.start(startAlt, startAz)) {
+                    result.slew += slewTime(servoAlt, servoAz, startAlt, startAz);
+                    servoAlt = startAlt;
+                    servoAz = startAz;
+                }
+
+                for (currentMs = 0; currentMs <= CATALOGUE_PASS * 1000L; currentMs += 1000) {
+                    float alt, az, toAlt, toAz;
+                    sky(pass, currentMs, alt, az);
+                    if (alt < 0.0f) continue;   // Rounding at the horizon
+                    if (!pointing.toServo(alt, az, toAlt, toAz)) {
+                        pointing.replan();
+                        result.replans++;
+                        planPass(planner, pointing, range, servoAlt, servoAz);
+                        if (!pointing.toServo(alt, az, toAlt, toAz)) {
+                            result.dropouts++;
+                            break;
+                        }
+                        result.slew += slewTime(servoAlt, servoAz, toAlt, toAz);
+                    }
+                    servoAlt = toAlt;
+                    servoAz = toAz;
+                }
+            }
+        }
+    }
+    printf("%-24s %8u %10.1f %8u %10u\n", range.name, (unsigned)result.passes, result.slew,
+           (unsigned)result.replans, (unsigned)result.dropouts);
+    return result;
+}
+
+static void header() {
+    printf("%-24s %8s %10s %8s %10s\n", "servo range", "passes", "slew s", "replans", "dropouts");
+}
+
+// Every pass spans 180 degrees of azimuth. Where it does not fit in one pose it is replanned halfway,
+// with a slew, but followed to the end. With both the flip and a full turn of azimuth it always fits
+void test_catalogue_without_dropouts() {
+    header();
+    const ServoRange ranges[] = {
+        {"alt 0..180 az 0..270", 0.0f, 180.0f, 0.0f, 270.0f},
+        {"alt 0..90 az 0..360", 0.0f, 90.0f, 0.0f, 360.0f},
+        {"alt 0..180 az 0..180", 0.0f, 180.0f, 0.0f, 180.0f},
+        {"alt 0..180 az 0..360", 0.0f, 180.0f, 0.0f, 360.0f},
+    };
+    for (const ServoRange &range : ranges) {
+        CatalogueResult result = followCatalogue(range);
+        TEST_ASSERT_EQUAL(0, result.dropouts);
+        if (range.altMax > 90.0f and range.azMax - range.azMin >= 360.0f) TEST_ASSERT_EQUAL(0, result.replans);
+    }
+}
+
+// Without the flip the passes through the 90 degrees of azimuth out of reach are followed up to there
+void test_catalogue_with_dropouts() {
+    header();
+    const ServoRange range = {"alt 0..90 az 0..270", 0.0f, 90.0f, 0.0f, 270.0f};
+    CatalogueResult result = followCatalogue(range);
+    TEST_ASSERT_GREATER_THAN(0, result.dropouts);
+    TEST_ASSERT_LESS_THAN(result.passes, result.dropouts);
+}
+
+// A plan made for a target that changed meanwhile is not taken
+void test_stale_plan() {
+    CataloguePass pass = {90.0f, 45.0f, 1.0f};
+    current = &pass;
+    currentMs = 0;
+    PassPlanner planner;
+    PointingPlanner pointing;
+    planner.setRange(0.0f, 180.0f, 0.0f, 270.0f);
+    pointing.setRange(0.0f, 180.0f, 0.0f, 270.0f);
+
+    PassPlan plan = planner.plan(predict, 0.0f, 135.0f);
+    plan.generation = pointing.generation();
+    pointing.reset();
+    TEST_ASSERT_FALSE(pointing.apply(plan));
+    TEST_ASSERT_FALSE(pointing.planned());
+    TEST_ASSERT_TRUE(pointing.due());
+
+    plan.generation = pointing.generation();
+    TEST_ASSERT_TRUE(pointing.apply(plan));
+    TEST_ASSERT_TRUE(pointing.planned());
+    TEST_ASSERT_FALSE(pointing.due());
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_catalogue_without_dropouts);
+    RUN_TEST(test_catalogue_with_dropouts);
+    RUN_TEST(test_stale_plan);
+    return UNITY_END();
+}
@@ -0,0 +1,211 @@
+// SGP4/SDP4 against reference vectors and a propagation benchmark: `pio test -e native -f test_sgp4 -v`.
+// The near earth and the deep space reference vectors are from the verification set of Vallado's
+// "Revisiting Spacetrack Report #3" (tcppver.out). Geostationary, GPS and Molniya orbits, for
+// which no reference vectors are included, are checked on their radius, semi-major axis and
+// longitude over 30 days, which exercises both resonances of the integrator.
+#include <Arduino.h>
+#include <unity.h>
+#include <chrono>
+#include <sgp4.h>
+
+#define SGP4_DAYS       30      // Span of the deep space sanity checks
+
+struct Reference {
+    double tsince;      // minutes
+    double r[3], v[3];  // km, km/s
+};
+
+static double length(const double a[3]) {
+    return sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+}
+
+static void assertReference(Sgp4 &sgp4, const Reference &ref, double positionKm, double velocityKms) {
+    double r[3], v[3];
+    TEST_ASSERT_TRUE(sgp4.propagate(ref.tsince, r, v));
+    for (int i = 0; i < 3; ++i) {
+        TEST_ASSERT_DOUBLE_WITHIN(positionKm, ref.r[i], r[i]);
+        TEST_ASSERT_DOUBLE_WITHIN(velocityKms, ref.v[i], v[i]);
+    }
+}
+
+// Elements without a TLE, epoch 2024-01-01 and no drag
+static Tle elements(double revsPerDay, double eccentricity, double inclination, double raan, double argPerigee, double meanAnomaly) {
+    const double deg2rad = M_PI / 180.0;
+    Tle tle;
+    tle.epoch = julianDate(2024, 1, 1);
+    tle.inclination = inclination * deg2rad;
+    tle.raan = raan * deg2rad;
+    tle.eccentricity = eccentricity;
+    tle.argPerigee = argPerigee * deg2rad;
+    tle.meanAnomaly = meanAnomaly * deg2rad;
+    tle.meanMotion = revsPerDay * 2.0 * M_PI / 1440.0;
+    return tle;
+}
+
+struct OrbitRange {
+    double rMin, rMax, aMin, aMax;      // radius and semi-major axis (vis-viva), km
+    double longitude, drift;            // over the earth at the epoch and its change, degrees
+};
+
+// Every hour for SGP4_DAYS days
+static OrbitRange orbitRange(Sgp4 &sgp4) {
+    OrbitRange range = {1e9, 0.0, 1e9, 0.0, 0.0, 0.0};
+    for (double t = 0.0; t <= SGP4_DAYS * 1440.0; t += 60.0) {
+        double r[3], v[3];
+        if (!sgp4.propagate(t, r, v)) {
+            range.rMin = 0.0;
+            break;
+        }
+        double radius = length(r), speed = length(v);
+        double a = 1.0 / (2.0 / radius - speed * speed / Sgp4::MU);
+        range.rMin = std::min(range.rMin, radius);
+        range.rMax = std::max(range.rMax, radius);
+        range.aMin = std::min(range.aMin, a);
+        range.aMax = std::max(range.aMax, a);
+
+        double longitude = fmod(atan2(r[1], r[0]) - gmst(sgp4.tle().epoch + t / 1440.0) + 4.0 * M_PI, 2.0 * M_PI) * 180.0 / M_PI;
+        if (t == 0.0) range.longitude = longitude;
+        range.drift = longitude - range.longitude;
+    }
+    return range;
+}
+
+// The resonance integrator steps 720 minutes, the position has to be continuous across a step
+static void assertContinuous(Sgp4 &sgp4, double tsince) {
+    const double dt = 0.001;    // minutes
+    double r1[3], r2[3], v[3];
+    TEST_ASSERT_TRUE(sgp4.propagate(tsince - dt, r1, v));
+    TEST_ASSERT_TRUE(sgp4.propagate(tsince + dt, r2, v));
+    double d[3] = {r2[0] - r1[0], r2[1] - r1[1], r2[2] - r1[2]};
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, length(v) * 2.0 * dt * 60.0, length(d));
+}
+
+void test_near_earth_reference() {
+    Tle tle;
+    TEST_ASSERT_TRUE(parseTle("00005", "1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753",
+                              "2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667", tle));
+    Sgp4 sgp4;
+    TEST_ASSERT_TRUE(sgp4.init(tle));
+    TEST_ASSERT_FALSE(sgp4.deepSpace());
+
+    const Reference refs[] = {
+        {0.0, {7022.46529266, -1400.08296755, 0.03995155}, {1.893841015, 6.405893759, 4.534807250}},
+        {360.0, {-7154.03120202, -3783.17682504, -3536.19412294}, {4.741887409, -4.151817765, -2.093935425}},
+    };
+    for (const Reference &ref : refs) assertReference(sgp4, ref, 1e-6, 1e-9);
+}
+
+// 11801 (an eccentric 12 hour orbit, resonance 2). The velocities agree to the last digit, the
+// positions only to some 20 m, the deep space terms they check move the satellite by kilometers
+void test_deep_space_reference() {
+    const double deg2rad = M_PI / 180.0;
+    Tle tle;
+    tle.epoch = julianDate(1980, 1, 1) + 230.29629788 - 1.0;
+    tle.bstar = 0.14311e-1;
+    tle.inclination = 46.7916 * deg2rad;
+    tle.raan = 230.4354 * deg2rad;
+    tle.eccentricity = 0.7318036;
+    tle.argPerigee = 47.4722 * deg2rad;
+    tle.meanAnomaly = 10.4117 * deg2rad;
+    tle.meanMotion = 2.28537848 * 2.0 * M_PI / 1440.0;
+    Sgp4 sgp4;
+    TEST_ASSERT_TRUE(sgp4.init(tle));
+    TEST_ASSERT_TRUE(sgp4.deepSpace());
+
+    const Reference refs[] = {
+        {0.0, {7473.37066650, 428.95261765, 5828.74786377}, {5.107155113, 6.444680410, -0.186133003}},
+        {360.0, {-3305.22537232, 32410.86328125, -24697.17675781}, {-1.301137319, -1.151315600, -0.283335823}},
+    };
+    for (const Reference &ref : refs) assertReference(sgp4, ref, 0.025, 1e-6);
+}
+
+// Synchronous resonance and the Lyddane modification of an equatorial orbit
+void test_geostationary() {
+    Sgp4 sgp4;
+    TEST_ASSERT_TRUE(sgp4.init(elements(1.00273, 0.0002, 0.05, 80.0, 270.0, 100.0)));
+    TEST_ASSERT_TRUE(sgp4.deepSpace());
+
+    OrbitRange range = orbitRange(sgp4);
+    printf("geostationary: radius %0.1f..%0.1f km, longitude %0.2f drifts %0.2f degrees in %d days\n",
+           range.rMin, range.rMax, range.longitude, range.drift, SGP4_DAYS);
+    TEST_ASSERT_DOUBLE_WITHIN(30.0, 42164.0, range.rMin);
+    TEST_ASSERT_DOUBLE_WITHIN(30.0, 42164.0, range.rMax);
+    TEST_ASSERT_DOUBLE_WITHIN(0.5, 0.0, range.drift);
+    assertContinuous(sgp4, 5 * 720.0);
+    assertContinuous(sgp4, -3 * 720.0);
+}
+
+// Half day resonance of an eccentric orbit
+void test_molniya() {
+    Sgp4 sgp4;
+    TEST_ASSERT_TRUE(sgp4.init(elements(2.00563, 0.72, 63.4, 100.0, 270.0, 30.0)));
+    TEST_ASSERT_TRUE(sgp4.deepSpace());
+
+    OrbitRange range = orbitRange(sgp4);
+    printf("molniya: radius %0.1f..%0.1f km, semi-major axis %0.1f..%0.1f km\n", range.rMin, range.rMax, range.aMin, range.aMax);
+    TEST_ASSERT_GREATER_THAN_DOUBLE(Sgp4::RE + 500.0, range.rMin);
+    TEST_ASSERT_LESS_THAN_DOUBLE(47000.0, range.rMax);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01 * 26560.0, 26560.0, range.aMin);
+    TEST_ASSERT_DOUBLE_WITHIN(0.01 * 26560.0, 26560.0, range.aMax);
+    assertContinuous(sgp4, 5 * 720.0);
+}
+
+// Deep space without a resonance (12 hours, not eccentric enough)
+void test_gps() {
+    Sgp4 sgp4;
+    TEST_ASSERT_TRUE(sgp4.init(elements(2.00561, 0.01, 55.0, 100.0, 30.0, 30.0)));
+    TEST_ASSERT_TRUE(sgp4.deepSpace());
+
+    OrbitRange range = orbitRange(sgp4);
+    printf("gps: radius %0.1f..%0.1f km\n", range.rMin, range.rMax);
+    TEST_ASSERT_DOUBLE_WITHIN(400.0, 26560.0, range.rMin);
+    TEST_ASSERT_DOUBLE_WITHIN(400.0, 26560.0, range.rMax);
+    TEST_ASSERT_DOUBLE_WITHIN(10.0, 26560.0, range.aMin);
+    TEST_ASSERT_DOUBLE_WITHIN(10.0, 26560.0, range.aMax);
+}
+
+static volatile double sink;     // Keeps the compiler from dropping the propagation
+
+// Time per propagate(), the control loop calls it every motion step while tracking on board
+static double propagateNs(Sgp4 &sgp4, double tsince) {
+    const int operations = 20000;
+    double r[3], v[3], sum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < operations; ++i) {
+        sgp4.propagate(tsince + i * 1e-4, r, v);
+        sum += r[0];
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    sink = sum;
+    return (double)ns / operations;
+}
+
+void test_propagate_benchmark() {
+    Tle tle;
+    TEST_ASSERT_TRUE(parseTle("ISS (ZARYA)", "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927",
+                              "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537", tle));
+    Sgp4 leo, geo, molniya;
+    TEST_ASSERT_TRUE(leo.init(tle));
+    TEST_ASSERT_TRUE(geo.init(elements(1.00273, 0.0002, 0.05, 80.0, 270.0, 100.0)));
+    TEST_ASSERT_TRUE(molniya.init(elements(2.00563, 0.72, 63.4, 100.0, 270.0, 30.0)));
+
+    printf("%-32s %10.1f ns/op\n", "propagate near earth", propagateNs(leo, 1440.0));
+    printf("%-32s %10.1f ns/op\n", "propagate geostationary, 1 day", propagateNs(geo, 1440.0));
+    printf("%-32s %10.1f ns/op\n", "propagate geostationary, 10 days", propagateNs(geo, 14400.0));
+    printf("%-32s %10.1f ns/op\n", "propagate molniya, 10 days", propagateNs(molniya, 14400.0));
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_near_earth_reference);
+    RUN_TEST(test_deep_space_reference);
+    RUN_TEST(test_geostationary);
+    RUN_TEST(test_molniya);
+    RUN_TEST(test_gps);
+    RUN_TEST(test_propagate_benchmark);
+    return UNITY_END();
+}